@@ -0,0 +1,60 @@
+'use strict'
+
+const couchbase = require('../dist/couchbase')
+
+// The same environment variables as the tests, but benchmarks always run
+// against a real cluster rather than the mock.
+const CONFIG = {
+  connstr: process.env.CNCSTR,
+  bucket: process.env.CNBUCKET || 'default',
+  user: process.env.CNUSER,
+  pass: process.env.CNPASS,
+}
+
+async function connect(options) {
+  if (!CONFIG.connstr) {
+    throw new Error('CNCSTR must be set to the cluster to benchmark against')
+  }
+
+  const cluster = await couchbase.connect(CONFIG.connstr, {
+    username: CONFIG.user,
+    password: CONFIG.pass,
+    ...options,
+  })
+  const coll = cluster.bucket(CONFIG.bucket).defaultCollection()
+  return { cluster, coll }
+}
+
+function genKey(name) {
+  return `bench-${name}-${process.pid}-${Date.now()}`
+}
+
+// Runs `numOps` operations produced by `opFn`, keeping up to `concurrency`
+// of them in flight at a time, and returns the achieved rate in ops/s.
+async function runOps(numOps, concurrency, opFn) {
+  const start = process.hrtime()
+
+  let nextOp = 0
+  const worker = async () => {
+    while (nextOp < numOps) {
+      await opFn(nextOp++)
+    }
+  }
+  const workers = []
+  for (let i = 0; i < concurrency; ++i) {
+    workers.push(worker())
+  }
+  await Promise.all(workers)
+
+  const elapsed = process.hrtime(start)
+  return numOps / (elapsed[0] + elapsed[1] / 1e9)
+}
+
+function run(main) {
+  main().catch((err) => {
+    console.error(err)
+    process.exitCode = 1
+  })
+}
+
+module.exports = { connect, genKey, runOps, run }
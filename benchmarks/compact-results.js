@@ -0,0 +1,61 @@
+'use strict'
+
+// Compares the old space retained by upsert results with and without
+// compactResults.  Every result is kept alive, the way a batch of results
+// held by an application would be, so that they end up in the old space.
+//
+//   CNCSTR=couchbase://... node --expose-gc benchmarks/compact-results.js [numOps]
+
+const v8 = require('v8')
+
+const { connect, genKey, runOps, run } = require('./common')
+
+const NUM_OPS = parseInt(process.argv[2] || '1000000', 10)
+
+function oldSpaceUsed() {
+  global.gc()
+  const space = v8
+    .getHeapSpaceStatistics()
+    .find((s) => s.space_name === 'old_space')
+  return space.space_used_size
+}
+
+async function measure(coll, testKey) {
+  const results = new Array(NUM_OPS)
+  await runOps(1000, 1000, (i) => coll.upsert(testKey, i))
+
+  const before = oldSpaceUsed()
+  const opsPerSec = await runOps(NUM_OPS, 1000, async (i) => {
+    results[i] = await coll.upsert(testKey, i)
+  })
+  const growth = oldSpaceUsed() - before
+
+  return { opsPerSec, bytesPerOp: growth / NUM_OPS }
+}
+
+run(async () => {
+  if (typeof global.gc !== 'function') {
+    throw new Error('this benchmark must be run with node --expose-gc')
+  }
+
+  const testKey = genKey('compact-results')
+  const report = async (name, options) => {
+    const { cluster, coll } = await connect(options)
+    try {
+      const res = await measure(coll, testKey)
+      console.log(
+        `upsert x${NUM_OPS} ${name}: ${Math.round(res.opsPerSec)} ops/s, ` +
+          `${Math.round(res.bytesPerOp)} old-space bytes/result`
+      )
+    } finally {
+      await cluster.close()
+    }
+  }
+
+  await report('objects', {})
+  await report('compact', { compactResults: true })
+
+  const { cluster, coll } = await connect()
+  await coll.remove(testKey)
+  await cluster.close()
+})
@@ -0,0 +1,45 @@
+'use strict'
+
+// Measures get throughput, along with the native allocations each get makes
+// before and after the connection's pools have warmed up.
+//
+//   CNCSTR=couchbase://... node benchmarks/get.js [numOps] [concurrency]
+
+const { connect, genKey, runOps, run } = require('./common')
+
+const NUM_OPS = parseInt(process.argv[2] || '100000', 10)
+const CONCURRENCY = parseInt(process.argv[3] || '1000', 10)
+
+run(async () => {
+  const { cluster, coll } = await connect()
+  const conn = coll.conn
+  const testKey = genKey('get')
+  await coll.insert(testKey, { foo: 'bar' })
+
+  const allocsPerOp = (stats, base, numOps) =>
+    (stats.cookieAllocs -
+      base.cookieAllocs +
+      stats.scratchAllocs -
+      base.scratchAllocs) /
+    numOps
+
+  try {
+    const before = conn.poolStats()
+    await runOps(CONCURRENCY, CONCURRENCY, () => coll.get(testKey))
+    const warm = conn.poolStats()
+
+    const opsPerSec = await runOps(NUM_OPS, CONCURRENCY, () =>
+      coll.get(testKey)
+    )
+    const after = conn.poolStats()
+
+    console.log(
+      `get x${NUM_OPS}: ${Math.round(opsPerSec)} ops/s, ` +
+        `native allocs/op cold: ${allocsPerOp(warm, before, CONCURRENCY)}, ` +
+        `warm: ${allocsPerOp(after, warm, NUM_OPS)}`
+    )
+  } finally {
+    await coll.remove(testKey)
+    await cluster.close()
+  }
+})
@@ -72,17 +72,23 @@
     'sources': [
       'src/binding.cpp',
       'src/cas.cpp',
+      'src/casloop.cpp',
+      'src/collectionref.cpp',
       'src/connection_callbacks.cpp',
       'src/connection_ops.cpp',
       'src/connection.cpp',
       'src/constants.cpp',
       'src/error.cpp',
+      'src/hedgedread.cpp',
+      'src/kvresult.cpp',
       'src/lcbx.cpp',
       'src/logger.cpp',
       'src/metrics.cpp',
       'src/mutationtoken.cpp',
       'src/opbuilder.cpp',
+      'src/rowbatcher.cpp',
       'src/tracing.cpp',
+      'src/transcoder.cpp',
       'src/uv-plugin-all.cpp'
     ],
     'include_dirs': [
@@ -104,6 +104,7 @@ SET(LCB_CORE_CXXSRC
     src/search/search.cc
     src/search/search_handle.cc
     src/settings.cc
+    src/sharedcache.cc
     src/utilities.cc
     src/views/view.cc
     src/views/view_handle.cc
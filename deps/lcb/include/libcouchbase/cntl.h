@@ -1326,11 +1326,148 @@ typedef enum {
  */
 #define LCB_CNTL_ENABLE_OP_METRICS 0x67
 
+/**
+ * @brief Enable/disable cluster map change notifications pushed by the server.
+ *
+ * When enabled, the library negotiates the DUPLEX and CLUSTERMAP_CHANGE_NOTIFICATION
+ * features on its data connections, and applies the cluster maps which the nodes
+ * send on their own whenever the topology changes instead of waiting to hit a
+ * NOT_MY_VBUCKET or the next configuration poll.  This is enabled by default.
+ *
+ * Use `enable_config_push` in the connection string.
+ *
+ * @cntl_arg_both{int* (as boolean)}
+ * @uncommitted
+ */
+#define LCB_CNTL_ENABLE_CONFIG_PUSH 0x68
+
+/**
+ * @brief Number of data connections to open to each node.
+ *
+ * With more than one connection, commands for a node are spread over its
+ * connections, each going to the one with the fewest bytes still queued or
+ * awaiting a response. Commands sent over different connections may be
+ * executed in a different order than they were scheduled. The setting is
+ * applied to nodes the library connects to after it has been changed. The
+ * default is 1.
+ *
+ * Use `kv_connections_per_node` in the connection string.
+ *
+ * @cntl_arg_both{lcb_U32*}
+ * @uncommitted
+ */
+#define LCB_CNTL_KV_CONNECTIONS_PER_NODE 0x69
+
+/**
+ * @brief Minimum value size for a mutation to use the dedicated connection.
+ *
+ * When set to a nonzero value and more than one connection is opened to each
+ * node (see @ref LCB_CNTL_KV_CONNECTIONS_PER_NODE), the last connection to
+ * each node is reserved for mutations whose value is at least this many
+ * bytes, so that they do not hold up smaller commands. The default is 0,
+ * which does not reserve any connection.
+ *
+ * Use `kv_large_value_threshold` in the connection string.
+ *
+ * @cntl_arg_both{lcb_U32*}
+ * @uncommitted
+ */
+#define LCB_CNTL_KV_LARGE_VALUE_THRESHOLD 0x6a
+
+/**
+ * @brief Name of a configuration cache shared within the process.
+ *
+ * Instances in the same process (usually on different threads) which set
+ * the same name for the same bucket share their cluster map and their
+ * collection IDs. Only the first of them needs to fetch the cluster map to
+ * bootstrap, the others use the one it stored, and any newer map seen by one
+ * instance is used by the others the next time they refresh theirs. This is
+ * an in-memory alternative to @ref LCB_CNTL_CONFIGCACHE.
+ *
+ * Use `config_cache_shared` in the connection string.
+ *
+ * @cntl_arg_setonly{const char*}
+ * @uncommitted
+ * @see LCB_CNTL_CONFIG_CACHE_LOADED
+ */
+#define LCB_CNTL_CONFIGCACHE_SHARED 0x6b
+
+/**
+ * @brief Maximum number of prepared statements kept by the instance.
+ *
+ * Queries executed with lcb_cmdquery_adhoc() set to false are prepared the
+ * first time they are executed, and the plan is kept for later executions of
+ * the same statement. When the cache is full, the least recently used plan is
+ * dropped. The default is 5000, and the value may not be 0.
+ *
+ * Use `query_cache_size` in the connection string.
+ *
+ * @cntl_arg_both{lcb_U32*}
+ * @uncommitted
+ * @see LCB_CNTL_QUERY_CACHE_STATS
+ */
+#define LCB_CNTL_QUERY_CACHE_SIZE 0x6c
+
+/**
+ * Counters of the prepared statement cache, see @ref LCB_CNTL_QUERY_CACHE_STATS.
+ * @uncommitted
+ */
+typedef struct {
+    lcb_U64 hits;      /**< Executions which found a prepared plan */
+    lcb_U64 misses;    /**< Executions which had to prepare the statement */
+    lcb_U64 evictions; /**< Plans dropped because the cache was full */
+    lcb_U32 size;      /**< Number of plans in the cache */
+    lcb_U32 capacity;  /**< Maximum number of plans in the cache */
+} lcb_QUERY_CACHE_STATS;
+
+/**
+ * @brief Get the counters of the prepared statement cache.
+ *
+ * @cntl_arg_getonly{lcb_QUERY_CACHE_STATS*}
+ * @uncommitted
+ * @see LCB_CNTL_QUERY_CACHE_SIZE
+ */
+#define LCB_CNTL_QUERY_CACHE_STATS 0x6d
+
+/**
+ * Counters of the values compressed before sending them, see
+ * @ref LCB_CNTL_COMPRESSION_STATS.
+ * @uncommitted
+ */
+typedef struct {
+    lcb_U64 bytes_in;    /**< Size of the values given to the compressor */
+    lcb_U64 bytes_out;   /**< Size of the values which were sent compressed */
+    lcb_U64 compress_ns; /**< Time spent compressing, in nanoseconds */
+    lcb_U64 compressed;  /**< Values sent compressed */
+    lcb_U64 rejected;    /**< Values compressed, but sent as they were because of the ratio */
+    lcb_U64 skipped;     /**< Values not compressed because they were not expected to compress */
+} lcb_COMPRESSION_STATS;
+
+/**
+ * @brief Get the counters of outgoing compression.
+ *
+ * Values are only sent compressed when they shrink to at most
+ * @ref LCB_CNTL_COMPRESSION_MIN_RATIO of their size. The library remembers
+ * the ratios of the values recently compressed for each collection and key
+ * prefix (the key up to the first character which is not a letter or digit),
+ * and does not compress values of the ones which usually don't meet it, apart
+ * from an occasional one to notice when that changes. These are counted as
+ * skipped.
+ *
+ * When operation metrics are enabled, the time taken to compress each value
+ * is also recorded by the meter, as the `kv` service operation
+ * `snappy_compress`.
+ *
+ * @cntl_arg_getonly{lcb_COMPRESSION_STATS*}
+ * @uncommitted
+ */
+#define LCB_CNTL_COMPRESSION_STATS 0x6e
+
 /**
  * This is not a command, but rather an indicator of the last item.
  * @internal
  */
-#define LCB_CNTL__MAX 0x68
+#define LCB_CNTL__MAX 0x6f
 /**@}*/
 
 #ifdef __cplusplus
@@ -694,6 +694,21 @@ LIBCOUCHBASE_API lcb_STATUS lcb_respget_datatype(const lcb_RESPGET *resp, uint8_
 LIBCOUCHBASE_API lcb_STATUS lcb_respget_flags(const lcb_RESPGET *resp, uint32_t *flags);
 LIBCOUCHBASE_API lcb_STATUS lcb_respget_key(const lcb_RESPGET *resp, const char **key, size_t *key_len);
 LIBCOUCHBASE_API lcb_STATUS lcb_respget_value(const lcb_RESPGET *resp, const char **value, size_t *value_len);
+struct rdb_ROPESEG;
+
+/**
+ * @uncommitted
+ * Get the network buffer which holds the value returned by lcb_respget_value().
+ *
+ * The value normally points into the buffer the response was read into. Calling lcb_backbuf_ref() (see pktfwd.h) on
+ * the returned buffer keeps the value valid after the callback returns, until the matching lcb_backbuf_unref().
+ *
+ * @param resp the response
+ * @param[out] backbuf the buffer, usable as an lcb_BACKBUF
+ * @return LCB_ERR_UNSUPPORTED_OPERATION if the value is not backed by a network buffer (for example because it was
+ * decompressed into temporary storage), in which case it must be copied before the callback returns.
+ */
+LIBCOUCHBASE_API lcb_STATUS lcb_respget_backbuf(const lcb_RESPGET *resp, struct rdb_ROPESEG **backbuf);
 
 typedef struct lcb_CMDGET_ lcb_CMDGET;
 
@@ -702,6 +717,14 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdget_destroy(lcb_CMDGET *cmd);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdget_parent_span(lcb_CMDGET *cmd, lcbtrace_SPAN *span);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdget_collection(lcb_CMDGET *cmd, const char *scope, size_t scope_len,
                                                   const char *collection, size_t collection_len);
+/**
+ * @uncommitted
+ * Use an already known ID for the collection set with lcb_cmdget_collection(), which must be called first, so that
+ * it is not looked up again. This is meant for IDs obtained with lcb_collection_id_cached(), which are only valid
+ * for the instance they were obtained from, and only while its collection cache generation is unchanged. The same
+ * applies to the other lcb_cmd*_collection_id() functions.
+ */
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdget_collection_id(lcb_CMDGET *cmd, uint32_t collection_id);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdget_key(lcb_CMDGET *cmd, const char *key, size_t key_len);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdget_expiry(lcb_CMDGET *cmd, uint32_t expiration);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdget_locktime(lcb_CMDGET *cmd, uint32_t duration);
@@ -797,6 +820,12 @@ LIBCOUCHBASE_API lcb_STATUS lcb_respgetreplica_flags(const lcb_RESPGETREPLICA *r
 LIBCOUCHBASE_API lcb_STATUS lcb_respgetreplica_key(const lcb_RESPGETREPLICA *resp, const char **key, size_t *key_len);
 LIBCOUCHBASE_API lcb_STATUS lcb_respgetreplica_value(const lcb_RESPGETREPLICA *resp, const char **value,
                                                      size_t *value_len);
+/**
+ * @uncommitted
+ * Replica counterpart of lcb_respget_backbuf()
+ */
+LIBCOUCHBASE_API lcb_STATUS lcb_respgetreplica_backbuf(const lcb_RESPGETREPLICA *resp,
+                                                       struct rdb_ROPESEG **backbuf);
 LIBCOUCHBASE_API int lcb_respgetreplica_is_final(const lcb_RESPGETREPLICA *resp);
 
 typedef struct lcb_CMDGETREPLICA_ lcb_CMDGETREPLICA;
@@ -806,6 +835,7 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdgetreplica_destroy(lcb_CMDGETREPLICA *cmd);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdgetreplica_parent_span(lcb_CMDGETREPLICA *cmd, lcbtrace_SPAN *span);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdgetreplica_collection(lcb_CMDGETREPLICA *cmd, const char *scope, size_t scope_len,
                                                          const char *collection, size_t collection_len);
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdgetreplica_collection_id(lcb_CMDGETREPLICA *cmd, uint32_t collection_id);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdgetreplica_key(lcb_CMDGETREPLICA *cmd, const char *key, size_t key_len);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdgetreplica_timeout(lcb_CMDGETREPLICA *cmd, uint32_t timeout);
 LIBCOUCHBASE_API lcb_STATUS lcb_getreplica(lcb_INSTANCE *instance, void *cookie, const lcb_CMDGETREPLICA *cmd);
@@ -829,6 +859,7 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdexists_destroy(lcb_CMDEXISTS *cmd);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdexists_parent_span(lcb_CMDEXISTS *cmd, lcbtrace_SPAN *span);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdexists_collection(lcb_CMDEXISTS *cmd, const char *scope, size_t scope_len,
                                                      const char *collection, size_t collection_len);
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdexists_collection_id(lcb_CMDEXISTS *cmd, uint32_t collection_id);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdexists_key(lcb_CMDEXISTS *cmd, const char *key, size_t key_len);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdexists_timeout(lcb_CMDEXISTS *cmd, uint32_t timeout);
 
@@ -967,9 +998,27 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdstore_destroy(lcb_CMDSTORE *cmd);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdstore_parent_span(lcb_CMDSTORE *cmd, lcbtrace_SPAN *span);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdstore_collection(lcb_CMDSTORE *cmd, const char *scope, size_t scope_len,
                                                     const char *collection, size_t collection_len);
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdstore_collection_id(lcb_CMDSTORE *cmd, uint32_t collection_id);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdstore_key(lcb_CMDSTORE *cmd, const char *key, size_t key_len);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdstore_value(lcb_CMDSTORE *cmd, const char *value, size_t value_len);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdstore_value_iov(lcb_CMDSTORE *cmd, const lcb_IOV *value, size_t value_len);
+/**
+ * @uncommitted
+ * Set the value of the document without copying it.
+ *
+ * The library references `value` directly when building the request, and calls `release(release_cookie)` once
+ * neither the command nor any packet created from it needs the buffer anymore. This may happen after the store
+ * callback has been invoked, and it also happens if the command fails to schedule. If the value has to be
+ * transformed (for example compressed), it is copied and released early.
+ *
+ * @param cmd the command
+ * @param value the buffer, which must stay valid until `release` is called
+ * @param value_len size of the buffer
+ * @param release function invoked exactly once to give the buffer back to the caller (required)
+ * @param release_cookie argument for `release`
+ */
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdstore_value_nocopy(lcb_CMDSTORE *cmd, const char *value, size_t value_len,
+                                                      void (*release)(void *), void *release_cookie);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdstore_expiry(lcb_CMDSTORE *cmd, uint32_t expiration);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdstore_preserve_expiry(lcb_CMDSTORE *cmd, int should_preserve);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdstore_cas(lcb_CMDSTORE *cmd, uint64_t cas);
@@ -1079,6 +1128,7 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdremove_destroy(lcb_CMDREMOVE *cmd);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdremove_parent_span(lcb_CMDREMOVE *cmd, lcbtrace_SPAN *span);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdremove_collection(lcb_CMDREMOVE *cmd, const char *scope, size_t scope_len,
                                                      const char *collection, size_t collection_len);
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdremove_collection_id(lcb_CMDREMOVE *cmd, uint32_t collection_id);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdremove_key(lcb_CMDREMOVE *cmd, const char *key, size_t key_len);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdremove_cas(lcb_CMDREMOVE *cmd, uint64_t cas);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdremove_durability(lcb_CMDREMOVE *cmd, lcb_DURABILITY_LEVEL level);
@@ -1164,6 +1214,7 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdcounter_destroy(lcb_CMDCOUNTER *cmd);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdcounter_parent_span(lcb_CMDCOUNTER *cmd, lcbtrace_SPAN *span);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdcounter_collection(lcb_CMDCOUNTER *cmd, const char *scope, size_t scope_len,
                                                       const char *collection, size_t collection_len);
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdcounter_collection_id(lcb_CMDCOUNTER *cmd, uint32_t collection_id);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdcounter_key(lcb_CMDCOUNTER *cmd, const char *key, size_t key_len);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdcounter_expiry(lcb_CMDCOUNTER *cmd, uint32_t expiration);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdcounter_delta(lcb_CMDCOUNTER *cmd, int64_t number);
@@ -1246,6 +1297,7 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdunlock_destroy(lcb_CMDUNLOCK *cmd);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdunlock_parent_span(lcb_CMDUNLOCK *cmd, lcbtrace_SPAN *span);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdunlock_collection(lcb_CMDUNLOCK *cmd, const char *scope, size_t scope_len,
                                                      const char *collection, size_t collection_len);
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdunlock_collection_id(lcb_CMDUNLOCK *cmd, uint32_t collection_id);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdunlock_key(lcb_CMDUNLOCK *cmd, const char *key, size_t key_len);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdunlock_cas(lcb_CMDUNLOCK *cmd, uint64_t cas);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdunlock_timeout(lcb_CMDUNLOCK *cmd, uint32_t timeout);
@@ -1312,6 +1364,7 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdtouch_destroy(lcb_CMDTOUCH *cmd);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdtouch_parent_span(lcb_CMDTOUCH *cmd, lcbtrace_SPAN *span);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdtouch_collection(lcb_CMDTOUCH *cmd, const char *scope, size_t scope_len,
                                                     const char *collection, size_t collection_len);
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdtouch_collection_id(lcb_CMDTOUCH *cmd, uint32_t collection_id);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdtouch_key(lcb_CMDTOUCH *cmd, const char *key, size_t key_len);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdtouch_expiry(lcb_CMDTOUCH *cmd, uint32_t expiration);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdtouch_durability(lcb_CMDTOUCH *cmd, lcb_DURABILITY_LEVEL level);
@@ -2578,6 +2631,21 @@ LIBCOUCHBASE_API lcb_STATUS lcb_analytics(lcb_INSTANCE *instance, void *cookie,
  * @endcode
  */
 LIBCOUCHBASE_API lcb_STATUS lcb_analytics_cancel(lcb_INSTANCE *instance, lcb_ANALYTICS_HANDLE *handle);
+/**
+ * @uncommitted
+ * Stop reading the response for an in-progress request from the network, so that rows are not received faster
+ * than the application can process them. Rows which have already been read may still be delivered. The
+ * request timeout keeps running while the request is paused.
+ *
+ * @param instance the instance
+ * @param handle the handle for the request
+ */
+LIBCOUCHBASE_API lcb_STATUS lcb_analytics_pause(lcb_INSTANCE *instance, lcb_ANALYTICS_HANDLE *handle);
+/**
+ * @uncommitted
+ * Resume reading the response for a request paused with lcb_analytics_pause()
+ */
+LIBCOUCHBASE_API lcb_STATUS lcb_analytics_resume(lcb_INSTANCE *instance, lcb_ANALYTICS_HANDLE *handle);
 
 /** @} */
 
@@ -2679,6 +2747,21 @@ LIBCOUCHBASE_API lcb_STATUS lcb_search(lcb_INSTANCE *instance, void *cookie, con
  * @return LCB_SUCCESS if successful, otherwise an error.
  */
 LIBCOUCHBASE_API lcb_STATUS lcb_search_cancel(lcb_INSTANCE *instance, lcb_SEARCH_HANDLE *handle);
+/**
+ * @uncommitted
+ * Stop reading the response for an in-progress request from the network, so that rows are not received faster
+ * than the application can process them. Rows which have already been read may still be delivered. The
+ * request timeout keeps running while the request is paused.
+ *
+ * @param instance the instance
+ * @param handle the handle for the request
+ */
+LIBCOUCHBASE_API lcb_STATUS lcb_search_pause(lcb_INSTANCE *instance, lcb_SEARCH_HANDLE *handle);
+/**
+ * @uncommitted
+ * Resume reading the response for a request paused with lcb_search_pause()
+ */
+LIBCOUCHBASE_API lcb_STATUS lcb_search_resume(lcb_INSTANCE *instance, lcb_SEARCH_HANDLE *handle);
 /** @} */
 
 /**
@@ -3003,6 +3086,25 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdquery_consistency_tokens(lcb_CMDQUERY *cmd, l
  */
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdquery_option(lcb_CMDQUERY *cmd, const char *name, size_t name_len, const char *value,
                                                 size_t value_len);
+/**
+ * Set a query option to a value which is already encoded as JSON.
+ *
+ * Unlike lcb_cmdquery_option(), the value is not parsed, but copied into the
+ * request body as is, so the caller must make sure it is valid JSON. This is
+ * meant for large values such as the positional (`args`) or named (`$name`)
+ * parameters of the query. Options which the library reads itself
+ * (`statement`, `timeout`, `client_context_id`, `readonly`, `creds` and
+ * `query_context`) cannot be set this way.
+ *
+ * @param cmd the command
+ * @param name the name of the option
+ * @param name_len length of the name
+ * @param value the JSON encoded value of the option
+ * @param value_len length of the value
+ * @uncommitted
+ */
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdquery_option_raw(lcb_CMDQUERY *cmd, const char *name, size_t name_len,
+                                                    const char *value, size_t value_len);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdquery_handle(lcb_CMDQUERY *cmd, lcb_QUERY_HANDLE **handle);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdquery_timeout(lcb_CMDQUERY *cmd, uint32_t timeout);
 /**
@@ -3046,6 +3148,21 @@ LIBCOUCHBASE_API lcb_STATUS lcb_query(lcb_INSTANCE *instance, void *cookie, cons
  * @endcode
  */
 LIBCOUCHBASE_API lcb_STATUS lcb_query_cancel(lcb_INSTANCE *instance, lcb_QUERY_HANDLE *handle);
+/**
+ * @uncommitted
+ * Stop reading the response for an in-progress request from the network, so that rows are not received faster
+ * than the application can process them. Rows which have already been read may still be delivered. The
+ * request timeout keeps running while the request is paused.
+ *
+ * @param instance the instance
+ * @param handle the handle for the request
+ */
+LIBCOUCHBASE_API lcb_STATUS lcb_query_pause(lcb_INSTANCE *instance, lcb_QUERY_HANDLE *handle);
+/**
+ * @uncommitted
+ * Resume reading the response for a request paused with lcb_query_pause()
+ */
+LIBCOUCHBASE_API lcb_STATUS lcb_query_resume(lcb_INSTANCE *instance, lcb_QUERY_HANDLE *handle);
 /** @} */
 
 /**
@@ -3195,6 +3312,7 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdsubdoc_destroy(lcb_CMDSUBDOC *cmd);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdsubdoc_parent_span(lcb_CMDSUBDOC *cmd, lcbtrace_SPAN *span);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdsubdoc_collection(lcb_CMDSUBDOC *cmd, const char *scope, size_t scope_len,
                                                      const char *collection, size_t collection_len);
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdsubdoc_collection_id(lcb_CMDSUBDOC *cmd, uint32_t collection_id);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdsubdoc_key(lcb_CMDSUBDOC *cmd, const char *key, size_t key_len);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdsubdoc_cas(lcb_CMDSUBDOC *cmd, uint64_t cas);
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdsubdoc_specs(lcb_CMDSUBDOC *cmd, const lcb_SUBDOCSPECS *operations);
@@ -224,6 +224,89 @@ lcb_STATUS lcbmetrics_meter_cookie(const lcbmetrics_METER *meter, void **cookie)
 LIBCOUCHBASE_API
 void lcbmetrics_meter_destroy(const lcbmetrics_METER *meter);
 
+/**
+ * @brief Summary of the values recorded for a single operation.
+ *
+ * Latencies are expressed in microseconds.
+ */
+typedef struct {
+    const char *service;   /**< The service the operation was sent to, e.g. "kv" */
+    const char *operation; /**< The operation, e.g. "get" */
+    uint64_t total_count;  /**< The number of values recorded */
+    uint64_t p50;          /**< 50th percentile */
+    uint64_t p90;          /**< 90th percentile */
+    uint64_t p99;          /**< 99th percentile */
+    uint64_t p999;         /**< 99.9th percentile */
+    uint64_t p100;         /**< The largest value recorded */
+} lcbmetrics_SUMMARY;
+
+/**
+ * @brief Callback invoked once per operation by @ref lcbmetrics_meter_summarize.
+ *
+ * The summary, including its strings, is only valid for the duration of the callback.
+ */
+typedef void (*lcbmetrics_SUMMARY_CALLBACK)(const lcbmetrics_SUMMARY *summary, void *cookie);
+
+/**
+ * @brief Allocate a meter which aggregates operation latencies in memory.
+ *
+ * This is the same histogram based aggregation used by the default logging
+ * meter, but nothing is logged.  Instead the aggregated values can be read
+ * at any time with @ref lcbmetrics_meter_summarize.  Recording a value costs
+ * a single histogram update, with no callbacks into the application.
+ *
+ * Unlike other meters, this meter may be shared by several instances, and it
+ * is not destroyed by @ref lcb_destroy.  It must be destroyed with
+ * @ref lcbmetrics_meter_destroy once all instances using it are destroyed.
+ *
+ * @param meter A pointer for where to place the allocated meter.
+ * @return LCB_SUCCESS if successful, or LCB_ERR_UNSUPPORTED_OPERATION if the
+ *  library was built without histogram support.
+ *
+ * @uncommitted
+ */
+LIBCOUCHBASE_API
+lcb_STATUS lcbmetrics_meter_create_aggregating(lcbmetrics_METER **meter);
+
+/**
+ * @brief Read the values aggregated by a meter.
+ *
+ * @param meter A meter created with @ref lcbmetrics_meter_create_aggregating.
+ * @param reset If non-zero, the aggregated values are cleared once read.
+ * @param callback Invoked once for each operation which has been recorded.
+ * @param cookie Passed to the callback.
+ * @return LCB_SUCCESS if successful, or LCB_ERR_UNSUPPORTED_OPERATION if the
+ *  meter does not aggregate values.
+ *
+ * @uncommitted
+ */
+LIBCOUCHBASE_API
+lcb_STATUS lcbmetrics_meter_summarize(const lcbmetrics_METER *meter, int reset, lcbmetrics_SUMMARY_CALLBACK callback,
+                                      void *cookie);
+
+/**
+ * @brief Read a single percentile of the latencies aggregated for an operation.
+ *
+ * Unlike @ref lcbmetrics_meter_summarize this only reads the histogram of
+ * the given operation, which makes it cheap enough to be used when deciding
+ * how to schedule an operation.
+ *
+ * @param meter A meter created with @ref lcbmetrics_meter_create_aggregating.
+ * @param service The service of the operation, e.g. "kv".
+ * @param operation The name of the operation, e.g. "get".
+ * @param percentile The percentile to read, between 0 and 100.
+ * @param value Set to the latency at the percentile, in nanoseconds as it was
+ *  recorded, or to zero if nothing has been recorded for the operation.
+ * @return LCB_SUCCESS if successful, LCB_ERR_INVALID_ARGUMENT if the
+ *  percentile is out of range, or LCB_ERR_UNSUPPORTED_OPERATION if the meter
+ *  does not aggregate values.
+ *
+ * @uncommitted
+ */
+LIBCOUCHBASE_API
+lcb_STATUS lcbmetrics_meter_percentile(const lcbmetrics_METER *meter, const char *service, const char *operation,
+                                       double percentile, uint64_t *value);
+
 /** @} (Group: Operation Metrics) */
 
 #ifdef __cplusplus
@@ -400,6 +400,31 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdgetcid_collection(lcb_CMDGETCID *cmd, const c
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdgetcid_timeout(lcb_CMDGETCID *cmd, uint32_t timeout);
 
 LIBCOUCHBASE_API lcb_STATUS lcb_getcid(lcb_INSTANCE *instance, void *cookie, const lcb_CMDGETCID *cmd);
+
+/**
+ * @uncommitted
+ * Look up the ID of a collection in the cache of the instance, without contacting the cluster.
+ *
+ * IDs in the cache may be replaced or removed, for example when a collection was dropped and created again, which
+ * changes the generation of the cache. An ID copied out of the cache can therefore be reused for as long as
+ * lcb_collection_cache_generation() returns the generation that came with it.
+ *
+ * @param instance the instance
+ * @param scope the scope name (nullptr or empty for the default scope)
+ * @param collection the collection name (nullptr or empty for the default collection)
+ * @param[out] collection_id the ID of the collection
+ * @param[out] generation the current generation of the cache, may be nullptr
+ * @return LCB_ERR_COLLECTION_NOT_FOUND if the ID is not cached (yet)
+ */
+LIBCOUCHBASE_API lcb_STATUS lcb_collection_id_cached(lcb_INSTANCE *instance, const char *scope, size_t scope_len,
+                                                     const char *collection, size_t collection_len,
+                                                     uint32_t *collection_id, uint64_t *generation);
+
+/**
+ * @uncommitted
+ * Get the current generation of the collection cache of the instance, see lcb_collection_id_cached()
+ */
+LIBCOUCHBASE_API lcb_STATUS lcb_collection_cache_generation(lcb_INSTANCE *instance, uint64_t *generation);
 /** @} */
 
 /**
@@ -234,6 +234,22 @@ int lcbvb_load_json(lcbvb_CONFIG *vbc, const char *data);
 LIBCOUCHBASE_API
 int lcbvb_load_json_ex(lcbvb_CONFIG *vbc, const char *data, const char *source, char **network);
 
+/**
+ * @volatile
+ * Read the revision of a JSON configuration string without parsing it.
+ *
+ * Only the top-level `rev` and `revEpoch` members are looked at, which makes
+ * this much cheaper than lcbvb_load_json(). It can be used to find out whether
+ * a configuration is the same one which is already loaded.
+ *
+ * @param data NUL-terminated configuration string
+ * @param[out] revepoch the revision epoch, or `-1` if the config does not have one
+ * @param[out] revid the revision ID
+ * @return 0 on success, nonzero if the revision could not be found
+ */
+LIBCOUCHBASE_API
+int lcbvb_peek_revision(const char *data, int64_t *revepoch, int64_t *revid);
+
 /**@brief Serialize the current config as a JSON string.
  * @volatile
  * Serialize the current configuration as a JSON string. The string returned is
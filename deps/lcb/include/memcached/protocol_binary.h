@@ -381,6 +381,17 @@ typedef enum {
     PROTOCOL_BINARY_CMD_INVALID = 0xff
 } protocol_binary_command;
 
+/**
+ * Definition of the opcodes the server may send to the client in a
+ * PROTOCOL_BINARY_SREQ packet, once DUPLEX has been negotiated with HELLO.
+ */
+typedef enum {
+    /* Extras hold the revision (and epoch), key the bucket, value the map */
+    PROTOCOL_BINARY_CMD_SERVER_CLUSTERMAP_CHANGE_NOTIFICATION = 0x01,
+    PROTOCOL_BINARY_CMD_SERVER_AUTHENTICATE = 0x02,
+    PROTOCOL_BINARY_CMD_SERVER_ACTIVE_EXTERNAL_USERS = 0x03
+} protocol_binary_server_command;
+
 /**
  * Definition of the data types in the packet
  * See section 3.4 Data Types
@@ -819,7 +830,7 @@ typedef enum {
 } protocol_binary_hello_features;
 
 #define MEMCACHED_FIRST_HELLO_FEATURE 0x01
-#define MEMCACHED_TOTAL_HELLO_FEATURES 15
+#define MEMCACHED_TOTAL_HELLO_FEATURES 17
 
 // clang-format off
 #define protocol_feature_2_text(a) \
@@ -220,6 +220,7 @@
         'src/http/http.cc',
         'src/http/http_io.cc',
         'src/jsparse/parser.cc',
+        'src/jsparse/rowscanner.cc',
         'src/lcbht/lcbht.cc',
         'src/lcbio/connect.cc',
         'src/lcbio/ctx.cc',
@@ -299,6 +300,7 @@
         'src/iometrics.cc',
         'src/retrychk.cc',
         'src/retryq.cc',
+        'src/sharedcache.cc',
         'src/ringbuffer.c',
         'src/rnd.cc',
         'src/settings.cc',
@@ -116,3 +116,19 @@ LIBCOUCHBASE_API lcb_STATUS lcb_analytics_cancel(lcb_INSTANCE * /* instance */,
     }
     return LCB_SUCCESS;
 }
+
+LIBCOUCHBASE_API lcb_STATUS lcb_analytics_pause(lcb_INSTANCE * /* instance */, lcb_ANALYTICS_HANDLE *handle)
+{
+    if (handle == nullptr) {
+        return LCB_ERR_INVALID_ARGUMENT;
+    }
+    return handle->pause();
+}
+
+LIBCOUCHBASE_API lcb_STATUS lcb_analytics_resume(lcb_INSTANCE * /* instance */, lcb_ANALYTICS_HANDLE *handle)
+{
+    if (handle == nullptr) {
+        return LCB_ERR_INVALID_ARGUMENT;
+    }
+    return handle->resume();
+}
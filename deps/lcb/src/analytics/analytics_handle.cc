@@ -125,7 +125,7 @@ static void cb_docq_throttle(lcb::docreq::Queue *q, int enabled)
     }
     if (enabled) {
         req->http_request()->pause();
-    } else {
+    } else if (!req->is_paused()) {
         req->http_request()->resume();
     }
 }
@@ -289,10 +289,31 @@ lcb_STATUS lcb_ANALYTICS_HANDLE_::issue_htreq(const std::string &body)
         if (priority_) {
             http_request_->add_header("Analytics-Priority", "-1");
         }
+        if (paused_) {
+            http_request_->pause();
+        }
     }
     return rc;
 }
 
+lcb_STATUS lcb_ANALYTICS_HANDLE_::pause()
+{
+    paused_ = true;
+    if (http_request_ != nullptr) {
+        http_request_->pause();
+    }
+    return LCB_SUCCESS;
+}
+
+lcb_STATUS lcb_ANALYTICS_HANDLE_::resume()
+{
+    paused_ = false;
+    if (http_request_ != nullptr) {
+        http_request_->resume();
+    }
+    return LCB_SUCCESS;
+}
+
 bool lcb_ANALYTICS_HANDLE_::has_retriable_error(const Json::Value &root)
 {
     if (!root.isObject()) {
@@ -153,6 +153,18 @@ struct lcb_ANALYTICS_HANDLE_ : lcb::jsparse::Parser::Actions {
         return callback_ == nullptr;
     }
 
+    /**
+     * Stop reading the response from the network until resume() is called. Rows which have already been received
+     * may still be delivered.
+     */
+    lcb_STATUS pause();
+    lcb_STATUS resume();
+
+    bool is_paused() const
+    {
+        return paused_;
+    }
+
     lcb_STATUS cancel()
     {
         if (callback_ != nullptr) {
@@ -211,6 +223,7 @@ struct lcb_ANALYTICS_HANDLE_ : lcb::jsparse::Parser::Actions {
   private:
     const lcb_RESPHTTP *http_response_{nullptr};
     lcb_HTTP_HANDLE *http_request_{nullptr};
+    bool paused_{false};
     lcb::jsparse::Parser *parser_{nullptr};
     void *cookie_{nullptr};
     lcb_ANALYTICS_CALLBACK callback_{nullptr};
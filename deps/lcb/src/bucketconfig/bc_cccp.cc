@@ -209,6 +209,20 @@ lcb_STATUS CccpProvider::update(const char *host, const char *data)
     lcbvb_CONFIG *vbc;
     int rv;
     ConfigInfo *new_config;
+    int64_t revepoch, revid;
+
+    /* Most of the time the node sends back the config we already have, in
+     * which case there is no need to parse it again. A config without a
+     * bucket is never reused once one is expected, as it has to be upgraded */
+    if (config && config->vbc->revid >= 0 && (config->vbc->bname || !settings().bucket) &&
+        lcbvb_peek_revision(data, &revepoch, &revid) == 0 && revepoch == config->vbc->revepoch &&
+        revid == config->vbc->revid) {
+        lcb_log(LOGARGS(this, TRACE), LOGFMT "Config rev=%" PRId64 ":%" PRId64 " is unchanged, not parsing it",
+                LOGID(this), revepoch, revid);
+        parent->provider_got_config(this, config);
+        return LCB_SUCCESS;
+    }
+
     vbc = lcbvb_create();
 
     if (!vbc) {
@@ -27,7 +27,7 @@
 
 #define LOGARGS(pb, lvl) static_cast<Provider *>(pb)->parent->settings, "bc_file", LCB_LOG_##lvl, __FILE__, __LINE__
 #define LOGFMT "(cache=%s) "
-#define LOGID(fb) fb->filename.c_str()
+#define LOGID(fb) (fb->shared ? "<shared>" : fb->filename.c_str())
 
 using namespace lcb::clconfig;
 
@@ -37,6 +37,7 @@ struct FileProvider : Provider, Listener {
 
     enum Status { CACHE_ERROR, NO_CHANGES, UPDATED };
     Status load_cache();
+    Status load_shared();
     void reload_cache();
     void maybe_remove_file() const
     {
@@ -57,11 +58,40 @@ struct FileProvider : Provider, Listener {
     time_t last_mtime;
     int last_errno;
     bool is_readonly; /* Whether the config cache should _not_ overwrite the file */
+    std::shared_ptr<lcb::SharedCache> shared; /* Used instead of the file, if set */
+    std::uint64_t shared_generation;
     lcb::io::Timer<FileProvider, &FileProvider::reload_cache> timer;
 };
 
+FileProvider::Status FileProvider::load_shared()
+{
+    std::string json;
+    if (!shared->get_config(&shared_generation, json)) {
+        return config ? NO_CHANGES : CACHE_ERROR;
+    }
+
+    lcbvb_CONFIG *vbc = lcbvb_create();
+    if (vbc == nullptr) {
+        return CACHE_ERROR;
+    }
+    if (lcbvb_load_json(vbc, json.c_str()) != 0) {
+        lcb_log(LOGARGS(this, ERROR), LOGFMT "Couldn't parse configuration", LOGID(this));
+        lcbvb_destroy(vbc);
+        return CACHE_ERROR;
+    }
+
+    if (config) {
+        config->decref();
+    }
+    config = ConfigInfo::create(vbc, CLCONFIG_FILE, std::string());
+    return UPDATED;
+}
+
 FileProvider::Status FileProvider::load_cache()
 {
+    if (shared) {
+        return load_shared();
+    }
     if (filename.empty()) {
         return CACHE_ERROR;
     }
@@ -152,6 +182,13 @@ GT_DONE:
 
 void FileProvider::write_cache(lcbvb_CONFIG *cfg)
 {
+    if (shared) {
+        if (cfg->bname != nullptr && shared->put_config(cfg)) {
+            lcb_log(LOGARGS(this, DEBUG), LOGFMT "Published configuration rev=%" PRId64 ":%" PRId64, LOGID(this),
+                    cfg->revepoch, cfg->revid);
+        }
+        return;
+    }
     if (filename.empty() || is_readonly || cfg->bname == nullptr || cfg->bname_len == 0) {
         return;
     }
@@ -171,6 +208,11 @@ void FileProvider::write_cache(lcbvb_CONFIG *cfg)
 
 ConfigInfo *FileProvider::get_cached()
 {
+    if (shared) {
+        // Every refresh picks up what the other instances have seen first
+        load_shared();
+        return config;
+    }
     return filename.empty() ? nullptr : config;
 }
 
@@ -229,7 +271,7 @@ void FileProvider::dump(FILE *fp) const
 
 FileProvider::FileProvider(Confmon *parent_)
     : Provider(parent_, CLCONFIG_FILE), config(nullptr), last_mtime(0), last_errno(0), is_readonly(false),
-      timer(parent_->iot, this)
+      shared_generation(0), timer(parent_->iot, this)
 {
     parent->add_listener(this);
 }
@@ -300,6 +342,14 @@ void lcb::clconfig::file_set_readonly(Provider *p, bool val)
     static_cast<FileProvider *>(p)->is_readonly = val;
 }
 
+void lcb::clconfig::file_set_shared(Provider *p, std::shared_ptr<lcb::SharedCache> cache)
+{
+    auto *provider = static_cast<FileProvider *>(p);
+    provider->enabled = true;
+    provider->shared = std::move(cache);
+    provider->shared_generation = 0;
+}
+
 Provider *lcb::clconfig::new_file_provider(Confmon *mon)
 {
     return new FileProvider(mon);
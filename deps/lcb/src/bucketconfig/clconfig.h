@@ -19,6 +19,7 @@
 #define LCB_CLCONFIG_H
 
 #include "hostlist.h"
+#include "sharedcache.h"
 #include <list>
 #include <utility>
 #include <lcbio/timer-ng.h>
@@ -648,6 +649,14 @@ bool file_set_filename(Provider *p, const char *f, bool ro);
  */
 const char *file_get_filename(Provider *p);
 void file_set_readonly(Provider *p, bool val);
+
+/**
+ * Have the file provider use a cache shared with other instances in the
+ * process instead of a file. This also enables the file provider.
+ * @param p the provider
+ * @param cache the shared cache
+ */
+void file_set_shared(Provider *p, std::shared_ptr<SharedCache> cache);
 /**@}*/
 
 /**
@@ -253,6 +253,12 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdquery_option(lcb_CMDQUERY *cmd, const char *n
     return cmd->option(name, name_len, value, value_len);
 }
 
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdquery_option_raw(lcb_CMDQUERY *cmd, const char *name, size_t name_len,
+                                                    const char *value, size_t value_len)
+{
+    return cmd->option_raw(name, name_len, value, value_len);
+}
+
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdquery_handle(lcb_CMDQUERY *cmd, lcb_QUERY_HANDLE **handle)
 {
     return cmd->store_handle_refence_to(handle);
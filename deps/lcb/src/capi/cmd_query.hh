@@ -21,10 +21,78 @@
 #include <cstddef>
 #include <cstdint>
 #include <chrono>
+#include <string>
+#include <vector>
 
 #include "contrib/lcb-jsoncpp/lcb-jsoncpp.h"
 #include "collection_qualifier.hh"
 
+namespace lcb
+{
+/**
+ * @private
+ * Query option whose value the application already encoded as JSON, it is
+ * copied into the request body as is.
+ */
+struct query_raw_option {
+    std::string name;
+    std::string value;
+};
+
+/**
+ * @private
+ * Writes the request body for a query. Only the small options are kept in
+ * the Json::Value, the raw options (usually the parameters of the query) are
+ * appended to its members without being parsed or encoded again.
+ *
+ * @param body the options which are not raw, anything other than an object
+ *  is dropped when there are members to append
+ * @param raw_options the raw options
+ * @param fragment pre-encoded members to append (e.g. a prepared plan),
+ *  may be empty
+ * @param[out] out the body
+ */
+inline void write_query_body(const Json::Value &body, const std::vector<query_raw_option> &raw_options,
+                             const std::string &fragment, std::string &out)
+{
+    if (raw_options.empty() && fragment.empty()) {
+        out = Json::FastWriter().write(body);
+        return;
+    }
+
+    bool first = true;
+    if (body.isObject()) {
+        // Remove the closing brace (and newline) to append the other members
+        out = Json::FastWriter().write(body);
+        out.erase(out.rfind('}'));
+        first = body.empty();
+    } else {
+        // The body is still null when no other option was set, the other
+        // members make up the whole object
+        out.assign(1, '{');
+    }
+    std::size_t extra = fragment.size() + 2;
+    for (const auto &option : raw_options) {
+        extra += option.name.size() + option.value.size() + 4;
+    }
+    out.reserve(out.size() + extra);
+    for (const auto &option : raw_options) {
+        if (!first) {
+            out.append(1, ',');
+        }
+        first = false;
+        out.append(1, '"').append(option.name).append("\":", 2).append(option.value);
+    }
+    if (!fragment.empty()) {
+        if (!first) {
+            out.append(1, ',');
+        }
+        out.append(fragment);
+    }
+    out.append(1, '}');
+}
+} // namespace lcb
+
 /**
  * @private
  */
@@ -311,7 +379,7 @@ struct lcb_CMDQUERY_ {
 
     lcb_STATUS encode_payload()
     {
-        query_ = Json::FastWriter().write(root_);
+        lcb::write_query_body(root_, raw_options_, std::string(), query_);
         return LCB_SUCCESS;
     }
 
@@ -322,6 +390,7 @@ struct lcb_CMDQUERY_ {
             return LCB_ERR_INVALID_ARGUMENT;
         }
         root_ = value;
+        raw_options_.clear();
         return LCB_SUCCESS;
     }
 
@@ -348,7 +417,9 @@ struct lcb_CMDQUERY_ {
         if (!Json::Reader().parse(value, value + value_len, json_value)) {
             return LCB_ERR_INVALID_ARGUMENT;
         }
-        root_[std::string(name, name_len)] = json_value;
+        std::string key(name, name_len);
+        remove_raw_option(key);
+        root_[key] = json_value;
         return LCB_SUCCESS;
     }
 
@@ -361,6 +432,7 @@ struct lcb_CMDQUERY_ {
         if (!Json::Reader().parse(value, value + value_len, json_value)) {
             return LCB_ERR_INVALID_ARGUMENT;
         }
+        remove_raw_option(name);
         root_[name] = json_value;
         return LCB_SUCCESS;
     }
@@ -377,15 +449,53 @@ struct lcb_CMDQUERY_ {
         if (json_value.type() != Json::ValueType::arrayValue) {
             return LCB_ERR_INVALID_ARGUMENT;
         }
+        remove_raw_option(name);
         root_[name] = json_value;
         return LCB_SUCCESS;
     }
 
+    /**
+     * Sets an option to a value which is already encoded as JSON. The value
+     * is neither parsed nor validated, which keeps large values (such as the
+     * parameters of a query) from being decoded and encoded again. Options
+     * the library itself reads or fills in cannot be set this way.
+     */
+    lcb_STATUS option_raw(const char *name, std::size_t name_len, const char *value, std::size_t value_len)
+    {
+        if (name == nullptr || name_len == 0 || value == nullptr || value_len == 0) {
+            return LCB_ERR_INVALID_ARGUMENT;
+        }
+        std::string key(name, name_len);
+        for (char ch : key) {
+            // Names are copied as is as well, so they may not need escaping
+            if (ch == '"' || ch == '\\' || static_cast<unsigned char>(ch) < 0x20) {
+                return LCB_ERR_INVALID_ARGUMENT;
+            }
+        }
+        static const char *const inspected[] = {"statement", "timeout", "client_context_id",
+                                                "readonly",  "creds",   "query_context"};
+        for (const char *inspected_name : inspected) {
+            if (key == inspected_name) {
+                return LCB_ERR_INVALID_ARGUMENT;
+            }
+        }
+        root_.removeMember(key);
+        remove_raw_option(key);
+        raw_options_.push_back({std::move(key), std::string(value, value_len)});
+        return LCB_SUCCESS;
+    }
+
+    const std::vector<lcb::query_raw_option> &raw_options() const
+    {
+        return raw_options_;
+    }
+
     lcb_STATUS option_string(const std::string &name, const char *value, std::size_t value_len)
     {
         if (name.empty() || value == nullptr || value_len == 0) {
             return LCB_ERR_INVALID_ARGUMENT;
         }
+        remove_raw_option(name);
         root_[name] = std::string(value, value_len);
         return LCB_SUCCESS;
     }
@@ -395,6 +505,7 @@ struct lcb_CMDQUERY_ {
         timeout_ = std::chrono::milliseconds::zero();
         parent_span_ = nullptr;
         root_.clear();
+        raw_options_.clear();
         scope_.clear();
         scope_qualifier_.clear();
         query_.clear();
@@ -418,6 +529,16 @@ struct lcb_CMDQUERY_ {
     }
 
   private:
+    void remove_raw_option(const std::string &name)
+    {
+        for (auto it = raw_options_.begin(); it != raw_options_.end(); ++it) {
+            if (it->name == name) {
+                raw_options_.erase(it);
+                return;
+            }
+        }
+    }
+
     std::string scope_{};
     std::string scope_qualifier_{};
     std::chrono::microseconds timeout_{0};
@@ -430,6 +551,8 @@ struct lcb_CMDQUERY_ {
     bool use_multi_bucket_authentication_{false};
 
     Json::Value root_{};
+    /** Options which are already encoded, see option_raw() */
+    std::vector<lcb::query_raw_option> raw_options_{};
     /**Query to be placed in the POST request. The library will not perform
      * any conversions or validation on this string, so it is up to the user
      * (or wrapping library) to ensure that the string is well formed.
@@ -21,6 +21,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <chrono>
+#include <memory>
 
 #include "key_value_error_context.hh"
 #include "collection_qualifier.hh"
@@ -240,9 +241,45 @@ struct lcb_CMDSTORE_ {
     lcb_STATUS value(std::string value)
     {
         value_ = std::move(value);
+        borrowed_value_ = nullptr;
+        borrowed_value_size_ = 0;
+        borrowed_value_owner_.reset();
         return LCB_SUCCESS;
     }
 
+    /**
+     * Use a caller-owned buffer for the value instead of copying it. The owner is invoked once every copy of this
+     * command, and every packet built from it, has released the buffer.
+     */
+    lcb_STATUS value_nocopy(const char *value, std::size_t value_len, std::shared_ptr<void> owner)
+    {
+        value_.clear();
+        borrowed_value_ = value;
+        borrowed_value_size_ = value_len;
+        borrowed_value_owner_ = std::move(owner);
+        return LCB_SUCCESS;
+    }
+
+    bool has_borrowed_value() const
+    {
+        return borrowed_value_ != nullptr;
+    }
+
+    const char *value_data() const
+    {
+        return borrowed_value_ != nullptr ? borrowed_value_ : value_.c_str();
+    }
+
+    std::size_t value_size() const
+    {
+        return borrowed_value_ != nullptr ? borrowed_value_size_ : value_.size();
+    }
+
+    const std::shared_ptr<void> &borrowed_value_owner() const
+    {
+        return borrowed_value_owner_;
+    }
+
     lcb_STATUS value(const lcb_IOV *iov, std::size_t iov_len)
     {
         std::stringstream ss;
@@ -251,8 +288,7 @@ struct lcb_CMDSTORE_ {
                 ss << std::string(static_cast<const char *>(iov[i].iov_base), iov[i].iov_len);
             }
         }
-        value_ = ss.str();
-        return LCB_SUCCESS;
+        return value(ss.str());
     }
 
     lcb_STATUS collection(lcb::collection_qualifier collection)
@@ -380,6 +416,9 @@ struct lcb_CMDSTORE_ {
     std::uint32_t expiry_{0};
     std::string key_{};
     std::string value_{};
+    const char *borrowed_value_{nullptr};
+    std::size_t borrowed_value_size_{0};
+    std::shared_ptr<void> borrowed_value_owner_{};
     std::uint64_t cas_{0};
     std::uint32_t flags_{0};
     durability_mode durability_mode_{durability_mode::none};
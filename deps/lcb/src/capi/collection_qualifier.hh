@@ -21,7 +21,6 @@
 #include <cstddef>
 #include <cstdint>
 #include <string>
-#include <sstream>
 #include <stdexcept>
 
 namespace lcb
@@ -48,11 +47,6 @@ struct collection_qualifier {
         if (collection_name != nullptr && collection_name_len > 0) {
             collection_.assign(collection_name, collection_name_len);
         }
-        std::stringstream ss;
-        ss << (scope_.empty() ? "_default" : scope_);
-        ss << '.';
-        ss << (collection_.empty() ? "_default" : collection_);
-        spec_ = ss.str();
     }
 
     const std::string &scope() const
@@ -91,8 +85,18 @@ struct collection_qualifier {
         resolved_ = true;
     }
 
+    /**
+     * The path of the collection, this is only needed to resolve its ID
+     * and therefore built on first use.
+     */
     const std::string &spec() const
     {
+        if (spec_.empty()) {
+            spec_.reserve(scope_.size() + collection_.size() + 1);
+            spec_.append(scope_.empty() ? "_default" : scope_);
+            spec_.append(1, '.');
+            spec_.append(collection_.empty() ? "_default" : collection_);
+        }
         return spec_;
     }
 
@@ -137,7 +141,7 @@ struct collection_qualifier {
 
     std::string scope_{};
     std::string collection_{};
-    std::string spec_{};
+    mutable std::string spec_{};
     std::uint32_t resolved_collection_id_{0};
     bool resolved_{false};
 };
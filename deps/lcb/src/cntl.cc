@@ -17,6 +17,9 @@
 
 #include "internal.h"
 #include "bucketconfig/clconfig.h"
+#include "collections.h"
+#include "mc/compress.h"
+#include "n1ql/query_cache.hh"
 #include "contrib/lcb-jsoncpp/lcb-jsoncpp.h"
 #include <lcbio/iotable.h>
 #include <mcserver/negotiate.h>
@@ -631,6 +634,41 @@ HANDLER(n1ql_cache_clear_handler)
     return LCB_SUCCESS;
 }
 
+HANDLER(n1ql_cache_size_handler)
+{
+    if (mode == LCB_CNTL_SET) {
+        std::uint32_t capacity = *reinterpret_cast<std::uint32_t *>(arg);
+        if (capacity == 0) {
+            return LCB_ERR_CONTROL_INVALID_ARGUMENT;
+        }
+        instance->n1ql_cache->max_size(capacity);
+    } else {
+        *reinterpret_cast<std::uint32_t *>(arg) = static_cast<std::uint32_t>(instance->n1ql_cache->max_size());
+    }
+    (void)cmd;
+    return LCB_SUCCESS;
+}
+
+HANDLER(n1ql_cache_stats_handler)
+{
+    if (mode != LCB_CNTL_GET) {
+        return LCB_ERR_CONTROL_UNSUPPORTED_MODE;
+    }
+    instance->n1ql_cache->stats(reinterpret_cast<lcb_QUERY_CACHE_STATS *>(arg));
+    (void)cmd;
+    return LCB_SUCCESS;
+}
+
+HANDLER(compression_stats_handler)
+{
+    if (mode != LCB_CNTL_GET) {
+        return LCB_ERR_CONTROL_UNSUPPORTED_MODE;
+    }
+    mcreq_compress_policy_stats(LCBT_SETTING(instance, compress_policy), reinterpret_cast<lcb_COMPRESSION_STATS *>(arg));
+    (void)cmd;
+    return LCB_SUCCESS;
+}
+
 HANDLER(bucket_auth_handler)
 {
     const lcb_BUCKETCRED *cred;
@@ -725,6 +763,42 @@ HANDLER(unordered_execution_handler)
     RETURN_GET_SET(int, LCBT_SETTING(instance, enable_unordered_execution))
 }
 
+HANDLER(config_push_handler)
+{
+    RETURN_GET_SET(int, LCBT_SETTING(instance, enable_config_push))
+}
+
+HANDLER(kv_connections_handler)
+{
+    if (mode == LCB_CNTL_SET && *reinterpret_cast<std::uint32_t *>(arg) == 0) {
+        return LCB_ERR_CONTROL_INVALID_ARGUMENT;
+    }
+    RETURN_GET_SET(std::uint32_t, LCBT_SETTING(instance, kv_connections_per_node))
+}
+
+HANDLER(kv_large_value_handler)
+{
+    RETURN_GET_SET(std::uint32_t, LCBT_SETTING(instance, kv_large_value_threshold))
+}
+
+HANDLER(config_cache_shared_handler)
+{
+    if (mode != LCB_CNTL_SET) {
+        return LCB_ERR_CONTROL_UNSUPPORTED_MODE;
+    }
+    const char *name = reinterpret_cast<const char *>(arg);
+    if (name == nullptr || *name == '\0' || LCBT_SETTING(instance, bucket) == nullptr) {
+        return LCB_ERR_INVALID_ARGUMENT;
+    }
+
+    std::shared_ptr<lcb::SharedCache> cache = lcb::SharedCache::get(name, LCBT_SETTING(instance, bucket));
+    lcb::clconfig::file_set_shared(instance->confmon->get_provider(lcb::clconfig::CLCONFIG_FILE), cache);
+    instance->collcache->set_shared(cache);
+    instance->settings->bc_http_stream_time = LCB_MS2US(10000);
+    (void)cmd;
+    return LCB_SUCCESS;
+}
+
 /* clang-format off */
 static ctl_handler handlers[] = {
     timeout_common,                       /* LCB_CNTL_OP_TIMEOUT */
@@ -831,6 +905,13 @@ static ctl_handler handlers[] = {
     enable_errmap_handler,                /* LCB_CNTL_ENABLE_ERRMAP */
     timeout_common,                       /* LCB_CNTL_OP_METRICS_FLUSH_INTERVAL */
     enable_op_metrics_handler,            /* LCB_CNTL_ENABLE_OP_METRICS */
+    config_push_handler,                  /* LCB_CNTL_ENABLE_CONFIG_PUSH */
+    kv_connections_handler,               /* LCB_CNTL_KV_CONNECTIONS_PER_NODE */
+    kv_large_value_handler,               /* LCB_CNTL_KV_LARGE_VALUE_THRESHOLD */
+    config_cache_shared_handler,          /* LCB_CNTL_CONFIGCACHE_SHARED */
+    n1ql_cache_size_handler,              /* LCB_CNTL_QUERY_CACHE_SIZE */
+    n1ql_cache_stats_handler,             /* LCB_CNTL_QUERY_CACHE_STATS */
+    compression_stats_handler,            /* LCB_CNTL_COMPRESSION_STATS */
     nullptr
 };
 /* clang-format on */
@@ -1067,6 +1148,11 @@ static cntl_OPCODESTRS stropcode_map[] = {
     {"enable_errmap", LCB_CNTL_ENABLE_ERRMAP, convert_intbool},
     {"operation_metrics_flush_interval", LCB_CNTL_OP_METRICS_FLUSH_INTERVAL, convert_timevalue},
     {"enable_operation_metrics", LCB_CNTL_ENABLE_OP_METRICS, convert_intbool},
+    {"enable_config_push", LCB_CNTL_ENABLE_CONFIG_PUSH, convert_intbool},
+    {"kv_connections_per_node", LCB_CNTL_KV_CONNECTIONS_PER_NODE, convert_u32},
+    {"kv_large_value_threshold", LCB_CNTL_KV_LARGE_VALUE_THRESHOLD, convert_u32},
+    {"config_cache_shared", LCB_CNTL_CONFIGCACHE_SHARED, convert_passthru},
+    {"query_cache_size", LCB_CNTL_QUERY_CACHE_SIZE, convert_u32},
     {nullptr, -1}};
 
 #define CNTL_NUM_HANDLERS (sizeof(handlers) / sizeof(handlers[0]))
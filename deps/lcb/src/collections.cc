@@ -28,44 +28,253 @@
 
 namespace lcb
 {
+static const char default_name[] = "_default";
+static const size_t default_name_len = sizeof(default_name) - 1;
+static const size_t min_cache_capacity = 16;
+
+static void hash_update(uint64_t &hash, const char *buf, size_t nbuf)
+{
+    /* FNV-1a, so that the pieces of a path hash like the path itself */
+    for (size_t ii = 0; ii < nbuf; ii++) {
+        hash ^= static_cast<uint8_t>(buf[ii]);
+        hash *= 1099511628211ULL;
+    }
+}
+
+static uint64_t path_hash(const char *scope, size_t nscope, const char *collection, size_t ncollection)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    hash_update(hash, scope, nscope);
+    hash_update(hash, ".", 1);
+    hash_update(hash, collection, ncollection);
+    return hash;
+}
+
+static size_t id_hash(uint32_t cid)
+{
+    return static_cast<size_t>((cid * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
 CollectionCache::CollectionCache()
 {
     static const std::string default_collection("_default._default");
-    put(default_collection, 0);
+    rehash(min_cache_capacity);
+    store(default_collection, 0);
+}
+
+CollectionCache::Entry *CollectionCache::find(const char *scope, size_t nscope, const char *collection,
+                                              size_t ncollection, uint64_t hash)
+{
+    size_t mask = entries_.size() - 1;
+    for (size_t ii = hash & mask;; ii = (ii + 1) & mask) {
+        Entry &entry = entries_[ii];
+        if (entry.state == ENTRY_EMPTY) {
+            return nullptr;
+        }
+        if (entry.state == ENTRY_USED && entry.hash == hash && entry.path.size() == nscope + 1 + ncollection &&
+            memcmp(entry.path.data(), scope, nscope) == 0 && entry.path[nscope] == '.' &&
+            memcmp(entry.path.data() + nscope + 1, collection, ncollection) == 0) {
+            return &entry;
+        }
+    }
+}
+
+int32_t *CollectionCache::find_id(uint32_t cid)
+{
+    size_t mask = ids_.size() - 1;
+    for (size_t ii = id_hash(cid) & mask;; ii = (ii + 1) & mask) {
+        int32_t &slot = ids_[ii];
+        if (slot == SLOT_EMPTY) {
+            return nullptr;
+        }
+        if (slot >= 0 && entries_[slot].cid == cid) {
+            return &slot;
+        }
+    }
+}
+
+void CollectionCache::insert_id(uint32_t cid, int32_t index)
+{
+    size_t mask = ids_.size() - 1;
+    for (size_t ii = id_hash(cid) & mask;; ii = (ii + 1) & mask) {
+        int32_t &slot = ids_[ii];
+        if (slot < 0) {
+            if (slot == SLOT_EMPTY) {
+                nids_filled_++;
+            }
+            slot = index;
+            return;
+        }
+    }
+}
+
+void CollectionCache::reserve_one()
+{
+    if ((nfilled_ + 1) * 2 <= entries_.size() && (nids_filled_ + 1) * 2 <= ids_.size()) {
+        return;
+    }
+    size_t capacity = min_cache_capacity;
+    while (capacity < (nused_ + 1) * 4) {
+        capacity <<= 1;
+    }
+    rehash(capacity);
 }
 
-std::string CollectionCache::id_to_name(uint32_t cid)
+void CollectionCache::rehash(size_t capacity)
 {
-    std::map<uint32_t, std::string>::const_iterator pos = cache_i2n.find(cid);
-    if (pos != cache_i2n.end()) {
-        return pos->second;
+    std::vector<Entry> old_entries(capacity);
+    old_entries.swap(entries_);
+    std::vector<int32_t> old_ids(capacity, SLOT_EMPTY);
+    old_ids.swap(ids_);
+    std::vector<int32_t> moved(old_entries.size(), SLOT_EMPTY);
+
+    size_t mask = capacity - 1;
+    nfilled_ = nused_ = nids_filled_ = 0;
+    for (size_t ii = 0; ii < old_entries.size(); ii++) {
+        if (old_entries[ii].state != ENTRY_USED) {
+            continue;
+        }
+        size_t pos = old_entries[ii].hash & mask;
+        while (entries_[pos].state != ENTRY_EMPTY) {
+            pos = (pos + 1) & mask;
+        }
+        entries_[pos] = std::move(old_entries[ii]);
+        moved[ii] = static_cast<int32_t>(pos);
+        nfilled_++;
+        nused_++;
     }
-    return "";
+    /* Only the entries the ID index pointed to are found by their ID */
+    for (int32_t slot : old_ids) {
+        if (slot >= 0 && moved[slot] >= 0) {
+            insert_id(entries_[moved[slot]].cid, moved[slot]);
+        }
+    }
+}
+
+const std::string &CollectionCache::id_to_name(uint32_t cid)
+{
+    static const std::string unknown;
+    int32_t *slot = find_id(cid);
+    return slot ? entries_[*slot].path : unknown;
 }
 
 bool CollectionCache::get(const std::string &path, uint32_t *cid)
 {
-    std::map<std::string, uint32_t>::const_iterator pos = cache_n2i.find(path);
-    if (pos != cache_n2i.end()) {
-        *cid = pos->second;
+    size_t dot = path.find('.');
+    if (dot == std::string::npos) {
+        return false;
+    }
+    return get(path.data(), dot, path.data() + dot + 1, path.size() - dot - 1, cid);
+}
+
+bool CollectionCache::get(const char *scope, size_t nscope, const char *collection, size_t ncollection,
+                          uint32_t *cid)
+{
+    if (scope == nullptr || nscope == 0) {
+        scope = default_name;
+        nscope = default_name_len;
+    }
+    if (collection == nullptr || ncollection == 0) {
+        collection = default_name;
+        ncollection = default_name_len;
+    }
+
+    const Entry *entry = find(scope, nscope, collection, ncollection, path_hash(scope, nscope, collection, ncollection));
+    if (entry != nullptr) {
+        *cid = entry->cid;
         return true;
     }
+    if (shared_) {
+        std::string path = collcache_build_spec(scope, nscope, collection, ncollection);
+        if (shared_->get_cid(path, cid)) {
+            store(path, *cid);
+            return true;
+        }
+    }
     return false;
 }
 
+void CollectionCache::store(const std::string &path, uint32_t cid)
+{
+    size_t dot = path.find('.');
+    if (dot == std::string::npos) {
+        return;
+    }
+    const char *scope = path.data();
+    const char *collection = path.data() + dot + 1;
+    size_t ncollection = path.size() - dot - 1;
+    uint64_t hash = path_hash(scope, dot, collection, ncollection);
+
+    Entry *entry = find(scope, dot, collection, ncollection, hash);
+    if (entry != nullptr) {
+        if (entry->cid == cid) {
+            return;
+        }
+        /* The new ID takes another slot in the ID index, which may need to be
+         * rebuilt to keep an empty one (and moves the entries with it) */
+        reserve_one();
+        entry = find(scope, dot, collection, ncollection, hash);
+        int32_t *slot = find_id(entry->cid);
+        if (slot && &entries_[*slot] == entry) {
+            *slot = SLOT_DELETED;
+        }
+        entry->cid = cid;
+        generation_++;
+    } else {
+        reserve_one();
+        size_t mask = entries_.size() - 1;
+        size_t pos = hash & mask;
+        while (entries_[pos].state == ENTRY_USED) {
+            pos = (pos + 1) & mask;
+        }
+        entry = &entries_[pos];
+        if (entry->state == ENTRY_EMPTY) {
+            nfilled_++;
+        }
+        entry->path = path;
+        entry->hash = hash;
+        entry->cid = cid;
+        entry->state = ENTRY_USED;
+        nused_++;
+    }
+
+    auto index = static_cast<int32_t>(entry - entries_.data());
+    int32_t *slot = find_id(cid);
+    if (slot) {
+        *slot = index;
+    } else {
+        insert_id(cid, index);
+    }
+}
+
 void CollectionCache::put(const std::string &path, uint32_t cid)
 {
-    cache_n2i[path] = cid;
-    cache_i2n[cid] = path;
+    store(path, cid);
+    if (shared_) {
+        shared_->put_cid(path, cid);
+    }
 }
 
 void CollectionCache::erase(uint32_t cid)
 {
-    auto pos = cache_i2n.find(cid);
-    if (pos != cache_i2n.end()) {
-        cache_n2i.erase(pos->second);
-        cache_i2n.erase(pos);
+    int32_t *slot = find_id(cid);
+    if (slot == nullptr) {
+        return;
     }
+    Entry &entry = entries_[*slot];
+    if (shared_) {
+        shared_->erase_cid(entry.path, cid);
+    }
+    entry.state = ENTRY_DELETED;
+    entry.path.clear();
+    *slot = SLOT_DELETED;
+    nused_--;
+    generation_++;
+}
+
+void CollectionCache::set_shared(std::shared_ptr<SharedCache> shared)
+{
+    shared_ = std::move(shared);
 }
 } // namespace lcb
 
@@ -96,8 +305,7 @@ lcb_STATUS collcache_get(lcb_INSTANCE *instance, const char *scope, size_t nscop
         return LCB_ERR_UNSUPPORTED_OPERATION;
     }
 
-    std::string spec = collcache_build_spec(scope, nscope, collection, ncollection);
-    if (instance->collcache->get(spec, cid)) {
+    if (instance->collcache->get(scope, nscope, collection, ncollection, cid)) {
         return LCB_SUCCESS;
     }
     return LCB_ERR_COLLECTION_NOT_FOUND;
@@ -105,6 +313,10 @@ lcb_STATUS collcache_get(lcb_INSTANCE *instance, const char *scope, size_t nscop
 
 lcb_STATUS collcache_get(lcb_INSTANCE *instance, lcb::collection_qualifier &collection)
 {
+    if (collection.is_resolved()) {
+        /* The application already knew the ID */
+        return LCB_SUCCESS;
+    }
     uint32_t collection_id;
     lcb_STATUS rc = collcache_get(instance, collection.scope().c_str(), collection.scope().size(),
                                   collection.collection().c_str(), collection.collection().size(), &collection_id);
@@ -115,6 +327,23 @@ lcb_STATUS collcache_get(lcb_INSTANCE *instance, lcb::collection_qualifier &coll
     return LCB_SUCCESS;
 }
 
+LIBCOUCHBASE_API lcb_STATUS lcb_collection_id_cached(lcb_INSTANCE *instance, const char *scope, size_t scope_len,
+                                                     const char *collection, size_t collection_len,
+                                                     uint32_t *collection_id, uint64_t *generation)
+{
+    lcb_STATUS rc = collcache_get(instance, scope, scope_len, collection, collection_len, collection_id);
+    if (rc == LCB_SUCCESS && generation != nullptr) {
+        *generation = instance->collcache->generation();
+    }
+    return rc;
+}
+
+LIBCOUCHBASE_API lcb_STATUS lcb_collection_cache_generation(lcb_INSTANCE *instance, uint64_t *generation)
+{
+    *generation = instance->collcache->generation();
+    return LCB_SUCCESS;
+}
+
 LIBCOUCHBASE_API lcb_STATUS lcb_respgetmanifest_status(const lcb_RESPGETMANIFEST *resp)
 {
     return resp->ctx.rc;
@@ -20,18 +20,24 @@
 
 #ifdef __cplusplus
 #include <memory>
+#include <vector>
 
 #include "capi/cmd_getcid.hh"
 #include "capi/collection_qualifier.hh"
 #include "capi/deferred_command_context.hh"
+#include "sharedcache.h"
 
 namespace lcb
 {
+/**
+ * Maps collection paths ("scope.collection") to their IDs and back.
+ *
+ * Every operation looks up its collection here before it is scheduled, so
+ * both directions are flat open-addressing tables, and a collection can be
+ * looked up by its scope and collection names without building its path.
+ */
 class CollectionCache
 {
-    std::map<std::string, uint32_t> cache_n2i{};
-    std::map<uint32_t, std::string> cache_i2n{};
-
   public:
     CollectionCache();
 
@@ -39,11 +45,63 @@ class CollectionCache
 
     bool get(const std::string &path, uint32_t *cid);
 
+    /**
+     * Look up a collection by its names, empty names are "_default"
+     */
+    bool get(const char *scope, size_t nscope, const char *collection, size_t ncollection, uint32_t *cid);
+
     void put(const std::string &path, uint32_t cid);
 
-    std::string id_to_name(uint32_t cid);
+    /**
+     * @return the path of the collection, or an empty string if it is unknown
+     */
+    const std::string &id_to_name(uint32_t cid);
 
     void erase(uint32_t cid);
+
+    /**
+     * Also look up and store collection IDs in a cache shared with other
+     * instances, so that each of them does not have to resolve them again.
+     */
+    void set_shared(std::shared_ptr<SharedCache> shared);
+
+    /**
+     * Incremented whenever a cached ID is removed or replaced, so that IDs
+     * copied out of the cache can be checked for staleness.
+     */
+    uint64_t generation() const
+    {
+        return generation_;
+    }
+
+  private:
+    enum EntryState { ENTRY_EMPTY, ENTRY_USED, ENTRY_DELETED };
+
+    struct Entry {
+        std::string path{};
+        uint64_t hash{0};
+        uint32_t cid{0};
+        EntryState state{ENTRY_EMPTY};
+    };
+
+    enum : int32_t { SLOT_EMPTY = -1, SLOT_DELETED = -2 };
+
+    Entry *find(const char *scope, size_t nscope, const char *collection, size_t ncollection, uint64_t hash);
+    int32_t *find_id(uint32_t cid);
+    void store(const std::string &path, uint32_t cid);
+    void insert_id(uint32_t cid, int32_t index);
+    void reserve_one();
+    void rehash(size_t capacity);
+
+    /* Indexed by the hash of the path, these own the entries */
+    std::vector<Entry> entries_{};
+    /* Indexed by the ID, these point into entries_ */
+    std::vector<int32_t> ids_{};
+    size_t nused_{0};    /* live entries */
+    size_t nfilled_{0};  /* live and deleted entries in entries_ */
+    size_t nids_filled_{0};
+    uint64_t generation_{0};
+    std::shared_ptr<SharedCache> shared_{};
 };
 } // namespace lcb
 typedef lcb::CollectionCache lcb_COLLCACHE;
@@ -336,7 +336,7 @@ template <typename T>
 void invoke_callback(const mc_PACKET *pkt, lcb_INSTANCE *instance, T *resp, lcb_CALLBACK_TYPE cbtype)
 {
     if (instance != nullptr) {
-        std::string collection_path = instance->collcache->id_to_name(mcreq_get_cid(instance, pkt));
+        const std::string &collection_path = instance->collcache->id_to_name(mcreq_get_cid(instance, pkt));
         if (!collection_path.empty()) {
             size_t dot = collection_path.find('.');
             if (dot != std::string::npos) {
@@ -370,9 +370,10 @@ void invoke_callback(const mc_PACKET *pkt, mc_PIPELINE *pipeline, T *resp, lcb_C
  * @param resp The response received
  * @param[out] bytes pointer to the final payload
  * @param[out] nbytes pointer to the size of the final payload
- * @param[out] freeptr pointer to free. This should be initialized to `nullptr`.
- * If temporary dynamic storage is required this will be set to the allocated
- * pointer upon return. Otherwise it will be set to nullptr. In any case it must
+ * @param[out] freeptr pointer to hand back with mcreq_inflate_release(). This
+ * should be initialized to `nullptr`. If temporary storage is required this
+ * will be set to the pooled buffer upon return. Otherwise it will be set to
+ * nullptr.
  */
 template <typename T>
 static void maybe_decompress(lcb_INSTANCE *o, const MemcachedResponse *respkt, T *rescmd, void **freeptr)
@@ -389,7 +390,8 @@ static void maybe_decompress(lcb_INSTANCE *o, const MemcachedResponse *respkt, T
     if (respkt->datatype() & PROTOCOL_BINARY_DATATYPE_COMPRESSED) {
         if (LCBT_SETTING(o, compressopts) & LCB_COMPRESS_IN) {
             /* if we inflate, we don't set the flag */
-            mcreq_inflate_value(respkt->value(), respkt->vallen(), &rescmd->value, &rescmd->nvalue, freeptr);
+            mcreq_inflate_value_pooled(LCBT_SETTING(o, snappy_pool), respkt->value(), respkt->vallen(),
+                                       &rescmd->value, &rescmd->nvalue, freeptr);
 
         } else {
             /* user doesn't want inflation. signal it's compressed */
@@ -421,6 +423,10 @@ static void H_get(mc_PIPELINE *pipeline, mc_PACKET *request, MemcachedResponse *
 
     void *freeptr = nullptr;
     maybe_decompress(o, response, &resp, &freeptr);
+    if (freeptr != nullptr) {
+        /* the value no longer lives in the network buffer */
+        resp.bufh = nullptr;
+    }
     LCBTRACE_KV_FINISH(pipeline, request, resp, response->duration());
     TRACE_GET_END(o, request, response, &resp);
     record_kv_op_latency("get", o, request);
@@ -429,7 +435,7 @@ static void H_get(mc_PIPELINE *pipeline, mc_PACKET *request, MemcachedResponse *
     } else {
         invoke_callback(request, o, &resp, LCB_CALLBACK_GET);
     }
-    free(freeptr);
+    mcreq_inflate_release(LCBT_SETTING(o, snappy_pool), freeptr);
 }
 
 static void H_exists(mc_PIPELINE *pipeline, mc_PACKET *request, MemcachedResponse *response, lcb_STATUS immerr)
@@ -483,8 +489,11 @@ static void H_getreplica(mc_PIPELINE *pipeline, mc_PACKET *request, MemcachedRes
     }
 
     maybe_decompress(instance, response, &resp, &freeptr);
+    if (freeptr != nullptr) {
+        resp.bufh = nullptr;
+    }
     rd->procs->handler(pipeline, request, LCB_CALLBACK_GETREPLICA, resp.ctx.rc, &resp);
-    free(freeptr);
+    mcreq_inflate_release(LCBT_SETTING(instance, snappy_pool), freeptr);
 }
 
 static int lcb_sdresult_next(const lcb_RESPSUBDOC *resp, lcb_SDENTRY *ent, size_t *iter);
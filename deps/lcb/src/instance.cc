@@ -686,6 +686,13 @@ void lcb_destroy(lcb_INSTANCE *instance)
             if (server) {
                 server->instance = nullptr;
                 server->parent = nullptr;
+                for (unsigned jj = 0; jj < server->nsiblings; jj++) {
+                    lcb::Server *sibling = server->get_sibling(jj);
+                    if (sibling) {
+                        sibling->instance = nullptr;
+                        sibling->parent = nullptr;
+                    }
+                }
             }
         }
     }
@@ -790,8 +797,7 @@ lcb_STATUS lcb_open(lcb_INSTANCE *instance, const char *bucket, size_t bucket_le
     instance->settings->conntype = LCB_TYPE_BUCKET;
     instance->settings->bucket = (char *)calloc(bucket_len + 1, sizeof(char));
     memcpy(instance->settings->bucket, bucket, bucket_len);
-    for (unsigned ii = 0; ii < instance->cmdq.npipelines; ii++) {
-        auto *server = static_cast<lcb::Server *>(instance->cmdq.pipelines[ii]);
+    auto select_bucket = [bucket, bucket_len](lcb::Server *server) {
         if (!server->selected_bucket && server->connctx) {
             lcb::MemcachedRequest req(PROTOCOL_BINARY_CMD_SELECT_BUCKET);
             req.opaque(0xcafe);
@@ -801,6 +807,15 @@ lcb_STATUS lcb_open(lcb_INSTANCE *instance, const char *bucket, size_t bucket_le
             lcbio_ctx_put(server->connctx, bucket, bucket_len);
             server->flush();
         }
+    };
+    for (unsigned ii = 0; ii < instance->cmdq.npipelines; ii++) {
+        auto *server = static_cast<lcb::Server *>(instance->cmdq.pipelines[ii]);
+        select_bucket(server);
+        for (unsigned jj = 0; jj < server->nsiblings; jj++) {
+            if (server->get_sibling(jj)) {
+                select_bucket(server->get_sibling(jj));
+            }
+        }
     }
 
     return instance->bootstrap(BS_REFRESH_OPEN_BUCKET);
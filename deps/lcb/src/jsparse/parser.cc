@@ -24,6 +24,7 @@
 #include "contrib/jsonsl/jsonsl.c"
 #include "contrib/lcb-jsoncpp/lcb-jsoncpp.h"
 #include "parser.h"
+#include "rowscanner.h"
 
 #define DECLARE_JSONSL_CALLBACK(name)                                                                                  \
     static void name(jsonsl_t, jsonsl_action_t, struct jsonsl_state_st *, const char *)
@@ -242,7 +243,11 @@ void Parser::feed(const char *data_, size_t ndata)
 {
     size_t old_len = current_buf.size();
     current_buf.append(data_, ndata);
-    jsonsl_feed(jsn, current_buf.c_str() + old_len, ndata);
+    if (scanner) {
+        scanner->scan(*this);
+    } else {
+        jsonsl_feed(jsn, current_buf.c_str() + old_len, ndata);
+    }
 
     /* Do we need to cut off some bytes? */
     if (keep_pos > min_pos) {
@@ -267,9 +272,9 @@ const char *Parser::jprstr_for_mode(Mode mode)
     }
 }
 
-Parser::Parser(Mode mode_, Parser::Actions *actions_)
+Parser::Parser(Mode mode_, Parser::Actions *actions_, bool scan_rows)
     : jsn(jsonsl_new(512)), jsn_rdetails(jsonsl_new(32)), jpr(jsonsl_jpr_new(jprstr_for_mode(mode_), nullptr)),
-      mode(mode_), have_error(0), initialized(0), meta_complete(0), rowcount(0), min_pos(0), keep_pos(0), header_len(0),
+      scanner(nullptr), mode(mode_), have_error(0), initialized(0), meta_complete(0), rowcount(0), min_pos(0), keep_pos(0), header_len(0),
       last_row_endpos(0), cxx_data(), actions(actions_)
 {
 
@@ -288,6 +293,20 @@ Parser::Parser(Mode mode_, Parser::Actions *actions_)
     jsn->max_callback_level = 4;
     jsn->data = this;
     jsonsl_enable_all_callbacks(jsn);
+
+    if (scan_rows && RowScanner::supported()) {
+        switch (mode_) {
+            case MODE_N1QL:
+            case MODE_ANALYTICS:
+                scanner = new RowScanner("results");
+                break;
+            case MODE_FTS:
+                scanner = new RowScanner("hits");
+                break;
+            default:
+                break;
+        }
+    }
 }
 
 void Parser::get_postmortem(lcb_IOV &out) const
@@ -303,6 +322,7 @@ void Parser::get_postmortem(lcb_IOV &out) const
 
 Parser::~Parser()
 {
+    delete scanner;
     jsonsl_jpr_match_state_cleanup(jsn);
     jsonsl_destroy(jsn);
     jsonsl_destroy(jsn_rdetails);
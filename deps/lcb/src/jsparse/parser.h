@@ -28,6 +28,7 @@ namespace jsparse
 {
 
 struct Parser;
+class RowScanner;
 
 struct Row {
     lcb_IOV docid{};
@@ -71,8 +72,11 @@ struct Parser {
      * You must set callbacks on this object if you wish it to be useful.
      * You must feed it data (calling vrow_feed) as well. The data may be fed
      * in chunks and callbacks will be invoked as each row is read.
+     *
+     * Unless scan_rows is false, the rows of N1QL, analytics and FTS
+     * responses are found by the RowScanner when the CPU supports it.
      */
-    Parser(Mode mode, Actions *actions_);
+    Parser(Mode mode, Actions *actions_, bool scan_rows = true);
     ~Parser();
 
     /**
@@ -107,12 +111,13 @@ struct Parser {
     void get_postmortem(lcb_IOV &out) const;
 
     inline const char *get_buffer_region(size_t pos, size_t desired, size_t *actual) const;
-    inline void combine_meta();
+    void combine_meta();
     inline static const char *jprstr_for_mode(Mode);
 
     jsonsl_t jsn;            /**< Parser for the row itself */
     jsonsl_t jsn_rdetails;   /**< Parser for the row details */
     jsonsl_jpr_t jpr;        /**< jsonpointer match object */
+    RowScanner *scanner;     /**< Used instead of jsn when set */
     std::string meta_buf;    /**< String containing the skeleton (outer layer) */
     std::string current_buf; /**< Scratch/read buffer */
     std::string last_hk;     /**< Last hashkey */
@@ -0,0 +1,533 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "rowscanner.h"
+#include "parser.h"
+
+#include <cstring>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__)) ||                          \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LCB_ROWSCANNER_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || (defined(_MSC_VER) && _MSC_VER >= 1800)
+#define LCB_ROWSCANNER_AVX2 1
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__)
+#define LCB_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define LCB_TARGET_AVX2
+#endif
+
+using namespace lcb::jsparse;
+
+namespace
+{
+inline unsigned trailing_zeroes(std::uint64_t bits)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanForward(&index, static_cast<std::uint32_t>(bits))) {
+        return index;
+    }
+    _BitScanForward(&index, static_cast<std::uint32_t>(bits >> 32));
+    return index + 32;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+/** Sets every bit from each quote up to (not including) the next one */
+inline std::uint64_t prefix_xor(std::uint64_t bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+inline bool is_space(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+#ifdef LCB_ROWSCANNER_AVX2
+bool cpu_has_avx2()
+{
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    // OSXSAVE and AVX, and the OS must save the YMM registers
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#endif
+}
+
+LCB_TARGET_AVX2 inline std::uint64_t avx2_eq(__m256i lo, __m256i hi, char c)
+{
+    __m256i needle = _mm256_set1_epi8(c);
+    std::uint64_t low = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, needle)));
+    std::uint64_t high = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, needle)));
+    return low | (high << 32);
+}
+#endif
+
+#ifdef LCB_ROWSCANNER_SSE2
+inline std::uint64_t sse2_eq(const __m128i *chunks, char c)
+{
+    __m128i needle = _mm_set1_epi8(c);
+    std::uint64_t bits = 0;
+    for (int ii = 0; ii < 4; ii++) {
+        bits |= static_cast<std::uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunks[ii], needle))) << (ii * 16);
+    }
+    return bits;
+}
+#endif
+} // namespace
+
+RowScanner::RowScanner(std::string rows_key) : rows_key_(std::move(rows_key)) {}
+
+bool RowScanner::supported()
+{
+#ifdef LCB_ROWSCANNER_SSE2
+    return true;
+#else
+    return false;
+#endif
+}
+
+void RowScanner::scan(Parser &parser)
+{
+    const char *buf = parser.current_buf.data() - parser.min_pos;
+    std::size_t end = parser.min_pos + parser.current_buf.size();
+
+    while (phase_ == PHASE_START && scan_pos_ < end) {
+        char c = buf[scan_pos_++];
+        if (is_space(c)) {
+            continue;
+        }
+        if (c != '{') {
+            fail(parser);
+            break;
+        }
+        open(c);
+        phase_ = PHASE_HEADER;
+    }
+
+    if (phase_ != PHASE_DONE && scan_pos_ < end) {
+        std::size_t len = end - scan_pos_;
+        std::size_t done = 0;
+#ifdef LCB_ROWSCANNER_AVX2
+        static const bool use_avx2 = cpu_has_avx2();
+        if (use_avx2) {
+            done = scan_blocks_avx2(parser, buf + scan_pos_, len, scan_pos_);
+        } else {
+            done = scan_blocks_sse2(parser, buf + scan_pos_, len, scan_pos_);
+        }
+#else
+        done = scan_blocks_sse2(parser, buf + scan_pos_, len, scan_pos_);
+#endif
+        if (phase_ != PHASE_DONE) {
+            scan_tail(parser, buf + scan_pos_ + done, len - done, scan_pos_ + done);
+        }
+    }
+    scan_pos_ = end;
+}
+
+#ifdef LCB_ROWSCANNER_AVX2
+LCB_TARGET_AVX2 std::size_t RowScanner::scan_blocks_avx2(Parser &parser, const char *data, std::size_t len,
+                                                         std::size_t pos)
+{
+    std::size_t off = 0;
+    for (; off + 64 <= len && phase_ != PHASE_DONE; off += 64) {
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + off));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + off + 32));
+        // '[' and '{' (and ']' and '}') only differ in the 0x20 bit
+        __m256i lo_folded = _mm256_or_si256(lo, _mm256_set1_epi8(0x20));
+        __m256i hi_folded = _mm256_or_si256(hi, _mm256_set1_epi8(0x20));
+
+        Masks masks;
+        masks.quote = avx2_eq(lo, hi, '"');
+        masks.backslash = avx2_eq(lo, hi, '\\');
+        masks.structural =
+            avx2_eq(lo_folded, hi_folded, '{') | avx2_eq(lo_folded, hi_folded, '}') | avx2_eq(lo, hi, ',');
+        masks.colon = avx2_eq(lo, hi, ':');
+        process_block(parser, data + off, pos + off, masks);
+    }
+    return off;
+}
+#else
+std::size_t RowScanner::scan_blocks_avx2(Parser &, const char *, std::size_t, std::size_t)
+{
+    return 0;
+}
+#endif
+
+std::size_t RowScanner::scan_blocks_sse2(Parser &parser, const char *data, std::size_t len, std::size_t pos)
+{
+    std::size_t off = 0;
+#ifdef LCB_ROWSCANNER_SSE2
+    for (; off + 64 <= len && phase_ != PHASE_DONE; off += 64) {
+        __m128i chunks[4], folded[4];
+        for (int ii = 0; ii < 4; ii++) {
+            chunks[ii] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + off + ii * 16));
+            folded[ii] = _mm_or_si128(chunks[ii], _mm_set1_epi8(0x20));
+        }
+
+        Masks masks;
+        masks.quote = sse2_eq(chunks, '"');
+        masks.backslash = sse2_eq(chunks, '\\');
+        masks.structural = sse2_eq(folded, '{') | sse2_eq(folded, '}') | sse2_eq(chunks, ',');
+        masks.colon = sse2_eq(chunks, ':');
+        process_block(parser, data + off, pos + off, masks);
+    }
+#else
+    (void)parser;
+    (void)data;
+    (void)len;
+    (void)pos;
+#endif
+    return off;
+}
+
+/**
+ * Works out which of the structural characters are outside of strings and
+ * hands them to handle(). The state at the end of the block is carried over
+ * to the next one in prev_odd_backslash_ (the next character is escaped) and
+ * prev_in_string_ (all ones when the block ended inside of a string).
+ */
+void RowScanner::process_block(Parser &parser, const char *data, std::size_t pos, const Masks &masks)
+{
+    static const std::uint64_t even_bits = 0x5555555555555555ULL;
+    static const std::uint64_t odd_bits = ~even_bits;
+
+    // A character is escaped when it follows an odd number of backslashes.
+    // Each run of backslashes is added to its start bit, and the carry
+    // lands on the first character after the run. Whether the run's length
+    // was odd follows from whether it started on an even or an odd bit.
+    std::uint64_t backslash = masks.backslash;
+    std::uint64_t starts = backslash & ~(backslash << 1);
+    std::uint64_t even_start_mask = even_bits ^ prev_odd_backslash_;
+    std::uint64_t even_starts = starts & even_start_mask;
+    std::uint64_t odd_starts = starts & ~even_start_mask;
+    std::uint64_t even_carries = backslash + even_starts;
+    std::uint64_t odd_carries = backslash + odd_starts;
+    std::uint64_t carried_out = odd_carries < backslash ? 1 : 0;
+    odd_carries |= prev_odd_backslash_;
+    prev_odd_backslash_ = carried_out;
+    std::uint64_t escaped =
+        ((even_carries & ~backslash) & odd_bits) | ((odd_carries & ~backslash) & even_bits);
+
+    std::uint64_t quotes = masks.quote & ~escaped;
+    std::uint64_t in_string = prefix_xor(quotes) ^ prev_in_string_;
+    prev_in_string_ = static_cast<std::uint64_t>(static_cast<std::int64_t>(in_string) >> 63);
+
+    // Inside of the rows only the brackets and commas matter; outside of
+    // them the members of the root object are followed as well.
+    std::uint64_t row_bits = masks.structural & ~in_string;
+    std::uint64_t skeleton_bits = row_bits | (masks.colon & ~in_string) | quotes;
+
+    Phase phase = phase_;
+    std::uint64_t bits = phase == PHASE_ROWS ? row_bits : skeleton_bits;
+    while (bits != 0) {
+        unsigned ii = trailing_zeroes(bits);
+        handle(parser, data[ii], pos + ii);
+        if (phase_ == phase) {
+            bits &= bits - 1;
+            continue;
+        }
+        if (phase_ == PHASE_DONE) {
+            return;
+        }
+        phase = phase_;
+        bits = (phase == PHASE_ROWS ? row_bits : skeleton_bits) & ~((std::uint64_t(2) << ii) - 1);
+    }
+}
+
+/** The same as process_block(), a byte at a time */
+void RowScanner::scan_tail(Parser &parser, const char *data, std::size_t len, std::size_t pos)
+{
+    bool escaped = prev_odd_backslash_ != 0;
+    bool in_string = prev_in_string_ != 0;
+
+    for (std::size_t ii = 0; ii < len && phase_ != PHASE_DONE; ii++) {
+        char c = data[ii];
+        if (escaped) {
+            escaped = false;
+            continue;
+        }
+        if (c == '\\') {
+            escaped = true;
+            continue;
+        }
+        if (c == '"') {
+            in_string = !in_string;
+            if (phase_ != PHASE_ROWS) {
+                handle(parser, c, pos + ii);
+            }
+            continue;
+        }
+        if (in_string) {
+            continue;
+        }
+        char folded = static_cast<char>(c | 0x20);
+        if (folded == '{' || folded == '}' || c == ',' || (c == ':' && phase_ != PHASE_ROWS)) {
+            handle(parser, c, pos + ii);
+        }
+    }
+
+    prev_odd_backslash_ = escaped ? 1 : 0;
+    prev_in_string_ = in_string ? ~std::uint64_t(0) : 0;
+}
+
+void RowScanner::handle(Parser &parser, char c, std::size_t pos)
+{
+    if (phase_ == PHASE_ROWS) {
+        handle_row(parser, c, pos);
+    } else if (phase_ != PHASE_DONE) {
+        handle_skeleton(parser, c, pos);
+    }
+}
+
+/**
+ * Follows the members of the root object, looking for the rows array in
+ * the header. Anything nested deeper is only checked for matching brackets.
+ */
+void RowScanner::handle_skeleton(Parser &parser, char c, std::size_t pos)
+{
+    switch (c) {
+        case '"':
+            if (depth_ != 1) {
+                return;
+            }
+            switch (member_) {
+                case MEMBER_KEY:
+                    member_ = MEMBER_IN_KEY;
+                    key_begin_ = pos + 1;
+                    return;
+                case MEMBER_IN_KEY:
+                    member_ = MEMBER_COLON;
+                    rows_key_matched_ =
+                        phase_ == PHASE_HEADER && pos - key_begin_ == rows_key_.size() &&
+                        std::memcmp(parser.current_buf.data() + (key_begin_ - parser.min_pos), rows_key_.data(),
+                                    rows_key_.size()) == 0;
+                    return;
+                case MEMBER_VALUE:
+                    member_ = MEMBER_IN_VALUE;
+                    return;
+                case MEMBER_IN_VALUE:
+                    member_ = MEMBER_NEXT;
+                    return;
+                default:
+                    fail(parser);
+                    return;
+            }
+
+        case ':':
+            if (depth_ != 1) {
+                return;
+            }
+            if (member_ != MEMBER_COLON) {
+                fail(parser);
+                return;
+            }
+            member_ = MEMBER_VALUE;
+            return;
+
+        case ',':
+            if (depth_ != 1) {
+                return;
+            }
+            // A number, true, false or null is the only thing which can
+            // come straight after the colon
+            if (member_ != MEMBER_VALUE && member_ != MEMBER_NEXT) {
+                fail(parser);
+                return;
+            }
+            member_ = MEMBER_KEY;
+            return;
+
+        case '{':
+        case '[':
+            if (depth_ == 1) {
+                if (member_ != MEMBER_VALUE) {
+                    fail(parser);
+                    return;
+                }
+                member_ = MEMBER_NEXT;
+                if (c == '[' && phase_ == PHASE_HEADER && rows_key_matched_) {
+                    // The header is everything up to and including the '['
+                    parser.meta_buf.append(parser.current_buf.data(), pos + 1 - parser.min_pos);
+                    parser.header_len = pos + 1;
+                    parser.keep_pos = pos + 1;
+                    row_begin_ = pos + 1;
+                    row_is_container_ = false;
+                    phase_ = PHASE_ROWS;
+                }
+            }
+            open(c);
+            return;
+
+        default:
+            if (!close(c)) {
+                fail(parser);
+                return;
+            }
+            if (depth_ != 0) {
+                return;
+            }
+            if (phase_ == PHASE_TRAILER) {
+                parser.combine_meta();
+                if (parser.actions) {
+                    parser.actions->JSPARSE_on_complete(parser.meta_buf);
+                    parser.actions = nullptr;
+                }
+            }
+            phase_ = PHASE_DONE;
+            return;
+    }
+}
+
+void RowScanner::handle_row(Parser &parser, char c, std::size_t pos)
+{
+    switch (c) {
+        case '{':
+        case '[':
+            if (depth_ == 2) {
+                row_begin_ = pos;
+                row_is_container_ = true;
+            }
+            open(c);
+            return;
+
+        case ',':
+            if (depth_ != 2) {
+                return;
+            }
+            if (!row_is_container_) {
+                emit_scalar(parser, pos);
+            }
+            row_begin_ = pos + 1;
+            row_is_container_ = false;
+            parser.keep_pos = row_begin_;
+            return;
+
+        default:
+            if (!close(c)) {
+                fail(parser);
+                return;
+            }
+            if (depth_ == 2) {
+                emit(parser, row_begin_, pos + 1);
+                parser.keep_pos = pos + 1;
+            } else if (depth_ == 1) {
+                // The end of the rows, the rest is the trailer
+                if (!row_is_container_) {
+                    emit_scalar(parser, pos);
+                }
+                parser.last_row_endpos = pos;
+                parser.keep_pos = pos;
+                phase_ = PHASE_TRAILER;
+            }
+            return;
+    }
+}
+
+/** Emits the row between row_begin_ and end, unless there is nothing there */
+void RowScanner::emit_scalar(Parser &parser, std::size_t end)
+{
+    const char *buf = parser.current_buf.data() - parser.min_pos;
+    std::size_t begin = row_begin_;
+    while (begin < end && is_space(buf[begin])) {
+        begin++;
+    }
+    while (end > begin && is_space(buf[end - 1])) {
+        end--;
+    }
+    if (begin != end) {
+        emit(parser, begin, end);
+    }
+}
+
+void RowScanner::emit(Parser &parser, std::size_t begin, std::size_t end)
+{
+    parser.rowcount++;
+    if (!parser.actions) {
+        return;
+    }
+    Row dt{};
+    dt.row.iov_base = const_cast<char *>(parser.current_buf.data() + (begin - parser.min_pos));
+    dt.row.iov_len = end - begin;
+    parser.actions->JSPARSE_on_row(dt);
+}
+
+void RowScanner::open(char c)
+{
+    if (depth_ < 64) {
+        brackets_ = (brackets_ << 1) | (c == '[' ? 1 : 0);
+    }
+    depth_++;
+}
+
+bool RowScanner::close(char c)
+{
+    if (depth_ == 0) {
+        return false;
+    }
+    if (depth_ <= 64) {
+        if ((brackets_ & 1) != (c == ']' ? 1U : 0U)) {
+            return false;
+        }
+        brackets_ >>= 1;
+    }
+    depth_--;
+    return true;
+}
+
+void RowScanner::fail(Parser &parser)
+{
+    phase_ = PHASE_DONE;
+    parser.have_error = 1;
+    if (parser.actions) {
+        parser.actions->JSPARSE_on_error(parser.current_buf);
+        parser.actions = nullptr;
+    }
+}
@@ -0,0 +1,117 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#ifndef LCB_JSPARSE_ROWSCANNER_H_
+#define LCB_JSPARSE_ROWSCANNER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace lcb
+{
+namespace jsparse
+{
+
+struct Parser;
+
+/**
+ * Splits the rows out of a query response without parsing them.
+ *
+ * jsonsl visits every byte of the response with a full state machine, even
+ * though all the Parser needs is where each element of the rows array begins
+ * and ends. This scanner classifies 64 bytes at a time with SSE2 or AVX2
+ * (like the first stage of simdjson): it finds the quotes which are not
+ * escaped, masks out everything between them, and only looks at the brackets
+ * and commas which remain.
+ *
+ * Only the skeleton of the response is validated: the root must be an object
+ * whose members are well formed and the brackets must match. The rows
+ * themselves are passed on as they are, the consumers parse them anyway.
+ */
+class RowScanner
+{
+  public:
+    /** @param rows_key the member of the root object which holds the rows */
+    explicit RowScanner(std::string rows_key);
+
+    /**
+     * Whether the CPU can run the scanner. When it can't, the parser
+     * continues to use jsonsl.
+     */
+    static bool supported();
+
+    /**
+     * Scans everything in the parser's buffer which has not been seen yet,
+     * invoking its callbacks for any rows (and the meta) found there.
+     */
+    void scan(Parser &parser);
+
+  private:
+    enum Phase { PHASE_START, PHASE_HEADER, PHASE_ROWS, PHASE_TRAILER, PHASE_DONE };
+
+    /** What is expected next inside of the root object */
+    enum Member { MEMBER_KEY, MEMBER_IN_KEY, MEMBER_COLON, MEMBER_VALUE, MEMBER_IN_VALUE, MEMBER_NEXT };
+
+    struct Masks {
+        std::uint64_t quote;
+        std::uint64_t backslash;
+        std::uint64_t structural; /**< brackets and commas */
+        std::uint64_t colon;
+    };
+
+    std::size_t scan_blocks_sse2(Parser &parser, const char *data, std::size_t len, std::size_t pos);
+    std::size_t scan_blocks_avx2(Parser &parser, const char *data, std::size_t len, std::size_t pos);
+    void scan_tail(Parser &parser, const char *data, std::size_t len, std::size_t pos);
+    inline void process_block(Parser &parser, const char *data, std::size_t pos, const Masks &masks);
+    inline void handle(Parser &parser, char c, std::size_t pos);
+    void handle_skeleton(Parser &parser, char c, std::size_t pos);
+    void handle_row(Parser &parser, char c, std::size_t pos);
+    void emit_scalar(Parser &parser, std::size_t end);
+    void emit(Parser &parser, std::size_t begin, std::size_t end);
+    void open(char c);
+    bool close(char c);
+    void fail(Parser &parser);
+
+    std::string rows_key_;
+    Phase phase_{PHASE_START};
+    Member member_{MEMBER_KEY};
+
+    /** absolute position of the next byte to classify */
+    std::size_t scan_pos_{0};
+
+    /** carried between blocks, see process_block() */
+    std::uint64_t prev_in_string_{0};
+    std::uint64_t prev_odd_backslash_{0};
+
+    std::size_t depth_{0};
+    /** bit per level, set for arrays. Only the outermost 64 levels are checked */
+    std::uint64_t brackets_{0};
+
+    /** start of the key in the root object currently being read */
+    std::size_t key_begin_{0};
+    bool rows_key_matched_{false};
+
+    /** first byte after the '[' or ',' preceding the current row */
+    std::size_t row_begin_{0};
+    /** whether the current row is an array or object (rather than a scalar) */
+    bool row_is_container_{false};
+};
+
+} // namespace jsparse
+} // namespace lcb
+#endif /* LCB_JSPARSE_ROWSCANNER_H_ */
@@ -17,9 +17,191 @@
 
 #include "mcreq.h"
 #include "compress.h"
+#include "metrics/metrics-internal.h"
 
 #include <snappy.h>
 #include <snappy-sinksource.h>
+#include <cstdlib>
+#include <vector>
+
+/**
+ * A small direct mapped table of compression ratios. Each collection and key
+ * prefix hashes to a slot, which holds a moving average of the ratios of its
+ * values. While the average is above the minimum ratio the values of the
+ * prefix are sent as they are, except for every probe_interval'th one, which
+ * is compressed to notice when the data changes. Prefixes sharing a slot
+ * simply take it over from each other.
+ */
+struct mc_COMPRESSPOLICY_st {
+    enum { nslots = 256, probe_interval = 32 };
+
+    struct Slot {
+        std::uint32_t hash{0};
+        std::uint32_t samples{0};
+        std::uint32_t skipped{0};
+        float ratio{0};
+    };
+
+    Slot slots[nslots];
+    lcb_COMPRESSION_STATS stats{};
+
+    static std::uint32_t hash_prefix(std::uint32_t cid, const char *key, std::size_t nkey)
+    {
+        // FNV-1a of the collection and the key up to the first separator
+        std::uint32_t hash = 2166136261U;
+        for (int ii = 0; ii < 4; ii++) {
+            hash = (hash ^ ((cid >> (ii * 8)) & 0xff)) * 16777619U;
+        }
+        for (std::size_t ii = 0; ii < nkey; ii++) {
+            unsigned char c = key[ii];
+            if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))) {
+                break;
+            }
+            hash = (hash ^ c) * 16777619U;
+        }
+        return hash;
+    }
+
+    Slot &slot(std::uint32_t hash)
+    {
+        Slot &found = slots[hash % nslots];
+        if (found.hash != hash || found.samples == 0) {
+            found = Slot();
+            found.hash = hash;
+        }
+        return found;
+    }
+
+    static bool should_compress(Slot &slot, float min_ratio)
+    {
+        if (slot.samples == 0 || slot.ratio <= min_ratio) {
+            return true;
+        }
+        if (++slot.skipped >= probe_interval) {
+            slot.skipped = 0;
+            return true;
+        }
+        return false;
+    }
+
+    static void record(Slot &slot, float ratio)
+    {
+        slot.ratio = slot.samples == 0 ? ratio : slot.ratio * 0.75f + ratio * 0.25f;
+        slot.samples++;
+    }
+};
+
+mc_COMPRESSPOLICY *mcreq_compress_policy_new(void)
+{
+    return new mc_COMPRESSPOLICY();
+}
+
+void mcreq_compress_policy_free(mc_COMPRESSPOLICY *policy)
+{
+    delete policy;
+}
+
+void mcreq_compress_policy_stats(const mc_COMPRESSPOLICY *policy, lcb_COMPRESSION_STATS *stats)
+{
+    if (policy) {
+        *stats = policy->stats;
+    } else {
+        *stats = lcb_COMPRESSION_STATS();
+    }
+}
+
+/**
+ * Buffers reused by the instance for compression. Values are compressed into
+ * a scratch buffer, so only the compressed size needs to be reserved from the
+ * pipeline's netbuf. Responses are inflated into one of a few buffers which
+ * are handed back once the callback returns. Buffers larger than
+ * max_retained are given back to the allocator straight away.
+ */
+struct mc_SNAPPYPOOL_st {
+    enum { max_buffers = 4, max_retained = 16 * 1024 * 1024 };
+
+    struct Buffer {
+        std::size_t capacity;
+
+        char *data()
+        {
+            return reinterpret_cast<char *>(this + 1);
+        }
+    };
+
+    std::vector<char> deflate;
+    Buffer *buffers[max_buffers]{};
+    unsigned nbuffers{0};
+
+    ~mc_SNAPPYPOOL_st()
+    {
+        for (unsigned ii = 0; ii < nbuffers; ii++) {
+            free(buffers[ii]);
+        }
+    }
+
+    Buffer *acquire(std::size_t size)
+    {
+        // The smallest one which is large enough
+        int found = -1;
+        for (unsigned ii = 0; ii < nbuffers; ii++) {
+            if (buffers[ii]->capacity >= size && (found < 0 || buffers[ii]->capacity < buffers[found]->capacity)) {
+                found = static_cast<int>(ii);
+            }
+        }
+        if (found >= 0) {
+            Buffer *buffer = buffers[found];
+            buffers[found] = buffers[--nbuffers];
+            return buffer;
+        }
+        auto *buffer = static_cast<Buffer *>(malloc(sizeof(Buffer) + size));
+        if (buffer != nullptr) {
+            buffer->capacity = size;
+        }
+        return buffer;
+    }
+
+    static void trim(std::vector<char> &scratch)
+    {
+        if (scratch.size() > max_retained) {
+            std::vector<char>().swap(scratch);
+        }
+    }
+
+    void release(Buffer *buffer)
+    {
+        if (buffer->capacity > max_retained) {
+            free(buffer);
+            return;
+        }
+        if (nbuffers == max_buffers) {
+            // Keep the larger ones
+            unsigned smallest = 0;
+            for (unsigned ii = 1; ii < nbuffers; ii++) {
+                if (buffers[ii]->capacity < buffers[smallest]->capacity) {
+                    smallest = ii;
+                }
+            }
+            if (buffers[smallest]->capacity >= buffer->capacity) {
+                free(buffer);
+                return;
+            }
+            free(buffers[smallest]);
+            buffers[smallest] = buffers[--nbuffers];
+        }
+        buffers[nbuffers++] = buffer;
+    }
+};
+
+mc_SNAPPYPOOL *mcreq_snappy_pool_new(void)
+{
+    return new mc_SNAPPYPOOL();
+}
+
+void mcreq_snappy_pool_free(mc_SNAPPYPOOL *pool)
+{
+    delete pool;
+}
 
 class FragBufSource : public snappy::Source
 {
@@ -83,69 +265,98 @@ class FragBufSource : public snappy::Source
 };
 
 int mcreq_compress_value(mc_PIPELINE *pl, mc_PACKET *pkt, const lcb_VALBUF *vbuf, lcb_settings *settings,
-                         int *should_compress)
+                         uint32_t cid, const char *key, size_t nkey, int *should_compress)
 {
     std::size_t origsize = 0;
-    snappy::Source *source;
     switch (vbuf->vtype) {
         case LCB_KV_COPY:
         case LCB_KV_CONTIG:
             origsize = vbuf->u_buf.contig.nbytes;
-            if (origsize < settings->compress_min_size) {
-                *should_compress = 0;
-                mcreq_reserve_value(pl, pkt, vbuf);
-                return 0;
-            }
-            source = new snappy::ByteArraySource(static_cast<const char *>(vbuf->u_buf.contig.bytes),
-                                                 vbuf->u_buf.contig.nbytes);
             break;
 
         case LCB_KV_IOV:
         case LCB_KV_IOVCOPY:
-            if (vbuf->u_buf.multi.total_length == 0) {
+            origsize = vbuf->u_buf.multi.total_length;
+            if (origsize == 0) {
                 for (unsigned int ii = 0; ii < vbuf->u_buf.multi.niov; ii++) {
                     origsize += vbuf->u_buf.multi.iov[ii].iov_len;
                 }
             }
-            if (origsize == 0 || origsize < settings->compress_min_size) {
-                *should_compress = 0;
-                mcreq_reserve_value(pl, pkt, vbuf);
-                return 0;
-            }
-            source = new FragBufSource(&vbuf->u_buf.multi);
             break;
 
         default:
             return -1;
     }
+    if (origsize == 0 || origsize < settings->compress_min_size) {
+        *should_compress = 0;
+        mcreq_reserve_value(pl, pkt, vbuf);
+        return 0;
+    }
+
+    mc_COMPRESSPOLICY *policy = settings->compress_policy;
+    mc_COMPRESSPOLICY::Slot *slot = nullptr;
+    if (policy) {
+        slot = &policy->slot(mc_COMPRESSPOLICY::hash_prefix(cid, key, nkey));
+        if (!mc_COMPRESSPOLICY::should_compress(*slot, settings->compress_min_ratio)) {
+            policy->stats.skipped++;
+            *should_compress = 0;
+            mcreq_reserve_value(pl, pkt, vbuf);
+            return 0;
+        }
+    }
+
+    snappy::Source *source;
+    if (vbuf->vtype == LCB_KV_COPY || vbuf->vtype == LCB_KV_CONTIG) {
+        source = new snappy::ByteArraySource(static_cast<const char *>(vbuf->u_buf.contig.bytes),
+                                             vbuf->u_buf.contig.nbytes);
+    } else {
+        source = new FragBufSource(&vbuf->u_buf.multi);
+    }
 
+    mc_SNAPPYPOOL *pool = settings->snappy_pool;
+    std::vector<char> scratch;
+    std::vector<char> &out = pool ? pool->deflate : scratch;
     std::size_t maxsize = snappy::MaxCompressedLength(source->Available());
-    if (mcreq_reserve_value2(pl, pkt, maxsize) != LCB_SUCCESS) {
-        delete source;
-        return -1;
+    if (out.size() < maxsize) {
+        out.resize(maxsize);
     }
-    nb_SPAN *outspan = &pkt->u_value.single;
-    snappy::UncheckedByteArraySink sink(SPAN_BUFFER(outspan));
+    snappy::UncheckedByteArraySink sink(out.data());
 
+    hrtime_t start = gethrtime();
     Compress(source, &sink);
-    std::size_t compsize = sink.CurrentDestination() - SPAN_BUFFER(outspan);
+    hrtime_t elapsed = gethrtime() - start;
+    record_op_latency("snappy_compress", "kv", settings, start);
+    std::size_t compsize = sink.CurrentDestination() - out.data();
     delete source;
 
-    if (compsize == 0 || (((float)compsize / origsize) > settings->compress_min_ratio)) {
-        netbuf_mblock_release(&pl->nbmgr, outspan);
+    float ratio = compsize == 0 ? 1 : (float)compsize / origsize;
+    if (policy) {
+        mc_COMPRESSPOLICY::record(*slot, ratio);
+        policy->stats.bytes_in += origsize;
+        policy->stats.compress_ns += elapsed;
+    }
+
+    if (compsize == 0 || ratio > settings->compress_min_ratio) {
+        if (policy) {
+            policy->stats.rejected++;
+        }
+        mc_SNAPPYPOOL::trim(out);
         *should_compress = 0;
         mcreq_reserve_value(pl, pkt, vbuf);
         return 0;
     }
 
-    if (compsize < maxsize) {
-        /* chop off some bytes? */
-        nb_SPAN trailspan = *outspan;
-        trailspan.offset += compsize;
-        trailspan.size = maxsize - compsize;
-        netbuf_mblock_release(&pl->nbmgr, &trailspan);
-        outspan->size = compsize;
+    if (policy) {
+        policy->stats.compressed++;
+        policy->stats.bytes_out += compsize;
+    }
+
+    if (mcreq_reserve_value2(pl, pkt, compsize) != LCB_SUCCESS) {
+        mc_SNAPPYPOOL::trim(out);
+        return -1;
     }
+    memcpy(SPAN_BUFFER(&pkt->u_value.single), out.data(), compsize);
+    mc_SNAPPYPOOL::trim(out);
     return 0;
 }
 
@@ -167,3 +378,41 @@ int mcreq_inflate_value(const void *compressed, size_t ncompressed, const void *
     *nbytes = compsize;
     return 0;
 }
+
+int mcreq_inflate_value_pooled(mc_SNAPPYPOOL *pool, const void *compressed, size_t ncompressed, const void **bytes,
+                               size_t *nbytes, void **freeptr)
+{
+    if (pool == nullptr) {
+        return mcreq_inflate_value(compressed, ncompressed, bytes, nbytes, freeptr);
+    }
+
+    size_t size = 0;
+    if (!snappy::GetUncompressedLength(static_cast<const char *>(compressed), ncompressed, &size)) {
+        return -1;
+    }
+    mc_SNAPPYPOOL::Buffer *buffer = pool->acquire(size);
+    if (buffer == nullptr) {
+        return -1;
+    }
+    if (!snappy::RawUncompress(static_cast<const char *>(compressed), ncompressed, buffer->data())) {
+        pool->release(buffer);
+        return -1;
+    }
+
+    *freeptr = buffer;
+    *bytes = buffer->data();
+    *nbytes = size;
+    return 0;
+}
+
+void mcreq_inflate_release(mc_SNAPPYPOOL *pool, void *freeptr)
+{
+    if (freeptr == nullptr) {
+        return;
+    }
+    if (pool == nullptr) {
+        free(freeptr);
+    } else {
+        pool->release(static_cast<mc_SNAPPYPOOL::Buffer *>(freeptr));
+    }
+}
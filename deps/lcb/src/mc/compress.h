@@ -24,17 +24,41 @@
 extern "C" {
 #endif
 
+/**
+ * Remembers how well the values of each collection and key prefix compressed
+ * recently, so that values which are not going to compress well enough to
+ * be sent compressed are not compressed at all.
+ */
+typedef struct mc_COMPRESSPOLICY_st mc_COMPRESSPOLICY;
+
+mc_COMPRESSPOLICY *mcreq_compress_policy_new(void);
+void mcreq_compress_policy_free(mc_COMPRESSPOLICY *policy);
+void mcreq_compress_policy_stats(const mc_COMPRESSPOLICY *policy, lcb_COMPRESSION_STATS *stats);
+
+/**
+ * Buffers kept by the instance for compressing values and inflating
+ * responses, so that large documents do not need new allocations each time.
+ */
+typedef struct mc_SNAPPYPOOL_st mc_SNAPPYPOOL;
+
+mc_SNAPPYPOOL *mcreq_snappy_pool_new(void);
+void mcreq_snappy_pool_free(mc_SNAPPYPOOL *pool);
+
 /**
  * Stores a compressed payload into a packet
  * @param pl The pipeline which hosts the packet
  * @param pkt The packet which hosts the value
  * @param vbuf The user input to be compressed
  * @param settings The instance settings
+ * @param cid The collection of the document
+ * @param key The key of the document, its prefix selects the history used by
+ * the compression policy
+ * @param nkey Size of the key
  * @param should_compress The pointer, which stores zero if the value is not compressed
  * @return 0 if successful, nonzero on error.
  */
 int mcreq_compress_value(mc_PIPELINE *pl, mc_PACKET *pkt, const lcb_VALBUF *vbuf, lcb_settings *settings,
-                         int *should_compress);
+                         uint32_t cid, const char *key, size_t nkey, int *should_compress);
 
 /**
  * Inflate a compressed value
@@ -49,6 +73,17 @@ int mcreq_compress_value(mc_PIPELINE *pl, mc_PACKET *pkt, const lcb_VALBUF *vbuf
  */
 int mcreq_inflate_value(const void *compressed, size_t ncompressed, const void **bytes, size_t *nbytes, void **freeptr);
 
+/**
+ * Like mcreq_inflate_value(), but inflates into a buffer taken from the pool.
+ * The buffer returned in freeptr (if any) must be handed back with
+ * mcreq_inflate_release() once the value is no longer needed, rather than
+ * freed.
+ */
+int mcreq_inflate_value_pooled(mc_SNAPPYPOOL *pool, const void *compressed, size_t ncompressed, const void **bytes,
+                               size_t *nbytes, void **freeptr);
+
+void mcreq_inflate_release(mc_SNAPPYPOOL *pool, void *freeptr);
+
 #ifdef __cplusplus
 }
 #endif
@@ -215,38 +215,279 @@ lcb_STATUS mcreq_reserve_value(mc_PIPELINE *pipeline, mc_PACKET *packet, const l
     return LCB_SUCCESS;
 }
 
-static int pkt_tmo_compar(sllist_node *a, sllist_node *b)
+#define PKTINDEX_MINCAP 64
+
+static unsigned pktindex_hash(const mc_PKTINDEX *ix, uint32_t opaque)
 {
-    mc_PACKET *pa, *pb;
-    hrtime_t tmo_a, tmo_b;
+    /* Opaques are sequential per queue and interleaved between pipelines, so
+     * use the high bits of a multiplicative hash to spread them out */
+    return (unsigned)((opaque * 2654435761u) >> ix->shift);
+}
 
-    pa = SLLIST_ITEM(a, mc_PACKET, slnode);
-    pb = SLLIST_ITEM(b, mc_PACKET, slnode);
+static void pktindex_place(mc_PKTINDEX *ix, const mc_PKTSLOT *src)
+{
+    unsigned mask = ix->capacity - 1;
+    unsigned pos = pktindex_hash(ix, src->opaque);
+    while (ix->slots[pos].pkt) {
+        pos = (pos + 1) & mask;
+    }
+    ix->slots[pos] = *src;
+    ix->count++;
+}
 
-    tmo_a = MCREQ_PKT_RDATA(pa)->start;
-    tmo_b = MCREQ_PKT_RDATA(pb)->start;
+static void pktindex_grow(mc_PKTINDEX *ix)
+{
+    mc_PKTSLOT *old = ix->slots;
+    unsigned oldcap = ix->capacity;
+    unsigned bits = 0;
 
-    if (tmo_a == tmo_b) {
-        return 0;
-    } else if (tmo_a < tmo_b) {
-        return -1;
-    } else {
-        return 1;
+    ix->capacity = oldcap ? oldcap * 2 : PKTINDEX_MINCAP;
+    while ((1u << bits) < ix->capacity) {
+        bits++;
     }
+    ix->shift = 32 - bits;
+    ix->slots = calloc(ix->capacity, sizeof(*ix->slots));
+    ix->count = 0;
+
+    for (unsigned ii = 0; ii < oldcap; ii++) {
+        if (old[ii].pkt) {
+            pktindex_place(ix, old + ii);
+        }
+    }
+    free(old);
 }
 
-void mcreq_reenqueue_packet(mc_PIPELINE *pipeline, mc_PACKET *packet)
+/**
+ * Find the slot for the given opaque. If `pkt` is not NULL, only the slot
+ * referencing that exact packet is returned, otherwise the first (i.e. oldest)
+ * slot carrying the opaque is returned.
+ */
+static mc_PKTSLOT *pktindex_lookup(mc_PKTINDEX *ix, uint32_t opaque, const mc_PACKET *pkt)
+{
+    unsigned mask, pos;
+    if (!ix->count) {
+        return NULL;
+    }
+    mask = ix->capacity - 1;
+    for (pos = pktindex_hash(ix, opaque); ix->slots[pos].pkt; pos = (pos + 1) & mask) {
+        mc_PKTSLOT *slot = ix->slots + pos;
+        if (slot->opaque == opaque && (pkt == NULL || slot->pkt == pkt)) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+static void pktindex_insert(mc_PKTINDEX *ix, mc_PACKET *pkt, sllist_node *prev)
+{
+    mc_PKTSLOT slot;
+    if ((ix->count + 1) * 2 > ix->capacity) {
+        pktindex_grow(ix);
+    }
+    slot.opaque = pkt->opaque;
+    slot.pkt = pkt;
+    slot.prev = prev;
+    pktindex_place(ix, &slot);
+}
+
+/** Remove a slot using backward-shift deletion, so no tombstones are needed */
+static void pktindex_erase(mc_PKTINDEX *ix, mc_PKTSLOT *slot)
+{
+    unsigned mask = ix->capacity - 1;
+    unsigned hole = (unsigned)(slot - ix->slots);
+    unsigned cur = hole;
+
+    for (;;) {
+        unsigned home;
+        cur = (cur + 1) & mask;
+        if (!ix->slots[cur].pkt) {
+            break;
+        }
+        home = pktindex_hash(ix, ix->slots[cur].opaque);
+        /* Leave the entry in place if its home lies cyclically in (hole, cur] */
+        if (hole <= cur ? (hole < home && home <= cur) : (hole < home || home <= cur)) {
+            continue;
+        }
+        ix->slots[hole] = ix->slots[cur];
+        hole = cur;
+    }
+    ix->slots[hole].pkt = NULL;
+    ix->count--;
+}
+
+static void pipeline_add_outstanding(mc_PIPELINE *pipeline, const mc_PACKET *pkt)
+{
+    pipeline->nbytes_outstanding += mcreq_get_size(pkt);
+}
+
+static void pipeline_remove_outstanding(mc_PIPELINE *pipeline, const mc_PACKET *pkt)
+{
+    uint32_t size = mcreq_get_size(pkt);
+    pipeline->nbytes_outstanding -= size < pipeline->nbytes_outstanding ? size : pipeline->nbytes_outstanding;
+}
+
+/** Update the indexed predecessor of the packet following `node`, if any */
+static void pipeline_set_prev(mc_PIPELINE *pipeline, sllist_node *node, sllist_node *prev)
+{
+    mc_PACKET *pkt;
+    mc_PKTSLOT *slot;
+    if (!node) {
+        return;
+    }
+    pkt = SLLIST_ITEM(node, mc_PACKET, slnode);
+    slot = pktindex_lookup(&pipeline->pktindex, pkt->opaque, pkt);
+    lcb_assert(slot);
+    slot->prev = prev;
+}
+
+/** Link the packet into the request log directly after `prev` */
+static void pipeline_link(mc_PIPELINE *pipeline, sllist_node *prev, mc_PACKET *pkt)
+{
+    sllist_insert(&pipeline->requests, prev, &pkt->slnode);
+    pktindex_insert(&pipeline->pktindex, pkt, prev);
+    pipeline_set_prev(pipeline, pkt->slnode.next, &pkt->slnode);
+    pipeline_add_outstanding(pipeline, pkt);
+}
+
+/** Unlink the packet referenced by `slot` from the request log */
+static void pipeline_unlink(mc_PIPELINE *pipeline, mc_PKTSLOT *slot)
 {
     sllist_root *reqs = &pipeline->requests;
-    mcreq_enqueue_packet(pipeline, packet);
-    sllist_remove(reqs, &packet->slnode);
-    sllist_insert_sorted(reqs, &packet->slnode, pkt_tmo_compar);
+    sllist_node *prev = slot->prev;
+    sllist_node *next = slot->pkt->slnode.next;
+
+    prev->next = next;
+    if (next) {
+        pipeline_set_prev(pipeline, next, prev);
+    } else {
+        reqs->last = prev == &reqs->first_prev ? NULL : prev;
+    }
+    pipeline_remove_outstanding(pipeline, slot->pkt);
+    pktindex_erase(&pipeline->pktindex, slot);
 }
 
-void mcreq_enqueue_packet(mc_PIPELINE *pipeline, mc_PACKET *packet)
+/** Like sllist_iter_remove(), but also keeps the pipeline's index in sync */
+static void pipeline_iter_remove(mc_PIPELINE *pipeline, sllist_iterator *iter)
+{
+    mc_PACKET *pkt = SLLIST_ITEM(iter->cur, mc_PACKET, slnode);
+    mc_PKTSLOT *slot = pktindex_lookup(&pipeline->pktindex, pkt->opaque, pkt);
+
+    lcb_assert(slot);
+    sllist_iter_remove(&pipeline->requests, iter);
+    pipeline_set_prev(pipeline, iter->next, iter->prev);
+    pipeline_remove_outstanding(pipeline, pkt);
+    pktindex_erase(&pipeline->pktindex, slot);
+}
+
+#define TMOHEAP_MINCAP 64
+
+static void tmoheap_sift_up(mc_TMOHEAP *h, unsigned pos)
+{
+    mc_TMOENTRY ent = h->entries[pos];
+    while (pos) {
+        unsigned parent = (pos - 1) / 2;
+        if (h->entries[parent].deadline <= ent.deadline) {
+            break;
+        }
+        h->entries[pos] = h->entries[parent];
+        pos = parent;
+    }
+    h->entries[pos] = ent;
+}
+
+static void tmoheap_sift_down(mc_TMOHEAP *h, unsigned pos)
+{
+    mc_TMOENTRY ent = h->entries[pos];
+    for (;;) {
+        unsigned child = pos * 2 + 1;
+        if (child >= h->size) {
+            break;
+        }
+        if (child + 1 < h->size && h->entries[child + 1].deadline < h->entries[child].deadline) {
+            child++;
+        }
+        if (ent.deadline <= h->entries[child].deadline) {
+            break;
+        }
+        h->entries[pos] = h->entries[child];
+        pos = child;
+    }
+    h->entries[pos] = ent;
+}
+
+static void tmoheap_pop(mc_TMOHEAP *h)
+{
+    if (--h->size) {
+        h->entries[0] = h->entries[h->size];
+        tmoheap_sift_down(h, 0);
+    }
+}
+
+/** Returns the packet referenced by the entry, or NULL if it is no longer pending */
+static mc_PACKET *tmoheap_entry_packet(mc_PIPELINE *pipeline, const mc_TMOENTRY *ent)
+{
+    if (pktindex_lookup(&pipeline->pktindex, ent->opaque, ent->pkt)) {
+        return ent->pkt;
+    }
+    return NULL;
+}
+
+/** Drop all stale entries and restore the heap property */
+static void tmoheap_compact(mc_PIPELINE *pipeline)
+{
+    mc_TMOHEAP *h = &pipeline->tmoheap;
+    unsigned nlive = 0;
+
+    for (unsigned ii = 0; ii < h->size; ii++) {
+        if (tmoheap_entry_packet(pipeline, h->entries + ii)) {
+            h->entries[nlive++] = h->entries[ii];
+        } else {
+            h->nstale++;
+        }
+    }
+    h->size = nlive;
+    for (unsigned ii = nlive / 2; ii-- > 0;) {
+        tmoheap_sift_down(h, ii);
+    }
+    h->ncompacted++;
+}
+
+static void tmoheap_push(mc_PIPELINE *pipeline, mc_PACKET *pkt, hrtime_t deadline)
+{
+    mc_TMOHEAP *h = &pipeline->tmoheap;
+    mc_TMOENTRY *ent;
+
+    if (h->size >= TMOHEAP_MINCAP && h->size >= pipeline->pktindex.count * 2) {
+        tmoheap_compact(pipeline);
+    }
+    if (h->size == h->capacity) {
+        h->capacity = h->capacity ? h->capacity * 2 : TMOHEAP_MINCAP;
+        h->entries = realloc(h->entries, h->capacity * sizeof(*h->entries));
+    }
+    ent = h->entries + h->size;
+    ent->deadline = deadline;
+    ent->opaque = pkt->opaque;
+    ent->pkt = pkt;
+    tmoheap_sift_up(h, h->size++);
+}
+
+/** Re-create the heap from the request log, e.g. after deadlines have been modified */
+static void tmoheap_rebuild(mc_PIPELINE *pipeline)
+{
+    sllist_node *nn;
+    pipeline->tmoheap.size = 0;
+    SLLIST_ITERBASIC(&pipeline->requests, nn)
+    {
+        mc_PACKET *pkt = SLLIST_ITEM(nn, mc_PACKET, slnode);
+        tmoheap_push(pipeline, pkt, MCREQ_PKT_RDATA(pkt)->deadline);
+    }
+}
+
+static void pipeline_enqueue(mc_PIPELINE *pipeline, sllist_node *prev, mc_PACKET *packet)
 {
     nb_SPAN *vspan = &packet->u_value.single;
-    sllist_append(&pipeline->requests, &packet->slnode);
+    pipeline_link(pipeline, prev, packet);
+    tmoheap_push(pipeline, packet, MCREQ_PKT_RDATA(packet)->deadline);
     netbuf_enqueue_span(&pipeline->nbmgr, &packet->kh_span, packet);
     MC_INCR_METRIC(pipeline, bytes_queued, packet->kh_span.size);
 
@@ -271,6 +512,30 @@ GT_ENQUEUE_PDU:
     MC_INCR_METRIC(pipeline, packets_queued, 1);
 }
 
+void mcreq_reenqueue_packet(mc_PIPELINE *pipeline, mc_PACKET *packet)
+{
+    sllist_root *reqs = &pipeline->requests;
+    sllist_iterator iter;
+    hrtime_t start = MCREQ_PKT_RDATA(packet)->start;
+
+    /* Insert before the first command which is not older than this one */
+    SLLIST_ITERFOR(reqs, &iter)
+    {
+        mc_PACKET *cur = SLLIST_ITEM(iter.cur, mc_PACKET, slnode);
+        if (start <= MCREQ_PKT_RDATA(cur)->start) {
+            pipeline_enqueue(pipeline, iter.prev, packet);
+            return;
+        }
+    }
+    mcreq_enqueue_packet(pipeline, packet);
+}
+
+void mcreq_enqueue_packet(mc_PIPELINE *pipeline, mc_PACKET *packet)
+{
+    sllist_root *reqs = &pipeline->requests;
+    pipeline_enqueue(pipeline, SLLIST_IS_EMPTY(reqs) ? &reqs->first_prev : reqs->last, packet);
+}
+
 void mcreq_wipe_packet(mc_PIPELINE *pipeline, mc_PACKET *packet)
 {
     if (!(packet->flags & MCREQ_F_KEY_NOCOPY)) {
@@ -499,9 +764,47 @@ uint16_t mcreq_get_key_size(protocol_binary_request_header *hdr)
     }
 }
 
+mc_PIPELINE *mcreq_pipeline_select(mc_PIPELINE *pipeline, uint32_t nvalue)
+{
+    mc_PIPELINE *best = pipeline;
+    unsigned nshared = pipeline->nsiblings;
+    lcb_U32 threshold = 0;
+
+    if (!nshared) {
+        return pipeline;
+    }
+
+    if (pipeline->parent && pipeline->parent->cqdata) {
+        threshold = LCBT_SETTING((lcb_INSTANCE *)pipeline->parent->cqdata, kv_large_value_threshold);
+    }
+    if (threshold) {
+        /* The last sibling is kept for large values */
+        mc_PIPELINE *dedicated = pipeline->siblings[nshared - 1];
+        if (nvalue >= threshold && dedicated) {
+            return dedicated;
+        }
+        nshared--;
+    }
+
+    for (unsigned ii = 0; ii < nshared; ii++) {
+        mc_PIPELINE *cur = pipeline->siblings[ii];
+        if (cur && cur->nbytes_outstanding < best->nbytes_outstanding) {
+            best = cur;
+        }
+    }
+    return best;
+}
+
 lcb_STATUS mcreq_basic_packet(mc_CMDQUEUE *queue, const lcb_KEYBUF *key, uint32_t collection_id,
                               protocol_binary_request_header *req, lcb_uint8_t extlen, lcb_uint8_t ffextlen,
                               mc_PACKET **packet, mc_PIPELINE **pipeline, int options)
+{
+    return mcreq_basic_packet_ex(queue, key, collection_id, req, extlen, ffextlen, packet, pipeline, options, 0);
+}
+
+lcb_STATUS mcreq_basic_packet_ex(mc_CMDQUEUE *queue, const lcb_KEYBUF *key, uint32_t collection_id,
+                                 protocol_binary_request_header *req, lcb_uint8_t extlen, lcb_uint8_t ffextlen,
+                                 mc_PACKET **packet, mc_PIPELINE **pipeline, int options, uint32_t nvalue)
 {
     int vb, srvix;
     uint16_t nkey;
@@ -515,7 +818,7 @@ lcb_STATUS mcreq_basic_packet(mc_CMDQUEUE *queue, const lcb_KEYBUF *key, uint32_
 
     mcreq_map_key(queue, key, sizeof(*req) + extlen + ffextlen, &vb, &srvix);
     if (srvix > -1 && srvix < (int)queue->npipelines) {
-        *pipeline = queue->pipelines[srvix];
+        *pipeline = mcreq_pipeline_select(queue->pipelines[srvix], nvalue);
 
     } else {
         if ((options & MCREQ_BASICPACKET_F_FALLBACKOK) && queue->fallback) {
@@ -689,6 +992,11 @@ void mcreq_pipeline_cleanup(mc_PIPELINE *pipeline)
 {
     netbuf_cleanup(&pipeline->nbmgr);
     netbuf_cleanup(&pipeline->reqpool);
+    free(pipeline->pktindex.slots);
+    memset(&pipeline->pktindex, 0, sizeof pipeline->pktindex);
+    free(pipeline->tmoheap.entries);
+    memset(&pipeline->tmoheap, 0, sizeof pipeline->tmoheap);
+    pipeline->nbytes_outstanding = 0;
 }
 
 int mcreq_pipeline_init(mc_PIPELINE *pipeline)
@@ -697,6 +1005,8 @@ int mcreq_pipeline_init(mc_PIPELINE *pipeline)
 
     /* Initialize all members to 0 */
     memset(&pipeline->requests, 0, sizeof pipeline->requests);
+    memset(&pipeline->pktindex, 0, sizeof pipeline->pktindex);
+    memset(&pipeline->tmoheap, 0, sizeof pipeline->tmoheap);
     pipeline->parent = NULL;
     pipeline->flush_start = NULL;
     pipeline->index = 0;
@@ -713,6 +1023,9 @@ int mcreq_pipeline_init(mc_PIPELINE *pipeline)
     netbuf_init(&pipeline->reqpool, &settings);
 
     pipeline->metrics = NULL;
+    pipeline->siblings = NULL;
+    pipeline->nsiblings = 0;
+    pipeline->nbytes_outstanding = 0;
     return 0;
 }
 
@@ -733,6 +1046,13 @@ void mcreq_queue_add_pipelines(mc_CMDQUEUE *queue, mc_PIPELINE *const *pipelines
     for (unsigned ii = 0; ii < npipelines; ii++) {
         pipelines[ii]->parent = queue;
         pipelines[ii]->index = ii;
+        for (unsigned jj = 0; jj < pipelines[ii]->nsiblings; jj++) {
+            mc_PIPELINE *sibling = pipelines[ii]->siblings[jj];
+            if (sibling) {
+                sibling->parent = queue;
+                sibling->index = ii;
+            }
+        }
     }
 
     if (queue->fallback) {
@@ -780,6 +1100,73 @@ void mcreq_sched_enter(mc_CMDQUEUE *queue)
     queue->ctxenter = 1;
 }
 
+/* Tell the owner of any user-allocated buffers that the packet no longer needs them */
+static void packet_bufdone(mc_PIPELINE *pipeline, mc_PACKET *pkt)
+{
+    if ((pkt->flags & MCREQ_UBUF_FLAGS) && pipeline->buf_done_callback) {
+        void *kbuf, *vbuf;
+        const void *cookie;
+
+        cookie = MCREQ_PKT_COOKIE(pkt);
+        if (pkt->flags & MCREQ_F_KEY_NOCOPY) {
+            kbuf = SPAN_BUFFER(&pkt->kh_span);
+        } else {
+            kbuf = NULL;
+        }
+        if (pkt->flags & MCREQ_F_VALUE_NOCOPY) {
+            if (pkt->flags & MCREQ_F_VALUE_IOV) {
+                vbuf = pkt->u_value.multi.iov->iov_base;
+            } else {
+                vbuf = SPAN_SABUFFER_NC(&pkt->u_value.single);
+            }
+        } else {
+            vbuf = NULL;
+        }
+
+        pipeline->buf_done_callback(pipeline, cookie, kbuf, vbuf);
+    }
+}
+
+static void pipeline_ctx_leave(mc_PIPELINE *pipeline, int success, int flush)
+{
+    sllist_node *ll_next, *ll;
+
+    ll = SLLIST_FIRST(&pipeline->ctxqueued);
+    if (!ll) {
+        return;
+    }
+
+    while (ll) {
+        mc_PACKET *pkt = SLLIST_ITEM(ll, mc_PACKET, slnode);
+        ll_next = ll->next;
+
+        pipeline_remove_outstanding(pipeline, pkt);
+        if (success) {
+            mcreq_enqueue_packet(pipeline, pkt);
+        } else {
+            if (lcbtrace_span_should_finish(MCREQ_PKT_RDATA(pkt)->span)) {
+                lcbtrace_span_finish(MCREQ_PKT_RDATA(pkt)->span, LCBTRACE_NOW);
+            }
+
+            if (pkt->flags & MCREQ_F_REQEXT) {
+                mc_REQDATAEX *rd = pkt->u_rdata.exdata;
+                if (rd->procs->fail_dtor) {
+                    rd->procs->fail_dtor(pkt);
+                }
+            }
+            packet_bufdone(pipeline, pkt);
+            mcreq_wipe_packet(pipeline, pkt);
+            mcreq_release_packet(pipeline, pkt);
+        }
+
+        ll = ll_next;
+    }
+    SLLIST_FIRST(&pipeline->ctxqueued) = pipeline->ctxqueued.last = NULL;
+    if (flush) {
+        pipeline->flush_start(pipeline);
+    }
+}
+
 static void queuectx_leave(mc_CMDQUEUE *queue, int success, int flush)
 {
     if (queue->ctxenter) {
@@ -788,41 +1175,18 @@ static void queuectx_leave(mc_CMDQUEUE *queue, int success, int flush)
 
     for (unsigned ii = 0; ii < queue->_npipelines_ex; ii++) {
         mc_PIPELINE *pipeline;
-        sllist_node *ll_next, *ll;
 
         if (!queue->scheds[ii]) {
             continue;
         }
 
+        /* Packets for this index may have been placed on any of its pipelines */
         pipeline = queue->pipelines[ii];
-        ll = SLLIST_FIRST(&pipeline->ctxqueued);
-
-        while (ll) {
-            mc_PACKET *pkt = SLLIST_ITEM(ll, mc_PACKET, slnode);
-            ll_next = ll->next;
-
-            if (success) {
-                mcreq_enqueue_packet(pipeline, pkt);
-            } else {
-                if (lcbtrace_span_should_finish(MCREQ_PKT_RDATA(pkt)->span)) {
-                    lcbtrace_span_finish(MCREQ_PKT_RDATA(pkt)->span, LCBTRACE_NOW);
-                }
-
-                if (pkt->flags & MCREQ_F_REQEXT) {
-                    mc_REQDATAEX *rd = pkt->u_rdata.exdata;
-                    if (rd->procs->fail_dtor) {
-                        rd->procs->fail_dtor(pkt);
-                    }
-                }
-                mcreq_wipe_packet(pipeline, pkt);
-                mcreq_release_packet(pipeline, pkt);
+        pipeline_ctx_leave(pipeline, success, flush);
+        for (unsigned jj = 0; jj < pipeline->nsiblings; jj++) {
+            if (pipeline->siblings[jj]) {
+                pipeline_ctx_leave(pipeline->siblings[jj], success, flush);
             }
-
-            ll = ll_next;
-        }
-        SLLIST_FIRST(&pipeline->ctxqueued) = pipeline->ctxqueued.last = NULL;
-        if (flush) {
-            pipeline->flush_start(pipeline);
         }
         queue->scheds[ii] = 0;
     }
@@ -850,23 +1214,22 @@ void mcreq_sched_add(mc_PIPELINE *pipeline, mc_PACKET *pkt)
         cq->scheds[pipeline->index] = 1;
     }
     sllist_append(&pipeline->ctxqueued, &pkt->slnode);
+    pipeline_add_outstanding(pipeline, pkt);
     mcreq_rearm_timeout(pipeline);
 }
 
 static mc_PACKET *pipeline_find(mc_PIPELINE *pipeline, lcb_uint32_t opaque, int do_remove)
 {
-    sllist_iterator iter;
-    SLLIST_ITERFOR(&pipeline->requests, &iter)
-    {
-        mc_PACKET *pkt = SLLIST_ITEM(iter.cur, mc_PACKET, slnode);
-        if (pkt->opaque == opaque) {
-            if (do_remove) {
-                sllist_iter_remove(&pipeline->requests, &iter);
-            }
-            return pkt;
-        }
+    mc_PACKET *pkt;
+    mc_PKTSLOT *slot = pktindex_lookup(&pipeline->pktindex, opaque, NULL);
+    if (!slot) {
+        return NULL;
     }
-    return NULL;
+    pkt = slot->pkt;
+    if (do_remove) {
+        pipeline_unlink(pipeline, slot);
+    }
+    return pkt;
 }
 
 mc_PACKET *mcreq_pipeline_find(mc_PIPELINE *pipeline, lcb_uint32_t opaque)
@@ -883,28 +1246,7 @@ void mcreq_packet_done(mc_PIPELINE *pipeline, mc_PACKET *pkt)
 {
     lcb_assert(pkt->flags & MCREQ_F_FLUSHED);
     lcb_assert(pkt->flags & MCREQ_F_INVOKED);
-    if (pkt->flags & MCREQ_UBUF_FLAGS) {
-        void *kbuf, *vbuf;
-        const void *cookie;
-
-        cookie = MCREQ_PKT_COOKIE(pkt);
-        if (pkt->flags & MCREQ_F_KEY_NOCOPY) {
-            kbuf = SPAN_BUFFER(&pkt->kh_span);
-        } else {
-            kbuf = NULL;
-        }
-        if (pkt->flags & MCREQ_F_VALUE_NOCOPY) {
-            if (pkt->flags & MCREQ_F_VALUE_IOV) {
-                vbuf = pkt->u_value.multi.iov->iov_base;
-            } else {
-                vbuf = SPAN_SABUFFER_NC(&pkt->u_value.single);
-            }
-        } else {
-            vbuf = NULL;
-        }
-
-        pipeline->buf_done_callback(pipeline, cookie, kbuf, vbuf);
-    }
+    packet_bufdone(pipeline, pkt);
     mcreq_wipe_packet(pipeline, pkt);
     mcreq_release_packet(pipeline, pkt);
 }
@@ -919,9 +1261,25 @@ void mcreq_reset_timeouts(mc_PIPELINE *pl, lcb_U64 nstime)
         MCREQ_PKT_RDATA(pkt)->start = nstime;
         MCREQ_PKT_RDATA(pkt)->deadline = nstime + old_timeout;
     }
+    tmoheap_rebuild(pl);
 }
 
-unsigned mcreq_pipeline_timeout(mc_PIPELINE *pl, lcb_STATUS err, mcreq_pktfail_fn failcb, void *cbarg, hrtime_t now)
+int mcreq_pipeline_next_deadline(mc_PIPELINE *pl, hrtime_t *deadline)
+{
+    mc_TMOHEAP *h = &pl->tmoheap;
+    while (h->size) {
+        mc_PACKET *pkt = tmoheap_entry_packet(pl, h->entries);
+        if (pkt) {
+            *deadline = h->entries[0].deadline;
+            return 1;
+        }
+        tmoheap_pop(h);
+        h->nstale++;
+    }
+    return 0;
+}
+
+static unsigned pipeline_fail_all(mc_PIPELINE *pl, lcb_STATUS err, mcreq_pktfail_fn failcb, void *cbarg)
 {
     sllist_iterator iter;
     unsigned count = 0;
@@ -929,14 +1287,48 @@ unsigned mcreq_pipeline_timeout(mc_PIPELINE *pl, lcb_STATUS err, mcreq_pktfail_f
     SLLIST_ITERFOR(&pl->requests, &iter)
     {
         mc_PACKET *pkt = SLLIST_ITEM(iter.cur, mc_PACKET, slnode);
-        mc_REQDATA *rd = MCREQ_PKT_RDATA(pkt);
-        if (now == 0 || rd->deadline <= now) {
-            sllist_iter_remove(&pl->requests, &iter);
-            failcb(pl, pkt, err, cbarg);
-            mcreq_packet_handled(pl, pkt);
-            count++;
+        pipeline_iter_remove(pl, &iter);
+        failcb(pl, pkt, err, cbarg);
+        mcreq_packet_handled(pl, pkt);
+        count++;
+    }
+    /* The failure callbacks may have enqueued new packets */
+    tmoheap_compact(pl);
+    return count;
+}
+
+unsigned mcreq_pipeline_timeout(mc_PIPELINE *pl, lcb_STATUS err, mcreq_pktfail_fn failcb, void *cbarg, hrtime_t now)
+{
+    mc_TMOHEAP *h = &pl->tmoheap;
+    unsigned count = 0;
+
+    if (now == 0) {
+        return pipeline_fail_all(pl, err, failcb, cbarg);
+    }
+
+    while (h->size && h->entries[0].deadline <= now) {
+        mc_TMOENTRY ent = h->entries[0];
+        mc_PACKET *pkt;
+        mc_REQDATA *rd;
+
+        tmoheap_pop(h);
+        pkt = tmoheap_entry_packet(pl, &ent);
+        if (!pkt) {
+            h->nstale++;
+            continue;
+        }
+        rd = MCREQ_PKT_RDATA(pkt);
+        if (rd->deadline > now) {
+            /* The deadline was extended after the packet was enqueued */
+            tmoheap_push(pl, pkt, rd->deadline);
+            continue;
         }
+        pipeline_unlink(pl, pktindex_lookup(&pl->pktindex, ent.opaque, pkt));
+        failcb(pl, pkt, err, cbarg);
+        mcreq_packet_handled(pl, pkt);
+        count++;
     }
+    h->nexpired += count;
     return count;
 }
 
@@ -955,7 +1347,7 @@ void mcreq_iterwipe(mc_CMDQUEUE *queue, mc_PIPELINE *src, mcreq_iterwipe_fn call
         mc_PACKET *orig = SLLIST_ITEM(iter.cur, mc_PACKET, slnode);
         rv = callback(queue, src, orig, arg);
         if (rv == MCREQ_REMOVE_PACKET) {
-            sllist_iter_remove(&src->requests, &iter);
+            pipeline_iter_remove(src, &iter);
         }
     }
 }
@@ -982,7 +1374,7 @@ static void do_fallback_flush(mc_PIPELINE *pipeline)
     {
         mc_PACKET *pkt = SLLIST_ITEM(iter.cur, mc_PACKET, slnode);
         fpl->handler(pipeline->parent, pkt);
-        sllist_iter_remove(&pipeline->requests, &iter);
+        pipeline_iter_remove(pipeline, &iter);
         mcreq_packet_handled(pipeline, pkt);
     }
 }
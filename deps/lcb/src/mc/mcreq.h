@@ -379,6 +379,53 @@ typedef struct mc_packet_st {
 
 /**@}*/
 
+/** @brief Single entry within the mc_PKTINDEX table */
+typedef struct {
+    uint32_t opaque;   /**< Cached copy of mc_PACKET::opaque */
+    mc_PACKET *pkt;    /**< The packet, or NULL if the slot is empty */
+    sllist_node *prev; /**< Node preceding the packet in mc_PIPELINE::requests */
+} mc_PKTSLOT;
+
+/**
+ * @brief Opaque-to-packet index for the pipeline's request log
+ *
+ * Open-addressing (linear probing) hash table which allows responses to be
+ * matched with their request, and the request to be unlinked from the
+ * singly-linked mc_PIPELINE::requests list, without walking the list.
+ * Entries are maintained by mcreq_enqueue_packet() and the various removal
+ * functions and should not be modified directly.
+ */
+typedef struct {
+    mc_PKTSLOT *slots;
+    unsigned capacity; /**< Number of slots; zero or a power of two */
+    unsigned count;    /**< Number of occupied slots */
+    unsigned shift;    /**< 32 - log2(capacity), used by the hash function */
+} mc_PKTINDEX;
+
+/** @brief Single entry within the mc_TMOHEAP */
+typedef struct {
+    hrtime_t deadline; /**< Deadline of the packet at the time it was inserted */
+    uint32_t opaque;   /**< Opaque of the packet, to validate against mc_PKTINDEX */
+    mc_PACKET *pkt;
+} mc_TMOENTRY;
+
+/**
+ * @brief Binary min-heap of in-flight packets ordered by their deadline
+ *
+ * Entries are not removed when a packet is completed; instead they are
+ * validated against the pipeline's mc_PKTINDEX when they reach the top of the
+ * heap and silently discarded if the packet is gone. The heap is compacted
+ * when stale entries start to outnumber the live ones.
+ */
+typedef struct {
+    mc_TMOENTRY *entries;
+    unsigned size;
+    unsigned capacity;
+    lcb_U64 nexpired;   /**< Number of packets failed because of their deadline */
+    lcb_U64 nstale;     /**< Number of entries discarded for completed packets */
+    lcb_U64 ncompacted; /**< Number of times the heap was compacted */
+} mc_TMOHEAP;
+
 /**
  * Callback invoked when APIs request that a pipeline start flushing. It
  * receives a pipeline object as its sole argument.
@@ -395,6 +442,12 @@ typedef struct mc_pipeline_st {
     /** List of requests. Newer requests are appended at the end */
     sllist_root requests;
 
+    /** Index of the `requests` list by opaque */
+    mc_PKTINDEX pktindex;
+
+    /** Packets within the `requests` list, ordered by deadline */
+    mc_TMOHEAP tmoheap;
+
     /** Parent command queue */
     struct mc_cmdqueue_st *parent;
 
@@ -427,6 +480,23 @@ typedef struct mc_pipeline_st {
 
     /** Optional metrics structure for server */
     struct lcb_SERVERMETRICS_st *metrics;
+
+    /**
+     * Additional pipelines for the same server index, when more than a single
+     * connection is opened to each node. Only the pipeline placed in
+     * mc_CMDQUEUE::pipelines has siblings; they share its `index`, and are
+     * chosen between by mcreq_pipeline_select()
+     */
+    struct mc_pipeline_st **siblings;
+
+    /** Number of entries in `siblings` */
+    unsigned nsiblings;
+
+    /**
+     * Total size of the packets which are scheduled on, or waiting for a
+     * response from this pipeline
+     */
+    uint64_t nbytes_outstanding;
 } mc_PIPELINE;
 
 typedef struct mc_cmdqueue_st {
@@ -669,6 +739,28 @@ lcb_STATUS mcreq_basic_packet(mc_CMDQUEUE *queue, const lcb_KEYBUF *key, uint32_
                               protocol_binary_request_header *req, lcb_uint8_t extlen, lcb_uint8_t ffextlen,
                               mc_PACKET **packet, mc_PIPELINE **pipeline, int options);
 
+/**
+ * Like mcreq_basic_packet(), but also takes the size of the value which is
+ * going to be reserved for the packet, so that large values can be placed on
+ * the pipeline reserved for them (see mcreq_pipeline_select())
+ * @param nvalue the size of the value, or 0 if the packet has none
+ */
+lcb_STATUS mcreq_basic_packet_ex(mc_CMDQUEUE *queue, const lcb_KEYBUF *key, uint32_t collection_id,
+                                 protocol_binary_request_header *req, lcb_uint8_t extlen, lcb_uint8_t ffextlen,
+                                 mc_PACKET **packet, mc_PIPELINE **pipeline, int options, uint32_t nvalue);
+
+/**
+ * Choose which of the pipelines serving a server index a new packet should
+ * be placed on. This is the pipeline itself unless it has siblings, in which
+ * case it is the one with the fewest outstanding bytes. If a large value
+ * threshold is configured, packets whose value is at least that large go to
+ * the last sibling, and other packets never do.
+ * @param pipeline the pipeline in mc_CMDQUEUE::pipelines for the server index
+ * @param nvalue the size of the packet's value, or 0
+ * @return the pipeline on which to allocate and schedule the packet
+ */
+mc_PIPELINE *mcreq_pipeline_select(mc_PIPELINE *pipeline, uint32_t nvalue);
+
 /**
  * @brief Get the key from a packet
  * @param[in] packet The packet from which to retrieve the key
@@ -771,12 +863,14 @@ void mcreq_sched_leave(struct mc_cmdqueue_st *queue, int do_flush);
 void mcreq_sched_fail(struct mc_cmdqueue_st *queue);
 
 /**
- * Find a packet with the given opaque value
+ * Find a packet with the given opaque value. This is a constant time lookup
+ * via mc_PIPELINE::pktindex
  */
 mc_PACKET *mcreq_pipeline_find(mc_PIPELINE *pipeline, uint32_t opaque);
 
 /**
- * Find and remove the packet with the given opaque value
+ * Find and remove the packet with the given opaque value. Like
+ * mcreq_pipeline_find(), this does not need to traverse the request list
  */
 mc_PACKET *mcreq_pipeline_remove(mc_PIPELINE *pipeline, uint32_t opaque);
 
@@ -858,6 +952,17 @@ void mcreq_reset_timeouts(mc_PIPELINE *pl, lcb_U64 nstime);
 
 void mcreq_rearm_timeout(mc_PIPELINE *pipeline);
 
+/**
+ * Get the earliest deadline of all the packets in the pipeline's request log.
+ * This is O(1) amortized as it only inspects the top of mc_PIPELINE::tmoheap.
+ *
+ * @param pipeline the pipeline
+ * @param[out] deadline set to the earliest deadline
+ * @return nonzero if the pipeline has pending packets, zero otherwise (in which
+ * case `deadline` is not modified)
+ */
+int mcreq_pipeline_next_deadline(mc_PIPELINE *pipeline, hrtime_t *deadline);
+
 /**
  * Callback to be invoked when a packet is about to be failed out from the
  * request queue. This should be used to possibly invoke handlers. The packet
@@ -886,7 +991,11 @@ unsigned mcreq_pipeline_fail(mc_PIPELINE *pipeline, lcb_STATUS err, mcreq_pktfai
 /**
  * Fail out all commands in the pipeline which are older than a specified
  * interval. This is similar to the pipeline_fail() function except that commands
- * which are newer than the threshold are still kept
+ * which are newer than the threshold are still kept.
+ *
+ * Expired commands are taken from mc_PIPELINE::tmoheap so the cost is
+ * proportional to the number of commands failed rather than to the number
+ * of commands pending.
  *
  * @param pipeline the pipeline to fail out
  * @param err the error to provide to the handlers (usually LCB_ERR_TIMEOUT)
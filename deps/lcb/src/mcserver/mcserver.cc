@@ -115,10 +115,15 @@ void lcb_sched_flush(lcb_INSTANCE *instance)
     for (size_t ii = 0; ii < LCBT_NSERVERS(instance); ii++) {
         Server *server = instance->get_server(ii);
 
-        if (!server->has_pending()) {
-            continue;
+        if (server->has_pending()) {
+            server->flush_start(server);
+        }
+        for (unsigned jj = 0; jj < server->nsiblings; jj++) {
+            Server *sibling = server->get_sibling(jj);
+            if (sibling && sibling->has_pending()) {
+                sibling->flush_start(sibling);
+            }
         }
-        server->flush_start(server);
     }
 }
 
@@ -181,6 +186,78 @@ bool Server::handle_nmv(MemcachedResponse &resinfo, mc_PACKET *oldpkt)
     return true;
 }
 
+/**
+ * Invoked for packets which the server sends on its own on a DUPLEX
+ * connection. None of them expects a response from us.
+ */
+void Server::handle_server_request(MemcachedResponse &request)
+{
+    switch (request.opcode()) {
+        case PROTOCOL_BINARY_CMD_SERVER_CLUSTERMAP_CHANGE_NOTIFICATION:
+            handle_config_push(request);
+            break;
+        default:
+            lcb_log(LOGARGS_T(DEBUG), LOGFMT "Ignoring unknown server request (OP=0x%x, SEQ=%u)", LOGID_T(),
+                    request.opcode(), request.opaque());
+            break;
+    }
+}
+
+/**
+ * Invoked when the server notifies us of a new cluster map. Every node sends
+ * the same map, so the revision in the extras is checked first to avoid
+ * parsing the maps which would be discarded by the monitor anyway.
+ */
+void Server::handle_config_push(MemcachedResponse &request)
+{
+    if (request.keylen() && settings->bucket &&
+        (request.keylen() != strlen(settings->bucket) ||
+         memcmp(request.key(), settings->bucket, request.keylen()) != 0)) {
+        lcb_log(LOGARGS_T(DEBUG), LOGFMT "Ignoring cluster map change for another bucket \"%.*s\"", LOGID_T(),
+                (int)request.keylen(), request.key());
+        return;
+    }
+
+    int64_t epoch = -1, rev = -1;
+    if (request.extlen() == sizeof(uint32_t)) {
+        uint32_t rev32;
+        memcpy(&rev32, request.ext(), sizeof(rev32));
+        rev = ntohl(rev32);
+    } else if (request.extlen() == 2 * sizeof(uint64_t)) {
+        uint64_t tmp;
+        memcpy(&tmp, request.ext(), sizeof(tmp));
+        epoch = static_cast<int64_t>(lcb_ntohll(tmp));
+        memcpy(&tmp, request.ext() + sizeof(tmp), sizeof(tmp));
+        rev = static_cast<int64_t>(lcb_ntohll(tmp));
+    }
+
+    lcb::clconfig::ConfigInfo *cur = instance->cur_configinfo;
+    if (rev >= 0 && cur != nullptr) {
+        const lcbvb_CONFIG *vbc = cur->vbc;
+        bool stale = epoch >= 0 ? epoch < vbc->revepoch || (epoch == vbc->revepoch && rev <= vbc->revid)
+                                : rev <= vbc->revid;
+        if (stale) {
+            lcb_log(LOGARGS_T(TRACE), LOGFMT "Ignoring pushed cluster map %" PRId64 ":%" PRId64 ", have %" PRId64
+                    ":%" PRId64, LOGID_T(), epoch, rev, vbc->revepoch, vbc->revid);
+            return;
+        }
+    }
+
+    lcb_log(LOGARGS_T(DEBUG), LOGFMT "Server pushed cluster map %" PRId64 ":%" PRId64, LOGID_T(), epoch, rev);
+
+    lcb::clconfig::Provider *cccp = instance->confmon->get_provider(lcb::clconfig::CLCONFIG_CCCP);
+    lcb_STATUS err = LCB_ERR_GENERIC;
+    if (request.vallen() && cccp->enabled) {
+        std::string s(request.value(), request.vallen());
+        err = lcb::clconfig::cccp_update(cccp, curhost->host, s.c_str());
+    }
+    if (err != LCB_SUCCESS) {
+        // Without a (usable) map in the notification we still know that ours
+        // is stale, so go and fetch the new one
+        instance->bootstrap(BS_REFRESH_THROTTLE);
+    }
+}
+
 struct packet_wrapper {
     lcb_KEYBUF key{};
     const char *scope = nullptr;
@@ -462,7 +539,7 @@ Server::ReadState Server::try_read(lcbio_CTX *ctx, rdb_IOROPE *ior)
     unsigned pktsize = 24, is_last = 1;
 
 #define RETURN_NEED_MORE(n)                                                                                            \
-    if (has_pending()) {                                                                                               \
+    if (has_pending() || config_push) {                                                                                \
         lcbio_ctx_rwant(ctx, n);                                                                                       \
     }                                                                                                                  \
     return PKT_READ_PARTIAL
@@ -494,6 +571,13 @@ Server::ReadState Server::try_read(lcbio_CTX *ctx, rdb_IOROPE *ior)
         RETURN_NEED_MORE(pktsize);
     }
 
+    if (mcresp.magic() == PROTOCOL_BINARY_SREQ) {
+        DO_ASSIGN_PAYLOAD()
+        handle_server_request(mcresp);
+        DO_SWALLOW_PAYLOAD()
+        return PKT_READ_COMPLETE;
+    }
+
     /* Find the packet */
     if (mcresp.opcode() == PROTOCOL_BINARY_CMD_STAT && mcresp.keylen() != 0) {
         is_last = 0;
@@ -860,26 +944,13 @@ static void flush_errdrain(mc_PIPELINE *pipeline)
 
 uint32_t Server::next_timeout() const
 {
-    hrtime_t now, expiry, diff, min = 0;
-    mc_PACKET *pkt = nullptr;
-
-    sllist_iterator iter;
-    SLLIST_ITERFOR(const_cast<sllist_root *>(&requests), &iter)
-    {
-        mc_PACKET *p = SLLIST_ITEM(iter.cur, mc_PACKET, slnode);
-        hrtime_t deadline = MCREQ_PKT_RDATA(p)->deadline;
-        if (pkt == nullptr || deadline < min) {
-            min = deadline;
-            pkt = p;
-        }
-    }
+    hrtime_t now, expiry, diff;
 
-    if (!pkt) {
+    if (!mcreq_pipeline_next_deadline(const_cast<Server *>(this), &expiry)) {
         return default_timeout();
     }
 
     now = gethrtime();
-    expiry = MCREQ_PKT_RDATA(pkt)->deadline;
     if (expiry <= now) {
         diff = 0;
     } else {
@@ -993,6 +1064,8 @@ void Server::handle_connected(lcbio_SOCKET *sock, lcb_STATUS err, lcbio_OSERR sy
         new_durability = sessinfo->has_feature(PROTOCOL_BINARY_FEATURE_SYNC_REPLICATION) &&
                          sessinfo->has_feature(PROTOCOL_BINARY_FEATURE_ALT_REQUEST_SUPPORT);
         selected_bucket = sessinfo->selected_bucket();
+        config_push = sessinfo->has_feature(PROTOCOL_BINARY_FEATURE_DUPLEX) &&
+                      sessinfo->has_feature(PROTOCOL_BINARY_FEATURE_CLUSTERMAP_CHANGE_NOTIFICATION);
         if (selected_bucket) {
             bucket = sessinfo->bucket_name();
         } else if (settings->conntype == LCB_TYPE_BUCKET && settings->bucket) {
@@ -1000,9 +1073,10 @@ void Server::handle_connected(lcbio_SOCKET *sock, lcb_STATUS err, lcbio_OSERR sy
         }
         lcb_log(
             LOGARGS_T(TRACE),
-            R"(<%s:%s> (SRV=%p) Got new KV connection (json=%s, snappy=%s, mt=%s, durability=%s, bucket=%s "%s"%s%s))",
+            R"(<%s:%s> (SRV=%p) Got new KV connection (json=%s, snappy=%s, mt=%s, durability=%s, push=%s, bucket=%s "%s"%s%s))",
             curhost->host, curhost->port, (void *)this, jsonsupport ? "yes" : "no", compsupport ? "yes" : "no",
-            mutation_tokens ? "yes" : "no", new_durability ? "yes" : "no", selected_bucket ? "yes" : "no",
+            mutation_tokens ? "yes" : "no", new_durability ? "yes" : "no", config_push ? "yes" : "no",
+            selected_bucket ? "yes" : "no",
             selected_bucket ? bucket.c_str() : "-", try_to_select_bucket ? " selecting " : "",
             try_to_select_bucket ? settings->bucket : "");
     }
@@ -1036,16 +1110,32 @@ void Server::connect()
     state = Server::S_CLEAN;
 }
 
-static void buf_done_cb(mc_PIPELINE *pl, const void *cookie, void *, void *)
+static void buf_done_cb(mc_PIPELINE *pl, const void *cookie, void *, void *vbuf)
 {
     auto *server = static_cast<Server *>(pl);
+    if (vbuf != nullptr) {
+        server->unpin_value(vbuf);
+    }
     server->instance->callbacks.pktflushed(server->instance, cookie);
 }
 
-Server::Server(lcb_INSTANCE *instance_, int ix)
+Server::Server(lcb_INSTANCE *instance_, int ix) : Server(instance_, ix, nullptr)
+{
+    lcb_U32 nconns = settings->kv_connections_per_node;
+    if (nconns > 1) {
+        siblings = static_cast<mc_PIPELINE **>(calloc(nconns - 1, sizeof(*siblings)));
+        for (unsigned ii = 0; ii < nconns - 1; ii++) {
+            siblings[ii] = new Server(instance_, ix, this);
+        }
+        nsiblings = nconns - 1;
+    }
+}
+
+Server::Server(lcb_INSTANCE *instance_, int ix, Server *primary_)
     : mc_PIPELINE(), state(S_CLEAN), io_timer(lcbio_timer_new(instance_->iotable, this, timeout_server)),
       instance(instance_), settings(lcb_settings_ref2(instance_->settings)), compsupport(0), jsonsupport(0),
-      mutation_tokens(0), new_durability(-1), selected_bucket(0), connctx(nullptr), curhost(new lcb_host_t())
+      mutation_tokens(0), new_durability(-1), selected_bucket(0), primary(primary_), connctx(nullptr),
+      curhost(new lcb_host_t())
 {
     mcreq_pipeline_init(this);
     flush_start = (mcreq_flushstart_fn)server_connect;
@@ -1079,7 +1169,13 @@ Server::~Server()
         return;
     }
 
-    if (this->instance) {
+    if (primary) {
+        for (unsigned ii = 0; ii < primary->nsiblings; ii++) {
+            if (primary->siblings[ii] == this) {
+                primary->siblings[ii] = nullptr;
+            }
+        }
+    } else if (this->instance) {
         unsigned ii;
         mc_CMDQUEUE *cmdq = &this->instance->cmdq;
         for (ii = 0; ii < cmdq->npipelines; ii++) {
@@ -1090,6 +1186,15 @@ Server::~Server()
             }
         }
     }
+    for (unsigned ii = 0; ii < nsiblings; ii++) {
+        if (siblings[ii]) {
+            get_sibling(ii)->primary = nullptr;
+        }
+    }
+    free(siblings);
+    siblings = nullptr;
+    nsiblings = 0;
+
     this->instance = nullptr;
     purge(LCB_ERR_REQUEST_CANCELED, 0, Server::REFRESH_NEVER);
 
@@ -1137,6 +1242,11 @@ void Server::close()
 {
     /* Should never be called twice */
     lcb_assert(state != Server::S_CLOSED);
+    for (unsigned ii = 0; ii < nsiblings; ii++) {
+        if (siblings[ii]) {
+            get_sibling(ii)->close();
+        }
+    }
     start_errored_ctx(S_CLOSED);
 }
 
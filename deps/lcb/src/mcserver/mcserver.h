@@ -24,6 +24,9 @@
 #include <netbuf/netbuf.h>
 
 #ifdef __cplusplus
+#include <memory>
+#include <unordered_map>
+
 namespace lcb
 {
 
@@ -44,6 +47,13 @@ class Server : public mc_PIPELINE
      */
     Server(lcb_INSTANCE *, int);
 
+    /**
+     * Allocate an additional connection to the node at the given index, which
+     * is owned by (and listed in the siblings of) `primary`. The primary
+     * server opens `kv_connections_per_node - 1` of these itself.
+     */
+    Server(lcb_INSTANCE *, int, Server *primary);
+
     /**
      * Close the server. The resources of the server may still continue to persist
      * internally for a bit until all callbacks have been delivered and all buffers
@@ -51,6 +61,16 @@ class Server : public mc_PIPELINE
      */
     void close();
 
+    /**
+     * Get the server of an additional connection to the same node
+     * @param ix index of the sibling, less than mc_PIPELINE::nsiblings
+     * @return the server, or nullptr if it has already been destroyed
+     */
+    Server *get_sibling(unsigned ix) const
+    {
+        return static_cast<Server *>(siblings[ix]);
+    }
+
     /**
      * Schedule a flush and potentially flush some immediate data on the server.
      * This is safe to call multiple times, however performance considerations
@@ -140,6 +160,23 @@ class Server : public mc_PIPELINE
         return connctx != nullptr;
     }
 
+    /**
+     * Keep a caller-owned value buffer alive for as long as a packet on this pipeline references it. The reference
+     * is dropped by the buffer-done callback once the packet has been flushed and completed (or discarded).
+     */
+    void pin_value(const void *vbuf, std::shared_ptr<void> owner)
+    {
+        pinned_values.emplace(vbuf, std::move(owner));
+    }
+
+    void unpin_value(const void *vbuf)
+    {
+        auto it = pinned_values.find(vbuf);
+        if (it != pinned_values.end()) {
+            pinned_values.erase(it);
+        }
+    }
+
     /** "Temporary" constructor. Only for use in retry queue */
     Server();
     ~Server();
@@ -200,6 +237,8 @@ class Server : public mc_PIPELINE
     int handle_unknown_error(const mc_PACKET *request, const MemcachedResponse &resinfo, lcb_STATUS &newerr);
     bool handle_nmv(MemcachedResponse &resinfo, mc_PACKET *oldpkt);
     bool handle_unknown_collection(MemcachedResponse &resinfo, mc_PACKET *oldpkt);
+    void handle_server_request(MemcachedResponse &request);
+    void handle_config_push(MemcachedResponse &request);
 
     bool maybe_retry_packet(mc_PACKET *pkt, lcb_STATUS err, protocol_binary_response_status status);
     bool maybe_reconnect_on_fake_timeout(lcb_STATUS received_error);
@@ -232,12 +271,21 @@ class Server : public mc_PIPELINE
     /** Whether bucket has been selected */
     short selected_bucket{};
 
+    /** Whether the server pushes cluster map changes on this connection */
+    short config_push{};
+
+    /** Server owning this one as an additional connection, if any */
+    Server *primary{};
+
     lcbio_CTX *connctx;
     lcb::io::ConnectionRequest *connreq{};
 
     /** Request for current connection */
     lcb_host_t *curhost;
     std::string bucket{}; /** non-empty if bucket has been selected */
+
+    /** Borrowed value buffers referenced by packets on this pipeline, see pin_value() */
+    std::unordered_multimap<const void *, std::shared_ptr<void>> pinned_values{};
 };
 } // namespace lcb
 #endif /* __cplusplus */
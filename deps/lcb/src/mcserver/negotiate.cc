@@ -448,6 +448,10 @@ bool SessionRequestImpl::send_hello()
     if (settings->enable_unordered_execution) {
         features[nfeatures++] = PROTOCOL_BINARY_FEATURE_UNORDERED_EXECUTION;
     }
+    if (settings->enable_config_push) {
+        features[nfeatures++] = PROTOCOL_BINARY_FEATURE_DUPLEX;
+        features[nfeatures++] = PROTOCOL_BINARY_FEATURE_CLUSTERMAP_CHANGE_NOTIFICATION;
+    }
     features[nfeatures++] = PROTOCOL_BINARY_FEATURE_CREATE_AS_DELETED;
     features[nfeatures++] = PROTOCOL_BINARY_FEATURE_PRESERVE_TTL;
 
@@ -581,6 +585,14 @@ GT_NEXT_PACKET:
         LCBIO_CTX_RSCHEDULE(ioctx, required);
         return;
     }
+    if (resp.magic() == PROTOCOL_BINARY_SREQ) {
+        // Server initiated requests are only of interest once the connection
+        // has been handed over to the pipeline, which fetches the config anyway
+        lcb_log(LOGARGS(this, TRACE), LOGFMT "Ignoring server request during negotiation. OP=0x%x", LOGID(this),
+                resp.opcode());
+        resp.release(ioctx);
+        goto GT_NEXT_PACKET;
+    }
     const uint16_t status = resp.status();
 
     switch (resp.opcode()) {
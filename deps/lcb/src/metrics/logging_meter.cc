@@ -26,7 +26,7 @@ extern "C" {
 static void mlm_destructor(const lcbmetrics_METER *wrapper)
 {
     if (wrapper != nullptr && wrapper->cookie_ != nullptr) {
-        auto *meter = reinterpret_cast<LoggingMeter *>(wrapper->cookie_);
+        auto *meter = reinterpret_cast<AggregatingMeter *>(wrapper->cookie_);
         delete meter;
     }
 }
@@ -38,7 +38,7 @@ static const lcbmetrics_VALUERECORDER *mlm_find_value_recorder(const lcbmetrics_
         return nullptr;
     }
 
-    auto *meter = reinterpret_cast<LoggingMeter *>(wrapper->cookie_);
+    auto *meter = reinterpret_cast<AggregatingMeter *>(wrapper->cookie_);
     return meter->findValueRecorder(name, tags, ntags);
 }
 
@@ -61,15 +61,45 @@ static void mlvr_record_value(const lcbmetrics_VALUERECORDER *wrapper, uint64_t
 }
 }
 
-LoggingMeter::LoggingMeter(lcb_INSTANCE *instance) : settings_(instance->settings), timer_(instance->iotable, this)
+LIBCOUCHBASE_API
+lcb_STATUS lcbmetrics_meter_create_aggregating(lcbmetrics_METER **meter)
 {
-    lcb_U32 tv = settings_->op_metrics_flush_interval;
-    if (tv > 0) {
-        timer_.rearm(tv);
+    // The wrapper is owned by the meter, but freed by lcbmetrics_meter_destroy().
+    *meter = const_cast<lcbmetrics_METER *>((new AggregatingMeter())->wrap());
+    return LCB_SUCCESS;
+}
+
+LIBCOUCHBASE_API
+lcb_STATUS lcbmetrics_meter_summarize(const lcbmetrics_METER *meter, int reset, lcbmetrics_SUMMARY_CALLBACK callback,
+                                      void *cookie)
+{
+    AggregatingMeter *aggregating = AggregatingMeter::unwrap(meter);
+    if (aggregating == nullptr || callback == nullptr) {
+        return LCB_ERR_UNSUPPORTED_OPERATION;
     }
+
+    aggregating->summarize(reset != 0, callback, cookie);
+    return LCB_SUCCESS;
 }
 
-const lcbmetrics_METER *LoggingMeter::wrap()
+LIBCOUCHBASE_API
+lcb_STATUS lcbmetrics_meter_percentile(const lcbmetrics_METER *meter, const char *service, const char *operation,
+                                       double percentile, uint64_t *value)
+{
+    *value = 0;
+    AggregatingMeter *aggregating = AggregatingMeter::unwrap(meter);
+    if (aggregating == nullptr) {
+        return LCB_ERR_UNSUPPORTED_OPERATION;
+    }
+    if (service == nullptr || operation == nullptr || percentile < 0.0 || percentile > 100.0) {
+        return LCB_ERR_INVALID_ARGUMENT;
+    }
+
+    *value = aggregating->percentile(service, operation, percentile);
+    return LCB_SUCCESS;
+}
+
+const lcbmetrics_METER *AggregatingMeter::wrap()
 {
     if (wrapper_ != nullptr) {
         return wrapper_;
@@ -82,6 +112,81 @@ const lcbmetrics_METER *LoggingMeter::wrap()
     return wrapper_;
 }
 
+AggregatingMeter *AggregatingMeter::unwrap(const lcbmetrics_METER *wrapper)
+{
+    if (wrapper == nullptr || wrapper->destructor_ != mlm_destructor) {
+        return nullptr;
+    }
+    return reinterpret_cast<AggregatingMeter *>(wrapper->cookie_);
+}
+
+const lcbmetrics_VALUERECORDER *AggregatingMeter::findValueRecorder(const char *name, const lcbmetrics_TAG *tags,
+                                                                    size_t ntags)
+{
+    // Every instance sharing this meter caches, and eventually destroys, the
+    // recorders it is given, so each of them gets a wrapper of its own.
+    LoggingValueRecorder *recorder = lookupRecorder(name, tags, ntags);
+    if (recorder == nullptr) {
+        return nullptr;
+    }
+    return recorder->wrapBorrowed();
+}
+
+LoggingValueRecorder *AggregatingMeter::lookupRecorder(const char *name, const lcbmetrics_TAG *tags, size_t ntags)
+{
+    if (strcmp(name, METRICS_OPS_METER_NAME) != 0) {
+        return nullptr;
+    }
+
+    const char *svcName = "";
+    const char *opName = "";
+    for (size_t i = 0; i < ntags; ++i) {
+        if (strcmp(tags[i].key, METRICS_SVC_TAG_NAME) == 0) {
+            svcName = tags[i].value;
+        } else if (strcmp(tags[i].key, METRICS_OP_TAG_NAME) == 0) {
+            opName = tags[i].value;
+        }
+    }
+
+    auto &first = valueRecorders_[svcName];
+    return &first[opName];
+}
+
+void AggregatingMeter::summarize(bool reset, lcbmetrics_SUMMARY_CALLBACK callback, void *cookie)
+{
+    for (auto &it : valueRecorders_) {
+        for (auto &it2 : it.second) {
+            lcbmetrics_SUMMARY summary{};
+            summary.service = it.first.c_str();
+            summary.operation = it2.first.c_str();
+            it2.second.summarize(&summary, reset);
+            callback(&summary, cookie);
+        }
+    }
+}
+
+std::uint64_t AggregatingMeter::percentile(const char *service, const char *operation, double percentile) const
+{
+    // Unlike lookupRecorder(), this must not create the operation.
+    auto it = valueRecorders_.find(service);
+    if (it == valueRecorders_.end()) {
+        return 0;
+    }
+    auto it2 = it->second.find(operation);
+    if (it2 == it->second.end()) {
+        return 0;
+    }
+    return it2->second.valueAtPercentile(percentile);
+}
+
+LoggingMeter::LoggingMeter(lcb_INSTANCE *instance) : settings_(instance->settings), timer_(instance->iotable, this)
+{
+    lcb_U32 tv = settings_->op_metrics_flush_interval;
+    if (tv > 0) {
+        timer_.rearm(tv);
+    }
+}
+
 void LoggingMeter::flush()
 {
     Json::Value meta;
@@ -112,28 +217,11 @@ void LoggingMeter::flush()
 const lcbmetrics_VALUERECORDER *LoggingMeter::findValueRecorder(const char *name, const lcbmetrics_TAG *tags,
                                                                 size_t ntags)
 {
-    if (strcmp(name, METRICS_OPS_METER_NAME) != 0) {
+    LoggingValueRecorder *recorder = lookupRecorder(name, tags, ntags);
+    if (recorder == nullptr) {
         return nullptr;
     }
-
-    const char *svcName = "";
-    const char *opName = "";
-    for (size_t i = 0; i < ntags; ++i) {
-        if (strcmp(tags[i].key, METRICS_SVC_TAG_NAME) == 0) {
-            svcName = tags[i].value;
-        } else if (strcmp(tags[i].key, METRICS_OP_TAG_NAME) == 0) {
-            opName = tags[i].value;
-        }
-    }
-
-    return findValueRecorder(svcName, opName).wrap();
-}
-
-LoggingValueRecorder &LoggingMeter::findValueRecorder(const char *svcName, const char *opName)
-{
-    auto &first = valueRecorders_[svcName];
-    auto &recorder = first[opName];
-    return recorder;
+    return recorder->wrap();
 }
 
 LoggingValueRecorder::LoggingValueRecorder() : wrapper_(nullptr), histogram_(nullptr)
@@ -166,31 +254,53 @@ const lcbmetrics_VALUERECORDER *LoggingValueRecorder::wrap()
     return wrapper_;
 }
 
+lcbmetrics_VALUERECORDER *LoggingValueRecorder::wrapBorrowed()
+{
+    auto *wrapper = new lcbmetrics_VALUERECORDER();
+    wrapper->cookie_ = this;
+    wrapper->destructor_ = nullptr;
+    wrapper->record_value_ = mlvr_record_value;
+    return wrapper;
+}
+
 void LoggingValueRecorder::recordValue(std::uint64_t value)
 {
     hdr_record_value(histogram_, value);
 }
 
-Json::Value LoggingValueRecorder::flush()
+std::uint64_t LoggingValueRecorder::valueAtPercentile(double percentile) const
+{
+    return hdr_value_at_percentile(histogram_, percentile);
+}
+
+void LoggingValueRecorder::summarize(lcbmetrics_SUMMARY *summary, bool reset)
 {
-    auto total_count = histogram_->total_count;
-    auto val_500 = hdr_value_at_percentile(histogram_, 50.0);
-    auto val_900 = hdr_value_at_percentile(histogram_, 90.0);
-    auto val_990 = hdr_value_at_percentile(histogram_, 99.0);
-    auto val_999 = hdr_value_at_percentile(histogram_, 99.9);
-    auto val_1000 = hdr_value_at_percentile(histogram_, 100.0);
+    summary->total_count = histogram_->total_count;
+    summary->p50 = hdr_value_at_percentile(histogram_, 50.0);
+    summary->p90 = hdr_value_at_percentile(histogram_, 90.0);
+    summary->p99 = hdr_value_at_percentile(histogram_, 99.0);
+    summary->p999 = hdr_value_at_percentile(histogram_, 99.9);
+    summary->p100 = hdr_value_at_percentile(histogram_, 100.0);
 
-    hdr_reset(histogram_);
+    if (reset) {
+        hdr_reset(histogram_);
+    }
+}
+
+Json::Value LoggingValueRecorder::flush()
+{
+    lcbmetrics_SUMMARY summary{};
+    summarize(&summary, true);
 
     Json::Value percentiles;
-    percentiles["50.0"] = Json::Int64(val_500);
-    percentiles["90.0"] = Json::Int64(val_900);
-    percentiles["99.0"] = Json::Int64(val_990);
-    percentiles["99.9"] = Json::Int64(val_999);
-    percentiles["100.0"] = Json::Int64(val_1000);
+    percentiles["50.0"] = Json::Int64(summary.p50);
+    percentiles["90.0"] = Json::Int64(summary.p90);
+    percentiles["99.0"] = Json::Int64(summary.p99);
+    percentiles["99.9"] = Json::Int64(summary.p999);
+    percentiles["100.0"] = Json::Int64(summary.p100);
 
     Json::Value top;
-    top["total_count"] = Json::Int64(total_count);
+    top["total_count"] = Json::Int64(summary.total_count);
     top["percentiles_us"] = percentiles;
 
     return top;
@@ -40,8 +40,18 @@ class LoggingValueRecorder
 
     const lcbmetrics_VALUERECORDER *wrap();
 
+    /**
+     * Returns a new wrapper for this recorder, which may be destroyed by its
+     * user without affecting the recorder itself.
+     */
+    lcbmetrics_VALUERECORDER *wrapBorrowed();
+
     void recordValue(std::uint64_t value);
 
+    std::uint64_t valueAtPercentile(double percentile) const;
+
+    void summarize(lcbmetrics_SUMMARY *summary, bool reset);
+
     Json::Value flush();
 
   protected:
@@ -49,24 +59,46 @@ class LoggingValueRecorder
     struct hdr_histogram *histogram_;
 };
 
-class LoggingMeter
+/**
+ * Aggregates the latencies of each service/operation pair in a histogram,
+ * which the application reads with lcbmetrics_meter_summarize().
+ */
+class AggregatingMeter
 {
   public:
-    explicit LoggingMeter(lcb_INSTANCE *lcb);
+    virtual ~AggregatingMeter() = default;
 
     const lcbmetrics_METER *wrap();
 
-    const lcbmetrics_VALUERECORDER *findValueRecorder(const char *name, const lcbmetrics_TAG *tags, size_t ntags);
+    static AggregatingMeter *unwrap(const lcbmetrics_METER *wrapper);
 
-    void flush();
+    virtual const lcbmetrics_VALUERECORDER *findValueRecorder(const char *name, const lcbmetrics_TAG *tags,
+                                                              size_t ntags);
+
+    void summarize(bool reset, lcbmetrics_SUMMARY_CALLBACK callback, void *cookie);
+
+    std::uint64_t percentile(const char *service, const char *operation, double percentile) const;
 
   protected:
-    LoggingValueRecorder &findValueRecorder(const char *svcName, const char *opName);
+    LoggingValueRecorder *lookupRecorder(const char *name, const lcbmetrics_TAG *tags, size_t ntags);
 
     lcbmetrics_METER *wrapper_{nullptr};
+    std::unordered_map<std::string, std::unordered_map<std::string, LoggingValueRecorder>> valueRecorders_;
+};
+
+class LoggingMeter : public AggregatingMeter
+{
+  public:
+    explicit LoggingMeter(lcb_INSTANCE *lcb);
+
+    const lcbmetrics_VALUERECORDER *findValueRecorder(const char *name, const lcbmetrics_TAG *tags,
+                                                      size_t ntags) override;
+
+    void flush();
+
+  protected:
     lcb_settings *settings_;
     lcb::io::Timer<LoggingMeter, &LoggingMeter::flush> timer_;
-    std::unordered_map<std::string, std::unordered_map<std::string, LoggingValueRecorder>> valueRecorders_;
 };
 
 } // namespace metrics
@@ -37,6 +37,7 @@ struct lcbmetrics_METER_ {
     lcbmetrics_VALUE_RECORDER_CALLBACK value_recorder_;
 };
 
+void record_op_latency(const char *op, const char *svc, struct lcb_settings_st *settings, hrtime_t start);
 void record_kv_op_latency(const char *op, lcb_INSTANCE *instance, mc_PACKET *request);
 void record_kv_op_latency_store(lcb_INSTANCE *instance, mc_PACKET *request, lcb_RESPSTORE *response);
 void record_http_op_latency(const char *op, const char *svc, lcb_INSTANCE *instance, hrtime_t start);
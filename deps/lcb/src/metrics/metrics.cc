@@ -100,3 +100,25 @@ void lcbmetrics_valuerecorder_destroy(const lcbmetrics_VALUERECORDER *recorder)
         delete recorder;
     }
 }
+
+#ifndef LCB_USE_HDR_HISTOGRAM
+LIBCOUCHBASE_API
+lcb_STATUS lcbmetrics_meter_create_aggregating(lcbmetrics_METER **meter)
+{
+    *meter = nullptr;
+    return LCB_ERR_UNSUPPORTED_OPERATION;
+}
+
+LIBCOUCHBASE_API
+lcb_STATUS lcbmetrics_meter_summarize(const lcbmetrics_METER *, int, lcbmetrics_SUMMARY_CALLBACK, void *)
+{
+    return LCB_ERR_UNSUPPORTED_OPERATION;
+}
+
+LIBCOUCHBASE_API
+lcb_STATUS lcbmetrics_meter_percentile(const lcbmetrics_METER *, const char *, const char *, double, uint64_t *value)
+{
+    *value = 0;
+    return LCB_ERR_UNSUPPORTED_OPERATION;
+}
+#endif
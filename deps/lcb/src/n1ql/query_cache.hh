@@ -22,10 +22,14 @@
 #include <cstdint>
 #include <chrono>
 #include <string>
-#include <map>
 #include <list>
+#include <unordered_map>
+#include <vector>
+
+#include <libcouchbase/couchbase.h>
 
 #include "contrib/lcb-jsoncpp/lcb-jsoncpp.h"
+#include "capi/cmd_query.hh"
 
 class Plan
 {
@@ -41,22 +45,14 @@ class Plan
      * Json::Value directly, as this appears to be horribly slow. On my system
      * an assignment took about 200ms!
      * @param body The request body (e.g. lcb_QUERY_HANDLE_::json)
+     * @param raw_options The options of the request which are already encoded
      * @param[out] bodystr the actual request payload
      */
-    void apply_plan(Json::Value &body, std::string &bodystr) const
+    void apply_plan(Json::Value &body, const std::vector<lcb::query_raw_option> &raw_options,
+                    std::string &bodystr) const
     {
         body.removeMember("statement");
-        bodystr = Json::FastWriter().write(body);
-
-        // Assume bodystr ends with '}'
-        size_t pos = bodystr.rfind('}');
-        bodystr.erase(pos);
-
-        if (!body.empty()) {
-            bodystr.append(",");
-        }
-        bodystr.append(planstr);
-        bodystr.append("}");
+        lcb::write_query_body(body, raw_options, planstr, bodystr);
     }
 
   private:
@@ -82,15 +78,28 @@ class Plan
  */
 // LRU Cache structure..
 struct lcb_QUERY_CACHE_ {
-    ~lcb_QUERY_CACHE_()
+    /** Number of plans kept unless configured otherwise */
+    enum : std::size_t { default_capacity = 5000 };
+
+    explicit lcb_QUERY_CACHE_(std::size_t capacity = default_capacity) : capacity_(capacity) {}
+
+    /** Maximum number of entries in LRU cache (LCB_CNTL_QUERY_CACHE_SIZE) */
+    std::size_t max_size() const
     {
-        clear();
+        return capacity_;
     }
 
-    /** Maximum number of entries in LRU cache. This is fixed at 5000 */
-    static size_t max_size()
+    /**
+     * Changes the maximum number of entries, evicting the least recently
+     * used plans which no longer fit.
+     * @param capacity new capacity, must be at least 1
+     */
+    void max_size(std::size_t capacity)
     {
-        return 5000;
+        capacity_ = capacity;
+        while (lru.size() > capacity_) {
+            evict();
+        }
     }
 
     /**
@@ -101,18 +110,17 @@ struct lcb_QUERY_CACHE_ {
      */
     const Plan &add_entry(const std::string &key, const Json::Value &json, bool include_encoded_plan = true)
     {
-        if (lru.size() == max_size()) {
-            // Purge entry from end
-            remove_entry(lru.back()->key);
-        }
-
         // Remove old entry, if present
         remove_entry(key);
 
-        lru.push_front(new Plan(key));
+        while (lru.size() >= capacity_) {
+            evict();
+        }
+
+        lru.push_front(Plan(key));
         by_name[key] = lru.begin();
-        lru.front()->set_plan(json, include_encoded_plan);
-        return *lru.front();
+        lru.front().set_plan(json, include_encoded_plan);
+        return lru.front();
     }
 
     /**
@@ -124,16 +132,16 @@ struct lcb_QUERY_CACHE_ {
     {
         auto m = by_name.find(key);
         if (m == by_name.end()) {
+            misses_++;
             return nullptr;
         }
-
-        const Plan *cur = *m->second;
+        hits_++;
 
         // Update LRU:
         lru.splice(lru.begin(), lru, m->second);
         // Note, updating of iterators is not required since splice doesn't
         // invalidate iterators.
-        return cur;
+        return &*m->second;
     }
 
     /** Removes an entry with the given key */
@@ -145,7 +153,6 @@ struct lcb_QUERY_CACHE_ {
         }
         // Remove entry from map
         auto m2 = m->second;
-        delete *m2;
         by_name.erase(m);
         lru.erase(m2);
     }
@@ -153,16 +160,34 @@ struct lcb_QUERY_CACHE_ {
     /** Clears the LRU cache */
     void clear()
     {
-        for (auto &ii : lru) {
-            delete ii;
-        }
         lru.clear();
         by_name.clear();
     }
 
+    /** Lookup and eviction counters since the instance was created */
+    void stats(lcb_QUERY_CACHE_STATS *out) const
+    {
+        out->hits = hits_;
+        out->misses = misses_;
+        out->evictions = evictions_;
+        out->size = lru.size();
+        out->capacity = capacity_;
+    }
+
   private:
-    std::list<Plan *> lru;
-    std::map<std::string, decltype(lru)::iterator> by_name;
+    void evict()
+    {
+        by_name.erase(lru.back().key);
+        lru.pop_back();
+        evictions_++;
+    }
+
+    std::size_t capacity_;
+    std::list<Plan> lru;
+    std::unordered_map<std::string, decltype(lru)::iterator> by_name;
+    std::uint64_t hits_{0};
+    std::uint64_t misses_{0};
+    std::uint64_t evictions_{0};
 };
 
 #endif // LIBCOUCHBASE_N1QL_QUERY_CACHE_HH
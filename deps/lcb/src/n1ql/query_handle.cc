@@ -415,10 +415,31 @@ lcb_STATUS lcb_QUERY_HANDLE_::issue_htreq(const std::string &body)
     lcb_cmdhttp_destroy(htcmd);
     if (rc == LCB_SUCCESS) {
         http_request_->set_callback(reinterpret_cast<lcb_RESPCALLBACK>(chunk_callback));
+        if (paused_) {
+            http_request_->pause();
+        }
     }
     return rc;
 }
 
+lcb_STATUS lcb_QUERY_HANDLE_::pause()
+{
+    paused_ = true;
+    if (http_request_ != nullptr) {
+        http_request_->pause();
+    }
+    return LCB_SUCCESS;
+}
+
+lcb_STATUS lcb_QUERY_HANDLE_::resume()
+{
+    paused_ = false;
+    if (http_request_ != nullptr) {
+        http_request_->resume();
+    }
+    return LCB_SUCCESS;
+}
+
 lcb_STATUS lcb_QUERY_HANDLE_::request_plan()
 {
     Json::Value newbody(Json::objectValue);
@@ -439,7 +460,7 @@ lcb_STATUS lcb_QUERY_HANDLE_::apply_plan(const Plan &plan)
 {
     lcb_log(LOGARGS(this, DEBUG), LOGFMT "Using prepared plan", LOGID(this));
     std::string bodystr;
-    plan.apply_plan(json, bodystr);
+    plan.apply_plan(json, raw_options_, bodystr);
     return issue_htreq(bodystr);
 }
 
@@ -449,15 +470,8 @@ lcb_QUERY_HANDLE_::lcb_QUERY_HANDLE_(lcb_INSTANCE *obj, void *user_cookie, const
       use_multi_bucket_authentication_(cmd->use_multi_bucket_authentication()),
       timeout_timer_(instance_->iotable, this), backoff_timer_(instance_->iotable, this)
 {
-    if (cmd->is_query_json()) {
-        json = cmd->root();
-    } else {
-        std::string encoded = Json::FastWriter().write(cmd->root());
-        if (!Json::Reader().parse(encoded, json)) {
-            last_error_ = LCB_ERR_INVALID_ARGUMENT;
-            return;
-        }
-    }
+    json = cmd->root();
+    raw_options_ = cmd->raw_options();
     if (cmd->has_explicit_scope_qualifier()) {
         json["query_context"] = cmd->scope_qualifier();
     } else if (cmd->has_scope()) {
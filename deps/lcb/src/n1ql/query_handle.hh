@@ -112,7 +112,8 @@ struct lcb_QUERY_HANDLE_ : lcb::jsparse::Parser::Actions {
 
     lcb_STATUS issue_htreq()
     {
-        std::string s = Json::FastWriter().write(json);
+        std::string s;
+        lcb::write_query_body(json, raw_options_, std::string(), s);
         return issue_htreq(s);
     }
 
@@ -232,6 +233,18 @@ struct lcb_QUERY_HANDLE_ : lcb::jsparse::Parser::Actions {
         return last_error_;
     }
 
+    /**
+     * Stop reading the response from the network until resume() is called. Rows which have already been received
+     * may still be delivered.
+     */
+    lcb_STATUS pause();
+    lcb_STATUS resume();
+
+    bool is_paused() const
+    {
+        return paused_;
+    }
+
     lcb_STATUS cancel()
     {
         if (backoff_timer_.is_armed()) {
@@ -261,12 +274,15 @@ struct lcb_QUERY_HANDLE_ : lcb::jsparse::Parser::Actions {
     std::uint32_t timeout{0};
     // How many rows were received. Used to avoid parsing the meta
     std::size_t rows_number_{0};
+    bool paused_{false};
 
     /** The PREPARE query itself */
     struct lcb_QUERY_HANDLE_ *prepare_query_{nullptr};
 
     /** Request body as received from the application */
     Json::Value json;
+    /** Options of the command which are already encoded (see lcb_cmdquery_option_raw()) */
+    std::vector<lcb::query_raw_option> raw_options_;
     /** String of the original statement. Cached here to avoid jsoncpp lookups */
     std::string statement_;
     std::string client_context_id;
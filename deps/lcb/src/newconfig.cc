@@ -223,9 +223,10 @@ static int iterwipe_cb(mc_CMDQUEUE *cq, mc_PIPELINE *oldpl, mc_PACKET *oldpkt, v
     }
 
     mc_PIPELINE *newpl = cq->pipelines[newix];
-    if (newpl == oldpl || newpl == nullptr) {
+    if (newpl == nullptr || newpl == oldpl || newpl == srv->primary) {
         return MCREQ_KEEP_PACKET;
     }
+    newpl = mcreq_pipeline_select(newpl, mcreq_get_bodysize(oldpkt));
 
     lcb_log(LOGARGS(instance, DEBUG), "Remapped packet %p (SEQ=%u) from " SERVER_FMT " to " SERVER_FMT, (void *)oldpkt,
             oldpkt->opaque, SERVER_ARGS((lcb::Server *)oldpl), SERVER_ARGS((lcb::Server *)newpl));
@@ -293,14 +294,28 @@ static void replace_config(lcb_INSTANCE *instance, lcbvb_CONFIG *oldconfig, lcbv
             continue;
         }
 
-        mcreq_iterwipe(cq, ppold[ii], iterwipe_cb, nullptr);
-        static_cast<lcb::Server *>(ppold[ii])->purge(LCB_ERR_MAP_CHANGED);
-        static_cast<lcb::Server *>(ppold[ii])->close();
+        auto *server = static_cast<lcb::Server *>(ppold[ii]);
+        for (unsigned jj = 0; jj < server->nsiblings; jj++) {
+            if (server->get_sibling(jj)) {
+                mcreq_iterwipe(cq, server->get_sibling(jj), iterwipe_cb, nullptr);
+                server->get_sibling(jj)->purge(LCB_ERR_MAP_CHANGED);
+            }
+        }
+        mcreq_iterwipe(cq, server, iterwipe_cb, nullptr);
+        server->purge(LCB_ERR_MAP_CHANGED);
+        server->close();
     }
 
     for (ii = 0; ii < nnew; ii++) {
-        if (static_cast<lcb::Server *>(ppnew[ii])->has_pending()) {
-            ppnew[ii]->flush_start(ppnew[ii]);
+        auto *server = static_cast<lcb::Server *>(ppnew[ii]);
+        if (server->has_pending()) {
+            server->flush_start(server);
+        }
+        for (unsigned jj = 0; jj < server->nsiblings; jj++) {
+            lcb::Server *sibling = server->get_sibling(jj);
+            if (sibling && sibling->has_pending()) {
+                sibling->flush_start(sibling);
+            }
         }
     }
 
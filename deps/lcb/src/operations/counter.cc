@@ -108,6 +108,12 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdcounter_collection(lcb_CMDCOUNTER *cmd, const
     }
 }
 
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdcounter_collection_id(lcb_CMDCOUNTER *cmd, uint32_t collection_id)
+{
+    cmd->collection().collection_id(collection_id);
+    return LCB_SUCCESS;
+}
+
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdcounter_key(lcb_CMDCOUNTER *cmd, const char *key, size_t key_len)
 {
     if (key == nullptr || key_len == 0) {
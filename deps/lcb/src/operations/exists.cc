@@ -99,6 +99,12 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdexists_collection(lcb_CMDEXISTS *cmd, const c
     }
 }
 
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdexists_collection_id(lcb_CMDEXISTS *cmd, uint32_t collection_id)
+{
+    cmd->collection().collection_id(collection_id);
+    return LCB_SUCCESS;
+}
+
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdexists_key(lcb_CMDEXISTS *cmd, const char *key, size_t key_len)
 {
     if (key == nullptr || key_len == 0) {
@@ -73,6 +73,15 @@ LIBCOUCHBASE_API lcb_STATUS lcb_respget_value(const lcb_RESPGET *resp, const cha
     return LCB_SUCCESS;
 }
 
+LIBCOUCHBASE_API lcb_STATUS lcb_respget_backbuf(const lcb_RESPGET *resp, struct rdb_ROPESEG **backbuf)
+{
+    if (resp->bufh == nullptr || resp->nvalue == 0) {
+        return LCB_ERR_UNSUPPORTED_OPERATION;
+    }
+    *backbuf = reinterpret_cast<struct rdb_ROPESEG *>(resp->bufh);
+    return LCB_SUCCESS;
+}
+
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdget_create(lcb_CMDGET **cmd)
 {
     *cmd = new lcb_CMDGET{};
@@ -106,6 +115,12 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdget_collection(lcb_CMDGET *cmd, const char *s
     }
 }
 
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdget_collection_id(lcb_CMDGET *cmd, uint32_t collection_id)
+{
+    cmd->collection().collection_id(collection_id);
+    return LCB_SUCCESS;
+}
+
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdget_key(lcb_CMDGET *cmd, const char *key, size_t key_len)
 {
     if (key == nullptr || key_len == 0) {
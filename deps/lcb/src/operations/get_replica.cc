@@ -81,6 +81,15 @@ LIBCOUCHBASE_API lcb_STATUS lcb_respgetreplica_value(const lcb_RESPGETREPLICA *r
     return LCB_SUCCESS;
 }
 
+LIBCOUCHBASE_API lcb_STATUS lcb_respgetreplica_backbuf(const lcb_RESPGETREPLICA *resp, struct rdb_ROPESEG **backbuf)
+{
+    if (resp->bufh == nullptr || resp->nvalue == 0) {
+        return LCB_ERR_UNSUPPORTED_OPERATION;
+    }
+    *backbuf = reinterpret_cast<struct rdb_ROPESEG *>(resp->bufh);
+    return LCB_SUCCESS;
+}
+
 LIBCOUCHBASE_API int lcb_respgetreplica_is_final(const lcb_RESPGETREPLICA *resp)
 {
     return resp->rflags & LCB_RESP_F_FINAL;
@@ -132,6 +141,12 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdgetreplica_collection(lcb_CMDGETREPLICA *cmd,
     }
 }
 
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdgetreplica_collection_id(lcb_CMDGETREPLICA *cmd, uint32_t collection_id)
+{
+    cmd->collection().collection_id(collection_id);
+    return LCB_SUCCESS;
+}
+
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdgetreplica_key(lcb_CMDGETREPLICA *cmd, const char *key, size_t key_len)
 {
     if (key == nullptr || key_len == 0) {
@@ -715,6 +715,24 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmddiag_prettify(lcb_CMDDIAG *cmd, int enable)
     return LCB_SUCCESS;
 }
 
+static void tmoheap_to_json(mc_PIPELINE *pipeline, Json::Value &node)
+{
+    const mc_TMOHEAP *heap = &pipeline->tmoheap;
+    Json::Value tmo;
+    hrtime_t deadline;
+
+    tmo["pending"] = pipeline->pktindex.count;
+    tmo["heap_size"] = heap->size;
+    tmo["expired"] = (Json::Value::UInt64)heap->nexpired;
+    tmo["stale"] = (Json::Value::UInt64)heap->nstale;
+    tmo["compactions"] = (Json::Value::UInt64)heap->ncompacted;
+    if (mcreq_pipeline_next_deadline(pipeline, &deadline)) {
+        hrtime_t now = gethrtime();
+        tmo["next_deadline_us"] = (Json::Value::UInt64)(deadline > now ? LCB_NS2US(deadline - now) : 0);
+    }
+    node["timeouts"] = tmo;
+}
+
 LIBCOUCHBASE_API
 lcb_STATUS lcb_diag(lcb_INSTANCE *instance, void *cookie, const lcb_CMDDIAG *cmd)
 {
@@ -764,6 +782,7 @@ lcb_STATUS lcb_diag(lcb_INSTANCE *instance, void *cookie, const lcb_CMDDIAG *cmd
                 endpoint["last_activity_us"] =
                     (Json::Value::UInt64)(now > ctx->sock->atime ? now - ctx->sock->atime : 0);
                 endpoint["status"] = "connected";
+                tmoheap_to_json(server, endpoint);
                 root[lcbio_svcstr(ctx->sock->service)].append(endpoint);
             }
         }
@@ -94,6 +94,12 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdremove_collection(lcb_CMDREMOVE *cmd, const c
     }
 }
 
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdremove_collection_id(lcb_CMDREMOVE *cmd, uint32_t collection_id)
+{
+    cmd->collection().collection_id(collection_id);
+    return LCB_SUCCESS;
+}
+
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdremove_key(lcb_CMDREMOVE *cmd, const char *key, size_t key_len)
 {
     if (key == nullptr || key_len == 0) {
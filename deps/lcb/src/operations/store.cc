@@ -166,6 +166,12 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdstore_collection(lcb_CMDSTORE *cmd, const cha
     }
 }
 
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdstore_collection_id(lcb_CMDSTORE *cmd, uint32_t collection_id)
+{
+    cmd->collection().collection_id(collection_id);
+    return LCB_SUCCESS;
+}
+
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdstore_key(lcb_CMDSTORE *cmd, const char *key, size_t key_len)
 {
     if (key == nullptr || key_len == 0) {
@@ -183,6 +189,19 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdstore_value(lcb_CMDSTORE *cmd, const char *va
     return cmd->value(std::string(value, value_len));
 }
 
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdstore_value_nocopy(lcb_CMDSTORE *cmd, const char *value, size_t value_len,
+                                                      void (*release)(void *), void *release_cookie)
+{
+    if (release == nullptr) {
+        return LCB_ERR_INVALID_ARGUMENT;
+    }
+    if (value == nullptr || value_len == 0) {
+        release(release_cookie);
+        return cmd->value(std::string());
+    }
+    return cmd->value_nocopy(value, value_len, std::shared_ptr<void>(release_cookie, release));
+}
+
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdstore_value_iov(lcb_CMDSTORE *cmd, const lcb_IOV *value, size_t value_len)
 {
     return cmd->value(value, value_len);
@@ -393,16 +412,22 @@ static lcb_STATUS store_schedule(lcb_INSTANCE *instance, std::shared_ptr<lcb_CMD
     hdr.request.opcode = cmd->opcode();
     hdr.request.extlen = cmd->extras_size();
     lcb_KEYBUF keybuf{LCB_KV_COPY, {cmd->key().c_str(), cmd->key().size()}};
-    err = mcreq_basic_packet(cq, &keybuf, cmd->collection().collection_id(), &hdr, hdr.request.extlen, ffextlen,
-                             &packet, &pipeline, MCREQ_BASICPACKET_F_FALLBACKOK);
+    err = mcreq_basic_packet_ex(cq, &keybuf, cmd->collection().collection_id(), &hdr, hdr.request.extlen, ffextlen,
+                                &packet, &pipeline, MCREQ_BASICPACKET_F_FALLBACKOK,
+                                static_cast<uint32_t>(cmd->value_size()));
     if (err != LCB_SUCCESS) {
         return err;
     }
 
     int should_compress = can_compress(instance, pipeline, cmd->value_is_compressed());
-    lcb_VALBUF valuebuf{LCB_KV_COPY, {{cmd->value().c_str(), cmd->value().size()}}};
+    /* Borrowed values are referenced in place unless they are about to be compressed into a new buffer, or the
+     * packet is parked on the fallback pipeline (which copies it anyway and has no pin bookkeeping) */
+    bool borrow_value = cmd->has_borrowed_value() && !should_compress && pipeline != cq->fallback;
+    lcb_VALBUF valuebuf{borrow_value ? LCB_KV_CONTIG : LCB_KV_COPY, {{cmd->value_data(), cmd->value_size()}}};
     if (should_compress) {
-        int rv = mcreq_compress_value(pipeline, packet, &valuebuf, instance->settings, &should_compress);
+        int rv = mcreq_compress_value(pipeline, packet, &valuebuf, instance->settings,
+                                      cmd->collection().collection_id(), cmd->key().c_str(), cmd->key().size(),
+                                      &should_compress);
         if (rv != 0) {
             mcreq_release_packet(pipeline, packet);
             return LCB_ERR_NO_MEMORY;
@@ -472,6 +497,10 @@ static lcb_STATUS store_schedule(lcb_INSTANCE *instance, std::shared_ptr<lcb_CMD
     if (cmd->is_replace_semantics()) {
         packet->flags |= MCREQ_F_REPLACE_SEMANTICS;
     }
+    if (borrow_value) {
+        static_cast<lcb::Server *>(pipeline)->pin_value(SPAN_SABUFFER_NC(&packet->u_value.single),
+                                                        cmd->borrowed_value_owner());
+    }
     LCBTRACE_KVSTORE_START(instance->settings, packet->opaque, cmd, cmd->operation_name(), rdata->span);
     LCB_SCHED_ADD(instance, pipeline, packet)
 
@@ -361,6 +361,12 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdsubdoc_collection(lcb_CMDSUBDOC *cmd, const c
     }
 }
 
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdsubdoc_collection_id(lcb_CMDSUBDOC *cmd, uint32_t collection_id)
+{
+    cmd->collection().collection_id(collection_id);
+    return LCB_SUCCESS;
+}
+
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdsubdoc_key(lcb_CMDSUBDOC *cmd, const char *key, size_t key_len)
 {
     if (key == nullptr || key_len == 0) {
@@ -94,6 +94,12 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdtouch_collection(lcb_CMDTOUCH *cmd, const cha
     }
 }
 
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdtouch_collection_id(lcb_CMDTOUCH *cmd, uint32_t collection_id)
+{
+    cmd->collection().collection_id(collection_id);
+    return LCB_SUCCESS;
+}
+
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdtouch_key(lcb_CMDTOUCH *cmd, const char *key, size_t key_len)
 {
     if (key == nullptr || key_len == 0) {
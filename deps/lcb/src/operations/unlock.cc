@@ -88,6 +88,12 @@ LIBCOUCHBASE_API lcb_STATUS lcb_cmdunlock_collection(lcb_CMDUNLOCK *cmd, const c
     }
 }
 
+LIBCOUCHBASE_API lcb_STATUS lcb_cmdunlock_collection_id(lcb_CMDUNLOCK *cmd, uint32_t collection_id)
+{
+    cmd->collection().collection_id(collection_id);
+    return LCB_SUCCESS;
+}
+
 LIBCOUCHBASE_API lcb_STATUS lcb_cmdunlock_key(lcb_CMDUNLOCK *cmd, const char *key, size_t key_len)
 {
     if (key == nullptr || key_len == 0) {
@@ -106,6 +106,15 @@ class MemcachedResponse
         release(&ctx->ior);
     }
 
+    /**
+     * Gets the magic byte of the packet, which tells responses apart from
+     * server initiated requests (PROTOCOL_BINARY_SREQ)
+     */
+    uint8_t magic() const
+    {
+        return res.response.magic;
+    }
+
     /**
      * Gets the command for the packet
      */
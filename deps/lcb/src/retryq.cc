@@ -279,7 +279,7 @@ void RetryQueue::flush(bool throttle)
                     "us, deadline_in=%" PRIu64 "us",
                     (void *)op->pkt, op->pkt->retries, cid, op->pkt->opaque, srvix, LCB_NS2US(now - op->start),
                     LCB_NS2US(op->deadline - now));
-            mc_PIPELINE *newpl = cq->pipelines[srvix];
+            mc_PIPELINE *newpl = mcreq_pipeline_select(cq->pipelines[srvix], mcreq_get_bodysize(op->pkt));
             mcreq_enqueue_packet(newpl, op->pkt);
             newpl->flush_start(newpl);
             erase(op);
@@ -328,6 +328,29 @@ RetryOp::RetryOp(errmap::RetrySpec *spec_)
     }
 }
 
+/** Make sure the server no longer references the packet in its pending/flush queues */
+static void unqueue_packet(lcb::Server *server, mc_PACKET *pkt)
+{
+    sllist_iterator iter;
+
+    /* check pending queue */
+    SLLIST_ITERFOR(&server->nbmgr.sendq.pending, &iter)
+    {
+        nb_SNDQELEM *el = SLLIST_ITEM(iter.cur, nb_SNDQELEM, slnode);
+        if (el->parent == pkt) {
+            sllist_iter_remove(&server->nbmgr.sendq.pending, &iter);
+        }
+    }
+    /* check flush queue */
+    SLLIST_ITERFOR(&server->nbmgr.sendq.pdus, &iter)
+    {
+        mc_PACKET *el = SLLIST_ITEM(iter.cur, mc_PACKET, sl_flushq);
+        if (el == pkt) {
+            sllist_iter_remove(&server->nbmgr.sendq.pdus, &iter);
+        }
+    }
+}
+
 void RetryQueue::add(mc_EXPACKET *pkt, const lcb_STATUS err, protocol_binary_response_status status,
                      errmap::RetrySpec *spec, int options)
 {
@@ -361,25 +384,14 @@ void RetryQueue::add(mc_EXPACKET *pkt, const lcb_STATUS err, protocol_binary_res
          * of the pipelines use it in the pending/flush queues
          */
         for (size_t ii = 0; ii < cq->npipelines; ii++) {
-            sllist_iterator iter;
             auto *server = static_cast<lcb::Server *>(cq->pipelines[ii]);
             if (server == nullptr) {
                 continue;
             }
-            /* check pending queue */
-            SLLIST_ITERFOR(&server->nbmgr.sendq.pending, &iter)
-            {
-                nb_SNDQELEM *el = SLLIST_ITEM(iter.cur, nb_SNDQELEM, slnode);
-                if (el->parent == op->pkt) {
-                    sllist_iter_remove(&server->nbmgr.sendq.pending, &iter);
-                }
-            }
-            /* check flush queue */
-            SLLIST_ITERFOR(&server->nbmgr.sendq.pdus, &iter)
-            {
-                mc_PACKET *el = SLLIST_ITEM(iter.cur, mc_PACKET, sl_flushq);
-                if (el == op->pkt) {
-                    sllist_iter_remove(&server->nbmgr.sendq.pdus, &iter);
+            unqueue_packet(server, op->pkt);
+            for (unsigned jj = 0; jj < server->nsiblings; jj++) {
+                if (server->get_sibling(jj)) {
+                    unqueue_packet(server->get_sibling(jj), op->pkt);
                 }
             }
         }
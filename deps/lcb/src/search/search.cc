@@ -86,3 +86,19 @@ LIBCOUCHBASE_API lcb_STATUS lcb_search_cancel(lcb_INSTANCE * /* instance */, lcb
     }
     return LCB_SUCCESS;
 }
+
+LIBCOUCHBASE_API lcb_STATUS lcb_search_pause(lcb_INSTANCE * /* instance */, lcb_SEARCH_HANDLE *handle)
+{
+    if (handle == nullptr) {
+        return LCB_ERR_INVALID_ARGUMENT;
+    }
+    return handle->pause();
+}
+
+LIBCOUCHBASE_API lcb_STATUS lcb_search_resume(lcb_INSTANCE * /* instance */, lcb_SEARCH_HANDLE *handle)
+{
+    if (handle == nullptr) {
+        return LCB_ERR_INVALID_ARGUMENT;
+    }
+    return handle->resume();
+}
@@ -187,7 +187,28 @@ lcb_SEARCH_HANDLE_::lcb_SEARCH_HANDLE_(lcb_INSTANCE *instance, void *cookie, con
     lcb_cmdhttp_destroy(htcmd);
     if (last_error_ == LCB_SUCCESS) {
         http_request_->set_callback(reinterpret_cast<lcb_RESPCALLBACK>(chunk_callback));
+        if (paused_) {
+            http_request_->pause();
+        }
+    }
+}
+
+lcb_STATUS lcb_SEARCH_HANDLE_::pause()
+{
+    paused_ = true;
+    if (http_request_ != nullptr) {
+        http_request_->pause();
+    }
+    return LCB_SUCCESS;
+}
+
+lcb_STATUS lcb_SEARCH_HANDLE_::resume()
+{
+    paused_ = false;
+    if (http_request_ != nullptr) {
+        http_request_->resume();
     }
+    return LCB_SUCCESS;
 }
 
 lcb_SEARCH_HANDLE_::~lcb_SEARCH_HANDLE_()
@@ -71,6 +71,18 @@ struct lcb_SEARCH_HANDLE_ : lcb::jsparse::Parser::Actions {
         return LCB_SUCCESS;
     }
 
+    /**
+     * Stop reading the response from the network until resume() is called. Rows which have already been received
+     * may still be delivered.
+     */
+    lcb_STATUS pause();
+    lcb_STATUS resume();
+
+    bool is_paused() const
+    {
+        return paused_;
+    }
+
     lcb_STATUS last_error() const
     {
         return last_error_;
@@ -118,6 +130,7 @@ struct lcb_SEARCH_HANDLE_ : lcb::jsparse::Parser::Actions {
   private:
     const lcb_RESPHTTP *http_response_{nullptr};
     lcb_HTTP_HANDLE *http_request_{nullptr};
+    bool paused_{false};
     lcb::jsparse::Parser *parser_{nullptr};
     void *cookie_{nullptr};
     lcb_SEARCH_CALLBACK callback_{nullptr};
@@ -18,6 +18,7 @@
 #include "settings.h"
 #include <lcbio/ssl.h>
 #include <rdb/rope.h>
+#include "mc/compress.h"
 
 LCB_INTERNAL_API
 void lcb_default_settings(lcb_settings *settings)
@@ -82,9 +83,12 @@ void lcb_default_settings(lcb_settings *settings)
     settings->enable_durable_write = 0;
     settings->retry_strategy = lcb_retry_strategy_best_effort;
     settings->enable_unordered_execution = 1;
+    settings->enable_config_push = 1;
     settings->use_errmap = 1;
     settings->op_metrics_flush_interval = LCB_DEFAULT_OP_METRICS_FLUSH_INTERVAL;
     settings->op_metrics_enabled = 1;
+    settings->kv_connections_per_node = 1;
+    settings->kv_large_value_threshold = 0;
 }
 
 LCB_INTERNAL_API
@@ -95,6 +99,8 @@ lcb_settings *lcb_settings_new(void)
     settings->refcount = 1;
     settings->auth = lcbauth_new();
     settings->errmap = lcb_errmap_new();
+    settings->compress_policy = mcreq_compress_policy_new();
+    settings->snappy_pool = mcreq_snappy_pool_new();
     return settings;
 }
 
@@ -113,6 +119,8 @@ void lcb_settings_unref(lcb_settings *settings)
 
     lcbauth_unref(settings->auth);
     lcb_errmap_free(settings->errmap);
+    mcreq_compress_policy_free(settings->compress_policy);
+    mcreq_snappy_pool_free(settings->snappy_pool);
 
     if (settings->ssl_ctx) {
         lcbio_ssl_free(settings->ssl_ctx);
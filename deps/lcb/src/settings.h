@@ -128,6 +128,8 @@ extern "C" {
 struct lcbio_SSLCTX;
 struct rdb_ALLOCATOR;
 struct lcb_METRICS_st;
+struct mc_COMPRESSPOLICY_st;
+struct mc_SNAPPYPOOL_st;
 
 /**
  * Stateless setting structure.
@@ -200,6 +202,8 @@ typedef struct lcb_settings_st {
     unsigned wait_for_config : 1;
     unsigned enable_durable_write : 1;
     unsigned enable_unordered_execution : 1;
+    /** Ask KV nodes to push cluster map changes over the data connection */
+    unsigned enable_config_push : 1;
 
     lcb_RETRY_STRATEGY retry_strategy;
     short max_redir;
@@ -231,9 +235,15 @@ typedef struct lcb_settings_st {
     lcb_U32 tracer_threshold[LCBTRACE_THRESHOLD__MAX];
     lcb_U32 compress_min_size;
     float compress_min_ratio;
+    struct mc_COMPRESSPOLICY_st *compress_policy;
+    struct mc_SNAPPYPOOL_st *snappy_pool;
     char *network; /** network resolution, AKA "Multi Network Configurations" */
     lcb_U32 op_metrics_flush_interval;
     unsigned op_metrics_enabled : 1;
+    /** Number of data connections (pipelines) opened to each node */
+    lcb_U32 kv_connections_per_node;
+    /** Values at least this large use their own connection, 0 to disable */
+    lcb_U32 kv_large_value_threshold;
 } lcb_settings;
 
 LCB_INTERNAL_API
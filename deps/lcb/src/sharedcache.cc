@@ -0,0 +1,109 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "sharedcache.h"
+
+#include <cstdlib>
+
+namespace lcb
+{
+std::shared_ptr<SharedCache> SharedCache::get(const std::string &name, const std::string &bucket)
+{
+    // Never destroyed, instances may still be released during static
+    // destruction.
+    static auto *registry_mutex = new std::mutex();
+    static auto *registry = new std::map<std::string, std::weak_ptr<SharedCache>>();
+
+    std::string key = name + "/" + bucket;
+    std::lock_guard<std::mutex> lock(*registry_mutex);
+    std::shared_ptr<SharedCache> cache = (*registry)[key].lock();
+    if (!cache) {
+        cache = std::make_shared<SharedCache>();
+        (*registry)[key] = cache;
+
+        // Drop the entries of caches nobody uses anymore
+        for (auto ii = registry->begin(); ii != registry->end();) {
+            if (ii->second.expired()) {
+                ii = registry->erase(ii);
+            } else {
+                ++ii;
+            }
+        }
+    }
+    return cache;
+}
+
+bool SharedCache::put_config(lcbvb_CONFIG *vbc)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!config_json_.empty()) {
+        if (vbc->revepoch < config_revepoch_ ||
+            (vbc->revepoch == config_revepoch_ && vbc->revid <= config_revid_)) {
+            return false;
+        }
+    }
+
+    char *json = lcbvb_save_json(vbc);
+    if (json == nullptr) {
+        return false;
+    }
+    config_json_ = json;
+    free(json);
+    config_revepoch_ = vbc->revepoch;
+    config_revid_ = vbc->revid;
+    config_generation_++;
+    return true;
+}
+
+bool SharedCache::get_config(std::uint64_t *generation, std::string &json)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (config_json_.empty() || *generation == config_generation_) {
+        return false;
+    }
+    json = config_json_;
+    *generation = config_generation_;
+    return true;
+}
+
+bool SharedCache::get_cid(const std::string &path, std::uint32_t *cid)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto pos = cids_.find(path);
+    if (pos == cids_.end()) {
+        return false;
+    }
+    *cid = pos->second;
+    return true;
+}
+
+void SharedCache::put_cid(const std::string &path, std::uint32_t cid)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    cids_[path] = cid;
+}
+
+void SharedCache::erase_cid(const std::string &path, std::uint32_t cid)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto pos = cids_.find(path);
+    // Another instance may have already resolved it again
+    if (pos != cids_.end() && pos->second == cid) {
+        cids_.erase(pos);
+    }
+}
+} // namespace lcb
@@ -0,0 +1,80 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#ifndef LCB_SHAREDCACHE_H
+#define LCB_SHAREDCACHE_H
+
+#include <libcouchbase/vbucket.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace lcb
+{
+/**
+ * Cluster map and collection IDs of a bucket, shared by every instance in
+ * the process which joined the same named cache (see
+ * LCB_CNTL_CONFIGCACHE_SHARED). Instances usually run on different threads,
+ * so all access is serialized.
+ *
+ * The cluster map is kept in its serialized form: lcbvb_CONFIG is modified
+ * by the instance using it (e.g. vbucket guesses), so every instance parses
+ * its own copy, but only when the map changed.
+ */
+class SharedCache
+{
+  public:
+    /**
+     * Get the cache for the bucket, creating it if this is the first
+     * instance to join it. The cache lives as long as any instance uses it.
+     */
+    static std::shared_ptr<SharedCache> get(const std::string &name, const std::string &bucket);
+
+    /**
+     * Publish a cluster map, unless the cache already has the same or a
+     * newer revision.
+     * @return true if the map was stored
+     */
+    bool put_config(lcbvb_CONFIG *vbc);
+
+    /**
+     * Fetch the cluster map if it was changed since it was last fetched.
+     * @param[in,out] generation the generation of the map known to the
+     *  caller, updated when the map is returned
+     * @param[out] json the serialized map
+     * @return true if there is a newer map
+     */
+    bool get_config(std::uint64_t *generation, std::string &json);
+
+    bool get_cid(const std::string &path, std::uint32_t *cid);
+    void put_cid(const std::string &path, std::uint32_t cid);
+    void erase_cid(const std::string &path, std::uint32_t cid);
+
+  private:
+    std::mutex mutex_{};
+    std::string config_json_{};
+    std::int64_t config_revepoch_{0};
+    std::int64_t config_revid_{-1};
+    std::uint64_t config_generation_{0};
+    std::map<std::string, std::uint32_t> cids_{};
+};
+} // namespace lcb
+
+#endif
@@ -34,6 +34,324 @@
         (cfg)->errstr = __FILE__ ":" STRINGIFY(__LINE__) " " s;                                                        \
     }
 
+/******************************************************************************
+ ******************************************************************************
+ ** Raw Scanning Routines                                                    **
+ ******************************************************************************
+ ******************************************************************************/
+/*
+ * These look at the JSON text directly rather than building a cJSON tree.
+ * Values are skipped by only following strings and brackets, so a member can
+ * be found without converting anything else in the document. They do not
+ * validate everything they skip; whatever they extract is either checked
+ * here or the document is still handed to cJSON as well.
+ */
+typedef struct {
+    const char *key;   /* first byte of the key, after the quote */
+    size_t nkey;       /* length of the key, as it appears in the text */
+    const char *value; /* first byte of the value */
+    const char *end;   /* first byte after the value */
+} raw_MEMBER;
+
+typedef struct {
+    const char *begin;
+    const char *end;
+} raw_SPAN;
+
+static const char *skip_ws(const char *p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+        p++;
+    }
+    return p;
+}
+
+/* p is at the opening quote. Returns the position after the closing one */
+static const char *skip_string(const char *p)
+{
+    for (p++; *p; p++) {
+        if (*p == '\\') {
+            if (*++p == '\0') {
+                return NULL;
+            }
+        } else if (*p == '"') {
+            return p + 1;
+        }
+    }
+    return NULL;
+}
+
+/* Returns the position after the value starting at p, NULL if truncated */
+static const char *skip_value(const char *p)
+{
+    unsigned depth = 0;
+
+    if (*p != '{' && *p != '[' && *p != '"') {
+        while (*p && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') {
+            p++;
+        }
+        return *p ? p : NULL;
+    }
+
+    do {
+        switch (*p) {
+            case '\0':
+                return NULL;
+            case '"':
+                if ((p = skip_string(p)) == NULL) {
+                    return NULL;
+                }
+                continue;
+            case '{':
+            case '[':
+                depth++;
+                break;
+            case '}':
+            case ']':
+                depth--;
+                break;
+            default:
+                break;
+        }
+        p++;
+    } while (depth);
+    return p;
+}
+
+/**
+ * Reads the next member of an object.
+ * @param[in,out] pp position just after the opening brace or previous member
+ * @return 1 if a member was read, 0 at the end of the object, -1 on bad input
+ */
+static int next_member(const char **pp, raw_MEMBER *m)
+{
+    const char *p = skip_ws(*pp);
+
+    if (*p == ',') {
+        p = skip_ws(p + 1);
+    } else if (*p == '}') {
+        *pp = p + 1;
+        return 0;
+    }
+    if (*p != '"') {
+        return -1;
+    }
+    m->key = p + 1;
+    if ((p = skip_string(p)) == NULL) {
+        return -1;
+    }
+    m->nkey = p - 1 - m->key;
+    p = skip_ws(p);
+    if (*p != ':') {
+        return -1;
+    }
+    m->value = p = skip_ws(p + 1);
+    if ((p = skip_value(p)) == NULL) {
+        return -1;
+    }
+    m->end = p;
+    *pp = p;
+    return 1;
+}
+
+/* Keys are compared the way cJSON_GetObjectItem() does, ignoring case */
+static int member_is(const raw_MEMBER *m, const char *key)
+{
+    size_t ii;
+    for (ii = 0; ii < m->nkey; ii++) {
+        char a = m->key[ii], b = key[ii];
+        if (b == '\0') {
+            return 0;
+        }
+        if (a >= 'A' && a <= 'Z') {
+            a += 'a' - 'A';
+        }
+        if (b >= 'A' && b <= 'Z') {
+            b += 'a' - 'A';
+        }
+        if (a != b) {
+            return 0;
+        }
+    }
+    return key[ii] == '\0';
+}
+
+static int scan_int64(const char *p, const char *end, int64_t *value)
+{
+    lcb_U64 v = 0;
+    int negative = 0;
+
+    if (p < end && *p == '-') {
+        negative = 1;
+        p++;
+    }
+    if (p == end) {
+        return 0;
+    }
+    for (; p < end; p++) {
+        if (*p < '0' || *p > '9' || v > (INT64_MAX - 9) / 10) {
+            return 0;
+        }
+        v = v * 10 + (*p - '0');
+    }
+    *value = negative ? -(int64_t)v : (int64_t)v;
+    return 1;
+}
+
+LIBCOUCHBASE_API
+int lcbvb_peek_revision(const char *data, int64_t *revepoch, int64_t *revid)
+{
+    raw_MEMBER m;
+    const char *p = skip_ws(data);
+    int rv, found_epoch = 0, found_rev = 0;
+
+    *revepoch = -1;
+    *revid = -1;
+    if (*p++ != '{') {
+        return -1;
+    }
+    while ((found_epoch == 0 || found_rev == 0) && (rv = next_member(&p, &m)) == 1) {
+        if (!found_rev && member_is(&m, "rev")) {
+            if (!scan_int64(m.value, m.end, revid)) {
+                return -1;
+            }
+            found_rev = 1;
+        } else if (!found_epoch && member_is(&m, "revEpoch")) {
+            if (!scan_int64(m.value, m.end, revepoch)) {
+                return -1;
+            }
+            found_epoch = 1;
+        }
+    }
+    return found_rev ? 0 : -1;
+}
+
+/**
+ * Finds the text of the vBucketMap and vBucketMapForward arrays inside of the
+ * top-level vBucketServerMap. These hold most of the values in a config, so
+ * they are read by stream_vbmap() instead of being turned into cJSON nodes.
+ */
+static void locate_vbmaps(const char *data, raw_SPAN *map, raw_SPAN *ffmap)
+{
+    raw_MEMBER m;
+    const char *p = skip_ws(data);
+    int found = 0;
+
+    map->begin = map->end = ffmap->begin = ffmap->end = NULL;
+    if (*p++ != '{') {
+        return;
+    }
+    while (!found && next_member(&p, &m) == 1) {
+        found = member_is(&m, "vBucketServerMap");
+    }
+    if (!found || *m.value != '{') {
+        return;
+    }
+
+    p = m.value + 1;
+    while (next_member(&p, &m) == 1) {
+        raw_SPAN *span = NULL;
+        if (member_is(&m, "vBucketMap")) {
+            span = map;
+        } else if (member_is(&m, "vBucketMapForward")) {
+            span = ffmap;
+        }
+        if (span && span->begin == NULL && *m.value == '[') {
+            span->begin = m.value;
+            span->end = m.end;
+        }
+    }
+}
+
+/**
+ * Parses a vBucket map such as `[[0,1],[1,0]]` straight into the vBucket
+ * entries. Returns -1 if the text is anything other than an array of arrays
+ * of integers, so that it can be handed to cJSON instead, 0 if the map is
+ * invalid and 1 on success.
+ */
+static int stream_vbmap(lcbvb_CONFIG *cfg, raw_SPAN *span, lcbvb_VBUCKET **out, unsigned *nitems)
+{
+    lcbvb_VBUCKET *vblist = NULL;
+    unsigned nvb = 0, nalloc = 0;
+    const char *p = skip_ws(span->begin + 1);
+
+    if (*p == ']') {
+        return 0;
+    }
+
+    for (;;) {
+        unsigned jj = 0;
+        if (*p != '[') {
+            goto GT_UNKNOWN;
+        }
+        if (nvb == nalloc) {
+            void *tmp;
+            nalloc = nalloc ? nalloc * 2 : 1024;
+            if ((tmp = realloc(vblist, nalloc * sizeof(*vblist))) == NULL) {
+                free(vblist);
+                return 0;
+            }
+            vblist = tmp;
+        }
+        memset(vblist + nvb, 0, sizeof(*vblist));
+
+        p = skip_ws(p + 1);
+        while (*p != ']') {
+            int ix = 0, negative = 0;
+            if (*p == '-') {
+                negative = 1;
+                p++;
+            }
+            if (*p < '0' || *p > '9') {
+                goto GT_UNKNOWN;
+            }
+            for (; *p >= '0' && *p <= '9'; p++) {
+                if (ix > 0xffff) {
+                    goto GT_UNKNOWN;
+                }
+                ix = ix * 10 + (*p - '0');
+            }
+            if (jj == sizeof(vblist->servers) / sizeof(vblist->servers[0])) {
+                SET_ERRSTR(cfg, "Invalid vBucket map received from server. Too many replicas");
+                goto GT_ERR;
+            }
+            vblist[nvb].servers[jj++] = negative ? -ix : ix;
+            if (vblist[nvb].servers[jj - 1] > (int)cfg->nsrv - 1) {
+                SET_ERRSTR(cfg, "Invalid vBucket map received from server. Above-bounds vBucket target found");
+                goto GT_ERR;
+            }
+            p = skip_ws(p);
+            if (*p == ',') {
+                p = skip_ws(p + 1);
+            } else if (*p != ']') {
+                goto GT_UNKNOWN;
+            }
+        }
+        nvb++;
+
+        p = skip_ws(p + 1);
+        if (*p == ',') {
+            p = skip_ws(p + 1);
+        } else if (*p == ']' && p + 1 == span->end) {
+            break;
+        } else {
+            goto GT_UNKNOWN;
+        }
+    }
+
+    *out = vblist;
+    *nitems = nvb;
+    return 1;
+
+GT_ERR:
+    free(vblist);
+    return 0;
+
+GT_UNKNOWN:
+    free(vblist);
+    return -1;
+}
+
 /******************************************************************************
  ******************************************************************************
  ** Core Parsing Routines                                                    **
@@ -90,6 +408,68 @@ GT_ERR:
     return NULL;
 }
 
+/* Reads a map from its text if it was located, otherwise from the tree */
+static lcbvb_VBUCKET *load_vbmap(lcbvb_CONFIG *cfg, cJSON *cj, raw_SPAN *span, unsigned *nitems)
+{
+    lcbvb_VBUCKET *vblist = NULL;
+    char *text;
+
+    if (span->begin == NULL) {
+        return build_vbmap(cfg, cj, nitems);
+    }
+    if (stream_vbmap(cfg, span, &vblist, nitems) != -1) {
+        return vblist;
+    }
+
+    /* Not a plain array of integers, let cJSON make sense of it */
+    if ((text = malloc(span->end - span->begin + 1)) == NULL) {
+        return NULL;
+    }
+    memcpy(text, span->begin, span->end - span->begin);
+    text[span->end - span->begin] = '\0';
+    cj = cJSON_Parse(text);
+    free(text);
+    if (cj == NULL) {
+        SET_ERRSTR(cfg, "Couldn't parse JSON");
+        return NULL;
+    }
+    vblist = build_vbmap(cfg, cj, nitems);
+    cJSON_Delete(cj);
+    return vblist;
+}
+
+/* Copies the document, replacing the located maps with empty arrays */
+static char *strip_vbmaps(const char *data, raw_SPAN *map, raw_SPAN *ffmap)
+{
+    raw_SPAN *spans[2];
+    const char *src = data;
+    char *copy, *dst;
+    unsigned ii;
+
+    if (ffmap->begin && ffmap->begin < map->begin) {
+        spans[0] = ffmap;
+        spans[1] = map;
+    } else {
+        spans[0] = map;
+        spans[1] = ffmap;
+    }
+    if ((copy = dst = malloc(strlen(data) + 1)) == NULL) {
+        return NULL;
+    }
+    for (ii = 0; ii < 2; ii++) {
+        if (spans[ii]->begin == NULL) {
+            continue;
+        }
+        memcpy(dst, src, spans[ii]->begin - src);
+        dst += spans[ii]->begin - src;
+        *dst++ = '[';
+        *dst++ = ']';
+        src = spans[ii]->end;
+    }
+    strcpy(dst, src);
+    return copy;
+}
+
 static void copy_address(char *buf, size_t nbuf, const char *host, lcb_U16 port)
 {
     if (strchr(host, ':')) {
@@ -213,7 +593,7 @@ GT_ERROR:
     return 0;
 }
 
-static int parse_vbucket(lcbvb_CONFIG *cfg, cJSON *cj)
+static int parse_vbucket(lcbvb_CONFIG *cfg, cJSON *cj, raw_SPAN *map_text, raw_SPAN *ffmap_text)
 {
     cJSON *vbconfig, *vbmap, *ffmap = NULL;
 
@@ -234,11 +614,11 @@ static int parse_vbucket(lcbvb_CONFIG *cfg, cJSON *cj)
 
     get_jarray(vbconfig, "vBucketMapForward", &ffmap);
 
-    if ((cfg->vbuckets = build_vbmap(cfg, vbmap, &cfg->nvb)) == NULL) {
+    if ((cfg->vbuckets = load_vbmap(cfg, vbmap, map_text, &cfg->nvb)) == NULL) {
         goto GT_ERROR;
     }
 
-    if (ffmap && (cfg->ffvbuckets = build_vbmap(cfg, ffmap, &cfg->nvb)) == NULL) {
+    if (ffmap && (cfg->ffvbuckets = load_vbmap(cfg, ffmap, ffmap_text, &cfg->nvb)) == NULL) {
         goto GT_ERROR;
     }
 
@@ -592,8 +972,22 @@ int lcbvb_load_json_ex(lcbvb_CONFIG *cfg, const char *data, const char *source,
     unsigned ii, jnodes_size = 0;
     int jnodes_defined = 0;
     int is_cluster_cfg = 0;
-
-    if ((cj = cJSON_Parse(data)) == NULL) {
+    raw_SPAN map_text, ffmap_text;
+
+    /* The vBucket maps are read separately, see stream_vbmap() */
+    locate_vbmaps(data, &map_text, &ffmap_text);
+    if (map_text.begin || ffmap_text.begin) {
+        char *stripped = strip_vbmaps(data, &map_text, &ffmap_text);
+        if (stripped == NULL) {
+            SET_ERRSTR(cfg, "Couldn't allocate memory for config");
+            goto GT_ERROR;
+        }
+        cj = cJSON_Parse(stripped);
+        free(stripped);
+    } else {
+        cj = cJSON_Parse(data);
+    }
+    if (cj == NULL) {
         SET_ERRSTR(cfg, "Couldn't parse JSON");
         goto GT_ERROR;
     }
@@ -737,7 +1131,7 @@ int lcbvb_load_json_ex(lcbvb_CONFIG *cfg, const char *data, const char *source,
     cfg->ndatasrv = ii;
 
     if (cfg->dtype == LCBVB_DIST_VBUCKET) {
-        if (!parse_vbucket(cfg, cj)) {
+        if (!parse_vbucket(cfg, cj, &map_text, &ffmap_text)) {
             SET_ERRSTR(cfg, "Failed to parse vBucket map");
             goto GT_ERROR;
         }
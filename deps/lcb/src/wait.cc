@@ -32,9 +32,15 @@ static bool has_pending(lcb_INSTANCE *instance)
     }
 
     for (size_t ii = 0; ii < LCBT_NSERVERS(instance); ii++) {
-        if (instance->get_server(ii)->has_pending()) {
+        lcb::Server *server = instance->get_server(ii);
+        if (server->has_pending()) {
             return true;
         }
+        for (unsigned jj = 0; jj < server->nsiblings; jj++) {
+            if (server->get_sibling(jj) && server->get_sibling(jj)->has_pending()) {
+                return true;
+            }
+        }
     }
     return false;
 }
@@ -48,7 +54,13 @@ static void maybe_reset_timeouts(lcb_INSTANCE *instance)
 
     uint64_t now = lcb_nstime();
     for (size_t ii = 0; ii < LCBT_NSERVERS(instance); ++ii) {
-        mcreq_reset_timeouts(instance->get_server(ii), now);
+        lcb::Server *server = instance->get_server(ii);
+        mcreq_reset_timeouts(server, now);
+        for (unsigned jj = 0; jj < server->nsiblings; jj++) {
+            if (server->get_sibling(jj)) {
+                mcreq_reset_timeouts(server->get_sibling(jj), now);
+            }
+        }
     }
     instance->retryq->reset_timeouts(now);
 }
@@ -0,0 +1,118 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "config.h"
+#include "internal.h"
+#include "bucketconfig/clconfig.h"
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace lcb::clconfig;
+
+class CccpTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        ASSERT_EQ(LCB_SUCCESS, lcb_create_io_ops(&io, nullptr));
+        iot = lcbio_table_new(io);
+        settings = lcb_settings_new();
+        settings->bucket = strdup("default");
+        mon = new Confmon(settings, iot, nullptr);
+        cccp = mon->get_provider(CLCONFIG_CCCP);
+    }
+
+    void TearDown() override
+    {
+        delete mon;
+        lcb_settings_unref(settings);
+        lcbio_table_unref(iot);
+    }
+
+    static std::string makeConfig(int64_t revepoch, int64_t revid, bool named = true)
+    {
+        lcbvb_CONFIG *vbc = lcbvb_create();
+        lcbvb_genconfig(vbc, 4, 1, 64);
+        vbc->revepoch = revepoch;
+        vbc->revid = revid;
+        char *js = lcbvb_save_json(vbc);
+        std::string config(js);
+        free(js);
+        lcbvb_destroy(vbc);
+
+        if (!named) {
+            // As sent before the bucket has been selected
+            std::string name = "\"name\":\"default\",";
+            size_t pos = config.find(name);
+            EXPECT_NE(std::string::npos, pos) << config;
+            config.erase(pos, name.size());
+        }
+        return config;
+    }
+
+    lcbvb_CONFIG *update(const std::string &config)
+    {
+        EXPECT_EQ(LCB_SUCCESS, cccp_update(cccp, "localhost:11210", config.c_str()));
+        ConfigInfo *info = cccp->get_cached();
+        EXPECT_NE(nullptr, info);
+        return info ? info->vbc : nullptr;
+    }
+
+    lcb_io_opt_t io{nullptr};
+    lcbio_pTABLE iot{nullptr};
+    lcb_settings *settings{nullptr};
+    Confmon *mon{nullptr};
+    Provider *cccp{nullptr};
+};
+
+TEST_F(CccpTest, testSameRevisionIsReused)
+{
+    lcbvb_CONFIG *first = update(makeConfig(1, 10));
+    ASSERT_EQ(10, first->revid);
+    ASSERT_EQ(first, update(makeConfig(1, 10)));
+    ASSERT_EQ(first, mon->get_config()->vbc);
+
+    // A newer revision is parsed
+    lcbvb_CONFIG *second = update(makeConfig(1, 11));
+    ASSERT_NE(first, second);
+    ASSERT_EQ(11, second->revid);
+}
+
+TEST_F(CccpTest, testNewEpochIsParsed)
+{
+    lcbvb_CONFIG *first = update(makeConfig(1, 10));
+
+    // Revisions start over with a new epoch, even the same one is different
+    lcbvb_CONFIG *second = update(makeConfig(2, 10));
+    ASSERT_NE(first, second);
+    ASSERT_EQ(2, second->revepoch);
+    ASSERT_EQ(10, second->revid);
+}
+
+TEST_F(CccpTest, testConfigWithoutBucketIsParsed)
+{
+    lcbvb_CONFIG *first = update(makeConfig(1, 10, false));
+    ASSERT_EQ(nullptr, first->bname);
+
+    // Not reused while a bucket is expected, so the named one replaces it
+    lcbvb_CONFIG *second = update(makeConfig(1, 10, false));
+    ASSERT_NE(first, second);
+    lcbvb_CONFIG *named = update(makeConfig(1, 10));
+    ASSERT_NE(second, named);
+    ASSERT_STREQ("default", named->bname);
+    ASSERT_EQ(named, update(makeConfig(1, 10)));
+}
@@ -0,0 +1,136 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "config.h"
+#include "internal.h"
+#include "collections.h"
+#include <gtest/gtest.h>
+
+class CollectionCacheTest : public ::testing::Test
+{
+};
+
+TEST_F(CollectionCacheTest, testDefaultCollection)
+{
+    lcb::CollectionCache cache;
+    uint32_t cid = 42;
+    ASSERT_TRUE(cache.get("_default._default", &cid));
+    ASSERT_EQ(0U, cid);
+
+    // Missing names are the defaults
+    cid = 42;
+    ASSERT_TRUE(cache.get(nullptr, 0, "", 0, &cid));
+    ASSERT_EQ(0U, cid);
+    ASSERT_EQ("_default._default", cache.id_to_name(0));
+}
+
+TEST_F(CollectionCacheTest, testLookupByNames)
+{
+    lcb::CollectionCache cache;
+    cache.put("inventory.airline", 8);
+    cache.put("_default.users", 9);
+
+    uint32_t cid = 0;
+    ASSERT_TRUE(cache.get("inventory", 9, "airline", 7, &cid));
+    ASSERT_EQ(8U, cid);
+    ASSERT_TRUE(cache.get(nullptr, 0, "users", 5, &cid));
+    ASSERT_EQ(9U, cid);
+    ASSERT_TRUE(cache.get("inventory.airline", &cid));
+    ASSERT_EQ(8U, cid);
+
+    // Only whole names match
+    ASSERT_FALSE(cache.get("inventory", 9, "air", 3, &cid));
+    ASSERT_FALSE(cache.get("inven", 5, "tory.airline", 12, &cid));
+    ASSERT_FALSE(cache.get("users", &cid));
+
+    ASSERT_EQ("inventory.airline", cache.id_to_name(8));
+    ASSERT_EQ("", cache.id_to_name(10));
+}
+
+TEST_F(CollectionCacheTest, testGeneration)
+{
+    lcb::CollectionCache cache;
+    uint64_t generation = cache.generation();
+
+    // New and unchanged IDs do not invalidate anything
+    cache.put("inventory.airline", 8);
+    cache.put("inventory.airline", 8);
+    ASSERT_EQ(generation, cache.generation());
+
+    cache.put("inventory.airline", 12);
+    ASSERT_LT(generation, cache.generation());
+    ASSERT_EQ("", cache.id_to_name(8));
+    ASSERT_EQ("inventory.airline", cache.id_to_name(12));
+
+    generation = cache.generation();
+    cache.erase(12);
+    ASSERT_LT(generation, cache.generation());
+    uint32_t cid = 0;
+    ASSERT_FALSE(cache.get("inventory.airline", &cid));
+
+    // Erasing something unknown does not either
+    generation = cache.generation();
+    cache.erase(12);
+    ASSERT_EQ(generation, cache.generation());
+}
+
+TEST_F(CollectionCacheTest, testRecreatedCollection)
+{
+    lcb::CollectionCache cache;
+
+    // Every new ID leaves the previous one behind in the ID index
+    for (uint32_t cid = 8; cid < 8 + 1000; cid++) {
+        cache.put("inventory.airline", cid);
+    }
+
+    uint32_t cid = 0;
+    ASSERT_TRUE(cache.get("inventory.airline", &cid));
+    ASSERT_EQ(8U + 999, cid);
+    ASSERT_EQ("inventory.airline", cache.id_to_name(cid));
+    ASSERT_EQ("", cache.id_to_name(8));
+    ASSERT_EQ("", cache.id_to_name(100000));
+    ASSERT_EQ("_default._default", cache.id_to_name(0));
+}
+
+TEST_F(CollectionCacheTest, testManyCollections)
+{
+    lcb::CollectionCache cache;
+    const uint32_t count = 1000;
+    for (uint32_t ii = 1; ii <= count; ii++) {
+        cache.put("scope" + std::to_string(ii % 7) + ".coll" + std::to_string(ii), ii);
+    }
+
+    // Churn through deletions, so the tables fill up with removed entries
+    for (int round = 0; round < 10; round++) {
+        for (uint32_t ii = 1; ii <= count; ii += 2) {
+            cache.erase(ii);
+            cache.put("scope" + std::to_string(ii % 7) + ".coll" + std::to_string(ii), ii);
+        }
+    }
+
+    for (uint32_t ii = 1; ii <= count; ii++) {
+        std::string scope = "scope" + std::to_string(ii % 7);
+        std::string collection = "coll" + std::to_string(ii);
+        uint32_t cid = 0;
+        ASSERT_TRUE(cache.get(scope.c_str(), scope.size(), collection.c_str(), collection.size(), &cid));
+        ASSERT_EQ(ii, cid);
+        ASSERT_EQ(scope + "." + collection, cache.id_to_name(ii));
+    }
+    uint32_t cid = 42;
+    ASSERT_TRUE(cache.get("_default._default", &cid));
+    ASSERT_EQ(0U, cid);
+}
@@ -22,6 +22,8 @@
 #include "contrib/lcb-jsoncpp/lcb-jsoncpp.h"
 #include "t_jsparse.h"
 
+#include <cstring>
+
 class JsonParseTest : public ::testing::Test
 {
 };
@@ -65,10 +67,10 @@ struct Context : Parser::Actions {
     }
 };
 
-static bool validateJsonRows(const char *txt, size_t ntxt, Parser::Mode mode)
+static bool validateJsonRows(const char *txt, size_t ntxt, Parser::Mode mode, bool scan_rows)
 {
     Context cx;
-    Parser parser(mode, &cx);
+    Parser parser(mode, &cx, scan_rows);
 
     for (size_t ii = 0; ii < ntxt; ii++) {
         parser.feed(txt + ii, 1);
@@ -83,10 +85,10 @@ static bool validateJsonRows(const char *txt, size_t ntxt, Parser::Mode mode)
     return true;
 }
 
-static bool validateBadParse(const char *txt, size_t ntxt, Parser::Mode mode)
+static bool validateBadParse(const char *txt, size_t ntxt, Parser::Mode mode, bool scan_rows)
 {
     Context cx;
-    Parser p(mode, &cx);
+    Parser p(mode, &cx, scan_rows);
     p.feed(txt, ntxt);
     EXPECT_EQ(LCB_ERR_PROTOCOL_ERROR, cx.rc);
     return true;
@@ -94,14 +96,108 @@ static bool validateBadParse(const char *txt, size_t ntxt, Parser::Mode mode)
 
 TEST_F(JsonParseTest, testFTS)
 {
-    ASSERT_TRUE(validateJsonRows(JSON_fts_good, sizeof(JSON_fts_good), Parser::MODE_FTS));
-    ASSERT_TRUE(validateBadParse(JSON_fts_bad, sizeof(JSON_fts_bad), Parser::MODE_FTS));
-    ASSERT_TRUE(validateBadParse(JSON_fts_bad2, sizeof(JSON_fts_bad2), Parser::MODE_FTS));
+    for (bool scan_rows : {false, true}) {
+        ASSERT_TRUE(validateJsonRows(JSON_fts_good, sizeof(JSON_fts_good), Parser::MODE_FTS, scan_rows));
+        ASSERT_TRUE(validateBadParse(JSON_fts_bad, sizeof(JSON_fts_bad), Parser::MODE_FTS, scan_rows));
+        ASSERT_TRUE(validateBadParse(JSON_fts_bad2, sizeof(JSON_fts_bad2), Parser::MODE_FTS, scan_rows));
+    }
 }
 
 TEST_F(JsonParseTest, testN1QL)
 {
-    ASSERT_TRUE(validateJsonRows(JSON_n1ql_nonempty, sizeof(JSON_n1ql_nonempty), Parser::MODE_N1QL));
-    ASSERT_TRUE(validateJsonRows(JSON_n1ql_empty, sizeof(JSON_n1ql_empty), Parser::MODE_N1QL));
-    ASSERT_TRUE(validateBadParse(JSON_n1ql_bad, sizeof(JSON_n1ql_bad), Parser::MODE_N1QL));
+    for (bool scan_rows : {false, true}) {
+        ASSERT_TRUE(
+            validateJsonRows(JSON_n1ql_nonempty, sizeof(JSON_n1ql_nonempty), Parser::MODE_N1QL, scan_rows));
+        ASSERT_TRUE(validateJsonRows(JSON_n1ql_empty, sizeof(JSON_n1ql_empty), Parser::MODE_N1QL, scan_rows));
+        ASSERT_TRUE(validateBadParse(JSON_n1ql_bad, sizeof(JSON_n1ql_bad), Parser::MODE_N1QL, scan_rows));
+    }
+}
+
+/*
+ * Builds a query response with the given number of rows, which have strings
+ * full of escapes and brackets, nested containers and scalars mixed in.
+ */
+static std::string makeResponse(unsigned nrows, unsigned seed)
+{
+    static const char *pieces[] = {"\\\"", "\\\\", "{", "}", "[", "]", ",", ":", "\\u00e9", "x", " "};
+    std::string out = "{\n\"requestID\": \"5a8f\\\"[{\",\n\"signature\": {\"*\": \"*\"},\n\"results\": [";
+    for (unsigned ii = 0; ii < nrows; ii++) {
+        seed = seed * 1103515245 + 12345;
+        if (ii) {
+            out += (seed & 0x10) ? ",\n" : ",";
+        }
+        std::string str = "\"";
+        for (unsigned jj = 0; jj < (seed >> 8) % 24; jj++) {
+            str += pieces[(seed >> (jj % 16)) % (sizeof(pieces) / sizeof(pieces[0]))];
+        }
+        str += "\"";
+        switch ((seed >> 4) % 4) {
+            case 0:
+                out += std::to_string(ii);
+                break;
+            case 1:
+                out += str;
+                break;
+            case 2:
+                out += "[" + str + ", [], {\"a\": [1, {}]}]";
+                break;
+            default:
+                out += "{\"id\": " + std::to_string(ii) + ", \"name\": " + str + ", \"nested\": {\"v\": [" + str + "]}}";
+                break;
+        }
+    }
+    out += " ],\n\"status\": \"success\",\n\"metrics\": {\"resultCount\": " + std::to_string(nrows) + "}\n}\n";
+    return out;
+}
+
+static void feedInChunks(Parser &parser, const std::string &body, unsigned seed)
+{
+    size_t pos = 0;
+    while (pos < body.size()) {
+        seed = seed * 1103515245 + 12345;
+        size_t chunk = (seed >> 8) % 200 + 1;
+        if (chunk > body.size() - pos) {
+            chunk = body.size() - pos;
+        }
+        parser.feed(body.c_str() + pos, chunk);
+        pos += chunk;
+    }
+}
+
+TEST_F(JsonParseTest, testScannerMatchesJsonsl)
+{
+    for (unsigned seed = 1; seed <= 50; seed++) {
+        std::string body = makeResponse(seed * 3, seed);
+        Context expected, actual;
+        Parser jsonsl(Parser::MODE_N1QL, &expected, false);
+        Parser scanner(Parser::MODE_N1QL, &actual, true);
+        feedInChunks(jsonsl, body, seed);
+        feedInChunks(scanner, body, seed * 7);
+
+        ASSERT_EQ(LCB_SUCCESS, expected.rc);
+        ASSERT_EQ(LCB_SUCCESS, actual.rc);
+        ASSERT_TRUE(actual.received_done);
+        ASSERT_EQ(expected.rows, actual.rows);
+        Json::Value expected_meta, actual_meta;
+        ASSERT_TRUE(Json::Reader().parse(expected.meta, expected_meta));
+        ASSERT_TRUE(Json::Reader().parse(actual.meta, actual_meta)) << actual.meta;
+        ASSERT_EQ(expected_meta, actual_meta);
+    }
+}
+
+TEST_F(JsonParseTest, testScannerErrors)
+{
+    const char *bodies[] = {
+        "[{\"results\": []}]",
+        "{\"results\": [1, 2}",
+        "{\"results\": [1, 2], [3]}",
+        "{\"status\" \"success\", \"results\": []}",
+        "{\"results\": [{\"a\": [}]]}",
+    };
+    for (const char *body : bodies) {
+        Context cx;
+        Parser parser(Parser::MODE_N1QL, &cx, true);
+        parser.feed(body, strlen(body));
+        ASSERT_EQ(LCB_ERR_PROTOCOL_ERROR, cx.rc) << body;
+    }
 }
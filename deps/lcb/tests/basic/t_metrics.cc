@@ -0,0 +1,145 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "config.h"
+#include <gtest/gtest.h>
+#include <libcouchbase/couchbase.h>
+#include "internal.h"
+#include "metrics/metrics-internal.h"
+#include <map>
+#include <string>
+
+class Metrics : public ::testing::Test
+{
+};
+
+typedef std::map<std::string, lcbmetrics_SUMMARY> SummaryMap;
+
+extern "C" {
+static void collect_summary(const lcbmetrics_SUMMARY *summary, void *cookie)
+{
+    auto *summaries = reinterpret_cast<SummaryMap *>(cookie);
+    std::string key = std::string(summary->service) + "/" + summary->operation;
+    (*summaries)[key] = *summary;
+}
+}
+
+static const lcbmetrics_VALUERECORDER *findRecorder(const lcbmetrics_METER *meter, const char *svc, const char *op)
+{
+    lcbmetrics_TAG tags[2] = {{METRICS_SVC_TAG_NAME, svc}, {METRICS_OP_TAG_NAME, op}};
+    return meter->value_recorder_(meter, METRICS_OPS_METER_NAME, tags, 2);
+}
+
+#ifdef LCB_USE_HDR_HISTOGRAM
+TEST_F(Metrics, testAggregatingMeter)
+{
+    lcbmetrics_METER *meter = nullptr;
+    ASSERT_EQ(LCB_SUCCESS, lcbmetrics_meter_create_aggregating(&meter));
+    ASSERT_NE(nullptr, meter);
+
+    lcbmetrics_TAG otherTags[1] = {{METRICS_SVC_TAG_NAME, "kv"}};
+    ASSERT_EQ(nullptr, meter->value_recorder_(meter, "some.other.meter", otherTags, 1));
+
+    // Two users of the same operation, as with two instances sharing the
+    // meter, must record into the same histogram but own their wrappers.
+    const lcbmetrics_VALUERECORDER *get1 = findRecorder(meter, "kv", "get");
+    const lcbmetrics_VALUERECORDER *get2 = findRecorder(meter, "kv", "get");
+    const lcbmetrics_VALUERECORDER *query = findRecorder(meter, "query", "query");
+    ASSERT_NE(get1, get2);
+
+    for (uint64_t ii = 1; ii <= 100; ii++) {
+        get1->record_value_(get1, ii);
+    }
+    get2->record_value_(get2, 1000);
+    query->record_value_(query, 5000);
+    lcbmetrics_valuerecorder_destroy(get2);
+
+    SummaryMap summaries;
+    ASSERT_EQ(LCB_SUCCESS, lcbmetrics_meter_summarize(meter, 0, collect_summary, &summaries));
+    ASSERT_EQ(2, summaries.size());
+    const lcbmetrics_SUMMARY &getSummary = summaries["kv/get"];
+    ASSERT_EQ(101, getSummary.total_count);
+    ASSERT_EQ(51, getSummary.p50);
+    ASSERT_EQ(100, getSummary.p99);
+    ASSERT_EQ(1000, getSummary.p100);
+    ASSERT_EQ(1, summaries["query/query"].total_count);
+
+    // Draining clears the histograms, but keeps the operations.
+    summaries.clear();
+    ASSERT_EQ(LCB_SUCCESS, lcbmetrics_meter_summarize(meter, 1, collect_summary, &summaries));
+    ASSERT_EQ(101, summaries["kv/get"].total_count);
+    summaries.clear();
+    ASSERT_EQ(LCB_SUCCESS, lcbmetrics_meter_summarize(meter, 1, collect_summary, &summaries));
+    ASSERT_EQ(2, summaries.size());
+    ASSERT_EQ(0, summaries["kv/get"].total_count);
+
+    get1->record_value_(get1, 7);
+    summaries.clear();
+    ASSERT_EQ(LCB_SUCCESS, lcbmetrics_meter_summarize(meter, 0, collect_summary, &summaries));
+    ASSERT_EQ(1, summaries["kv/get"].total_count);
+    ASSERT_EQ(7, summaries["kv/get"].p50);
+
+    lcbmetrics_valuerecorder_destroy(get1);
+    lcbmetrics_valuerecorder_destroy(query);
+    lcbmetrics_meter_destroy(meter);
+}
+
+TEST_F(Metrics, testAggregatingMeterPercentile)
+{
+    lcbmetrics_METER *meter = nullptr;
+    ASSERT_EQ(LCB_SUCCESS, lcbmetrics_meter_create_aggregating(&meter));
+
+    uint64_t value = 42;
+    ASSERT_EQ(LCB_SUCCESS, lcbmetrics_meter_percentile(meter, "kv", "get", 99.0, &value));
+    ASSERT_EQ(0, value);
+
+    const lcbmetrics_VALUERECORDER *get = findRecorder(meter, "kv", "get");
+    for (uint64_t ii = 1; ii <= 100; ii++) {
+        get->record_value_(get, ii);
+    }
+    ASSERT_EQ(LCB_SUCCESS, lcbmetrics_meter_percentile(meter, "kv", "get", 50.0, &value));
+    ASSERT_EQ(50, value);
+    ASSERT_EQ(LCB_SUCCESS, lcbmetrics_meter_percentile(meter, "kv", "get", 99.0, &value));
+    ASSERT_EQ(99, value);
+    ASSERT_EQ(LCB_ERR_INVALID_ARGUMENT, lcbmetrics_meter_percentile(meter, "kv", "get", 101.0, &value));
+
+    // Reading an operation which was never recorded must not add it.
+    ASSERT_EQ(LCB_SUCCESS, lcbmetrics_meter_percentile(meter, "kv", "upsert", 99.0, &value));
+    ASSERT_EQ(0, value);
+    SummaryMap summaries;
+    ASSERT_EQ(LCB_SUCCESS, lcbmetrics_meter_summarize(meter, 0, collect_summary, &summaries));
+    ASSERT_EQ(1, summaries.size());
+
+    lcbmetrics_valuerecorder_destroy(get);
+    lcbmetrics_meter_destroy(meter);
+}
+#endif
+
+TEST_F(Metrics, testSummarizeRequiresAggregatingMeter)
+{
+    lcbmetrics_METER *meter = nullptr;
+    ASSERT_EQ(LCB_SUCCESS, lcbmetrics_meter_create(&meter, nullptr));
+
+    SummaryMap summaries;
+    ASSERT_EQ(LCB_ERR_UNSUPPORTED_OPERATION, lcbmetrics_meter_summarize(meter, 0, collect_summary, &summaries));
+    ASSERT_TRUE(summaries.empty());
+
+    uint64_t value = 42;
+    ASSERT_EQ(LCB_ERR_UNSUPPORTED_OPERATION, lcbmetrics_meter_percentile(meter, "kv", "get", 99.0, &value));
+    ASSERT_EQ(0, value);
+    lcbmetrics_meter_destroy(meter);
+}
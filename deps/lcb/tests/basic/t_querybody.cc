@@ -0,0 +1,106 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "config.h"
+#include <gtest/gtest.h>
+#include <libcouchbase/couchbase.h>
+
+#include "capi/cmd_query.hh"
+
+class QueryBodyTest : public ::testing::Test
+{
+  protected:
+    static Json::Value encoded(lcb_CMDQUERY *cmd)
+    {
+        const char *payload = nullptr;
+        size_t payload_len = 0;
+        EXPECT_EQ(LCB_SUCCESS, lcb_cmdquery_encoded_payload(cmd, &payload, &payload_len));
+        Json::Value body;
+        EXPECT_TRUE(Json::Reader().parse(payload, payload + payload_len, body)) << std::string(payload, payload_len);
+        return body;
+    }
+};
+
+TEST_F(QueryBodyTest, testRawOptions)
+{
+    lcb_CMDQUERY *cmd;
+    lcb_cmdquery_create(&cmd);
+    std::string statement = "SELECT * FROM `travel-sample` WHERE id = $1 AND name = $name";
+    ASSERT_EQ(LCB_SUCCESS, lcb_cmdquery_statement(cmd, statement.c_str(), statement.size()));
+    ASSERT_EQ(LCB_SUCCESS, lcb_cmdquery_option_raw(cmd, "args", 4, "[1, \"two\"]", 10));
+    ASSERT_EQ(LCB_SUCCESS, lcb_cmdquery_option_raw(cmd, "$name", 5, "\"bob\"", 5));
+
+    Json::Value body = encoded(cmd);
+    ASSERT_EQ(statement, body["statement"].asString());
+    ASSERT_EQ(1, body["args"][0].asInt());
+    ASSERT_EQ("two", body["args"][1].asString());
+    ASSERT_EQ("bob", body["$name"].asString());
+
+    // Setting the option again replaces it, whichever way it is set
+    ASSERT_EQ(LCB_SUCCESS, lcb_cmdquery_option(cmd, "$name", 5, "\"alice\"", 7));
+    ASSERT_EQ(LCB_SUCCESS, lcb_cmdquery_option_raw(cmd, "args", 4, "[3]", 3));
+    body = encoded(cmd);
+    ASSERT_EQ("alice", body["$name"].asString());
+    ASSERT_EQ(1U, body["args"].size());
+    ASSERT_EQ(3, body["args"][0].asInt());
+
+    ASSERT_EQ(LCB_SUCCESS, lcb_cmdquery_option_raw(cmd, "$name", 5, "\"carol\"", 7));
+    body = encoded(cmd);
+    ASSERT_EQ("carol", body["$name"].asString());
+    ASSERT_EQ(3U, body.size());
+
+    // Only a raw option
+    lcb_cmdquery_reset(cmd);
+    ASSERT_EQ(LCB_SUCCESS, lcb_cmdquery_option_raw(cmd, "args", 4, "[]", 2));
+    body = encoded(cmd);
+    ASSERT_EQ(1U, body.size());
+    ASSERT_TRUE(body["args"].isArray());
+
+    lcb_cmdquery_destroy(cmd);
+}
+
+TEST_F(QueryBodyTest, testRawOptionsOnly)
+{
+    // Nothing but the raw option, the body starts out null
+    lcb_CMDQUERY *cmd;
+    lcb_cmdquery_create(&cmd);
+    ASSERT_EQ(LCB_SUCCESS, lcb_cmdquery_option_raw(cmd, "args", 4, "[1]", 3));
+    Json::Value body = encoded(cmd);
+    ASSERT_EQ(1U, body.size());
+    ASSERT_EQ(1, body["args"][0].asInt());
+
+    ASSERT_EQ(LCB_SUCCESS, lcb_cmdquery_payload(cmd, "null", 4));
+    ASSERT_EQ(LCB_SUCCESS, lcb_cmdquery_option_raw(cmd, "args", 4, "[2]", 3));
+    ASSERT_EQ(LCB_SUCCESS, lcb_cmdquery_option_raw(cmd, "$name", 5, "\"bob\"", 5));
+    body = encoded(cmd);
+    ASSERT_EQ(2U, body.size());
+    ASSERT_EQ(2, body["args"][0].asInt());
+    ASSERT_EQ("bob", body["$name"].asString());
+    lcb_cmdquery_destroy(cmd);
+}
+
+TEST_F(QueryBodyTest, testRawOptionNames)
+{
+    lcb_CMDQUERY *cmd;
+    lcb_cmdquery_create(&cmd);
+    ASSERT_NE(LCB_SUCCESS, lcb_cmdquery_option_raw(cmd, "statement", 9, "\"SELECT 1\"", 10));
+    ASSERT_NE(LCB_SUCCESS, lcb_cmdquery_option_raw(cmd, "timeout", 7, "\"1s\"", 4));
+    ASSERT_NE(LCB_SUCCESS, lcb_cmdquery_option_raw(cmd, "a\"b", 3, "1", 1));
+    ASSERT_NE(LCB_SUCCESS, lcb_cmdquery_option_raw(cmd, "args", 4, "", 0));
+    ASSERT_NE(LCB_SUCCESS, lcb_cmdquery_option_raw(cmd, "", 0, "1", 1));
+    lcb_cmdquery_destroy(cmd);
+}
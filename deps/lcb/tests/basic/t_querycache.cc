@@ -0,0 +1,95 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "config.h"
+#include "n1ql/query_cache.hh"
+#include <gtest/gtest.h>
+
+class QueryCacheTest : public ::testing::Test
+{
+  protected:
+    static Json::Value prepared(const std::string &name)
+    {
+        Json::Value plan;
+        plan["name"] = name;
+        plan["encoded_plan"] = "plan-" + name;
+        return plan;
+    }
+};
+
+TEST_F(QueryCacheTest, testApplyPlan)
+{
+    lcb_QUERY_CACHE_ cache;
+    const Plan &plan = cache.add_entry("SELECT 1", prepared("p1"), true);
+
+    Json::Value body;
+    body["statement"] = "SELECT 1";
+    body["timeout"] = "75000000us";
+    std::string bodystr;
+    plan.apply_plan(body, {}, bodystr);
+
+    Json::Value parsed;
+    ASSERT_TRUE(Json::Reader().parse(bodystr, parsed));
+    ASSERT_FALSE(parsed.isMember("statement"));
+    ASSERT_EQ("75000000us", parsed["timeout"].asString());
+    ASSERT_EQ("p1", parsed["prepared"].asString());
+    ASSERT_EQ("plan-p1", parsed["encoded_plan"].asString());
+}
+
+TEST_F(QueryCacheTest, testCounters)
+{
+    lcb_QUERY_CACHE_ cache;
+    ASSERT_EQ(nullptr, cache.get_entry("SELECT 1"));
+    cache.add_entry("SELECT 1", prepared("p1"));
+    ASSERT_NE(nullptr, cache.get_entry("SELECT 1"));
+    ASSERT_NE(nullptr, cache.get_entry("SELECT 1"));
+
+    lcb_QUERY_CACHE_STATS stats{};
+    cache.stats(&stats);
+    ASSERT_EQ(2U, stats.hits);
+    ASSERT_EQ(1U, stats.misses);
+    ASSERT_EQ(0U, stats.evictions);
+    ASSERT_EQ(1U, stats.size);
+    ASSERT_EQ(5000U, stats.capacity);
+}
+
+TEST_F(QueryCacheTest, testEvictsLeastRecentlyUsed)
+{
+    lcb_QUERY_CACHE_ cache(2);
+    cache.add_entry("SELECT 1", prepared("p1"));
+    cache.add_entry("SELECT 2", prepared("p2"));
+    ASSERT_NE(nullptr, cache.get_entry("SELECT 1"));
+    cache.add_entry("SELECT 3", prepared("p3"));
+
+    ASSERT_NE(nullptr, cache.get_entry("SELECT 1"));
+    ASSERT_EQ(nullptr, cache.get_entry("SELECT 2"));
+    ASSERT_NE(nullptr, cache.get_entry("SELECT 3"));
+
+    // Replacing a plan does not evict anything
+    cache.add_entry("SELECT 3", prepared("p4"));
+
+    // Shrinking drops the least recently used plans
+    cache.max_size(1);
+    ASSERT_EQ(nullptr, cache.get_entry("SELECT 1"));
+    ASSERT_NE(nullptr, cache.get_entry("SELECT 3"));
+
+    lcb_QUERY_CACHE_STATS stats{};
+    cache.stats(&stats);
+    ASSERT_EQ(2U, stats.evictions);
+    ASSERT_EQ(1U, stats.size);
+    ASSERT_EQ(1U, stats.capacity);
+}
@@ -0,0 +1,64 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <libcouchbase/vbucket.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include "contrib/cJSON/cJSON.h"
+#include "bench.h"
+
+TEST(ConfigBench, parse)
+{
+    lcbvb_CONFIG *orig = lcbvb_create();
+    lcbvb_genconfig(orig, 100, 2, 1024);
+    orig->revepoch = 1;
+    orig->revid = 4096;
+    char *js = lcbvb_save_json(orig);
+    lcbvb_destroy(orig);
+
+    unsigned iterations = benchIterations(200);
+
+    typedef std::chrono::steady_clock clock;
+    clock::time_point begin = clock::now();
+    for (unsigned ii = 0; ii < iterations; ii++) {
+        cJSON *cj = cJSON_Parse(js);
+        ASSERT_TRUE(cj != nullptr);
+        cJSON_Delete(cj);
+    }
+    double tree_us = std::chrono::duration<double, std::micro>(clock::now() - begin).count() / iterations;
+
+    begin = clock::now();
+    for (unsigned ii = 0; ii < iterations; ii++) {
+        lcbvb_CONFIG *cfg = lcbvb_create();
+        ASSERT_EQ(0, lcbvb_load_json(cfg, js));
+        lcbvb_destroy(cfg);
+    }
+    double load_us = std::chrono::duration<double, std::micro>(clock::now() - begin).count() / iterations;
+
+    begin = clock::now();
+    for (unsigned ii = 0; ii < iterations; ii++) {
+        int64_t revepoch, revid;
+        ASSERT_EQ(0, lcbvb_peek_revision(js, &revepoch, &revid));
+        ASSERT_EQ(4096, revid);
+    }
+    double peek_us = std::chrono::duration<double, std::micro>(clock::now() - begin).count() / iterations;
+
+    printf("config of %u bytes (100 nodes, 1024 vBuckets): cJSON tree %.1fus, lcbvb_load_json %.1fus, "
+           "lcbvb_peek_revision %.2fus\n",
+           (unsigned)strlen(js), tree_us, load_us, peek_us);
+    free(js);
+}
@@ -0,0 +1,85 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "config.h"
+#include <gtest/gtest.h>
+#include <libcouchbase/couchbase.h>
+#include "jsparse/parser.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace lcb::jsparse;
+
+/*
+ * Splits the rows out of a synthetic response, once with jsonsl and once with
+ * the scanner. The response is 100MB when LCB_JSPARSE_BENCH_MB is not set in
+ * the environment. Only meaningful in optimized builds.
+ */
+TEST(JsonParseBench, rowSplit)
+{
+    size_t megabytes = 100;
+    const char *env = getenv("LCB_JSPARSE_BENCH_MB");
+    if (env != nullptr && atoi(env) > 0) {
+        megabytes = atoi(env);
+    }
+    // Roughly the size and shape of a travel-sample route
+    std::string row = "{\"route\": {\"id\": 10000, \"type\": \"route\", \"airline\": \"AF\", \"airlineid\": "
+                      "\"airline_137\", \"sourceairport\": \"TLV\", \"destinationairport\": \"MRS\", \"stops\": 0, "
+                      "\"equipment\": \"320\", \"schedule\": [";
+    for (int ii = 0; ii < 8; ii++) {
+        row += std::string(ii ? ", " : "") + "{\"day\": " + std::to_string(ii % 7) + ", \"utc\": \"1" +
+               std::to_string(ii) + ":07:00\", \"flight\": \"AF19" + std::to_string(ii) + "\"}";
+    }
+    row += "], \"distance\": 2881.617376098415, \"note\": \"say \\\"hi\\\" [ok]\"}}";
+    std::string body = "{\"results\": [" + row;
+    while (body.size() < megabytes * 1024 * 1024) {
+        body += "," + row;
+    }
+    body += "], \"status\": \"success\"}";
+
+    struct Counter : Parser::Actions {
+        size_t rows = 0;
+        bool done = false;
+        void JSPARSE_on_row(const Row &) override
+        {
+            rows++;
+        }
+        void JSPARSE_on_error(const std::string &) override {}
+        void JSPARSE_on_complete(const std::string &) override
+        {
+            done = true;
+        }
+    };
+
+    size_t rows[2];
+    for (int scan_rows = 0; scan_rows < 2; scan_rows++) {
+        Counter counter;
+        Parser parser(Parser::MODE_N1QL, &counter, scan_rows != 0);
+        hrtime_t begin = gethrtime();
+        // The size of the chunks libuv typically delivers
+        for (size_t pos = 0; pos < body.size(); pos += 65536) {
+            parser.feed(body.c_str() + pos, std::min<size_t>(65536, body.size() - pos));
+        }
+        hrtime_t elapsed = gethrtime() - begin;
+        ASSERT_TRUE(counter.done);
+        rows[scan_rows] = counter.rows;
+        printf("%-7s %zu rows in %zuMB: %8.1f MB/s\n", scan_rows ? "scanner" : "jsonsl", counter.rows,
+               body.size() >> 20, (double)body.size() / (1024 * 1024) / ((double)elapsed / 1000000000));
+    }
+    ASSERT_EQ(rows[0], rows[1]);
+}
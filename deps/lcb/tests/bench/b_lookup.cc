@@ -0,0 +1,72 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "mc/mctest.h"
+#include "mc/mcreq-flush-inl.h"
+#include <vector>
+
+static mc_PACKET *enqueueHeaderPacket(mc_PIPELINE *pl)
+{
+    protocol_binary_request_header hdr{};
+    mc_PACKET *pkt = mcreq_allocate_packet(pl);
+    EXPECT_EQ(LCB_SUCCESS, mcreq_reserve_header(pl, pkt, sizeof(hdr.bytes)));
+    hdr.request.magic = PROTOCOL_BINARY_REQ;
+    hdr.request.opcode = PROTOCOL_BINARY_CMD_NOOP;
+    hdr.request.opaque = pkt->opaque;
+    mcreq_write_hdr(pkt, &hdr);
+    mcreq_enqueue_packet(pl, pkt);
+    return pkt;
+}
+
+static void flushAll(mc_PIPELINE *pl)
+{
+    nb_IOV iov[64];
+    unsigned toFlush;
+    while ((toFlush = mcreq_flush_iov_fill(pl, iov, 64, nullptr))) {
+        mcreq_flush_done(pl, toFlush, toFlush);
+    }
+}
+
+/*
+ * Responses are matched in reverse order of submission (the worst case for a
+ * linear scan of the request log). The per-response cost should remain
+ * roughly constant as the number of in-flight packets grows.
+ */
+TEST(LookupBench, costByDepth)
+{
+    for (unsigned depth : {10u, 100u, 1000u, 10000u, 100000u}) {
+        CQWrap cq;
+        mc_PIPELINE *pl = cq.pipelines[0];
+        std::vector<mc_PACKET *> pkts;
+        pkts.reserve(depth);
+        for (unsigned ii = 0; ii < depth; ii++) {
+            pkts.push_back(enqueueHeaderPacket(pl));
+        }
+
+        hrtime_t begin = gethrtime();
+        for (auto it = pkts.rbegin(); it != pkts.rend(); ++it) {
+            ASSERT_EQ(*it, mcreq_pipeline_remove(pl, (*it)->opaque));
+        }
+        hrtime_t elapsed = gethrtime() - begin;
+        printf("depth=%-7u %8.1f ns/response\n", depth, (double)elapsed / depth);
+
+        for (mc_PACKET *pkt : pkts) {
+            mcreq_packet_handled(pl, pkt);
+        }
+        flushAll(pl);
+    }
+}
@@ -0,0 +1,73 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "config.h"
+#include <gtest/gtest.h>
+#include <libcouchbase/couchbase.h>
+
+#include "capi/cmd_query.hh"
+#include "bench.h"
+
+static std::string positionalParams(int count)
+{
+    std::string params = "[";
+    for (int ii = 0; ii < count; ii++) {
+        if (ii > 0) {
+            params += ",";
+        }
+        params += R"({"id":)" + std::to_string(ii) + R"(,"name":"value )" + std::to_string(ii) + R"("})";
+    }
+    return params + "]";
+}
+
+/*
+ * Builds the body of a query with 1, 10 and 100 positional parameters which
+ * the application already encoded, once by passing them through
+ * lcb_cmdquery_positional_param() (parsed into the Json::Value and encoded
+ * again) and once with lcb_cmdquery_option_raw().
+ */
+TEST(QueryBodyBench, costByParams)
+{
+    const unsigned iterations = benchIterations(2000);
+    const std::string statement = "SELECT * FROM `travel-sample` WHERE id IN $1";
+    for (int count : {1, 10, 100}) {
+        std::string params = positionalParams(count);
+        hrtime_t elapsed[2] = {0, 0};
+        for (int raw = 0; raw < 2; raw++) {
+            lcb_CMDQUERY *cmd;
+            lcb_cmdquery_create(&cmd);
+            hrtime_t begin = gethrtime();
+            for (unsigned ii = 0; ii < iterations; ii++) {
+                lcb_cmdquery_reset(cmd);
+                lcb_cmdquery_statement(cmd, statement.c_str(), statement.size());
+                lcb_cmdquery_readonly(cmd, 1);
+                if (raw) {
+                    ASSERT_EQ(LCB_SUCCESS, lcb_cmdquery_option_raw(cmd, "args", 4, params.c_str(), params.size()));
+                } else {
+                    ASSERT_EQ(LCB_SUCCESS, lcb_cmdquery_positional_param(cmd, params.c_str(), params.size()));
+                }
+                const char *payload;
+                size_t payload_len;
+                lcb_cmdquery_encoded_payload(cmd, &payload, &payload_len);
+            }
+            elapsed[raw] = gethrtime() - begin;
+            lcb_cmdquery_destroy(cmd);
+        }
+        printf("params=%-4d json=%9.1f ns/query  raw=%9.1f ns/query\n", count, (double)elapsed[0] / iterations,
+               (double)elapsed[1] / iterations);
+    }
+}
@@ -0,0 +1,36 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#ifndef LCB_TESTS_BENCH_H
+#define LCB_TESTS_BENCH_H
+
+#include <cstdlib>
+
+/**
+ * Number of times each benchmark should repeat its loop, LCB_BENCH_ITERATIONS
+ * overrides the default of the benchmark.
+ */
+static inline unsigned benchIterations(unsigned defaultIterations)
+{
+    const char *env = getenv("LCB_BENCH_ITERATIONS");
+    if (env && atoi(env) > 0) {
+        return atoi(env);
+    }
+    return defaultIterations;
+}
+
+#endif
@@ -0,0 +1,307 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <sys/types.h>
+#include "kvserver.h"
+#include <memcached/protocol_binary.h>
+using namespace LCBTest;
+
+class KVServer::Session
+{
+  public:
+    Session(KVServer *parent_, SockFD *sock_) : parent(parent_), sock(sock_), notify(false)
+    {
+        thr = new Thread(runfunc, this);
+    }
+
+    ~Session()
+    {
+        sock->close();
+        delete thr;
+        delete sock;
+    }
+
+    void close()
+    {
+        sock->close();
+    }
+
+    bool wantsNotifications()
+    {
+        return notify;
+    }
+
+    bool send(uint8_t magic, uint8_t opcode, uint16_t status, uint32_t opaque, const std::string &ext,
+              const std::string &key, const std::string &value, uint8_t datatype = PROTOCOL_BINARY_RAW_BYTES)
+    {
+        protocol_binary_response_header hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.response.magic = magic;
+        hdr.response.opcode = opcode;
+        hdr.response.keylen = htons(static_cast<uint16_t>(key.size()));
+        hdr.response.extlen = static_cast<uint8_t>(ext.size());
+        hdr.response.datatype = datatype;
+        hdr.response.status = htons(status);
+        hdr.response.bodylen = htonl(static_cast<uint32_t>(ext.size() + key.size() + value.size()));
+        hdr.response.opaque = opaque;
+
+        std::string pkt(reinterpret_cast<const char *>(hdr.bytes), sizeof(hdr.bytes));
+        pkt += ext;
+        pkt += key;
+        pkt += value;
+
+        wrmutex.lock();
+        bool ok = true;
+        for (size_t nsent = 0; ok && nsent < pkt.size();) {
+            ssize_t nw = sock->send(pkt.data() + nsent, pkt.size() - nsent);
+            if (nw <= 0) {
+                ok = false;
+            } else {
+                nsent += nw;
+            }
+        }
+        wrmutex.unlock();
+        return ok;
+    }
+
+  private:
+    static void runfunc(void *arg)
+    {
+        reinterpret_cast<Session *>(arg)->run();
+    }
+
+    bool recvFully(void *buf, size_t n)
+    {
+        char *p = reinterpret_cast<char *>(buf);
+        while (n > 0) {
+            ssize_t nr = sock->recv(p, n);
+            if (nr <= 0) {
+                return false;
+            }
+            p += nr;
+            n -= nr;
+        }
+        return true;
+    }
+
+    void run()
+    {
+        protocol_binary_request_header hdr;
+        std::string body;
+
+        while (recvFully(hdr.bytes, sizeof(hdr.bytes))) {
+            body.resize(ntohl(hdr.request.bodylen));
+            if (!body.empty() && !recvFully(&body[0], body.size())) {
+                break;
+            }
+            if (hdr.request.magic != PROTOCOL_BINARY_REQ) {
+                // Responses to our own requests (there are none we expect)
+                continue;
+            }
+            handle(hdr, body);
+        }
+    }
+
+    void reply(const protocol_binary_request_header &hdr, uint16_t status, const std::string &value = "",
+               uint8_t datatype = PROTOCOL_BINARY_RAW_BYTES)
+    {
+        send(PROTOCOL_BINARY_RES, hdr.request.opcode, status, hdr.request.opaque, "", "", value, datatype);
+    }
+
+    void handle(const protocol_binary_request_header &hdr, const std::string &body)
+    {
+        switch (hdr.request.opcode) {
+            case PROTOCOL_BINARY_CMD_HELLO: {
+                size_t offset = hdr.request.extlen + ntohs(hdr.request.keylen);
+                std::string features;
+                bool duplex = false, clustermap = false;
+                for (; offset + 2 <= body.size(); offset += 2) {
+                    uint16_t feature;
+                    memcpy(&feature, body.data() + offset, sizeof(feature));
+                    switch (ntohs(feature)) {
+                        case PROTOCOL_BINARY_FEATURE_DUPLEX:
+                            duplex = true;
+                            break;
+                        case PROTOCOL_BINARY_FEATURE_CLUSTERMAP_CHANGE_NOTIFICATION:
+                            clustermap = true;
+                            break;
+                        case PROTOCOL_BINARY_FEATURE_XATTR:
+                        case PROTOCOL_BINARY_FEATURE_JSON:
+                        case PROTOCOL_BINARY_FEATURE_SELECT_BUCKET:
+                            break;
+                        default:
+                            continue;
+                    }
+                    features.append(body.data() + offset, sizeof(feature));
+                }
+                notify = duplex && clustermap;
+                reply(hdr, PROTOCOL_BINARY_RESPONSE_SUCCESS, features);
+                break;
+            }
+            case PROTOCOL_BINARY_CMD_SASL_LIST_MECHS:
+                reply(hdr, PROTOCOL_BINARY_RESPONSE_SUCCESS, "PLAIN");
+                break;
+            case PROTOCOL_BINARY_CMD_SASL_AUTH:
+            case PROTOCOL_BINARY_CMD_SELECT_BUCKET:
+            case PROTOCOL_BINARY_CMD_NOOP:
+                reply(hdr, PROTOCOL_BINARY_RESPONSE_SUCCESS);
+                break;
+            case PROTOCOL_BINARY_CMD_GET_CLUSTER_CONFIG:
+                reply(hdr, PROTOCOL_BINARY_RESPONSE_SUCCESS, parent->getConfig(), PROTOCOL_BINARY_DATATYPE_JSON);
+                break;
+            default:
+                reply(hdr, PROTOCOL_BINARY_RESPONSE_UNKNOWN_COMMAND);
+                break;
+        }
+    }
+
+    KVServer *parent;
+    SockFD *sock;
+    Thread *thr;
+    Mutex wrmutex;
+    volatile bool notify;
+};
+
+extern "C" {
+static void kvserver_runfunc(void *arg)
+{
+    reinterpret_cast<KVServer *>(arg)->run();
+}
+}
+
+KVServer::KVServer()
+{
+    closed = false;
+    lsn = SockFD::newListener();
+    thr = new Thread(kvserver_runfunc, this);
+}
+
+KVServer::~KVServer()
+{
+    closed = true;
+    lsn->close();
+    delete thr;
+
+    mutex.lock();
+    for (auto &session : sessions) {
+        session->close();
+    }
+    mutex.unlock();
+
+    // Sessions are only joined here, with the lock released, since they may
+    // still be waiting for it to serve the config.
+    for (auto &session : sessions) {
+        delete session;
+    }
+    mutex.close();
+    delete lsn;
+}
+
+void KVServer::run()
+{
+    while (!closed) {
+        fd_set fds;
+        struct timeval tmout = {0, 100000};
+
+        FD_ZERO(&fds);
+        FD_SET(*lsn, &fds);
+        if (select(*lsn + 1, &fds, nullptr, nullptr, &tmout) != 1) {
+            continue;
+        }
+
+        int newfd = accept(*lsn, nullptr, nullptr);
+        if (newfd == -1) {
+            break;
+        }
+
+        mutex.lock();
+        if (closed) {
+            ::closesocket(newfd);
+        } else {
+            sessions.push_back(new Session(this, new SockFD(newfd)));
+        }
+        mutex.unlock();
+    }
+}
+
+void KVServer::setConfig(const std::string &config_)
+{
+    mutex.lock();
+    config = config_;
+    mutex.unlock();
+}
+
+std::string KVServer::makeConfig(int rev)
+{
+    std::string port = std::to_string(getListenPort());
+    return R"({"rev":)" + std::to_string(rev) +
+           R"(,"name":"default","nodeLocator":"vbucket","uuid":"6b3b4b5c","bucketCapabilities":["cccp","xattr",)"
+           R"("nodesExt"],"nodes":[{"hostname":"$HOST:8091","ports":{"direct":)" +
+           port + R"(}}],"nodesExt":[{"services":{"kv":)" + port +
+           R"(,"mgmt":8091},"thisNode":true}],"vBucketServerMap":{"hashAlgorithm":"CRC","numReplicas":0,)"
+           R"("serverList":["$HOST:)" +
+           port + R"("],"vBucketMap":[[0],[0],[0],[0]]}})";
+}
+
+std::string KVServer::getConfig()
+{
+    mutex.lock();
+    std::string ret = config;
+    mutex.unlock();
+    return ret;
+}
+
+size_t KVServer::pushConfig(const std::string &config_, uint32_t rev)
+{
+    uint32_t nrev = htonl(rev);
+    std::string ext(reinterpret_cast<const char *>(&nrev), sizeof(nrev));
+    size_t nsent = 0;
+
+    mutex.lock();
+    for (auto &session : sessions) {
+        if (!session->wantsNotifications()) {
+            continue;
+        }
+        if (session->send(PROTOCOL_BINARY_SREQ, PROTOCOL_BINARY_CMD_SERVER_CLUSTERMAP_CHANGE_NOTIFICATION, 0, 0, ext,
+                          "default", config_, PROTOCOL_BINARY_DATATYPE_JSON)) {
+            nsent++;
+        }
+    }
+    mutex.unlock();
+    return nsent;
+}
+
+size_t KVServer::getNumPushConnections()
+{
+    size_t ret = 0;
+    mutex.lock();
+    for (auto &session : sessions) {
+        if (session->wantsNotifications()) {
+            ret++;
+        }
+    }
+    mutex.unlock();
+    return ret;
+}
+
+size_t KVServer::getNumConnections()
+{
+    mutex.lock();
+    size_t ret = sessions.size();
+    mutex.unlock();
+    return ret;
+}
@@ -0,0 +1,99 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#ifndef LCB_IOSERVER_KVSERVER_H
+#define LCB_IOSERVER_KVSERVER_H
+
+#include "ioserver.h"
+
+namespace LCBTest
+{
+
+/**
+ * A single node memcached server which speaks just enough of the binary
+ * protocol for a client instance to bootstrap from it over CCCP: HELLO,
+ * SASL PLAIN, SELECT_BUCKET and GET_CLUSTER_CONFIG. Anything else is
+ * answered with UNKNOWN_COMMAND.
+ *
+ * Connections which negotiated DUPLEX and CLUSTERMAP_CHANGE_NOTIFICATION
+ * can be sent cluster map change notifications (for the "default" bucket)
+ * with pushConfig().
+ *
+ * The configuration is served verbatim, so it should use `$HOST` and the
+ * port returned by getListenPort() for the node address.
+ */
+class KVServer
+{
+  public:
+    KVServer();
+    ~KVServer();
+
+    /** Set the cluster map returned by GET_CLUSTER_CONFIG */
+    void setConfig(const std::string &config);
+
+    /**
+     * Generate a cluster map for a "default" bucket with this server as its
+     * only node
+     * @param rev the revision of the map
+     */
+    std::string makeConfig(int rev);
+
+    /**
+     * Send a cluster map change notification to every connection which
+     * asked for them.
+     * @param config the cluster map, may be empty
+     * @param rev the revision to put in the extras
+     * @return the number of connections notified
+     */
+    size_t pushConfig(const std::string &config, uint32_t rev);
+
+    /** @return the number of connections which asked for notifications */
+    size_t getNumPushConnections();
+
+    /** @return the number of connections accepted so far */
+    size_t getNumConnections();
+
+    uint16_t getListenPort()
+    {
+        return lsn->getLocalPort();
+    }
+
+    std::string getHostString()
+    {
+        return lsn->getLocalHost();
+    }
+
+    /** Accept loop, run from its own thread */
+    void run();
+
+  private:
+    class Session;
+    friend class Session;
+
+    std::string getConfig();
+
+    volatile bool closed;
+    SockFD *lsn;
+    Thread *thr;
+    Mutex mutex;
+    std::string config;
+    std::list<Session *> sessions;
+};
+
+} // namespace LCBTest
+
+#endif
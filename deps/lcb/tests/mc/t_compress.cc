@@ -0,0 +1,199 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "mctest.h"
+#include "mc/compress.h"
+#include "metrics/metrics-internal.h"
+#include <snappy.h>
+#include <string>
+#include <vector>
+
+class McCompress : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        settings = lcb_settings_new();
+    }
+
+    void TearDown() override
+    {
+        lcb_settings_unref(settings);
+    }
+
+    /** Compresses the value into a new packet, returns whether it was sent compressed */
+    bool compress(CQWrap &q, const std::string &key, const std::string &value, uint32_t cid = 0)
+    {
+        PacketWrap pw;
+        pw.setCopyKey(key.c_str());
+        pw.setHeaderSize();
+        EXPECT_TRUE(pw.reservePacket(&q));
+
+        lcb_VALBUF vbuf{LCB_KV_COPY, {{value.c_str(), value.size()}}};
+        int should_compress = 1;
+        EXPECT_EQ(0, mcreq_compress_value(pw.pipeline, pw.pkt, &vbuf, settings, cid, key.c_str(), key.size(),
+                                          &should_compress));
+        if (should_compress) {
+            EXPECT_LT(pw.pkt->u_value.single.size, value.size());
+        } else {
+            EXPECT_EQ(value.size(), pw.pkt->u_value.single.size);
+        }
+        mcreq_wipe_packet(pw.pipeline, pw.pkt);
+        mcreq_release_packet(pw.pipeline, pw.pkt);
+        return should_compress != 0;
+    }
+
+    static std::string randomValue(size_t size, unsigned seed)
+    {
+        std::string value(size, '\0');
+        for (size_t ii = 0; ii < size; ii++) {
+            seed = seed * 1103515245 + 12345;
+            value[ii] = static_cast<char>(seed >> 16);
+        }
+        return value;
+    }
+
+    lcb_COMPRESSION_STATS stats()
+    {
+        lcb_COMPRESSION_STATS out;
+        mcreq_compress_policy_stats(settings->compress_policy, &out);
+        return out;
+    }
+
+    lcb_settings *settings{nullptr};
+};
+
+TEST_F(McCompress, testCompressible)
+{
+    CQWrap q;
+    std::string value(1024, 'x');
+    for (int ii = 0; ii < 10; ii++) {
+        ASSERT_TRUE(compress(q, "doc::" + std::to_string(ii), value));
+    }
+    lcb_COMPRESSION_STATS st = stats();
+    ASSERT_EQ(10U, st.compressed);
+    ASSERT_EQ(0U, st.rejected);
+    ASSERT_EQ(0U, st.skipped);
+    ASSERT_EQ(10U * value.size(), st.bytes_in);
+    ASSERT_GT(st.bytes_in, st.bytes_out);
+
+    // Below the minimum size nothing is counted
+    ASSERT_FALSE(compress(q, "doc::small", "xx"));
+    ASSERT_EQ(10U, stats().compressed);
+}
+
+TEST_F(McCompress, testSkipsIncompressiblePrefix)
+{
+    CQWrap q;
+    for (unsigned ii = 0; ii < 100; ii++) {
+        ASSERT_FALSE(compress(q, "img::" + std::to_string(ii), randomValue(1024, ii + 1)));
+    }
+    lcb_COMPRESSION_STATS st = stats();
+    ASSERT_EQ(0U, st.compressed);
+    ASSERT_EQ(100U, st.rejected + st.skipped);
+    // Only the first value and the periodic probes are compressed
+    ASSERT_GE(st.skipped, 90U);
+
+    // Other prefixes and collections have their own history
+    std::string value(1024, 'x');
+    ASSERT_TRUE(compress(q, "doc::1", value));
+    ASSERT_TRUE(compress(q, "img::1", value, 8));
+
+    // Once the data becomes compressible, the next probe notices it
+    unsigned skipped = 0;
+    while (!compress(q, "img::again", value)) {
+        ASSERT_LT(++skipped, 100U);
+    }
+    for (int ii = 0; ii < 5; ii++) {
+        ASSERT_TRUE(compress(q, "img::" + std::to_string(ii), value));
+    }
+}
+
+extern "C" {
+static void ignore_value(const lcbmetrics_VALUERECORDER *, uint64_t) {}
+
+static const lcbmetrics_VALUERECORDER *record_operation(const lcbmetrics_METER *meter, const char *,
+                                                        const lcbmetrics_TAG *tags, size_t ntags)
+{
+    std::vector<std::string> *ops;
+    lcbmetrics_meter_cookie(meter, reinterpret_cast<void **>(&ops));
+    for (size_t ii = 0; ii < ntags; ii++) {
+        if (strcmp(tags[ii].key, METRICS_OP_TAG_NAME) == 0) {
+            ops->push_back(tags[ii].value);
+        }
+    }
+    static lcbmetrics_VALUERECORDER recorder{nullptr, nullptr, ignore_value};
+    return &recorder;
+}
+}
+
+TEST_F(McCompress, testRecordsOnlyLatency)
+{
+    std::vector<std::string> ops;
+    lcbmetrics_METER *meter;
+    lcbmetrics_meter_create(&meter, &ops);
+    lcbmetrics_meter_value_recorder_callback(meter, record_operation);
+    settings->meter = meter;
+
+    // Sizes are only counted in the stats, the meter only sees the time spent
+    CQWrap q;
+    ASSERT_TRUE(compress(q, "doc::1", std::string(1024, 'x')));
+    ASSERT_FALSE(compress(q, "img::1", randomValue(1024, 1)));
+    for (unsigned ii = 0; ii < 10; ii++) {
+        compress(q, "img::" + std::to_string(ii), randomValue(1024, ii + 2));
+    }
+    ASSERT_LT(0U, stats().skipped);
+    ASSERT_EQ(stats().compressed + stats().rejected, ops.size());
+    for (const std::string &op : ops) {
+        ASSERT_EQ("snappy_compress", op);
+    }
+}
+
+TEST_F(McCompress, testInflateReusesBuffers)
+{
+    std::string value = randomValue(512, 1) + std::string(100000, 'x');
+    std::string compressed;
+    snappy::Compress(value.c_str(), value.size(), &compressed);
+
+    const void *bytes = nullptr;
+    size_t nbytes = 0;
+    void *first = nullptr;
+    ASSERT_EQ(0, mcreq_inflate_value_pooled(settings->snappy_pool, compressed.c_str(), compressed.size(), &bytes,
+                                            &nbytes, &first));
+    ASSERT_EQ(value, std::string(static_cast<const char *>(bytes), nbytes));
+
+    // While the first one is in use, another buffer is needed
+    void *second = nullptr;
+    ASSERT_EQ(0, mcreq_inflate_value_pooled(settings->snappy_pool, compressed.c_str(), compressed.size(), &bytes,
+                                            &nbytes, &second));
+    ASSERT_NE(first, second);
+    mcreq_inflate_release(settings->snappy_pool, second);
+    mcreq_inflate_release(settings->snappy_pool, first);
+
+    // Smaller values use the buffers which were handed back
+    void *third = nullptr;
+    std::string small;
+    snappy::Compress(value.c_str(), 1000, &small);
+    ASSERT_EQ(0, mcreq_inflate_value_pooled(settings->snappy_pool, small.c_str(), small.size(), &bytes, &nbytes,
+                                            &third));
+    ASSERT_TRUE(third == first || third == second);
+    ASSERT_EQ(value.substr(0, 1000), std::string(static_cast<const char *>(bytes), nbytes));
+    mcreq_inflate_release(settings->snappy_pool, third);
+
+    void *ignored = nullptr;
+    ASSERT_NE(0, mcreq_inflate_value_pooled(settings->snappy_pool, "garbage", 7, &bytes, &nbytes, &ignored));
+}
@@ -17,6 +17,7 @@
 
 #include "mctest.h"
 #include "mc/mcreq-flush-inl.h"
+#include <vector>
 
 class McContext : public ::testing::Test
 {
@@ -116,3 +117,45 @@ TEST_F(McContext, testFailedContext)
         ASSERT_EQ(0, mcreq_flush_iov_fill(pl, iov, 1, NULL));
     }
 }
+
+extern "C" {
+static void ctx_bufdone(mc_PIPELINE *, const void *cookie, void *kbuf, void *)
+{
+    auto *ck = (CtxCookie *)cookie;
+    EXPECT_TRUE(kbuf != nullptr);
+    ck->ncalled++;
+}
+}
+
+TEST_F(McContext, testFailedContextReleasesUserBuffers)
+{
+    CQWrap cq;
+    CtxCookie cookie;
+    std::vector<PacketWrap *> pws;
+
+    cq.setBufFreeCallback(ctx_bufdone);
+    mcreq_sched_enter(&cq);
+
+    for (int ii = 0; ii < 20; ii++) {
+        auto *pw = new PacketWrap();
+        char kbuf[128];
+        sprintf(kbuf, "Key_%d", ii);
+        pw->setContigKey(kbuf);
+
+        ASSERT_TRUE(pw->reservePacket(&cq));
+
+        pw->setHeaderSize();
+        pw->copyHeader();
+        pw->setCookie(&cookie);
+        mcreq_sched_add(pw->pipeline, pw->pkt);
+        pws.push_back(pw);
+    }
+
+    // Packets which never made it into the queue must still hand back their buffers
+    mcreq_sched_fail(&cq);
+    ASSERT_EQ(20, cookie.ncalled);
+
+    for (auto *pw : pws) {
+        delete pw;
+    }
+}
@@ -0,0 +1,144 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2014-2020 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "mctest.h"
+#include "mc/mcreq-flush-inl.h"
+#include <vector>
+
+class McLookup : public ::testing::Test
+{
+};
+
+static mc_PACKET *enqueueHeaderPacket(mc_PIPELINE *pl)
+{
+    protocol_binary_request_header hdr{};
+    mc_PACKET *pkt = mcreq_allocate_packet(pl);
+    EXPECT_EQ(LCB_SUCCESS, mcreq_reserve_header(pl, pkt, sizeof(hdr.bytes)));
+    hdr.request.magic = PROTOCOL_BINARY_REQ;
+    hdr.request.opcode = PROTOCOL_BINARY_CMD_NOOP;
+    hdr.request.opaque = pkt->opaque;
+    mcreq_write_hdr(pkt, &hdr);
+    mcreq_enqueue_packet(pl, pkt);
+    return pkt;
+}
+
+static void flushAll(mc_PIPELINE *pl)
+{
+    nb_IOV iov[64];
+    unsigned toFlush;
+    while ((toFlush = mcreq_flush_iov_fill(pl, iov, 64, nullptr))) {
+        mcreq_flush_done(pl, toFlush, toFlush);
+    }
+}
+
+static std::vector<uint32_t> requestOpaques(mc_PIPELINE *pl)
+{
+    std::vector<uint32_t> ret;
+    sllist_node *ll;
+    SLLIST_FOREACH(&pl->requests, ll)
+    {
+        ret.push_back(SLLIST_ITEM(ll, mc_PACKET, slnode)->opaque);
+    }
+    return ret;
+}
+
+TEST_F(McLookup, testRemoveOutOfOrder)
+{
+    CQWrap cq;
+    mc_PIPELINE *pl = cq.pipelines[0];
+    std::vector<mc_PACKET *> pkts;
+    for (int ii = 0; ii < 10; ii++) {
+        pkts.push_back(enqueueHeaderPacket(pl));
+    }
+
+    // Middle, head, and tail
+    ASSERT_EQ(pkts[4], mcreq_pipeline_remove(pl, pkts[4]->opaque));
+    ASSERT_EQ(pkts[0], mcreq_pipeline_remove(pl, pkts[0]->opaque));
+    ASSERT_EQ(pkts[9], mcreq_pipeline_remove(pl, pkts[9]->opaque));
+    ASSERT_EQ(nullptr, mcreq_pipeline_find(pl, pkts[4]->opaque));
+    ASSERT_EQ(pkts[5], mcreq_pipeline_find(pl, pkts[5]->opaque));
+
+    std::vector<uint32_t> expected;
+    for (int ii : {1, 2, 3, 5, 6, 7, 8}) {
+        expected.push_back(pkts[ii]->opaque);
+    }
+    ASSERT_EQ(expected, requestOpaques(pl));
+
+    // Appending after removing the tail must still link correctly
+    mc_PACKET *extra = enqueueHeaderPacket(pl);
+    expected.push_back(extra->opaque);
+    ASSERT_EQ(expected, requestOpaques(pl));
+    pkts.push_back(extra);
+
+    for (mc_PACKET *pkt : pkts) {
+        mcreq_pipeline_remove(pl, pkt->opaque);
+        mcreq_packet_handled(pl, pkt);
+    }
+    ASSERT_TRUE(SLLIST_IS_EMPTY(&pl->requests));
+    ASSERT_EQ(0, pl->pktindex.count);
+    flushAll(pl);
+}
+
+TEST_F(McLookup, testReenqueueSorted)
+{
+    CQWrap cq;
+    mc_PIPELINE *pl = cq.pipelines[0];
+    mc_PACKET *first = enqueueHeaderPacket(pl);
+    mc_PACKET *second = enqueueHeaderPacket(pl);
+    MCREQ_PKT_RDATA(first)->start = 100;
+    MCREQ_PKT_RDATA(second)->start = 300;
+
+    mc_PACKET *middle = mcreq_allocate_packet(pl);
+    ASSERT_EQ(LCB_SUCCESS, mcreq_reserve_header(pl, middle, MCREQ_PKT_BASESIZE));
+    MCREQ_PKT_RDATA(middle)->start = 200;
+    mcreq_reenqueue_packet(pl, middle);
+
+    std::vector<uint32_t> expected = {first->opaque, middle->opaque, second->opaque};
+    ASSERT_EQ(expected, requestOpaques(pl));
+    ASSERT_EQ(middle, mcreq_pipeline_remove(pl, middle->opaque));
+    ASSERT_EQ(second, mcreq_pipeline_remove(pl, second->opaque));
+    ASSERT_EQ(first, mcreq_pipeline_remove(pl, first->opaque));
+    ASSERT_TRUE(SLLIST_IS_EMPTY(&pl->requests));
+
+    for (mc_PACKET *pkt : {first, middle, second}) {
+        mcreq_packet_handled(pl, pkt);
+    }
+    flushAll(pl);
+}
+
+TEST_F(McLookup, testRemoveReverseOrder)
+{
+    // The worst case for a linear scan of the request log
+    CQWrap cq;
+    mc_PIPELINE *pl = cq.pipelines[0];
+    std::vector<mc_PACKET *> pkts;
+    for (int ii = 0; ii < 1000; ii++) {
+        pkts.push_back(enqueueHeaderPacket(pl));
+    }
+    for (auto it = pkts.rbegin(); it != pkts.rend(); ++it) {
+        ASSERT_EQ(*it, mcreq_pipeline_find(pl, (*it)->opaque));
+        ASSERT_EQ(*it, mcreq_pipeline_remove(pl, (*it)->opaque));
+        ASSERT_EQ(nullptr, mcreq_pipeline_find(pl, (*it)->opaque));
+    }
+    ASSERT_TRUE(SLLIST_IS_EMPTY(&pl->requests));
+    ASSERT_EQ(0, pl->pktindex.count);
+
+    for (mc_PACKET *pkt : pkts) {
+        mcreq_packet_handled(pl, pkt);
+    }
+    flushAll(pl);
+}
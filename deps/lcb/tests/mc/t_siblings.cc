@@ -0,0 +1,185 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "mctest.h"
+#include "mc/mcreq-flush-inl.h"
+#include <vector>
+
+#define NUM_SIBLINGS 2
+
+class McSiblings : public ::testing::Test
+{
+};
+
+/* Gives the first pipeline of the queue additional connections */
+struct SiblingWrap {
+    mc_PIPELINE *primary;
+
+    explicit SiblingWrap(CQWrap &cq) : primary(cq.pipelines[0])
+    {
+        primary->siblings = (mc_PIPELINE **)calloc(NUM_SIBLINGS, sizeof(*primary->siblings));
+        for (unsigned ii = 0; ii < NUM_SIBLINGS; ii++) {
+            mc_PIPELINE *pipeline = new lcb::Server();
+            mcreq_pipeline_init(pipeline);
+            pipeline->parent = &cq;
+            pipeline->index = primary->index;
+            primary->siblings[ii] = pipeline;
+        }
+        primary->nsiblings = NUM_SIBLINGS;
+    }
+
+    ~SiblingWrap()
+    {
+        for (unsigned ii = 0; ii < NUM_SIBLINGS; ii++) {
+            mc_PIPELINE *pipeline = primary->siblings[ii];
+            EXPECT_NE(0, netbuf_is_clean(&pipeline->nbmgr));
+            EXPECT_NE(0, netbuf_is_clean(&pipeline->reqpool));
+            mcreq_pipeline_cleanup(pipeline);
+            delete pipeline;
+        }
+        free(primary->siblings);
+        primary->siblings = nullptr;
+        primary->nsiblings = 0;
+    }
+
+    mc_PIPELINE *get(unsigned ix)
+    {
+        return ix == 0 ? primary : primary->siblings[ix - 1];
+    }
+
+    uint64_t totalOutstanding()
+    {
+        uint64_t total = 0;
+        for (unsigned ii = 0; ii < NUM_SIBLINGS + 1; ii++) {
+            total += get(ii)->nbytes_outstanding;
+        }
+        return total;
+    }
+};
+
+/* Flush the pipeline and complete all of its packets */
+static void drainPipeline(mc_PIPELINE *pl)
+{
+    nb_IOV iov[64];
+    unsigned toFlush;
+    while ((toFlush = mcreq_flush_iov_fill(pl, iov, 64, nullptr))) {
+        mcreq_flush_done(pl, toFlush, toFlush);
+    }
+    while (!SLLIST_IS_EMPTY(&pl->requests)) {
+        mc_PACKET *pkt = SLLIST_ITEM(SLLIST_FIRST(&pl->requests), mc_PACKET, slnode);
+        ASSERT_EQ(pkt, mcreq_pipeline_remove(pl, pkt->opaque));
+        mcreq_packet_handled(pl, pkt);
+    }
+}
+
+/* Schedule packets until `count` of them were placed on the first index */
+static uint64_t schedulePackets(CQWrap &cq, unsigned count, std::vector<mc_PACKET *> &pkts)
+{
+    uint64_t nbytes = 0;
+    for (int ii = 0; pkts.size() < count; ii++) {
+        PacketWrap pw;
+        char kbuf[128];
+        sprintf(kbuf, "key_%d", ii);
+        pw.setCopyKey(kbuf);
+
+        EXPECT_TRUE(pw.reservePacket(&cq));
+        pw.setHeaderSize();
+        pw.copyHeader();
+        mcreq_sched_add(pw.pipeline, pw.pkt);
+
+        if (pw.pipeline->index == 0) {
+            nbytes += mcreq_get_size(pw.pkt);
+            pkts.push_back(pw.pkt);
+        }
+    }
+    return nbytes;
+}
+
+TEST_F(McSiblings, testSelectWithoutSiblings)
+{
+    CQWrap cq;
+    ASSERT_EQ(cq.pipelines[0], mcreq_pipeline_select(cq.pipelines[0], 0));
+    ASSERT_EQ(cq.pipelines[0], mcreq_pipeline_select(cq.pipelines[0], 1024 * 1024));
+}
+
+TEST_F(McSiblings, testSelectLeastOutstanding)
+{
+    CQWrap cq;
+    SiblingWrap sw(cq);
+
+    // Ties go to the primary
+    ASSERT_EQ(sw.get(0), mcreq_pipeline_select(sw.primary, 0));
+
+    sw.get(0)->nbytes_outstanding = 300;
+    sw.get(1)->nbytes_outstanding = 100;
+    sw.get(2)->nbytes_outstanding = 200;
+    ASSERT_EQ(sw.get(1), mcreq_pipeline_select(sw.primary, 0));
+
+    sw.get(1)->nbytes_outstanding = 400;
+    ASSERT_EQ(sw.get(2), mcreq_pipeline_select(sw.primary, 0));
+
+    for (unsigned ii = 0; ii < NUM_SIBLINGS + 1; ii++) {
+        sw.get(ii)->nbytes_outstanding = 0;
+    }
+}
+
+TEST_F(McSiblings, testPacketsAreSpread)
+{
+    CQWrap cq;
+    SiblingWrap sw(cq);
+    std::vector<mc_PACKET *> pkts;
+
+    mcreq_sched_enter(&cq);
+    uint64_t nbytes = schedulePackets(cq, 30, pkts);
+    ASSERT_EQ(nbytes, sw.totalOutstanding());
+    mcreq_sched_leave(&cq, 0);
+
+    // Every connection got a share, and kept its accounting once enqueued
+    ASSERT_EQ(nbytes, sw.totalOutstanding());
+    for (unsigned ii = 0; ii < NUM_SIBLINGS + 1; ii++) {
+        mc_PIPELINE *pl = sw.get(ii);
+        ASSERT_TRUE(SLLIST_IS_EMPTY(&pl->ctxqueued));
+        ASSERT_FALSE(SLLIST_IS_EMPTY(&pl->requests));
+        ASSERT_LT(0U, pl->nbytes_outstanding);
+    }
+
+    // Completing the packets returns their bytes
+    for (unsigned ii = 0; ii < NUM_SIBLINGS + 1; ii++) {
+        drainPipeline(sw.get(ii));
+        ASSERT_EQ(0U, sw.get(ii)->nbytes_outstanding);
+    }
+    for (unsigned ii = 1; ii < cq.npipelines; ii++) {
+        drainPipeline(cq.pipelines[ii]);
+    }
+}
+
+TEST_F(McSiblings, testFailedContextResetsOutstanding)
+{
+    CQWrap cq;
+    SiblingWrap sw(cq);
+    std::vector<mc_PACKET *> pkts;
+
+    mcreq_sched_enter(&cq);
+    ASSERT_LT(0U, schedulePackets(cq, 10, pkts));
+    mcreq_sched_fail(&cq);
+
+    ASSERT_EQ(0U, sw.totalOutstanding());
+    for (unsigned ii = 0; ii < NUM_SIBLINGS + 1; ii++) {
+        ASSERT_TRUE(SLLIST_IS_EMPTY(&sw.get(ii)->ctxqueued));
+        ASSERT_TRUE(SLLIST_IS_EMPTY(&sw.get(ii)->requests));
+    }
+}
@@ -0,0 +1,133 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2014-2020 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "mctest.h"
+#include "mc/mcreq-flush-inl.h"
+#include <vector>
+
+class McTimeout : public ::testing::Test
+{
+};
+
+extern "C" {
+static void tmo_failcb(mc_PIPELINE *, mc_PACKET *pkt, lcb_STATUS, void *arg)
+{
+    auto *failed = reinterpret_cast<std::vector<mc_PACKET *> *>(arg);
+    failed->push_back(pkt);
+}
+}
+
+static mc_PACKET *enqueueWithDeadline(mc_PIPELINE *pl, hrtime_t deadline)
+{
+    mc_PACKET *pkt = mcreq_allocate_packet(pl);
+    EXPECT_EQ(LCB_SUCCESS, mcreq_reserve_header(pl, pkt, MCREQ_PKT_BASESIZE));
+    MCREQ_PKT_RDATA(pkt)->start = 0;
+    MCREQ_PKT_RDATA(pkt)->deadline = deadline;
+    mcreq_enqueue_packet(pl, pkt);
+    return pkt;
+}
+
+static void flushAll(mc_PIPELINE *pl)
+{
+    nb_IOV iov[64];
+    unsigned toFlush;
+    while ((toFlush = mcreq_flush_iov_fill(pl, iov, 64, nullptr))) {
+        mcreq_flush_done(pl, toFlush, toFlush);
+    }
+}
+
+TEST_F(McTimeout, testExpireInDeadlineOrder)
+{
+    CQWrap cq;
+    mc_PIPELINE *pl = cq.pipelines[0];
+    hrtime_t deadline = 0;
+    std::vector<mc_PACKET *> failed;
+
+    ASSERT_EQ(0, mcreq_pipeline_next_deadline(pl, &deadline));
+
+    mc_PACKET *p50 = enqueueWithDeadline(pl, 50);
+    mc_PACKET *p10 = enqueueWithDeadline(pl, 10);
+    mc_PACKET *p30 = enqueueWithDeadline(pl, 30);
+    mc_PACKET *p20 = enqueueWithDeadline(pl, 20);
+
+    ASSERT_NE(0, mcreq_pipeline_next_deadline(pl, &deadline));
+    ASSERT_EQ(10, deadline);
+
+    // A completed packet must not be timed out, nor reported as next deadline
+    ASSERT_EQ(p10, mcreq_pipeline_remove(pl, p10->opaque));
+    mcreq_packet_handled(pl, p10);
+    ASSERT_NE(0, mcreq_pipeline_next_deadline(pl, &deadline));
+    ASSERT_EQ(20, deadline);
+
+    ASSERT_EQ(2, mcreq_pipeline_timeout(pl, LCB_ERR_TIMEOUT, tmo_failcb, &failed, 30));
+    ASSERT_EQ(2, failed.size());
+    ASSERT_EQ(p20, failed[0]);
+    ASSERT_EQ(p30, failed[1]);
+    ASSERT_EQ(2, pl->tmoheap.nexpired);
+    ASSERT_EQ(nullptr, mcreq_pipeline_find(pl, p20->opaque));
+
+    ASSERT_NE(0, mcreq_pipeline_next_deadline(pl, &deadline));
+    ASSERT_EQ(50, deadline);
+    ASSERT_EQ(p50, mcreq_first_packet(pl));
+
+    failed.clear();
+    ASSERT_EQ(1, mcreq_pipeline_fail(pl, LCB_ERR_GENERIC, tmo_failcb, &failed));
+    ASSERT_EQ(p50, failed[0]);
+    ASSERT_EQ(0, mcreq_pipeline_next_deadline(pl, &deadline));
+    ASSERT_EQ(0, pl->tmoheap.size);
+    flushAll(pl);
+}
+
+TEST_F(McTimeout, testResetTimeouts)
+{
+    CQWrap cq;
+    mc_PIPELINE *pl = cq.pipelines[0];
+    hrtime_t deadline = 0;
+    std::vector<mc_PACKET *> failed;
+
+    mc_PACKET *pkt = enqueueWithDeadline(pl, 100);
+    mcreq_reset_timeouts(pl, 1000);
+    ASSERT_NE(0, mcreq_pipeline_next_deadline(pl, &deadline));
+    ASSERT_EQ(1100, deadline);
+    ASSERT_EQ(0, mcreq_pipeline_timeout(pl, LCB_ERR_TIMEOUT, tmo_failcb, &failed, 500));
+
+    // Deadline extended behind the heap's back
+    MCREQ_PKT_RDATA(pkt)->deadline = 2000;
+    ASSERT_EQ(0, mcreq_pipeline_timeout(pl, LCB_ERR_TIMEOUT, tmo_failcb, &failed, 1500));
+    ASSERT_EQ(1, mcreq_pipeline_timeout(pl, LCB_ERR_TIMEOUT, tmo_failcb, &failed, 2000));
+    ASSERT_EQ(pkt, failed[0]);
+    flushAll(pl);
+}
+
+TEST_F(McTimeout, testStaleEntriesCompacted)
+{
+    CQWrap cq;
+    mc_PIPELINE *pl = cq.pipelines[0];
+    std::vector<mc_PACKET *> failed;
+
+    // Complete packets as they are sent, the heap should not grow unbounded
+    for (unsigned ii = 0; ii < 10000; ii++) {
+        mc_PACKET *pkt = enqueueWithDeadline(pl, 1000 + ii);
+        ASSERT_EQ(pkt, mcreq_pipeline_remove(pl, pkt->opaque));
+        mcreq_packet_handled(pl, pkt);
+        flushAll(pl);
+    }
+    ASSERT_LE(pl->tmoheap.size, 128);
+    ASSERT_NE(0, pl->tmoheap.ncompacted);
+    ASSERT_EQ(0, mcreq_pipeline_timeout(pl, LCB_ERR_TIMEOUT, tmo_failcb, &failed, 100000));
+    ASSERT_EQ(0, pl->tmoheap.size);
+}
@@ -0,0 +1,130 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "socktest.h"
+#include <ioserver/kvserver.h>
+#include <libcouchbase/vbucket.h>
+#include <chrono>
+#include <thread>
+
+using namespace LCBTest;
+using std::string;
+
+class ConfigPushTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        server = new KVServer();
+        server->setConfig(makeConfig(1));
+        instance = nullptr;
+    }
+
+    void TearDown() override
+    {
+        if (instance) {
+            lcb_destroy(instance);
+        }
+        delete server;
+    }
+
+    string makeConfig(int rev)
+    {
+        return server->makeConfig(rev);
+    }
+
+    void connect(const char *options)
+    {
+        string connstr = "couchbase://" + server->getHostString() + ":" + std::to_string(server->getListenPort()) +
+                         "=mcd/default?bootstrap_on=cccp&sasl_mech_force=PLAIN&enable_errmap=false";
+        if (options) {
+            connstr += "&";
+            connstr += options;
+        }
+
+        lcb_CREATEOPTS *crparams = nullptr;
+        lcb_createopts_create(&crparams, LCB_TYPE_BUCKET);
+        lcb_createopts_connstr(crparams, connstr.c_str(), connstr.size());
+        lcb_createopts_credentials(crparams, "default", strlen("default"), "password", strlen("password"));
+        ASSERT_EQ(LCB_SUCCESS, lcb_create(&instance, crparams));
+        lcb_createopts_destroy(crparams);
+
+        ASSERT_EQ(LCB_SUCCESS, lcb_connect(instance));
+        lcb_wait(instance, LCB_WAIT_DEFAULT);
+        ASSERT_EQ(LCB_SUCCESS, lcb_get_bootstrap_status(instance));
+
+        // Have the pipeline take over a data connection, which is then idle
+        lcb_CMDPING *cmd;
+        lcb_cmdping_create(&cmd);
+        lcb_cmdping_kv(cmd, 1);
+        ASSERT_EQ(LCB_SUCCESS, lcb_ping(instance, nullptr, cmd));
+        lcb_cmdping_destroy(cmd);
+        lcb_wait(instance, LCB_WAIT_DEFAULT);
+    }
+
+    int revision()
+    {
+        lcbvb_CONFIG *vbc = nullptr;
+        lcb_cntl(instance, LCB_CNTL_GET, LCB_CNTL_VBCONFIG, &vbc);
+        return vbc ? lcbvb_get_revision(vbc) : -1;
+    }
+
+    // Runs the event loop without anything pending, so that only what the
+    // server sends on its own can change the config. Depending on the plugin
+    // a tick may block until the next timer, hence the deadline.
+    bool waitForRevision(int rev, int maxWaitMs = 2000)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(maxWaitMs);
+        while (revision() != rev && std::chrono::steady_clock::now() < deadline) {
+            lcb_tick_nowait(instance);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return revision() == rev;
+    }
+
+    KVServer *server;
+    lcb_INSTANCE *instance;
+};
+
+TEST_F(ConfigPushTest, testPushedConfigIsApplied)
+{
+    connect(nullptr);
+    ASSERT_EQ(1, revision());
+    ASSERT_LT(0U, server->getNumPushConnections());
+
+    server->setConfig(makeConfig(2));
+    ASSERT_LT(0U, server->pushConfig(makeConfig(2), 2));
+    ASSERT_TRUE(waitForRevision(2));
+}
+
+TEST_F(ConfigPushTest, testStalePushIsIgnored)
+{
+    connect(nullptr);
+    server->pushConfig(makeConfig(5), 5);
+    ASSERT_TRUE(waitForRevision(5));
+
+    // An older map must not replace the newer one
+    server->pushConfig(makeConfig(3), 3);
+    ASSERT_FALSE(waitForRevision(3, 200));
+    ASSERT_EQ(5, revision());
+}
+
+TEST_F(ConfigPushTest, testPushCanBeDisabled)
+{
+    connect("enable_config_push=false");
+    ASSERT_EQ(0U, server->getNumPushConnections());
+}
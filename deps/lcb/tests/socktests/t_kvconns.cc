@@ -0,0 +1,116 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "socktest.h"
+#include <ioserver/kvserver.h>
+
+using namespace LCBTest;
+using std::string;
+
+class KVConnectionsTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        server = new KVServer();
+        server->setConfig(server->makeConfig(1));
+        instance = nullptr;
+    }
+
+    void TearDown() override
+    {
+        if (instance) {
+            lcb_destroy(instance);
+        }
+        delete server;
+    }
+
+    void connect(const char *options)
+    {
+        string connstr = "couchbase://" + server->getHostString() + ":" + std::to_string(server->getListenPort()) +
+                         "=mcd/default?bootstrap_on=cccp&sasl_mech_force=PLAIN&enable_errmap=false&" + options;
+
+        lcb_CREATEOPTS *crparams = nullptr;
+        lcb_createopts_create(&crparams, LCB_TYPE_BUCKET);
+        lcb_createopts_connstr(crparams, connstr.c_str(), connstr.size());
+        lcb_createopts_credentials(crparams, "default", strlen("default"), "password", strlen("password"));
+        ASSERT_EQ(LCB_SUCCESS, lcb_create(&instance, crparams));
+        lcb_createopts_destroy(crparams);
+
+        ASSERT_EQ(LCB_SUCCESS, lcb_connect(instance));
+        lcb_wait(instance, LCB_WAIT_DEFAULT);
+        ASSERT_EQ(LCB_SUCCESS, lcb_get_bootstrap_status(instance));
+    }
+
+    // Schedule a batch of gets, which the server fails, and wait for them
+    void runGets(int count)
+    {
+        lcb_install_callback(instance, LCB_CALLBACK_GET, get_callback);
+        int ndone = 0;
+        lcb_sched_enter(instance);
+        for (int ii = 0; ii < count; ii++) {
+            string key = "key_" + std::to_string(ii);
+            lcb_CMDGET *cmd;
+            lcb_cmdget_create(&cmd);
+            lcb_cmdget_key(cmd, key.c_str(), key.size());
+            ASSERT_EQ(LCB_SUCCESS, lcb_get(instance, &ndone, cmd));
+            lcb_cmdget_destroy(cmd);
+        }
+        lcb_sched_leave(instance);
+        lcb_wait(instance, LCB_WAIT_DEFAULT);
+        ASSERT_EQ(count, ndone);
+    }
+
+    static void get_callback(lcb_INSTANCE *, int, const lcb_RESPBASE *rb)
+    {
+        int *ndone;
+        lcb_respget_cookie(reinterpret_cast<const lcb_RESPGET *>(rb), reinterpret_cast<void **>(&ndone));
+        (*ndone)++;
+    }
+
+    KVServer *server;
+    lcb_INSTANCE *instance;
+};
+
+TEST_F(KVConnectionsTest, testSingleConnection)
+{
+    connect("kv_connections_per_node=1");
+    runGets(10);
+    ASSERT_EQ(1U, server->getNumConnections());
+}
+
+TEST_F(KVConnectionsTest, testMultipleConnections)
+{
+    connect("kv_connections_per_node=3");
+
+    lcb_U32 nconns = 0;
+    ASSERT_EQ(LCB_SUCCESS, lcb_cntl(instance, LCB_CNTL_GET, LCB_CNTL_KV_CONNECTIONS_PER_NODE, &nconns));
+    ASSERT_EQ(3U, nconns);
+
+    // A batch is spread over all of the connections to the node
+    runGets(10);
+    ASSERT_EQ(3U, server->getNumConnections());
+}
+
+TEST_F(KVConnectionsTest, testInvalidSetting)
+{
+    lcb_INSTANCE *tmp;
+    ASSERT_EQ(LCB_SUCCESS, lcb_create(&tmp, nullptr));
+    lcb_U32 nconns = 0;
+    ASSERT_NE(LCB_SUCCESS, lcb_cntl(tmp, LCB_CNTL_SET, LCB_CNTL_KV_CONNECTIONS_PER_NODE, &nconns));
+    lcb_destroy(tmp);
+}
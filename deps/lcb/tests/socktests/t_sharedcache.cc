@@ -0,0 +1,134 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2021 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "socktest.h"
+#include <ioserver/kvserver.h>
+#include <libcouchbase/vbucket.h>
+#include <chrono>
+#include <thread>
+
+using namespace LCBTest;
+using std::string;
+
+class SharedCacheTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        server = new KVServer();
+        server->setConfig(server->makeConfig(1));
+    }
+
+    void TearDown() override
+    {
+        for (auto &instance : instances) {
+            lcb_destroy(instance);
+        }
+        delete server;
+    }
+
+    lcb_INSTANCE *connect(const char *name)
+    {
+        string connstr = "couchbase://" + server->getHostString() + ":" + std::to_string(server->getListenPort()) +
+                         "=mcd/default?bootstrap_on=cccp&sasl_mech_force=PLAIN&enable_errmap=false&"
+                         "config_cache_shared=" +
+                         name;
+
+        lcb_INSTANCE *instance = nullptr;
+        lcb_CREATEOPTS *crparams = nullptr;
+        lcb_createopts_create(&crparams, LCB_TYPE_BUCKET);
+        lcb_createopts_connstr(crparams, connstr.c_str(), connstr.size());
+        lcb_createopts_credentials(crparams, "default", strlen("default"), "password", strlen("password"));
+        EXPECT_EQ(LCB_SUCCESS, lcb_create(&instance, crparams));
+        lcb_createopts_destroy(crparams);
+        if (instance == nullptr) {
+            return nullptr;
+        }
+        instances.push_back(instance);
+
+        EXPECT_EQ(LCB_SUCCESS, lcb_connect(instance));
+        lcb_wait(instance, LCB_WAIT_DEFAULT);
+        EXPECT_EQ(LCB_SUCCESS, lcb_get_bootstrap_status(instance));
+        return instance;
+    }
+
+    static bool loadedFromCache(lcb_INSTANCE *instance)
+    {
+        int loaded = 0;
+        lcb_cntl(instance, LCB_CNTL_GET, LCB_CNTL_CONFIG_CACHE_LOADED, &loaded);
+        return loaded != 0;
+    }
+
+    static int revision(lcb_INSTANCE *instance)
+    {
+        lcbvb_CONFIG *vbc = nullptr;
+        lcb_cntl(instance, LCB_CNTL_GET, LCB_CNTL_VBCONFIG, &vbc);
+        return vbc ? lcbvb_get_revision(vbc) : -1;
+    }
+
+    static bool refreshToRevision(lcb_INSTANCE *instance, int rev, int maxWaitMs = 2000)
+    {
+        lcb_refresh_config(instance);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(maxWaitMs);
+        while (revision(instance) != rev && std::chrono::steady_clock::now() < deadline) {
+            lcb_tick_nowait(instance);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return revision(instance) == rev;
+    }
+
+    KVServer *server;
+    std::vector<lcb_INSTANCE *> instances;
+};
+
+TEST_F(SharedCacheTest, testSecondInstanceUsesSharedConfig)
+{
+    lcb_INSTANCE *first = connect("testSecondInstance");
+    ASSERT_NE(nullptr, first);
+    ASSERT_FALSE(loadedFromCache(first));
+    ASSERT_EQ(1, revision(first));
+
+    lcb_INSTANCE *second = connect("testSecondInstance");
+    ASSERT_NE(nullptr, second);
+    ASSERT_TRUE(loadedFromCache(second));
+    ASSERT_EQ(1, revision(second));
+}
+
+TEST_F(SharedCacheTest, testNewerConfigIsShared)
+{
+    lcb_INSTANCE *first = connect("testNewerConfig");
+    lcb_INSTANCE *second = connect("testNewerConfig");
+    ASSERT_NE(nullptr, first);
+    ASSERT_NE(nullptr, second);
+
+    server->setConfig(server->makeConfig(2));
+    ASSERT_TRUE(refreshToRevision(first, 2));
+
+    // The second instance only gets the newer map from the first one
+    server->setConfig(server->makeConfig(1));
+    ASSERT_TRUE(refreshToRevision(second, 2));
+}
+
+TEST_F(SharedCacheTest, testNamesAreSeparate)
+{
+    lcb_INSTANCE *first = connect("testNamesAreSeparate1");
+    lcb_INSTANCE *second = connect("testNamesAreSeparate2");
+    ASSERT_NE(nullptr, first);
+    ASSERT_NE(nullptr, second);
+    ASSERT_FALSE(loadedFromCache(first));
+    ASSERT_FALSE(loadedFromCache(second));
+}
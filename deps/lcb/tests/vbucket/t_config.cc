@@ -456,3 +456,107 @@ TEST_F(ConfigTest, testLargeRevision)
         ASSERT_EQ(18446744073709551615UL, json["max_uint64"].asUInt64());
     }
 }
+
+TEST_F(ConfigTest, testPeekRevision)
+{
+    int64_t revepoch, revid;
+    ASSERT_EQ(0, lcbvb_peek_revision("{\"rev\":42,\"revEpoch\":3}", &revepoch, &revid));
+    ASSERT_EQ(3, revepoch);
+    ASSERT_EQ(42, revid);
+
+    // Only the members of the root object count
+    const char *nested = "{ \"a\" : {\"rev\":1}, \"b\":[{\"rev\":2}], \"c\":\"\\\"rev\\\":3\", \"rev\" : 7 }";
+    ASSERT_EQ(0, lcbvb_peek_revision(nested, &revepoch, &revid));
+    ASSERT_EQ(-1, revepoch);
+    ASSERT_EQ(7, revid);
+
+    ASSERT_NE(0, lcbvb_peek_revision("{\"name\":\"default\"}", &revepoch, &revid));
+    ASSERT_NE(0, lcbvb_peek_revision("{\"rev\":1.5}", &revepoch, &revid));
+    ASSERT_NE(0, lcbvb_peek_revision("{\"rev\":", &revepoch, &revid));
+    ASSERT_NE(0, lcbvb_peek_revision("[1]", &revepoch, &revid));
+
+    string txt = getConfigFile("terse_30.json");
+    lcbvb_CONFIG *cfg = lcbvb_create();
+    ASSERT_EQ(0, lcbvb_load_json(cfg, txt.c_str()));
+    ASSERT_EQ(0, lcbvb_peek_revision(txt.c_str(), &revepoch, &revid));
+    ASSERT_EQ(cfg->revepoch, revepoch);
+    ASSERT_EQ(cfg->revid, revid);
+    lcbvb_destroy(cfg);
+}
+
+static void replaceAll(string &s, size_t pos, const string &from, const string &to)
+{
+    while ((pos = s.find(from, pos)) != string::npos) {
+        s.replace(pos, from.size(), to);
+        pos += to.size();
+    }
+}
+
+static void assertSameMap(const lcbvb_CONFIG *expected, const lcbvb_VBUCKET *vbs, const lcbvb_CONFIG *cfg)
+{
+    ASSERT_EQ(expected->nvb, cfg->nvb);
+    ASSERT_EQ(expected->nrepl, cfg->nrepl);
+    for (unsigned ii = 0; ii < cfg->nvb; ii++) {
+        for (unsigned jj = 0; jj < cfg->nrepl + 1; jj++) {
+            ASSERT_EQ(expected->vbuckets[ii].servers[jj], vbs[ii].servers[jj]);
+        }
+    }
+}
+
+TEST_F(ConfigTest, testStreamedMap)
+{
+    lcbvb_CONFIG *orig = lcbvb_create();
+    lcbvb_genconfig(orig, 100, 2, 1024);
+    orig->revid = 1024;
+    char *js = lcbvb_save_json(orig);
+    string txt(js);
+    free(js);
+
+    lcbvb_CONFIG *cfg = lcbvb_create();
+    ASSERT_EQ(0, lcbvb_load_json(cfg, txt.c_str()));
+    assertSameMap(orig, cfg->vbuckets, cfg);
+    ASSERT_TRUE(cfg->ffvbuckets == nullptr);
+    for (unsigned ii = 0; ii < cfg->nsrv; ii++) {
+        ASSERT_EQ(orig->servers[ii].nvbs, cfg->servers[ii].nvbs);
+    }
+    lcbvb_destroy(cfg);
+
+    // Formatted the way the server does it, with a forward map
+    size_t pos = txt.find("\"vBucketMap\":");
+    ASSERT_NE(string::npos, pos);
+    string map = txt.substr(pos, txt.find("]]", pos) + 2 - pos);
+    string ffmap = map;
+    ffmap.replace(0, sizeof("\"vBucketMap\"") - 1, "\"vBucketMapForward\"");
+    string withff = txt;
+    withff.insert(pos, ffmap + ",");
+    replaceAll(withff, 0, ",[", ",\n  [ ");
+    cfg = lcbvb_create();
+    ASSERT_EQ(0, lcbvb_load_json(cfg, withff.c_str()));
+    assertSameMap(orig, cfg->vbuckets, cfg);
+    ASSERT_TRUE(cfg->ffvbuckets != nullptr);
+    assertSameMap(orig, cfg->ffvbuckets, cfg);
+    lcbvb_destroy(cfg);
+
+    // Numbers which aren't plain integers are still understood
+    string floats = txt;
+    replaceAll(floats, floats.find("\"vBucketMap\":"), "[0,", "[0.0,");
+    ASSERT_NE(txt, floats);
+    cfg = lcbvb_create();
+    ASSERT_EQ(0, lcbvb_load_json(cfg, floats.c_str()));
+    assertSameMap(orig, cfg->vbuckets, cfg);
+    lcbvb_destroy(cfg);
+
+    // Servers which don't exist are rejected
+    string bounds = txt;
+    replaceAll(bounds, bounds.find("\"vBucketMap\":"), "[0,", "[100,");
+    cfg = lcbvb_create();
+    ASSERT_EQ(-1, lcbvb_load_json(cfg, bounds.c_str()));
+    lcbvb_destroy(cfg);
+
+    string truncated = txt.substr(0, txt.find("]]", txt.find("\"vBucketMap\":")));
+    cfg = lcbvb_create();
+    ASSERT_EQ(-1, lcbvb_load_json(cfg, truncated.c_str()));
+    lcbvb_destroy(cfg);
+
+    lcbvb_destroy(orig);
+}
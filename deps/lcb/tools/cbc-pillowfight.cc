@@ -104,7 +104,8 @@ class Configuration
           o_startAt("start-at"), o_rateLimit("rate-limit"), o_userdocs("docs"), o_writeJson("json"),
           o_templatePairs("template"), o_subdoc("subdoc"), o_noop("noop"), o_sdPathCount("pathcount"),
           o_populateOnly("populate-only"), o_exptime("expiry"), o_collection("collection"), o_durability("durability"),
-          o_persist("persist-to"), o_replicate("replicate-to"), o_lock("lock")
+          o_persist("persist-to"), o_replicate("replicate-to"), o_lock("lock"), o_kvConnections("kv-connections"),
+          o_largeValueThreshold("large-value-threshold")
     {
         o_multiSize.setDefault(100).abbrev('B').description("Number of operations to batch");
         o_numItems.setDefault(1000).abbrev('I').description("Number of items to operate on");
@@ -138,6 +139,10 @@ class Configuration
         o_replicate.description("Wait until item is replicated to this number of nodes (-1 for all replicas)")
             .setDefault(0);
         o_lock.description("Lock keys for updates for given time (will not lock when set to zero)").setDefault(0);
+        o_kvConnections.description("Number of data connections to open to each node").setDefault(1);
+        o_largeValueThreshold
+            .description("Reserve a data connection for values of at least this size (with --kv-connections > 1)")
+            .setDefault(0);
         params.getTimings().description("Enable command timings (second time to dump timings automatically)");
     }
 
@@ -279,6 +284,8 @@ class Configuration
         parser.addOption(o_persist);
         parser.addOption(o_replicate);
         parser.addOption(o_lock);
+        parser.addOption(o_kvConnections);
+        parser.addOption(o_largeValueThreshold);
         params.addToParser(parser);
         depr.addOptions(parser);
     }
@@ -357,6 +364,17 @@ class Configuration
     {
         return o_exptime;
     }
+    void setKvConnections(lcb_INSTANCE *instance)
+    {
+        if (o_kvConnections.passed()) {
+            uint32_t nconns = o_kvConnections;
+            lcb_cntl(instance, LCB_CNTL_SET, LCB_CNTL_KV_CONNECTIONS_PER_NODE, &nconns);
+        }
+        if (o_largeValueThreshold.passed()) {
+            uint32_t threshold = o_largeValueThreshold;
+            lcb_cntl(instance, LCB_CNTL_SET, LCB_CNTL_KV_LARGE_VALUE_THRESHOLD, &threshold);
+        }
+    }
 
     uint32_t opsPerCycle{};
     uint32_t sdOpsPerCmd{};
@@ -411,6 +429,8 @@ class Configuration
     IntOption o_replicate;
 
     IntOption o_lock;
+    UIntOption o_kvConnections;
+    UIntOption o_largeValueThreshold;
     DeprecatedOptions depr;
 } config;
 
@@ -1401,6 +1421,7 @@ int main(int argc, char **argv)
         }
 #endif
         cp.doCtls(instance);
+        config.setKvConnections(instance);
         if (config.useCollections()) {
             int use = 1;
             lcb_cntl(instance, LCB_CNTL_SET, LCB_CNTL_ENABLE_COLLECTIONS, &use);
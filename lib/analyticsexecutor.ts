@@ -8,7 +8,7 @@ import {
 } from './analyticstypes'
 import binding, { CppAnalyticsQueryFlags } from './binding'
 import { Connection } from './connection'
-import { StreamableRowPromise } from './streamablepromises'
+import { ROW_BATCH_SIZE, StreamableRowPromise } from './streamablepromises'
 import { goDurationStrToMs } from './utilities'
 
 /**
@@ -80,11 +80,12 @@ export class AnalyticsExecutor {
       })
     })
 
-    this._conn.analyticsQuery(
+    const rowStream = this._conn.analyticsQuery(
       queryData,
       queryFlags,
       options.parentSpan,
       lcbTimeout,
+      ROW_BATCH_SIZE,
       (err, flags, data) => {
         if (!(flags & binding.LCBX_RESP_F_NONFINAL)) {
           if (err) {
@@ -138,10 +139,10 @@ export class AnalyticsExecutor {
           return
         }
 
-        const row = JSON.parse(data)
-        emitter.emit('row', row)
+        return emitter._emitRows(data)
       }
     )
+    emitter._setRowStream(rowStream)
 
     return emitter
   }
@@ -45,6 +45,14 @@ export interface CppMeter {
   ): CppValueRecorder | null
 }
 
+export interface CppAggregatingMeter {
+  snapshot(): any
+  drain(): any
+}
+
+/* eslint-disable-next-line @typescript-eslint/no-empty-interface */
+export interface CppCollectionRef {}
+
 export interface CppRequestSpan {
   addTag(key: string, value: string | number | boolean): void
   end(): void
@@ -55,10 +63,39 @@ export interface CppTracer {
 }
 
 export type CppBytes = string | Buffer
+
+export interface CppRowStream {
+  pause(): void
+  resume(): void
+}
 export type CppTranscoder = any
 export type CppCas = any
 export type CppMutationToken = any
 
+// The results of the simple key-value operations are built by the binding
+// with a fixed shape, their prototypes are the classes in crudoptypes.
+export interface CppGetResult {
+  content: any
+  cas: CppCas
+  expiryTime?: number
+}
+
+export interface CppExistsResult {
+  exists: boolean
+  cas: CppCas
+}
+
+export interface CppMutationResult {
+  cas: CppCas
+  token?: CppMutationToken
+}
+
+export interface CppCounterResult {
+  value: number
+  cas: CppCas
+  token?: CppMutationToken
+}
+
 export interface CppErrorBase extends Error {
   code: number
 }
@@ -131,6 +168,19 @@ export type CppError =
   | CppSearchError
   | CppAnalyticsError
 
+export interface CppPoolStats {
+  cookieAllocs: number
+  scratchAllocs: number
+}
+
+export interface CppQueryCacheStats {
+  hits: number
+  misses: number
+  evictions: number
+  size: number
+  capacity: number
+}
+
 export interface CppConnection {
   new (
     connType: CppConnType,
@@ -139,7 +189,8 @@ export interface CppConnection {
     password: string | undefined,
     logFn: CppLogFunc,
     tracer: CppTracer | undefined,
-    meter: CppMeter | undefined
+    meter: CppMeter | CppAggregatingMeter | undefined,
+    compactResults: boolean | undefined
   ): any
 
   connect(callback: (err: CppError | null) => void): void
@@ -148,31 +199,35 @@ export interface CppConnection {
     bucketName: string,
     callback: (err: CppError | null) => void
   ): void
+  poolStats(): CppPoolStats
+  queryCacheStats(): CppQueryCacheStats
 
   get(
-    scopeName: string,
-    collectionName: string,
+    scopeName: string | CppCollectionRef,
+    collectionName: string | undefined,
     key: CppBytes,
     transcoder: CppTranscoder,
     expiryTime: number | undefined,
     lockTime: number | undefined,
     parentSpan: CppRequestSpan | undefined,
     timeoutMs: number | undefined,
-    callback: (err: CppError | null, cas: CppCas, value: any) => void
+    hedgePercentile: number | undefined,
+    hedgeDelay: number | undefined,
+    callback: (err: CppError | null, res: CppGetResult) => void
   ): void
 
   exists(
-    scopeName: string,
-    collectionName: string,
+    scopeName: string | CppCollectionRef,
+    collectionName: string | undefined,
     key: CppBytes,
     parentSpan: CppRequestSpan | undefined,
     timeoutMs: number | undefined,
-    callback: (err: CppError | null, cas: CppCas, exists: boolean) => void
+    callback: (err: CppError | null, res: CppExistsResult) => void
   ): void
 
   getReplica(
-    scopeName: string,
-    collectionName: string,
+    scopeName: string | CppCollectionRef,
+    collectionName: string | undefined,
     key: CppBytes,
     transcoder: CppTranscoder,
     mode: CppReplicaMode,
@@ -187,8 +242,8 @@ export interface CppConnection {
   ): void
 
   store(
-    scopeName: string,
-    collectionName: string,
+    scopeName: string | CppCollectionRef,
+    collectionName: string | undefined,
     key: CppBytes,
     transcoder: CppTranscoder,
     value: any,
@@ -200,16 +255,50 @@ export interface CppConnection {
     parentSpan: CppRequestSpan | undefined,
     timeoutMs: number | undefined,
     opType: CppStoreOpType,
+    callback: (err: CppError | null, res: CppMutationResult) => void
+  ): void
+
+  getMulti(
+    scopeName: string | CppCollectionRef,
+    collectionName: string | undefined,
+    keys: CppBytes[],
+    transcoder: CppTranscoder,
+    expiryTime: number | undefined,
+    lockTime: number | undefined,
+    parentSpan: CppRequestSpan | undefined,
+    timeoutMs: number | undefined,
     callback: (
       err: CppError | null,
-      cas: CppCas,
-      token: CppMutationToken
+      errs: (CppError | null)[],
+      cas: CppCas[],
+      values: any[]
+    ) => void
+  ): void
+
+  storeMulti(
+    scopeName: string | CppCollectionRef,
+    collectionName: string | undefined,
+    keys: CppBytes[],
+    transcoder: CppTranscoder,
+    values: any[],
+    expirySecs: number | undefined,
+    duraMode: CppDurabilityMode | undefined,
+    persistTo: number | undefined,
+    replicateTo: number | undefined,
+    parentSpan: CppRequestSpan | undefined,
+    timeoutMs: number | undefined,
+    opType: CppStoreOpType,
+    callback: (
+      err: CppError | null,
+      errs: (CppError | null)[],
+      cas: CppCas[],
+      tokens: CppMutationToken[]
     ) => void
   ): void
 
   remove(
-    scopeName: string,
-    collectionName: string,
+    scopeName: string | CppCollectionRef,
+    collectionName: string | undefined,
     key: CppBytes,
     cas: CppCas | undefined,
     duraMode: CppDurabilityMode | undefined,
@@ -217,12 +306,12 @@ export interface CppConnection {
     replicateTo: number | undefined,
     parentSpan: CppRequestSpan | undefined,
     timeoutMs: number | undefined,
-    callback: (err: CppError | null, cas: CppCas) => void
+    callback: (err: CppError | null, res: CppMutationResult) => void
   ): void
 
   touch(
-    scopeName: string,
-    collectionName: string,
+    scopeName: string | CppCollectionRef,
+    collectionName: string | undefined,
     key: CppBytes,
     expirySecs: number,
     duraMode: CppDurabilityMode | undefined,
@@ -230,12 +319,12 @@ export interface CppConnection {
     replicateTo: number | undefined,
     parentSpan: CppRequestSpan | undefined,
     timeoutMs: number | undefined,
-    callback: (err: CppError | null, cas: CppCas) => void
+    callback: (err: CppError | null, res: CppMutationResult) => void
   ): void
 
   unlock(
-    scopeName: string,
-    collectionName: string,
+    scopeName: string | CppCollectionRef,
+    collectionName: string | undefined,
     key: CppBytes,
     cas: CppCas,
     parentSpan: CppRequestSpan | undefined,
@@ -244,8 +333,8 @@ export interface CppConnection {
   ): void
 
   counter(
-    scopeName: string,
-    collectionName: string,
+    scopeName: string | CppCollectionRef,
+    collectionName: string | undefined,
     key: CppBytes,
     delta: number | undefined,
     initial: number | undefined,
@@ -255,17 +344,12 @@ export interface CppConnection {
     replicateTo: number | undefined,
     parentSpan: CppRequestSpan | undefined,
     timeoutMs: number | undefined,
-    callback: (
-      err: CppError | null,
-      cas: CppCas,
-      token: CppMutationToken,
-      value: number
-    ) => void
+    callback: (err: CppError | null, res: CppCounterResult) => void
   ): void
 
   lookupIn(
-    scopeName: string,
-    collectionName: string,
+    scopeName: string | CppCollectionRef,
+    collectionName: string | undefined,
     key: CppBytes,
     flags: number,
     cmds: [
@@ -280,8 +364,8 @@ export interface CppConnection {
   ): void
 
   mutateIn(
-    scopeName: string,
-    collectionName: string,
+    scopeName: string | CppCollectionRef,
+    collectionName: string | undefined,
     key: CppBytes,
     expirySecs: number | undefined,
     cas: CppCas | undefined,
@@ -301,6 +385,25 @@ export interface CppConnection {
     callback: (err: CppError | null, res: any) => void
   ): void
 
+  queuePop(
+    scopeName: string | CppCollectionRef,
+    collectionName: string | undefined,
+    key: CppBytes,
+    parentSpan: CppRequestSpan | undefined,
+    timeoutMs: number | undefined,
+    callback: (err: CppError | null, value: any) => void
+  ): void
+
+  setRemove(
+    scopeName: string | CppCollectionRef,
+    collectionName: string | undefined,
+    key: CppBytes,
+    item: any,
+    parentSpan: CppRequestSpan | undefined,
+    timeoutMs: number | undefined,
+    callback: (err: CppError | null, removed: boolean) => void
+  ): void
+
   viewQuery(
     designDoc: string,
     viewName: string,
@@ -320,39 +423,43 @@ export interface CppConnection {
 
   query(
     queryData: CppBytes,
+    queryParams: string[] | undefined,
     flags: CppQueryFlags,
     parentSpan: CppRequestSpan | undefined,
     timeoutMs: number | undefined,
+    rowBatchSize: number | undefined,
     callback: (
       err: CppError | null,
       flags: CppQueryRespFlags,
       data: any
-    ) => void
-  ): void
+    ) => boolean | void
+  ): CppRowStream | boolean
 
   analyticsQuery(
     queryData: CppBytes,
     flags: CppAnalyticsQueryFlags,
     parentSpan: CppRequestSpan | undefined,
     timeoutMs: number | undefined,
+    rowBatchSize: number | undefined,
     callback: (
       err: CppError | null,
       flags: CppAnalyticsQueryRespFlags,
       data: any
-    ) => void
-  ): void
+    ) => boolean | void
+  ): CppRowStream | boolean
 
   searchQuery(
     queryData: CppBytes,
     flags: CppSearchQueryFlags,
     parentSpan: CppRequestSpan | undefined,
     timeoutMs: number | undefined,
+    rowBatchSize: number | undefined,
     callback: (
       err: CppError | null,
       flags: CppSearchQueryRespFlags,
       data: any
-    ) => void
-  ): void
+    ) => boolean | void
+  ): CppRowStream | boolean
 
   httpRequest(
     httpType: CppHttpType,
@@ -383,6 +490,19 @@ export interface CppBinding {
   lcbVersion: string
 
   Connection: CppConnection
+  AggregatingMeter: { new (): CppAggregatingMeter }
+  CollectionRef: {
+    new (scopeName: string, collectionName: string): CppCollectionRef
+  }
+  GetResult: { prototype: CppGetResult }
+  ExistsResult: { prototype: CppExistsResult }
+  MutationResult: { prototype: CppMutationResult }
+  CounterResult: { prototype: CppCounterResult }
+
+  registerDefaultTranscoder(
+    encode: (value: any) => [Buffer, number],
+    decode: (bytes: Buffer, flags: number) => any
+  ): void
 
   LCB_SUCCESS: CppErrType
   LCB_ERR_GENERIC: CppErrType
@@ -127,6 +127,24 @@ export interface ConnectOptions {
    * Specifies a logging function to use when outputting logging.
    */
   logFunc?: LogFunc
+
+  /**
+   * Specifies the name of a configuration cache shared by every cluster in the
+   * process which uses the same name, including those created on other
+   * worker threads.  Bucket connections sharing the cache only fetch the
+   * cluster map once between them, keep each other up to date with newer
+   * ones and share resolved collection IDs.
+   */
+  sharedConfigCache?: string
+
+  /**
+   * Specifies that the CAS of results should be a BigInt, and that mutation
+   * tokens should be packed into shared buffers, rather than both being
+   * wrapped in objects of their own.  This reduces the number of objects the
+   * garbage collector has to deal with for every operation.  Note that a
+   * BigInt cannot be passed to JSON.stringify without a replacer.
+   */
+  compactResults?: boolean
 }
 
 /**
@@ -154,6 +172,8 @@ export class Cluster {
   private _tracer: RequestTracer
   private _meter: Meter
   private _logFunc: LogFunc
+  private _sharedConfigCache: string
+  private _compactResults: boolean
 
   /**
   @internal
@@ -180,6 +200,8 @@ export class Cluster {
     this._analyticsTimeout = options.analyticsTimeout || 0
     this._searchTimeout = options.searchTimeout || 0
     this._managementTimeout = options.managementTimeout || 0
+    this._sharedConfigCache = options.sharedConfigCache || ''
+    this._compactResults = options.compactResults || false
 
     if (options.transcoder) {
       this._transcoder = options.transcoder
@@ -487,6 +509,8 @@ export class Cluster {
       analyticsTimeout: this._analyticsTimeout,
       searchTimeout: this._searchTimeout,
       managementTimeout: this._managementTimeout,
+      sharedConfigCache: this._sharedConfigCache,
+      compactResults: this._compactResults,
       ...extraOpts,
     }
 
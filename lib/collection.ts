@@ -5,7 +5,11 @@ import {
   PrependOptions,
   BinaryCollection,
 } from './binarycollection'
-import binding, { CppReplicaMode, CppSdOpFlag } from './binding'
+import binding, {
+  CppCollectionRef,
+  CppReplicaMode,
+  CppSdOpFlag,
+} from './binding'
 import { CppStoreOpType } from './binding'
 import { duraLevelToCppDuraMode, translateCppError } from './bindingutilities'
 import { Connection } from './connection'
@@ -65,6 +69,24 @@ export interface GetOptions {
    * The timeout for this operation, represented in milliseconds.
    */
   timeout?: number
+
+  /**
+   * Hedges the read against the replicas of the document.  If the active
+   * node has not responded once this percentile (0 to 100) of the latencies
+   * of recent gets has passed, the document is also read from a replica and
+   * whichever read succeeds first is returned.  Latencies are only available
+   * when the cluster was connected with an AggregatingMeter, until then
+   * {@link hedgeDelay} is used.  Reads which use {@link project} or
+   * {@link withExpiry} are not hedged.
+   */
+  hedgePercentile?: number
+
+  /**
+   * The time, in milliseconds, after which a hedged read is also sent to a
+   * replica when {@link hedgePercentile} is not set, or no latencies have
+   * been recorded yet.
+   */
+  hedgeDelay?: number
 }
 
 /**
@@ -494,6 +516,7 @@ export class Collection {
   private _scope: Scope
   private _name: string
   private _conn: Connection
+  private _lcbRef: CppCollectionRef | undefined
 
   /**
   @internal
@@ -532,15 +555,22 @@ export class Collection {
     return this._name
   }
 
-  private get _lcbScopeColl(): [string, string] {
-    // BUG(JSCBC-853): There is a bug in libcouchbase which causes non-blank scope
-    // and collection names to fail the collections feature-check when they should not.
-    const scopeName = this.scope.name || '_default'
-    const collectionName = this.name || '_default'
-    if (scopeName === '_default' && collectionName === '_default') {
-      return ['', '']
+  private get _lcbScopeColl(): [CppCollectionRef, undefined] {
+    if (!this._lcbRef) {
+      // BUG(JSCBC-853): There is a bug in libcouchbase which causes non-blank scope
+      // and collection names to fail the collections feature-check when they should not.
+      let scopeName = this.scope.name || '_default'
+      let collectionName = this.name || '_default'
+      if (scopeName === '_default' && collectionName === '_default') {
+        scopeName = ''
+        collectionName = ''
+      }
+
+      // The reference is kept for the lifetime of this collection so that the
+      // names are only converted once and the collection ID can be reused.
+      this._lcbRef = new binding.CollectionRef(scopeName, collectionName)
     }
-    return [scopeName, collectionName]
+    return [this._lcbRef, undefined]
   }
 
   /**
@@ -570,6 +600,8 @@ export class Collection {
     const transcoder = options.transcoder || this.transcoder
     const parentSpan = options.parentSpan
     const lcbTimeout = options.timeout ? options.timeout * 1000 : undefined
+    const lcbHedgeDelay =
+      options.hedgeDelay !== undefined ? options.hedgeDelay * 1000 : undefined
 
     return PromiseHelper.wrap((wrapCallback) => {
       this._conn.get(
@@ -580,18 +612,14 @@ export class Collection {
         undefined,
         parentSpan,
         lcbTimeout,
-        (err, cas, value) => {
+        options.hedgePercentile,
+        lcbHedgeDelay,
+        (err, res) => {
           if (err) {
             return wrapCallback(err, null)
           }
 
-          wrapCallback(
-            null,
-            new GetResult({
-              content: value,
-              cas: cas,
-            })
-          )
+          wrapCallback(null, res as GetResult)
         }
       )
     }, callback)
@@ -710,18 +738,12 @@ export class Collection {
         key,
         parentSpan,
         lcbTimeout,
-        (err, cas, exists) => {
+        (err, res) => {
           if (err) {
             return wrapCallback(err, null)
           }
 
-          wrapCallback(
-            null,
-            new ExistsResult({
-              cas,
-              exists,
-            })
-          )
+          wrapCallback(null, res as ExistsResult)
         }
       )
     }, callback)
@@ -860,17 +882,12 @@ export class Collection {
         replicateTo,
         parentSpan,
         lcbTimeout,
-        (err, cas) => {
+        (err, res) => {
           if (err) {
             return wrapCallback(err, null)
           }
 
-          wrapCallback(
-            err,
-            new MutationResult({
-              cas: cas,
-            })
-          )
+          wrapCallback(null, res as MutationResult)
         }
       )
     }, callback)
@@ -912,18 +929,14 @@ export class Collection {
         undefined,
         parentSpan,
         lcbTimeout,
-        (err, cas, value) => {
+        undefined,
+        undefined,
+        (err, res) => {
           if (err) {
             return wrapCallback(err, null)
           }
 
-          wrapCallback(
-            err,
-            new GetResult({
-              content: value,
-              cas: cas,
-            })
-          )
+          wrapCallback(null, res as GetResult)
         }
       )
     }, callback)
@@ -967,17 +980,12 @@ export class Collection {
         replicateTo,
         parentSpan,
         lcbTimeout,
-        (err, cas) => {
+        (err, res) => {
           if (err) {
             return wrapCallback(err, null)
           }
 
-          wrapCallback(
-            err,
-            new MutationResult({
-              cas: cas,
-            })
-          )
+          wrapCallback(null, res as MutationResult)
         }
       )
     }, callback)
@@ -1018,18 +1026,14 @@ export class Collection {
         lockTime,
         parentSpan,
         lcbTimeout,
-        (err, cas, value) => {
+        undefined,
+        undefined,
+        (err, res) => {
           if (err) {
             return wrapCallback(err, null)
           }
 
-          wrapCallback(
-            err,
-            new GetResult({
-              cas: cas,
-              content: value,
-            })
-          )
+          wrapCallback(null, res as GetResult)
         }
       )
     }, callback)
@@ -1124,11 +1128,6 @@ export class Collection {
             for (let i = 0; i < res.content.length; ++i) {
               const itemRes = res.content[i]
               itemRes.error = translateCppError(itemRes.error)
-              if (itemRes.value && itemRes.value.length > 0) {
-                itemRes.value = JSON.parse(itemRes.value)
-              } else {
-                itemRes.value = null
-              }
 
               // TODO(brett19): BUG JSCBC-632 - This conversion logic should not be required,
               // it is expected that when JSCBC-632 is fixed, this code is removed as well.
@@ -1226,17 +1225,6 @@ export class Collection {
         lcbTimeout,
         (err, res) => {
           if (res && res.content) {
-            for (let i = 0; i < res.content.length; ++i) {
-              const itemRes = res.content[i]
-              if (itemRes.value && itemRes.value.length > 0) {
-                res.content[i] = {
-                  value: JSON.parse(itemRes.value),
-                }
-              } else {
-                res.content[i] = null
-              }
-            }
-
             wrapCallback(
               err,
               new MutateInResult({
@@ -1399,18 +1387,12 @@ export class Collection {
         parentSpan,
         lcbTimeout,
         opType,
-        (err, cas, token) => {
+        (err, res) => {
           if (err) {
             return wrapCallback(err, null)
           }
 
-          wrapCallback(
-            err,
-            new MutationResult({
-              cas: cas,
-              token: token,
-            })
-          )
+          wrapCallback(null, res as MutationResult)
         }
       )
     }, callback)
@@ -1458,19 +1440,12 @@ export class Collection {
         replicateTo,
         parentSpan,
         lcbTimeout,
-        (err, cas, token, value) => {
+        (err, res) => {
           if (err) {
             return wrapCallback(err, null)
           }
 
-          wrapCallback(
-            err,
-            new CounterResult({
-              cas: cas,
-              token: token,
-              value: value,
-            })
-          )
+          wrapCallback(null, res as CounterResult)
         }
       )
     }, callback)
@@ -1537,4 +1512,59 @@ export class Collection {
       callback
     )
   }
+
+  /**
+   * Removes and returns the last element of the array stored in a document.
+   * The read and the conditional removal are retried within the binding for
+   * as long as other writers cause CAS mismatches, up to a fixed limit.
+   *
+   * @internal
+   */
+  _queuePop(key: string, callback?: NodeCallback<any>): Promise<any> {
+    return PromiseHelper.wrap((wrapCallback) => {
+      this._conn.queuePop(
+        ...this._lcbScopeColl,
+        key,
+        undefined,
+        undefined,
+        (err, value) => {
+          if (err) {
+            return wrapCallback(err, null)
+          }
+
+          wrapCallback(null, value)
+        }
+      )
+    }, callback)
+  }
+
+  /**
+   * Removes the first element of the array stored in a document which is
+   * strictly equal to the item, resolving to whether there was one.  Retried
+   * within the binding in the same way as {@link _queuePop}.
+   *
+   * @internal
+   */
+  _setRemove(
+    key: string,
+    item: any,
+    callback?: NodeCallback<boolean>
+  ): Promise<boolean> {
+    return PromiseHelper.wrap((wrapCallback) => {
+      this._conn.setRemove(
+        ...this._lcbScopeColl,
+        key,
+        item,
+        undefined,
+        undefined,
+        (err, removed) => {
+          if (err) {
+            return wrapCallback(err, null)
+          }
+
+          wrapCallback(null, removed)
+        }
+      )
+    }, callback)
+  }
 }
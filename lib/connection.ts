@@ -4,13 +4,16 @@ import binding, {
   CppLogFunc,
   CppError,
   CppTracer,
+  CppAggregatingMeter,
   CppMeter,
+  CppPoolStats,
+  CppQueryCacheStats,
 } from './binding'
 import { translateCppError } from './bindingutilities'
 import { ConnSpec } from './connspec'
 import { ConnectionClosedError } from './errors'
 import { LogFunc } from './logging'
-import { NoopMeter, LoggingMeter, Meter } from './metrics'
+import { NoopMeter, LoggingMeter, AggregatingMeter, Meter } from './metrics'
 import { NoopTracer, ThresholdLoggingTracer, RequestTracer } from './tracing'
 
 function getClientString() {
@@ -45,6 +48,8 @@ export interface ConnectionOptions {
   tracer?: RequestTracer
   meter?: Meter
   logFunc?: LogFunc
+  sharedConfigCache?: string
+  compactResults?: boolean
 }
 
 type ErrCallback = (err: Error | null) => void
@@ -73,6 +78,32 @@ type CppCbToNew<T extends (...fargs: any[]) => void> = T extends (
     ]
   : never
 
+// The batched equivalent of CppCbToNew, which additionally adjusts the
+// per-operation error column of the callback to be of type (Error | null).
+type CppBatchCbToNew<T extends (...fargs: any[]) => void> = T extends (
+  ...fargs: [
+    ...infer FArgs,
+    (
+      err: CppError | null,
+      errs: (CppError | null)[],
+      ...cbArgs: infer CbArgs
+    ) => void
+  ]
+) => void
+  ? [
+      ...fargs: MergeArgs<
+        FArgs,
+        [
+          callback: (
+            err: Error | null,
+            errs: (Error | null)[],
+            ...cbArgs: CbArgs
+          ) => void
+        ]
+      >
+    ]
+  : never
+
 // BUG(JSCBC-901): We cannot defer HTTP operations inside of libcouchbase and thus
 // need to perform that deferral at the binding level.
 type HttpWaitFunc = (err: Error | null) => void
@@ -112,6 +143,10 @@ export class Connection {
     if (options.bucketName) {
       lcbDsnObj.bucket = options.bucketName
     }
+    if (options.sharedConfigCache && lcbDsnObj.bucket) {
+      // Only bucket connections have a cluster map to share.
+      lcbDsnObj.options.config_cache_shared = options.sharedConfigCache
+    }
     if (options.kvConnectTimeout) {
       lcbDsnObj.options.config_total_timeout = fmtTmt(options.kvConnectTimeout)
     }
@@ -183,7 +218,7 @@ export class Connection {
       }
     }
 
-    let lcbMeter: CppMeter | undefined = undefined
+    let lcbMeter: CppMeter | CppAggregatingMeter | undefined = undefined
     if (options.meter) {
       if (options.meter instanceof NoopMeter) {
         lcbDsnObj.options.enable_operation_metrics = 'off'
@@ -195,6 +230,9 @@ export class Connection {
             meterOpts.emitInterval
           )
         }
+      } else if (options.meter instanceof AggregatingMeter) {
+        lcbDsnObj.options.enable_operation_metrics = 'on'
+        lcbMeter = options.meter._impl
       } else {
         lcbDsnObj.options.enable_operation_metrics = 'on'
         lcbMeter = options.meter
@@ -221,7 +259,8 @@ export class Connection {
       options.password,
       lcbLogFunc,
       lcbTracer,
-      lcbMeter
+      lcbMeter,
+      options.compactResults
     )
 
     // If a bucket name is specified, this connection is immediately marked as
@@ -272,6 +311,14 @@ export class Connection {
     callback(null)
   }
 
+  poolStats(): CppPoolStats {
+    return this._inst.poolStats()
+  }
+
+  queryCacheStats(): CppQueryCacheStats {
+    return this._inst.queryCacheStats()
+  }
+
   get(
     ...args: CppCbToNew<CppConnection['get']>
   ): ReturnType<CppConnection['get']> {
@@ -296,6 +343,18 @@ export class Connection {
     return this._proxyToConn(this._inst, this._inst.store, ...args)
   }
 
+  getMulti(
+    ...args: CppBatchCbToNew<CppConnection['getMulti']>
+  ): ReturnType<CppConnection['getMulti']> {
+    return this._proxyBatchToConn(this._inst, this._inst.getMulti, ...args)
+  }
+
+  storeMulti(
+    ...args: CppBatchCbToNew<CppConnection['storeMulti']>
+  ): ReturnType<CppConnection['storeMulti']> {
+    return this._proxyBatchToConn(this._inst, this._inst.storeMulti, ...args)
+  }
+
   remove(
     ...args: CppCbToNew<CppConnection['remove']>
   ): ReturnType<CppConnection['remove']> {
@@ -332,6 +391,18 @@ export class Connection {
     return this._proxyToConn(this._inst, this._inst.mutateIn, ...args)
   }
 
+  queuePop(
+    ...args: CppCbToNew<CppConnection['queuePop']>
+  ): ReturnType<CppConnection['queuePop']> {
+    return this._proxyToConn(this._inst, this._inst.queuePop, ...args)
+  }
+
+  setRemove(
+    ...args: CppCbToNew<CppConnection['setRemove']>
+  ): ReturnType<CppConnection['setRemove']> {
+    return this._proxyToConn(this._inst, this._inst.setRemove, ...args)
+  }
+
   viewQuery(
     ...args: CppCbToNew<CppConnection['viewQuery']>
   ): ReturnType<CppConnection['viewQuery']> {
@@ -380,6 +451,24 @@ export class Connection {
     return this._proxyToConn(this._inst, this._inst.diag, ...args)
   }
 
+  private _proxyBatchToConn(
+    thisArg: CppConnection,
+    fn: (...cppArgs: any[]) => void,
+    ...newArgs: any[]
+  ) {
+    const callback = newArgs.pop()
+
+    newArgs.push(
+      (err: Error | null, errs: (CppError | null)[], ...cbArgs: any[]) => {
+        const translatedErrs = errs
+          ? errs.map((opErr) => translateCppError(opErr))
+          : errs
+        callback(err, translatedErrs, ...cbArgs)
+      }
+    )
+    return this._proxyToConn(thisArg, fn as any, ...(newArgs as any))
+  }
+
   private _proxyToConn<FArgs extends any[], CbArgs extends any[]>(
     thisArg: CppConnection,
     fn: (
@@ -400,10 +489,12 @@ export class Connection {
       return ((callback as any) as ErrCallback)(closeErr)
     }
 
+    // The return values are passed through in both directions, streaming
+    // requests use them to return their row stream and to apply backpressure.
     wrappedArgs.push((err: CppError | null, ...cbArgs: CbArgs) => {
       const translatedErr = translateCppError(err)
-      callback.apply(undefined, [translatedErr, ...cbArgs])
+      return callback.apply(undefined, [translatedErr, ...cbArgs])
     })
-    fn.apply(thisArg, wrappedArgs)
+    return fn.apply(thisArg, wrappedArgs)
   }
 }
@@ -1,3 +1,4 @@
+import binding from './binding'
 import { MutationToken } from './mutationstate'
 import { Cas } from './utilities'
 
@@ -285,3 +286,13 @@ export class CounterResult {
     this.token = data.token
   }
 }
+
+// The binding builds the results of the simple key-value operations itself,
+// these make them instances of the classes above.
+Object.setPrototypeOf(binding.GetResult.prototype, GetResult.prototype)
+Object.setPrototypeOf(binding.ExistsResult.prototype, ExistsResult.prototype)
+Object.setPrototypeOf(
+  binding.MutationResult.prototype,
+  MutationResult.prototype
+)
+Object.setPrototypeOf(binding.CounterResult.prototype, CounterResult.prototype)
@@ -1,5 +1,12 @@
 import { Collection } from './collection'
-import { CouchbaseError, PathExistsError, PathInvalidError } from './errors'
+import {
+  CasMismatchError,
+  CouchbaseError,
+  PathExistsError,
+  PathInvalidError,
+  PathMismatchError,
+  PathNotFoundError,
+} from './errors'
 import { StoreSemantics } from './generaltypes'
 import { LookupInSpec, MutateInSpec } from './sdspecs'
 import { NodeCallback, PromiseHelper } from './utilities'
@@ -448,29 +455,21 @@ export class CouchbaseQueue {
    */
   async pop(callback?: NodeCallback<any>): Promise<any> {
     return PromiseHelper.wrapAsync(async () => {
-      for (let i = 0; i < 16; ++i) {
-        try {
-          const res = await this._coll.lookupIn(this._key, [
-            LookupInSpec.get('[-1]'),
-          ])
-
-          const value = res.content[0].value
-
-          await this._coll.mutateIn(this._key, [MutateInSpec.remove('[-1]')], {
-            cas: res.cas,
-          })
-
-          return value
-        } catch (e) {
-          if (e instanceof PathInvalidError) {
-            throw new CouchbaseError('no items available in list')
-          }
-
-          // continue and retry
+      try {
+        return await this._coll._queuePop(this._key)
+      } catch (e) {
+        if (e instanceof PathInvalidError || e instanceof PathNotFoundError) {
+          throw new CouchbaseError('no items available in list')
+        }
+        if (e instanceof PathMismatchError) {
+          throw new CouchbaseError('expected document of array type')
+        }
+        if (e instanceof CasMismatchError) {
+          throw new CouchbaseError('no items available to pop')
         }
-      }
 
-      throw new CouchbaseError('no items available to pop')
+        throw e
+      }
     }, callback)
   }
 }
@@ -561,33 +560,23 @@ export class CouchbaseSet {
    */
   async remove(item: any, callback?: NodeCallback<void>): Promise<void> {
     return PromiseHelper.wrapAsync(async () => {
-      for (let i = 0; i < 16; ++i) {
-        try {
-          const res = await this._coll.get(this._key)
-          if (!(res.content instanceof Array)) {
-            throw new CouchbaseError('expected document of array type')
-          }
-
-          const itemIdx = res.content.indexOf(item)
-          if (itemIdx === -1) {
-            throw new Error('item was not found in set')
-          }
-
-          await this._coll.mutateIn(
-            this._key,
-            [MutateInSpec.remove('[' + itemIdx + ']')],
-            {
-              cas: res.cas,
-            }
-          )
-
-          return
-        } catch (e) {
-          // continue and retry
+      let removed = false
+      try {
+        removed = await this._coll._setRemove(this._key, item)
+      } catch (e) {
+        if (e instanceof PathMismatchError) {
+          throw new CouchbaseError('expected document of array type')
         }
+        if (e instanceof CasMismatchError) {
+          throw new CouchbaseError('item could not be removed from set')
+        }
+
+        throw e
       }
 
-      throw new CouchbaseError('no items available to pop')
+      if (!removed) {
+        throw new CouchbaseError('item was not found in set')
+      }
     }, callback)
   }
 
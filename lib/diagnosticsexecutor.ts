@@ -51,12 +51,29 @@ export class DiagnoticsExecutor {
       version: baseConfig.version,
       sdk: baseConfig.sdk,
       services: [] as any[],
+      queryCache: {
+        hits: 0,
+        misses: 0,
+        evictions: 0,
+        size: 0,
+        capacity: 0,
+      },
     }
 
     if (options.reportId) {
       report.id = options.reportId
     }
 
+    // Every connection prepares the statements it executes on its own.
+    this._conns.forEach((conn) => {
+      const stats = conn.queryCacheStats()
+      report.queryCache.hits += stats.hits
+      report.queryCache.misses += stats.misses
+      report.queryCache.evictions += stats.evictions
+      report.queryCache.size += stats.size
+      report.queryCache.capacity += stats.capacity
+    })
+
     diagReses.forEach((diagRes: any) => {
       if (diagRes.config) {
         diagRes.config.forEach((svcDiagRes: any) => {
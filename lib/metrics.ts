@@ -1,3 +1,5 @@
+import binding, { CppAggregatingMeter } from './binding'
+
 export interface LoggingMeterOptions {
   /**
    * Specifies how often logging meter information should be logged,
@@ -73,3 +75,71 @@ export class LoggingMeter implements Meter {
     throw new Error('invalid usage')
   }
 }
+
+/**
+ * The latencies recorded for a single operation by an {@link AggregatingMeter}.
+ */
+export interface OperationMetrics {
+  /**
+   * The number of operations recorded.
+   */
+  totalCount: number
+
+  /**
+   * The latencies of the operations at various percentiles, specified in
+   * microseconds and keyed by percentile (`"50.0"`, `"90.0"`, `"99.0"`,
+   * `"99.9"` and `"100.0"`).
+   */
+  percentiles: { [percentile: string]: number }
+}
+
+/**
+ * The latencies aggregated by an {@link AggregatingMeter}, keyed by service
+ * and then by operation name.
+ */
+export interface MeterSnapshot {
+  [service: string]: { [operation: string]: OperationMetrics }
+}
+
+/**
+ * Implements a meter which aggregates operation latencies into histograms
+ * inside the native binding, which can then be read through {@link snapshot}
+ * or {@link drain}.  Unlike a custom {@link Meter}, recording a value never
+ * calls into JavaScript.  Note that this class is not called by the SDK to
+ * record values, the native implementation does so directly.
+ */
+export class AggregatingMeter implements Meter {
+  /**
+   * @internal
+   */
+  _impl: CppAggregatingMeter
+
+  constructor() {
+    this._impl = new binding.AggregatingMeter()
+  }
+
+  /**
+   * Returns the latencies aggregated since the meter was created or last
+   * drained.
+   */
+  snapshot(): MeterSnapshot {
+    return this._impl.snapshot()
+  }
+
+  /**
+   * Returns the latencies aggregated since the meter was created or last
+   * drained, and then resets them.
+   */
+  drain(): MeterSnapshot {
+    return this._impl.drain()
+  }
+
+  /**
+   * @internal
+   */
+  valueRecorder(name: string, tags: { [key: string]: string }): ValueRecorder {
+    name
+    tags
+    throw new Error('invalid usage')
+  }
+}
@@ -43,14 +43,30 @@ export class MutationState {
       token = (token as any).token
     }
 
-    const tokenData = token.toString().split(':')
-    if (tokenData.length < 4 || tokenData[3] === '') {
-      return
+    let vbId: number
+    let vbUuid: string
+    let vbSeqNo: number
+    let bucketName: string
+    if (ArrayBuffer.isView(token)) {
+      // A packed token of [vbId, vbUuid, seqNo], whose buffer names the bucket.
+      const fields = token as any
+      vbId = Number(fields[0])
+      vbUuid = fields[1].toString()
+      vbSeqNo = Number(fields[2])
+      bucketName = (fields.buffer as any).bucketName
+      if (!bucketName) {
+        return
+      }
+    } else {
+      const tokenData = token.toString().split(':')
+      if (tokenData.length < 4 || tokenData[3] === '') {
+        return
+      }
+      vbId = parseInt(tokenData[0])
+      vbUuid = tokenData[1]
+      vbSeqNo = parseInt(tokenData[2], 10)
+      bucketName = tokenData[3]
     }
-    const vbId = parseInt(tokenData[0])
-    const vbUuid = tokenData[1]
-    const vbSeqNo = parseInt(tokenData[2], 10)
-    const bucketName = tokenData[3]
 
     if (!this._data[bucketName]) {
       this._data[bucketName] = {}
@@ -8,7 +8,7 @@ import {
   QueryResult,
   QueryWarning,
 } from './querytypes'
-import { StreamableRowPromise } from './streamablepromises'
+import { ROW_BATCH_SIZE, StreamableRowPromise } from './streamablepromises'
 import { msToGoDurationStr, goDurationStrToMs } from './utilities'
 
 /**
@@ -83,23 +83,38 @@ export class QueryExecutor {
       queryObj.query_context = options.queryContext
     }
 
+    if (options.raw) {
+      for (const i in options.raw) {
+        queryObj[i] = options.raw[i]
+      }
+    }
+
+    // Parameters are encoded on their own and handed to the binding as
+    // [name, json, ...] pairs, which it passes on without decoding them.
+    // Values JSON cannot represent (undefined, functions and symbols) are
+    // left out, as they would be if they were part of queryObj.
+    const queryParams: string[] = []
+    const addParam = (name: string, value: any) => {
+      const json = JSON.stringify(value)
+      if (json !== undefined) {
+        queryParams.push(name, json)
+      }
+    }
     if (options.parameters) {
       const params = options.parameters
       if (Array.isArray(params)) {
-        queryObj.args = params
+        if (!('args' in queryObj)) {
+          addParam('args', params)
+        }
       } else {
         Object.entries(params).forEach(([key, value]) => {
-          queryObj['$' + key] = value
+          if (!('$' + key in queryObj)) {
+            addParam('$' + key, value)
+          }
         })
       }
     }
 
-    if (options.raw) {
-      for (const i in options.raw) {
-        queryObj[i] = options.raw[i]
-      }
-    }
-
     const queryData = JSON.stringify(queryObj)
     const lcbTimeout = options.timeout ? options.timeout * 1000 : undefined
 
@@ -114,11 +129,13 @@ export class QueryExecutor {
       })
     })
 
-    this._conn.query(
+    const rowStream = this._conn.query(
       queryData,
+      queryParams,
       queryFlags,
       options.parentSpan,
       lcbTimeout,
+      ROW_BATCH_SIZE,
       (err, flags, data) => {
         if (!(flags & binding.LCBX_RESP_F_NONFINAL)) {
           if (err) {
@@ -180,10 +197,10 @@ export class QueryExecutor {
           return
         }
 
-        const row = JSON.parse(data)
-        emitter.emit('row', row)
+        return emitter._emitRows(data)
       }
     )
+    emitter._setRowStream(rowStream)
 
     return emitter
   }
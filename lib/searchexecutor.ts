@@ -9,7 +9,7 @@ import {
   SearchResult,
   SearchRow,
 } from './searchtypes'
-import { StreamableRowPromise } from './streamablepromises'
+import { ROW_BATCH_SIZE, StreamableRowPromise } from './streamablepromises'
 
 /**
  * @internal
@@ -109,11 +109,12 @@ export class SearchExecutor {
       })
     })
 
-    this._conn.searchQuery(
+    const rowStream = this._conn.searchQuery(
       queryData,
       queryFlags,
       options.parentSpan,
       lcbTimeout,
+      ROW_BATCH_SIZE,
       (err, flags, data) => {
         if (!(flags & binding.LCBX_RESP_F_NONFINAL)) {
           if (err) {
@@ -134,10 +135,10 @@ export class SearchExecutor {
           return
         }
 
-        const row = JSON.parse(data)
-        emitter.emit('row', row)
+        return emitter._emitRows(data)
       }
     )
+    emitter._setRowStream(rowStream)
 
     return emitter
   }
@@ -1,5 +1,15 @@
 /* eslint jsdoc/require-jsdoc: off */
 import EventEmitter from 'events'
+import { Readable } from 'stream'
+import { CppRowStream } from './binding'
+
+/**
+ * The number of rows the binding collects before handing them to a streaming
+ * query (N1QL, analytics or search) in one callback.
+ *
+ * @internal
+ */
+export const ROW_BATCH_SIZE = 1000
 
 /**
  * @internal
@@ -69,12 +79,27 @@ export class StreamablePromise<T> extends EventEmitter implements Promise<T> {
   }
 }
 
+/**
+ * Options for reading the rows of a query as a {@link Readable} stream.
+ */
+export interface RowStreamOptions {
+  /**
+   * The number of rows the stream buffers before reading from the server is
+   * paused.  Defaults to 1000 rows.
+   */
+  highWaterMark?: number
+}
+
 /**
  * Provides the ability to be used as both a promise, or an event emitter.  Enabling
  * an application to easily retrieve all results using async/await, while also enabling
  * streaming of results by listening for the row and meta events.
  */
 export class StreamableRowPromise<T, TRow, TMeta> extends StreamablePromise<T> {
+  private _rowStream: CppRowStream | null = null
+  private _readable: Readable | null = null
+  private _wantsPause = false
+
   constructor(fn: (rows: TRow[], meta: TMeta) => T) {
     super((emitter, resolve, reject) => {
       let err: Error | undefined
@@ -93,6 +118,100 @@ export class StreamableRowPromise<T, TRow, TMeta> extends StreamablePromise<T> {
       })
     })
   }
+
+  /**
+   * Returns the rows of this query as an object mode {@link Readable} stream.
+   * Reading from the server is paused whenever the stream holds more than
+   * `highWaterMark` rows, keeping memory bounded no matter how large the
+   * result is.  The stream emits a `meta` event before it ends.
+   *
+   * Note that rows are still emitted as `row` events, so using this stream
+   * together with the promise will still buffer the entire result.
+   *
+   * @param options Optional parameters for the stream.
+   */
+  stream(options?: RowStreamOptions): Readable {
+    if (this._readable) {
+      return this._readable
+    }
+
+    if (!options) {
+      options = {}
+    }
+
+    const readable = new Readable({
+      objectMode: true,
+      highWaterMark:
+        options.highWaterMark !== undefined
+          ? options.highWaterMark
+          : ROW_BATCH_SIZE,
+      read: () => this._resumeRows(),
+      destroy: (err, callback) => {
+        // Rows keep flowing after the stream is gone, so that the request
+        // still runs to completion rather than sitting paused until it
+        // times out.
+        this._resumeRows()
+        callback(err)
+      },
+    })
+
+    this.on('row', (row) => {
+      if (!readable.destroyed && !readable.push(row)) {
+        this._wantsPause = true
+      }
+    })
+    this.on('meta', (meta) => {
+      if (!readable.destroyed) {
+        readable.emit('meta', meta)
+      }
+    })
+    this.on('error', (err) => {
+      if (!readable.destroyed) {
+        readable.destroy(err)
+      }
+    })
+    this.on('end', () => {
+      if (!readable.destroyed) {
+        readable.push(null)
+      }
+    })
+
+    this._readable = readable
+    return readable
+  }
+
+  /**
+   * @internal
+   */
+  _setRowStream(rowStream: CppRowStream | boolean | void): void {
+    if (rowStream && typeof rowStream === 'object') {
+      this._rowStream = rowStream
+    }
+  }
+
+  /**
+   * Emits a batch of rows, returning false if the binding should stop
+   * reading further rows until the stream is read from again.
+   *
+   * @internal
+   */
+  _emitRows(rows: TRow[]): boolean {
+    for (const row of rows) {
+      this.emit('row', row)
+    }
+    return !this._wantsPause
+  }
+
+  private _resumeRows(): void {
+    if (!this._wantsPause) {
+      return
+    }
+
+    this._wantsPause = false
+    if (this._rowStream) {
+      this._rowStream.resume()
+    }
+  }
 }
 
 /**
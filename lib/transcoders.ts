@@ -1,3 +1,5 @@
+import binding from './binding'
+
 const NF_JSON = 0x00
 const NF_RAW = 0x02
 const NF_UTF8 = 0x04
@@ -109,3 +111,10 @@ export class DefaultTranscoder implements Transcoder {
     return bytes
   }
 }
+
+// The binding implements the DefaultTranscoder natively, and uses that
+// implementation for any transcoder whose encode/decode are these functions.
+binding.registerDefaultTranscoder(
+  DefaultTranscoder.prototype.encode,
+  DefaultTranscoder.prototype.decode
+)
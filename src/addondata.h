@@ -0,0 +1,106 @@
+#pragma once
+#ifndef ADDONDATA_H
+#define ADDONDATA_H
+
+#include <nan.h>
+#include <node.h>
+#include <unordered_set>
+
+namespace couchnode
+{
+
+using namespace v8;
+
+class Connection;
+
+// Property names which are set for every operation, along with the values of
+// ctxtype.  They are internalized once per isolate, see key().
+#define COUCHNODE_KEYS(X)                                                      \
+    X(analytics)                                                               \
+    X(bucket)                                                                  \
+    X(cas)                                                                     \
+    X(client_context_id)                                                       \
+    X(code)                                                                    \
+    X(collection)                                                              \
+    X(content)                                                                 \
+    X(context)                                                                 \
+    X(ctxtype)                                                                 \
+    X(decode)                                                                  \
+    X(design_document)                                                         \
+    X(encode)                                                                  \
+    X(error)                                                                   \
+    X(error_message)                                                           \
+    X(exists)                                                                  \
+    X(expiryTime)                                                              \
+    X(first_error_code)                                                        \
+    X(first_error_message)                                                     \
+    X(http_response_body)                                                      \
+    X(http_response_code)                                                      \
+    X(index)                                                                   \
+    X(index_name)                                                              \
+    X(key)                                                                     \
+    X(kv)                                                                      \
+    X(opaque)                                                                  \
+    X(parameters)                                                              \
+    X(query)                                                                   \
+    X(ref)                                                                     \
+    X(scope)                                                                   \
+    X(search)                                                                  \
+    X(statement)                                                               \
+    X(status_code)                                                             \
+    X(token)                                                                   \
+    X(value)                                                                   \
+    X(view)                                                                    \
+    X(views)
+
+enum class Key {
+#define COUCHNODE_KEY_ENUM(name) name,
+    COUCHNODE_KEYS(COUCHNODE_KEY_ENUM)
+#undef COUCHNODE_KEY_ENUM
+        Max
+};
+
+// Everything the binding keeps across calls which belongs to a specific
+// isolate.  The module can be loaded by any number of worker_threads, each
+// with its own isolate and event loop, so none of this may be process-wide.
+// Every worker runs on its own thread, which is how the instance for the
+// current isolate is found.
+struct AddonData {
+    Nan::Persistent<Function> casConstructor;
+    Nan::Persistent<Function> connectionConstructor;
+    Nan::Persistent<Function> mutationTokenConstructor;
+    Nan::Persistent<Function> rowBatcherConstructor;
+    Nan::Persistent<FunctionTemplate> aggregatingMeterTempl;
+    Nan::Persistent<FunctionTemplate> collectionRefTempl;
+    Nan::Persistent<Function> defaultEncodeFn;
+    Nan::Persistent<Function> defaultDecodeFn;
+    Nan::Persistent<Function> getResultConstructor;
+    Nan::Persistent<Function> existsResultConstructor;
+    Nan::Persistent<Function> mutationResultConstructor;
+    Nan::Persistent<Function> counterResultConstructor;
+
+    // These live as long as the isolate does, so there is nothing to reset.
+    Eternal<String> keys[static_cast<size_t>(Key::Max)];
+
+    // Connections which have not been destroyed yet, these are shut down
+    // when the environment goes away so the loop can be closed.
+    std::unordered_set<Connection *> connections;
+
+    static inline AddonData *&current()
+    {
+        static thread_local AddonData *data = nullptr;
+        return data;
+    }
+
+    static void init(Isolate *isolate);
+};
+
+static inline Local<String> key(Key k)
+{
+    return AddonData::current()->keys[static_cast<size_t>(k)].Get(
+        Isolate::GetCurrent());
+}
+
+} // namespace couchnode
+
+#endif // ADDONDATA_H
@@ -1,28 +1,90 @@
 #include <nan.h>
 #include <node.h>
 
+#include "addondata.h"
 #include "cas.h"
+#include "collectionref.h"
 #include "connection.h"
 #include "constants.h"
 #include "error.h"
+#include "kvresult.h"
+#include "metrics.h"
 #include "mutationtoken.h"
+#include "rowbatcher.h"
+#include "transcoder.h"
 
 namespace couchnode
 {
 
+static void cleanupAddonData(void *arg)
+{
+    AddonData *data = reinterpret_cast<AddonData *>(arg);
+
+    // Nothing is going to run the loop for these anymore.
+    std::unordered_set<Connection *> connections;
+    connections.swap(data->connections);
+    for (Connection *conn : connections) {
+        conn->shutdown(false);
+    }
+
+    data->casConstructor.Reset();
+    data->connectionConstructor.Reset();
+    data->mutationTokenConstructor.Reset();
+    data->rowBatcherConstructor.Reset();
+    data->aggregatingMeterTempl.Reset();
+    data->collectionRefTempl.Reset();
+    data->defaultEncodeFn.Reset();
+    data->defaultDecodeFn.Reset();
+    data->getResultConstructor.Reset();
+    data->existsResultConstructor.Reset();
+    data->mutationResultConstructor.Reset();
+    data->counterResultConstructor.Reset();
+
+    if (AddonData::current() == data) {
+        AddonData::current() = nullptr;
+    }
+    delete data;
+}
+
+void AddonData::init(Isolate *isolate)
+{
+    AddonData *data = new AddonData();
+    current() = data;
+    node::AddEnvironmentCleanupHook(isolate, &cleanupAddonData, data);
+
+    static const char *const keyNames[] = {
+#define COUCHNODE_KEY_NAME(name) #name,
+        COUCHNODE_KEYS(COUCHNODE_KEY_NAME)
+#undef COUCHNODE_KEY_NAME
+    };
+    for (size_t i = 0; i < static_cast<size_t>(Key::Max); ++i) {
+        data->keys[i].Set(isolate, String::NewFromUtf8(
+                                       isolate, keyNames[i],
+                                       NewStringType::kInternalized)
+                                       .ToLocalChecked());
+    }
+}
+
 static NAN_MODULE_INIT(init)
 {
+    AddonData::init(Isolate::GetCurrent());
+
     constants::Init(target);
 
+    AggregatingMeter::Init(target);
     Cas::Init(target);
+    CollectionRef::Init(target);
     Connection::Init(target);
     Error::Init(target);
+    KvResult::Init(target);
     MutationToken::Init(target);
+    RowBatcher::Init(target);
+    DefaultTranscoder::Init(target);
 
     Nan::Set(target, Nan::New("lcbVersion").ToLocalChecked(),
              Nan::New<String>(lcb_get_version(NULL)).ToLocalChecked());
 }
 
-NODE_MODULE(couchbase_impl, couchnode::init)
+NAN_MODULE_WORKER_ENABLED(couchbase_impl, couchnode::init)
 
 } // namespace couchnode
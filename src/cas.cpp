@@ -51,6 +51,15 @@ Local<Value> Cas::create(uint64_t cas)
     return ret;
 }
 
+Local<Value> Cas::createBigInt(uint64_t cas)
+{
+#ifdef COUCHNODE_HAS_BIGINT
+    return BigInt::NewFromUnsigned(Isolate::GetCurrent(), cas);
+#else
+    return create(cas);
+#endif
+}
+
 bool _StrToCas(Local<Value> obj, uint64_t *p)
 {
     if (sscanf(*Nan::Utf8String(
@@ -87,6 +96,12 @@ bool Cas::parse(Local<Value> obj, uint64_t *p)
     if (obj->IsNull() || obj->IsUndefined()) {
         *p = 0;
         return true;
+#ifdef COUCHNODE_HAS_BIGINT
+    } else if (obj->IsBigInt()) {
+        bool lossless = false;
+        *p = obj.As<BigInt>()->Uint64Value(&lossless);
+        return lossless;
+#endif
     } else if (obj->IsObject()) {
         return _ObjToCas(obj, p);
     } else if (obj->IsString()) {
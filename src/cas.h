@@ -2,10 +2,17 @@
 #ifndef CAS_H
 #define CAS_H
 
+#include "addondata.h"
 #include <libcouchbase/sysdefs.h>
 #include <nan.h>
 #include <node.h>
 
+// BigInt, and the typed arrays over it, are only available from V8 6.8
+// (Node.js 10.4).
+#if V8_MAJOR_VERSION > 6 || (V8_MAJOR_VERSION == 6 && V8_MINOR_VERSION >= 8)
+#define COUCHNODE_HAS_BIGINT 1
+#endif
+
 namespace couchnode
 {
 
@@ -18,12 +25,15 @@ public:
 
     static v8::Local<v8::Value> create(uint64_t);
 
+    // Returns the CAS as a BigInt rather than a CbCas, which costs a single
+    // heap object instead of the CbCas and the Buffer holding its value.
+    static v8::Local<v8::Value> createBigInt(uint64_t);
+
     static bool parse(Local<Value>, uint64_t *);
 
     static inline Nan::Persistent<Function> &constructor()
     {
-        static Nan::Persistent<Function> class_constructor;
-        return class_constructor;
+        return AddonData::current()->casConstructor;
     }
 
 private:
@@ -0,0 +1,354 @@
+#include "casloop.h"
+
+#include "collectionref.h"
+#include "error.h"
+#include "respreader.h"
+#include <algorithm>
+#include <random>
+
+namespace couchnode
+{
+
+typedef RespReader<lcb_RESPSUBDOC, &lcb_respsubdoc_cookie> SubdocRespReader;
+
+// Full jitter: anywhere between no delay and an exponentially growing cap,
+// so that the clients which collided do not all come back at once.
+static uint64_t jitteredBackoff(uint32_t attempt)
+{
+    static thread_local std::minstd_rand rng(std::random_device{}());
+
+    uint32_t cap = CasLoop::BaseBackoffMs << std::min<uint32_t>(attempt, 16);
+    cap = std::min<uint32_t>(cap, CasLoop::MaxBackoffMs);
+    return std::uniform_int_distribution<uint32_t>(0, cap)(rng);
+}
+
+CasLoop::CasLoop(Connection *impl, Kind kind)
+    : Nan::AsyncResource("couchbase::casloop")
+    , _impl(impl)
+    , _kind(kind)
+    , _parentSpan(nullptr)
+    , _hasDeadline(false)
+    , _deadlineMs(0)
+    , _timer(nullptr)
+    , _attempt(0)
+    , _cas(0)
+{
+    _implRef.Reset(_impl->persistent());
+    _step._casLoop = this;
+}
+
+CasLoop::~CasLoop()
+{
+    _callback.Reset();
+    _implRef.Reset();
+    _item.Reset();
+    _value.Reset();
+
+    if (_parentSpan) {
+        delete _parentSpan;
+        _parentSpan = nullptr;
+    }
+
+    if (_timer) {
+        uv_timer_stop(_timer);
+        uv_close(reinterpret_cast<uv_handle_t *>(_timer),
+                 [](uv_handle_t *handle) {
+                     delete reinterpret_cast<uv_timer_t *>(handle);
+                 });
+        _timer = nullptr;
+    }
+}
+
+bool CasLoop::parseCollection(Local<Value> scope, Local<Value> collection)
+{
+    CollectionRef *ref = CollectionRef::unwrap(scope);
+    if (ref) {
+        _scope = ref->scopeName();
+        _collection = ref->collectionName();
+        return true;
+    }
+
+    ValueParser parser(_impl->scratch());
+    const char *bytes;
+    size_t nbytes;
+    if (!parser.parseString(&bytes, &nbytes, scope)) {
+        return false;
+    }
+    _scope.assign(bytes ? bytes : "", nbytes);
+    if (!parser.parseString(&bytes, &nbytes, collection)) {
+        return false;
+    }
+    _collection.assign(bytes ? bytes : "", nbytes);
+    return true;
+}
+
+bool CasLoop::parseKey(Local<Value> key)
+{
+    ValueParser parser(_impl->scratch());
+    const char *bytes;
+    size_t nbytes;
+    if (!parser.parseString(&bytes, &nbytes, key) || nbytes == 0) {
+        return false;
+    }
+    _key.assign(bytes, nbytes);
+    return true;
+}
+
+bool CasLoop::parseItem(Local<Value> item)
+{
+    _item.Reset(item);
+    return true;
+}
+
+bool CasLoop::parseTimeout(Local<Value> timeout)
+{
+    if (timeout.IsEmpty() || timeout->IsUndefined()) {
+        return true;
+    }
+
+    uint32_t timeoutUs;
+    if (!ValueParser::parseUint(&timeoutUs, timeout)) {
+        return false;
+    }
+
+    // Applies to the loop as a whole, each step gets what remains of it.
+    _hasDeadline = true;
+    _deadlineMs =
+        uv_now(Nan::GetCurrentEventLoop()) + (timeoutUs + 999) / 1000;
+    return true;
+}
+
+bool CasLoop::parseParentSpan(Local<Value> parentSpan)
+{
+    if (!parentSpan.IsEmpty() && parentSpan->IsObject()) {
+        _parentSpan = new WrappedRequestSpan(_impl, parentSpan.As<Object>());
+    }
+
+    TraceSpan parent;
+    if (_parentSpan && *_parentSpan) {
+        parent = TraceSpan::wrap(_parentSpan->span());
+    }
+
+    const char *opName = _kind == QueuePop ? "queue_pop" : "set_remove";
+    _traceSpan = TraceSpan::beginOpTrace(_impl, LCBTRACE_SERVICE_KV, opName,
+                                         parent);
+    return true;
+}
+
+bool CasLoop::parseCallback(Local<Value> callback)
+{
+    Nan::MaybeLocal<Function> callbackFnM = Nan::To<Function>(callback);
+    if (callbackFnM.IsEmpty()) {
+        return false;
+    }
+
+    _callback.Reset(callbackFnM.ToLocalChecked());
+    return true;
+}
+
+lcb_STATUS CasLoop::start()
+{
+    return scheduleLookup();
+}
+
+lcb_STATUS CasLoop::prepareCmd(lcb_CMDSUBDOC *cmd)
+{
+    lcb_cmdsubdoc_collection(cmd, _scope.data(), _scope.size(),
+                             _collection.data(), _collection.size());
+    lcb_cmdsubdoc_key(cmd, _key.data(), _key.size());
+
+    if (_hasDeadline) {
+        uint64_t now = uv_now(Nan::GetCurrentEventLoop());
+        if (now >= _deadlineMs) {
+            return LCB_ERR_TIMEOUT;
+        }
+        lcb_cmdsubdoc_timeout(
+            cmd, static_cast<uint32_t>((_deadlineMs - now) * 1000));
+    }
+
+    if (_traceSpan) {
+        return lcbx_cmd_parent_span(cmd, _traceSpan.span());
+    }
+    return LCB_SUCCESS;
+}
+
+lcb_STATUS CasLoop::scheduleLookup()
+{
+    // The connection may have been shut down during a backoff.
+    lcb_INSTANCE *instance = _impl->lcbHandle();
+    if (!instance) {
+        return LCB_ERR_REQUEST_CANCELED;
+    }
+
+    lcb_CMDSUBDOC *cmd;
+    lcb_cmdsubdoc_create(&cmd);
+
+    lcb_STATUS err = prepareCmd(cmd);
+    if (err == LCB_SUCCESS) {
+        lcb_SUBDOCSPECS *specs;
+        lcb_subdocspecs_create(&specs, 1);
+        if (_kind == QueuePop) {
+            lcb_subdocspecs_get(specs, 0, 0, "[-1]", 4);
+        } else {
+            // The whole document, the item is searched for in here.
+            lcb_subdocspecs_get(specs, 0, 0, nullptr, 0);
+        }
+        lcb_cmdsubdoc_specs(cmd, specs);
+
+        err = lcb_subdoc(instance, &_step, cmd);
+        lcb_subdocspecs_destroy(specs);
+    }
+
+    lcb_cmdsubdoc_destroy(cmd);
+    return err;
+}
+
+lcb_STATUS CasLoop::scheduleMutate()
+{
+    lcb_INSTANCE *instance = _impl->lcbHandle();
+    if (!instance) {
+        return LCB_ERR_REQUEST_CANCELED;
+    }
+
+    lcb_CMDSUBDOC *cmd;
+    lcb_cmdsubdoc_create(&cmd);
+
+    lcb_STATUS err = prepareCmd(cmd);
+    if (err == LCB_SUCCESS) {
+        lcb_cmdsubdoc_cas(cmd, _cas);
+
+        lcb_SUBDOCSPECS *specs;
+        lcb_subdocspecs_create(&specs, 1);
+        lcb_subdocspecs_remove(specs, 0, 0, _removePath.data(),
+                               _removePath.size());
+        lcb_cmdsubdoc_specs(cmd, specs);
+
+        err = lcb_subdoc(instance, &_step, cmd);
+        lcb_subdocspecs_destroy(specs);
+    }
+
+    lcb_cmdsubdoc_destroy(cmd);
+    return err;
+}
+
+void CasLoop::onLookup(lcb_INSTANCE *instance, const lcb_RESPSUBDOC *resp)
+{
+    SubdocRespReader rdr(instance, resp);
+
+    lcb_STATUS rc = rdr.getValue<&lcb_respsubdoc_status>();
+    if (rc == LCB_SUCCESS) {
+        rc = rdr.getValue<&lcb_respsubdoc_result_status>(0);
+    }
+    if (rc != LCB_SUCCESS) {
+        finish(rdr.decodeError<lcb_respsubdoc_error_context>(rc),
+               Nan::Undefined());
+        return;
+    }
+
+    lcb_respsubdoc_cas(resp, &_cas);
+    Local<Value> valueVal =
+        rdr.parseJsonValue<&lcb_respsubdoc_result_value>(0);
+
+    if (_kind == QueuePop) {
+        _value.Reset(valueVal);
+        _removePath = "[-1]";
+    } else {
+        if (!valueVal->IsArray()) {
+            finish(Error::create(LCB_ERR_SUBDOC_PATH_MISMATCH),
+                   Nan::Undefined());
+            return;
+        }
+
+        Local<Array> values = valueVal.As<Array>();
+        Local<Value> itemVal = Nan::New(_item);
+        uint32_t numValues = values->Length();
+        uint32_t index = 0;
+        while (index < numValues &&
+               !Nan::Get(values, index).ToLocalChecked()->StrictEquals(
+                   itemVal)) {
+            ++index;
+        }
+
+        if (index == numValues) {
+            finish(Nan::Null(), Nan::False());
+            return;
+        }
+        _removePath = "[" + std::to_string(index) + "]";
+    }
+
+    lcb_STATUS err = scheduleMutate();
+    if (err != LCB_SUCCESS) {
+        finish(Error::create(err), Nan::Undefined());
+    }
+}
+
+void CasLoop::onMutate(lcb_INSTANCE *instance, const lcb_RESPSUBDOC *resp)
+{
+    SubdocRespReader rdr(instance, resp);
+
+    lcb_STATUS rc = rdr.getValue<&lcb_respsubdoc_status>();
+    if (rc != LCB_SUCCESS &&
+        rdr.getValue<&lcb_respsubdoc_result_size>() > 0) {
+        // Failures of the spec itself are more specific.
+        lcb_STATUS itemstatus = rdr.getValue<&lcb_respsubdoc_result_status>(0);
+        if (itemstatus != LCB_SUCCESS) {
+            rc = itemstatus;
+        }
+    }
+
+    if (rc == LCB_ERR_CAS_MISMATCH) {
+        retry(rdr.decodeError<lcb_respsubdoc_error_context>(rc));
+        return;
+    }
+    if (rc != LCB_SUCCESS) {
+        finish(rdr.decodeError<lcb_respsubdoc_error_context>(rc),
+               Nan::Undefined());
+        return;
+    }
+
+    if (_kind == QueuePop) {
+        finish(Nan::Null(), Nan::New(_value));
+    } else {
+        finish(Nan::Null(), Nan::True());
+    }
+}
+
+void CasLoop::retry(Local<Value> errVal)
+{
+    if (++_attempt >= MaxAttempts) {
+        finish(errVal, Nan::Undefined());
+        return;
+    }
+
+    _value.Reset();
+
+    if (!_timer) {
+        _timer = new uv_timer_t();
+        uv_timer_init(Nan::GetCurrentEventLoop(), _timer);
+        _timer->data = this;
+    }
+    uv_timer_start(_timer, &onTimer, jitteredBackoff(_attempt), 0);
+}
+
+void CasLoop::onTimer(uv_timer_t *timer)
+{
+    CasLoop *me = reinterpret_cast<CasLoop *>(timer->data);
+    Nan::HandleScope scope;
+
+    lcb_STATUS err = me->scheduleLookup();
+    if (err != LCB_SUCCESS) {
+        me->finish(Error::create(err), Nan::Undefined());
+    }
+}
+
+void CasLoop::finish(Local<Value> errVal, Local<Value> resVal)
+{
+    _traceSpan.end();
+
+    Local<Value> args[] = {errVal, resVal};
+    _callback.Call(2, args, this);
+
+    delete this;
+}
+
+} // namespace couchnode
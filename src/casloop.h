@@ -0,0 +1,91 @@
+#pragma once
+#ifndef CASLOOP_H
+#define CASLOOP_H
+
+#include "opbuilder.h"
+#include <libcouchbase/couchbase.h>
+#include <nan.h>
+#include <node.h>
+#include <string>
+#include <uv.h>
+
+namespace couchnode
+{
+
+using namespace v8;
+
+// Runs a read-modify-write of a single document without going back to JS in
+// between.  A lookupIn reads the current state, which decides the mutation
+// to apply, and the mutateIn is made conditional on the CAS which was read.
+// When another writer gets in between, the loop waits for a jittered,
+// exponentially growing delay and starts over, up to MaxAttempts times.
+// Only the final result is reported to the callback, as (err, result).
+class CasLoop : public Nan::AsyncResource
+{
+public:
+    enum Kind {
+        // Removes the last element of an array, the result is the element.
+        QueuePop,
+        // Removes the first element of an array which is strictly equal to
+        // the item, the result is whether there was one.
+        SetRemove,
+    };
+
+    enum {
+        MaxAttempts = 16,
+        BaseBackoffMs = 1,
+        MaxBackoffMs = 64,
+    };
+
+    CasLoop(Connection *impl, Kind kind);
+    ~CasLoop();
+
+    bool parseCollection(Local<Value> scope, Local<Value> collection);
+    bool parseKey(Local<Value> key);
+    bool parseItem(Local<Value> item);
+    bool parseTimeout(Local<Value> timeout);
+    bool parseParentSpan(Local<Value> parentSpan);
+    bool parseCallback(Local<Value> callback);
+
+    // Schedules the first lookup.  The loop deletes itself once it has
+    // invoked the callback, but if this fails it is left to the caller.
+    lcb_STATUS start();
+
+    void onLookup(lcb_INSTANCE *instance, const lcb_RESPSUBDOC *resp);
+    void onMutate(lcb_INSTANCE *instance, const lcb_RESPSUBDOC *resp);
+
+private:
+    lcb_STATUS scheduleLookup();
+    lcb_STATUS scheduleMutate();
+    lcb_STATUS prepareCmd(lcb_CMDSUBDOC *cmd);
+    void retry(Local<Value> errVal);
+    void finish(Local<Value> errVal, Local<Value> resVal);
+
+    static void onTimer(uv_timer_t *timer);
+
+    Connection *_impl;
+    Kind _kind;
+    Nan::Callback _callback;
+    Nan::Persistent<Object> _implRef;
+    Nan::Persistent<Value> _item;
+    Nan::Persistent<Value> _value;
+    WrappedRequestSpan *_parentSpan;
+    TraceSpan _traceSpan;
+
+    std::string _scope;
+    std::string _collection;
+    std::string _key;
+    bool _hasDeadline;
+    uint64_t _deadlineMs;
+
+    // The cookie handed to libcouchbase for each lookup and mutation.
+    OpCookieBase _step;
+    uv_timer_t *_timer;
+    uint32_t _attempt;
+    uint64_t _cas;
+    std::string _removePath;
+};
+
+} // namespace couchnode
+
+#endif // CASLOOP_H
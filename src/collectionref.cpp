@@ -0,0 +1,86 @@
+#include "collectionref.h"
+
+#include "error.h"
+
+namespace couchnode
+{
+
+NAN_MODULE_INIT(CollectionRef::Init)
+{
+    Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(fnNew);
+    tpl->SetClassName(Nan::New<String>("CbCollectionRef").ToLocalChecked());
+    tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+    templ().Reset(tpl);
+
+    Nan::Set(target, Nan::New("CollectionRef").ToLocalChecked(),
+             Nan::GetFunction(tpl).ToLocalChecked());
+}
+
+CollectionRef *CollectionRef::unwrap(Local<Value> val)
+{
+    if (!val->IsObject() || !Nan::New(templ())->HasInstance(val)) {
+        return nullptr;
+    }
+    return ObjectWrap::Unwrap<CollectionRef>(val.As<Object>());
+}
+
+CollectionRef::CollectionRef(std::string scope, std::string collection)
+    : _scope(std::move(scope))
+    , _collection(std::move(collection))
+    , _instance(nullptr)
+    , _generation(0)
+    , _cid(0)
+{
+}
+
+bool CollectionRef::collectionId(lcb_INSTANCE *instance, uint32_t *cid)
+{
+    if (_instance == instance) {
+        uint64_t generation;
+        lcb_collection_cache_generation(instance, &generation);
+        if (generation == _generation) {
+            *cid = _cid;
+            return true;
+        }
+    }
+
+    _instance = nullptr;
+    if (lcb_collection_id_cached(instance, _scope.data(), _scope.size(),
+                                 _collection.data(), _collection.size(), &_cid,
+                                 &_generation) != LCB_SUCCESS) {
+        return false;
+    }
+    _instance = instance;
+    *cid = _cid;
+    return true;
+}
+
+NAN_METHOD(CollectionRef::fnNew)
+{
+    Nan::HandleScope scope;
+
+    if (info.Length() != 2) {
+        return Nan::ThrowError(Error::create("expected 2 parameters"));
+    }
+
+    std::string names[2];
+    for (int i = 0; i < 2; ++i) {
+        if (info[i]->IsUndefined() || info[i]->IsNull()) {
+            continue;
+        }
+        if (!info[i]->IsString()) {
+            return Nan::ThrowError(
+                Error::create("must pass string for scope/collection"));
+        }
+        Nan::Utf8String name(info[i]);
+        names[i].assign(*name, name.length());
+    }
+
+    CollectionRef *obj = new CollectionRef(names[0], names[1]);
+    obj->Wrap(info.This());
+
+    info.GetReturnValue().Set(info.This());
+}
+
+} // namespace couchnode
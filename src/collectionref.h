@@ -0,0 +1,61 @@
+#pragma once
+#ifndef COLLECTIONREF_H
+#define COLLECTIONREF_H
+
+#include "addondata.h"
+#include <libcouchbase/couchbase.h>
+#include <nan.h>
+#include <node.h>
+#include <string>
+
+namespace couchnode
+{
+
+using namespace v8;
+
+// The scope and collection names of a Collection, kept by it for the
+// lifetime of the Collection so that operations neither convert the names
+// again nor look up the collection ID once it is known.  The ID is only
+// reused while the collection cache of the lcb instance which resolved it
+// keeps the same generation.
+class CollectionRef : public Nan::ObjectWrap
+{
+public:
+    static NAN_MODULE_INIT(Init);
+
+    static inline Nan::Persistent<FunctionTemplate> &templ()
+    {
+        return AddonData::current()->collectionRefTempl;
+    }
+
+    static CollectionRef *unwrap(Local<Value> val);
+
+    const std::string &scopeName() const
+    {
+        return _scope;
+    }
+
+    const std::string &collectionName() const
+    {
+        return _collection;
+    }
+
+    // Returns false if the ID is not known to the instance yet, in which
+    // case lcb resolves it for the operation.
+    bool collectionId(lcb_INSTANCE *instance, uint32_t *cid);
+
+private:
+    CollectionRef(std::string scope, std::string collection);
+
+    static NAN_METHOD(fnNew);
+
+    std::string _scope;
+    std::string _collection;
+    lcb_INSTANCE *_instance;
+    uint64_t _generation;
+    uint32_t _cid;
+};
+
+} // namespace couchnode
+
+#endif // COLLECTIONREF_H
@@ -14,24 +14,28 @@ Connection::Connection(lcb_INSTANCE *instance, Logger *logger)
     , _clientStringCache(nullptr)
     , _bootstrapCookie(nullptr)
     , _openCookie(nullptr)
+    , _compactResults(false)
+    , _latencyMeter(nullptr)
+    , _hedgePercentile(-1)
+    , _hedgeDelayUs(0)
+    , _hedgeDelayAt(0)
 {
     _flushWatch = new uv_prepare_t();
-    uv_prepare_init(uv_default_loop(), _flushWatch);
+    uv_prepare_init(Nan::GetCurrentEventLoop(), _flushWatch);
     _flushWatch->data = this;
+
+    AddonData::current()->connections.insert(this);
 }
 
 Connection::~Connection()
 {
-    if (_flushWatch) {
-        uv_prepare_stop(_flushWatch);
-        uv_close(reinterpret_cast<uv_handle_t *>(_flushWatch),
-                 [](uv_handle_t *handle) { delete handle; });
-        _flushWatch = nullptr;
-    }
-    if (_instance) {
-        lcb_destroy(_instance);
-        _instance = nullptr;
+    if (AddonData::current()) {
+        AddonData::current()->connections.erase(this);
     }
+
+    shutdown(false);
+    _meter.Reset();
+    _tokenSlab.reset();
     if (_logger) {
         delete _logger;
         _logger = nullptr;
@@ -96,16 +100,22 @@ NAN_MODULE_INIT(Connection::Init)
     Nan::SetPrototypeMethod(tpl, "selectBucket", fnSelectBucket);
     Nan::SetPrototypeMethod(tpl, "shutdown", fnShutdown);
     Nan::SetPrototypeMethod(tpl, "cntl", fnCntl);
+    Nan::SetPrototypeMethod(tpl, "poolStats", fnPoolStats);
+    Nan::SetPrototypeMethod(tpl, "queryCacheStats", fnQueryCacheStats);
     Nan::SetPrototypeMethod(tpl, "get", fnGet);
     Nan::SetPrototypeMethod(tpl, "exists", fnExists);
     Nan::SetPrototypeMethod(tpl, "getReplica", fnGetReplica);
     Nan::SetPrototypeMethod(tpl, "store", fnStore);
+    Nan::SetPrototypeMethod(tpl, "getMulti", fnGetMulti);
+    Nan::SetPrototypeMethod(tpl, "storeMulti", fnStoreMulti);
     Nan::SetPrototypeMethod(tpl, "remove", fnRemove);
     Nan::SetPrototypeMethod(tpl, "touch", fnTouch);
     Nan::SetPrototypeMethod(tpl, "unlock", fnUnlock);
     Nan::SetPrototypeMethod(tpl, "counter", fnCounter);
     Nan::SetPrototypeMethod(tpl, "lookupIn", fnLookupIn);
     Nan::SetPrototypeMethod(tpl, "mutateIn", fnMutateIn);
+    Nan::SetPrototypeMethod(tpl, "queuePop", fnQueuePop);
+    Nan::SetPrototypeMethod(tpl, "setRemove", fnSetRemove);
     Nan::SetPrototypeMethod(tpl, "viewQuery", fnViewQuery);
     Nan::SetPrototypeMethod(tpl, "query", fnQuery);
     Nan::SetPrototypeMethod(tpl, "analyticsQuery", fnAnalyticsQuery);
@@ -124,8 +134,8 @@ NAN_METHOD(Connection::fnNew)
 {
     Nan::HandleScope scope;
 
-    if (info.Length() != 7) {
-        return Nan::ThrowError(Error::create("expected 7 parameters"));
+    if (info.Length() != 8) {
+        return Nan::ThrowError(Error::create("expected 8 parameters"));
     }
 
     lcb_STATUS err;
@@ -134,7 +144,7 @@ NAN_METHOD(Connection::fnNew)
     lcbuv_options_t iopsOptions;
 
     iopsOptions.version = 0;
-    iopsOptions.v.v0.loop = uv_default_loop();
+    iopsOptions.v.v0.loop = Nan::GetCurrentEventLoop();
     iopsOptions.v.v0.startsop_noop = 1;
 
     err = lcb_create_libuv_io_opts(0, &iops, &iopsOptions);
@@ -226,18 +236,38 @@ NAN_METHOD(Connection::fnNew)
     }
 
     Meter *meter = nullptr;
+    AggregatingMeter *aggMeter = nullptr;
     if (!info[6]->IsUndefined() && !info[6]->IsNull()) {
         if (!info[6]->IsObject()) {
             return Nan::ThrowError(Error::create("must pass object for meter"));
         }
 
         Local<Object> meterVal = info[6].As<Object>();
-        if (!meterVal.IsEmpty()) {
+        aggMeter = AggregatingMeter::unwrap(meterVal);
+        if (aggMeter) {
+            lcb_createopts_meter(createOpts, aggMeter->lcbProcs());
+        } else if (!meterVal.IsEmpty()) {
             meter = new Meter(meterVal);
             lcb_createopts_meter(createOpts, meter->lcbProcs());
         }
     }
 
+    bool compactResults = false;
+    if (!info[7]->IsUndefined() && !info[7]->IsNull()) {
+        if (!info[7]->IsBoolean()) {
+            return Nan::ThrowError(
+                Error::create("must pass boolean for compactResults"));
+        }
+
+        compactResults = Nan::To<bool>(info[7]).ToChecked();
+#ifndef COUCHNODE_HAS_BIGINT
+        if (compactResults) {
+            return Nan::ThrowError(
+                Error::create("compactResults requires BigInt support"));
+        }
+#endif
+    }
+
     lcb_createopts_io(createOpts, iops);
 
     lcb_INSTANCE *instance;
@@ -271,6 +301,13 @@ NAN_METHOD(Connection::fnNew)
 
     Connection *obj = new Connection(instance, logger);
     obj->Wrap(info.This());
+    obj->_compactResults = compactResults;
+
+    if (aggMeter) {
+        // The meter is shared, it must outlive the lcb instance using it.
+        obj->_meter.Reset(info[6].As<Object>());
+        obj->_latencyMeter = aggMeter->lcbProcs();
+    }
 
     lcb_set_cookie(instance, reinterpret_cast<void *>(obj));
     lcb_set_bootstrap_callback(instance, &lcbBootstapHandler);
@@ -318,10 +355,58 @@ NAN_METHOD(Connection::fnNew)
     info.GetReturnValue().Set(info.This());
 }
 
+void Connection::shutdown(bool async)
+{
+    // This is the last chance to close the watcher when the environment is
+    // torn down (the destructor is not run then), and the loop of a worker
+    // must not have any handles left open once it exits.
+    if (_flushWatch) {
+        uv_prepare_stop(_flushWatch);
+        uv_close(reinterpret_cast<uv_handle_t *>(_flushWatch),
+                 [](uv_handle_t *handle) {
+                     delete reinterpret_cast<uv_prepare_t *>(handle);
+                 });
+        _flushWatch = nullptr;
+    }
+
+    if (_instance) {
+        if (async) {
+            lcb_destroy_async(_instance, NULL);
+        } else {
+            lcb_destroy(_instance);
+        }
+        _instance = nullptr;
+    }
+}
+
+uint64_t Connection::hedgeDelay(double percentile)
+{
+    static const uint64_t refreshIntervalMs = 1000;
+
+    if (!_latencyMeter) {
+        return 0;
+    }
+
+    uint64_t now = uv_now(Nan::GetCurrentEventLoop());
+    if (percentile != _hedgePercentile ||
+        now - _hedgeDelayAt >= refreshIntervalMs) {
+        // Latencies are recorded in nanoseconds.
+        uint64_t delayNs = 0;
+        lcbmetrics_meter_percentile(_latencyMeter, "kv", "get", percentile,
+                                    &delayNs);
+        _hedgeDelayUs = delayNs / 1000;
+        _hedgePercentile = percentile;
+        _hedgeDelayAt = now;
+    }
+    return _hedgeDelayUs;
+}
+
 void Connection::uvFlushHandler(uv_prepare_t *handle)
 {
     Connection *me = reinterpret_cast<Connection *>(handle->data);
-    lcb_sched_flush(me->_instance);
+    if (me->_instance) {
+        lcb_sched_flush(me->_instance);
+    }
 }
 
 void Connection::lcbBootstapHandler(lcb_INSTANCE *instance, lcb_STATUS err)
@@ -333,7 +418,9 @@ void Connection::lcbBootstapHandler(lcb_INSTANCE *instance, lcb_STATUS err)
         lcb_destroy_async(instance, NULL);
         me->_instance = nullptr;
     } else {
-        uv_prepare_start(me->_flushWatch, &uvFlushHandler);
+        if (me->_flushWatch) {
+            uv_prepare_start(me->_flushWatch, &uvFlushHandler);
+        }
 
         int flushMode = 0;
         lcb_cntl(instance, LCB_CNTL_SET, LCB_CNTL_SCHED_IMPLICIT_FLUSH,
@@ -424,12 +511,7 @@ NAN_METHOD(Connection::fnShutdown)
     Connection *me = ObjectWrap::Unwrap<Connection>(info.This());
     Nan::HandleScope scope;
 
-    uv_prepare_stop(me->_flushWatch);
-
-    if (me->_instance) {
-        lcb_destroy_async(me->_instance, NULL);
-        me->_instance = nullptr;
-    }
+    me->shutdown();
 
     info.GetReturnValue().Set(true);
 }
@@ -492,4 +574,44 @@ NAN_METHOD(Connection::fnCntl)
     Nan::ThrowError(Error::create("unexpected cntl cmd"));
 }
 
+NAN_METHOD(Connection::fnPoolStats)
+{
+    Connection *me = ObjectWrap::Unwrap<Connection>(info.This());
+    Nan::HandleScope scope;
+
+    Local<Object> res = Nan::New<Object>();
+    Nan::Set(res, Nan::New("cookieAllocs").ToLocalChecked(),
+             Nan::New<Number>(
+                 static_cast<double>(me->_cookiePool.numAllocs())));
+    Nan::Set(res, Nan::New("scratchAllocs").ToLocalChecked(),
+             Nan::New<Number>(static_cast<double>(me->_scratch.numAllocs())));
+    info.GetReturnValue().Set(res);
+}
+
+NAN_METHOD(Connection::fnQueryCacheStats)
+{
+    Connection *me = ObjectWrap::Unwrap<Connection>(info.This());
+    Nan::HandleScope scope;
+
+    lcb_QUERY_CACHE_STATS stats;
+    lcb_STATUS err = lcb_cntl(me->_instance, LCB_CNTL_GET,
+                              LCB_CNTL_QUERY_CACHE_STATS, &stats);
+    if (err != LCB_SUCCESS) {
+        return Nan::ThrowError(Error::create(err));
+    }
+
+    Local<Object> res = Nan::New<Object>();
+    Nan::Set(res, Nan::New("hits").ToLocalChecked(),
+             Nan::New<Number>(static_cast<double>(stats.hits)));
+    Nan::Set(res, Nan::New("misses").ToLocalChecked(),
+             Nan::New<Number>(static_cast<double>(stats.misses)));
+    Nan::Set(res, Nan::New("evictions").ToLocalChecked(),
+             Nan::New<Number>(static_cast<double>(stats.evictions)));
+    Nan::Set(res, Nan::New("size").ToLocalChecked(),
+             Nan::New<Number>(stats.size));
+    Nan::Set(res, Nan::New("capacity").ToLocalChecked(),
+             Nan::New<Number>(stats.capacity));
+    info.GetReturnValue().Set(res);
+}
+
 } // namespace couchnode
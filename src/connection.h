@@ -2,8 +2,11 @@
 #ifndef CONNECTION_H
 #define CONNECTION_H
 
+#include "addondata.h"
 #include "cookie.h"
 #include "logger.h"
+#include "mutationtoken.h"
+#include "pool.h"
 #include "valueparser.h"
 
 #include <libcouchbase/couchbase.h>
@@ -16,6 +19,8 @@ namespace couchnode
 
 using namespace v8;
 
+class OpCookie;
+
 class Connection : public Nan::ObjectWrap
 {
 public:
@@ -23,8 +28,7 @@ public:
 
     static inline Nan::Persistent<Function> &constructor()
     {
-        static Nan::Persistent<Function> class_constructor;
-        return class_constructor;
+        return AddonData::current()->connectionConstructor;
     }
 
     lcb_INSTANCE *lcbHandle() const
@@ -35,6 +39,42 @@ public:
     const char *bucketName();
     const char *clientString();
 
+    // Stops flushing and destroys the lcb instance, any operations which are
+    // still pending are failed.  Unless async, this happens before returning,
+    // for when the event loop will not be run again.
+    void shutdown(bool async = true);
+
+    // Per-operation allocations are recycled through these, rather than
+    // going through the heap for every operation.
+    ObjectPool<OpCookie> &cookiePool()
+    {
+        return _cookiePool;
+    }
+
+    ScratchArena &scratch()
+    {
+        return _scratch;
+    }
+
+    // Whether results carry their CAS as a BigInt and their mutation token
+    // packed into the tokenSlab, instead of as CbCas/CbMutationToken objects.
+    bool compactResults() const
+    {
+        return _compactResults;
+    }
+
+    MutationTokenSlab &tokenSlab()
+    {
+        return _tokenSlab;
+    }
+
+    // How long a hedged get waits for the active node before also reading
+    // from a replica: the given percentile of the latencies of recent gets,
+    // in microseconds.  This is zero when the connection has no aggregating
+    // meter, or nothing has been recorded yet.  Reading a percentile walks
+    // the whole histogram, so the value is only refreshed periodically.
+    uint64_t hedgeDelay(double percentile);
+
     static inline Connection *fromInstance(lcb_INSTANCE *instance)
     {
         void *cookie = const_cast<void *>(lcb_get_cookie(instance));
@@ -52,17 +92,23 @@ private:
     static NAN_METHOD(fnSelectBucket);
     static NAN_METHOD(fnShutdown);
     static NAN_METHOD(fnCntl);
+    static NAN_METHOD(fnPoolStats);
+    static NAN_METHOD(fnQueryCacheStats);
 
     static NAN_METHOD(fnGet);
     static NAN_METHOD(fnExists);
     static NAN_METHOD(fnGetReplica);
     static NAN_METHOD(fnStore);
+    static NAN_METHOD(fnGetMulti);
+    static NAN_METHOD(fnStoreMulti);
     static NAN_METHOD(fnRemove);
     static NAN_METHOD(fnTouch);
     static NAN_METHOD(fnUnlock);
     static NAN_METHOD(fnCounter);
     static NAN_METHOD(fnLookupIn);
     static NAN_METHOD(fnMutateIn);
+    static NAN_METHOD(fnQueuePop);
+    static NAN_METHOD(fnSetRemove);
     static NAN_METHOD(fnViewQuery);
     static NAN_METHOD(fnQuery);
     static NAN_METHOD(fnSearchQuery);
@@ -117,6 +163,18 @@ private:
 
     Cookie *_bootstrapCookie;
     Cookie *_openCookie;
+    Nan::Persistent<Object> _meter;
+
+    ObjectPool<OpCookie> _cookiePool;
+    ScratchArena _scratch;
+
+    bool _compactResults;
+    MutationTokenSlab _tokenSlab;
+
+    const lcbmetrics_METER *_latencyMeter;
+    double _hedgePercentile;
+    uint64_t _hedgeDelayUs;
+    uint64_t _hedgeDelayAt;
 };
 
 } // namespace couchnode
@@ -1,7 +1,10 @@
 #include "connection.h"
 
 #include "cas.h"
+#include "casloop.h"
 #include "error.h"
+#include "hedgedread.h"
+#include "kvresult.h"
 #include "mutationtoken.h"
 #include "respreader.h"
 
@@ -14,6 +17,11 @@ void Connection::lcbGetRespHandler(lcb_INSTANCE *instance, int cbtype,
     Nan::HandleScope scope;
     RespReader<lcb_RESPGET, &lcb_respget_cookie> rdr(instance, resp);
 
+    if (HedgedRead *hedge = rdr.hedgedRead()) {
+        hedge->onActive(instance, resp);
+        return;
+    }
+
     lcb_STATUS rc = rdr.getValue<&lcb_respget_status>();
     Local<Value> errVal = rdr.decodeError<lcb_respget_error_context>(rc);
 
@@ -24,7 +32,8 @@ void Connection::lcbGetRespHandler(lcb_INSTANCE *instance, int cbtype,
         {
             Nan::TryCatch tryCatch;
             valueVal =
-                rdr.parseDocValue<&lcb_respget_value, lcb_respget_flags>();
+                rdr.parseDocValue<&lcb_respget_value, &lcb_respget_flags,
+                                  &lcb_respget_backbuf>();
             if (tryCatch.HasCaught()) {
                 errVal = tryCatch.Exception();
             }
@@ -34,7 +43,18 @@ void Connection::lcbGetRespHandler(lcb_INSTANCE *instance, int cbtype,
         valueVal = Nan::Null();
     }
 
-    rdr.invokeCallback(errVal, casVal, valueVal);
+    // Batches keep one column per field, see BatchCookie.
+    if (rdr.batch()) {
+        rdr.invokeCallback(errVal, casVal, valueVal);
+        return;
+    }
+
+    Local<Value> resVal = Nan::Null();
+    if (rc == LCB_SUCCESS) {
+        resVal = KvResult::createGet(casVal, valueVal);
+    }
+
+    rdr.invokeCallback(errVal, resVal);
 }
 
 void Connection::lcbExistsRespHandler(lcb_INSTANCE *instance, int cbtype,
@@ -47,21 +67,21 @@ void Connection::lcbExistsRespHandler(lcb_INSTANCE *instance, int cbtype,
 
     Local<Value> errVal = rdr.decodeError<lcb_respexists_error_context>(rc);
 
-    Local<Value> casVal, existsVal;
+    Local<Value> resVal = Nan::Null();
     if (rc == LCB_SUCCESS) {
-        casVal = rdr.decodeCas<&lcb_respexists_cas>();
+        Local<Value> casVal = rdr.decodeCas<&lcb_respexists_cas>();
 
+        Local<Value> existsVal;
         if (rdr.getValue<&lcb_respexists_is_found>() != 0) {
             existsVal = Nan::True();
         } else {
             existsVal = Nan::False();
         }
-    } else {
-        casVal = Nan::Null();
-        existsVal = Nan::Null();
+
+        resVal = KvResult::createExists(casVal, existsVal);
     }
 
-    rdr.invokeCallback(errVal, casVal, existsVal);
+    rdr.invokeCallback(errVal, resVal);
 }
 
 void Connection::lcbGetReplicaRespHandler(lcb_INSTANCE *instance, int cbtype,
@@ -71,6 +91,11 @@ void Connection::lcbGetReplicaRespHandler(lcb_INSTANCE *instance, int cbtype,
     RespReader<lcb_RESPGETREPLICA, &lcb_respgetreplica_cookie> rdr(instance,
                                                                    resp);
 
+    if (HedgedRead *hedge = rdr.hedgedRead()) {
+        hedge->onReplica(instance, resp);
+        return;
+    }
+
     lcb_STATUS rc = rdr.getValue<&lcb_respgetreplica_status>();
     Local<Value> errVal = rdr.decodeError<lcb_respgetreplica_error_context>(rc);
 
@@ -86,7 +111,8 @@ void Connection::lcbGetReplicaRespHandler(lcb_INSTANCE *instance, int cbtype,
         {
             Nan::TryCatch tryCatch;
             valueVal = rdr.parseDocValue<&lcb_respgetreplica_value,
-                                         &lcb_respgetreplica_flags>();
+                                         &lcb_respgetreplica_flags,
+                                         &lcb_respgetreplica_backbuf>();
             if (tryCatch.HasCaught()) {
                 errVal = tryCatch.Exception();
                 tryCatch.Reset();
@@ -127,14 +153,13 @@ void Connection::lcbRemoveRespHandler(lcb_INSTANCE *instance, int cbtype,
     lcb_STATUS rc = rdr.getValue<&lcb_respremove_status>();
     Local<Value> errVal = rdr.decodeError<lcb_respremove_error_context>(rc);
 
-    Local<Value> casVal;
+    Local<Value> resVal = Nan::Null();
     if (rc == LCB_SUCCESS) {
-        casVal = rdr.decodeCas<&lcb_respremove_cas>();
-    } else {
-        casVal = Nan::Null();
+        resVal = KvResult::createMutation(rdr.decodeCas<&lcb_respremove_cas>(),
+                                          Nan::Undefined());
     }
 
-    rdr.invokeCallback(errVal, casVal);
+    rdr.invokeCallback(errVal, resVal);
 }
 
 void Connection::lcbTouchRespHandler(lcb_INSTANCE *instance, int cbtype,
@@ -146,14 +171,13 @@ void Connection::lcbTouchRespHandler(lcb_INSTANCE *instance, int cbtype,
     lcb_STATUS rc = rdr.getValue<&lcb_resptouch_status>();
     Local<Value> errVal = rdr.decodeError<lcb_resptouch_error_context>(rc);
 
-    Local<Value> casVal;
+    Local<Value> resVal = Nan::Null();
     if (rc == LCB_SUCCESS) {
-        casVal = rdr.decodeCas<&lcb_resptouch_cas>();
-    } else {
-        casVal = Nan::Null();
+        resVal = KvResult::createMutation(rdr.decodeCas<&lcb_resptouch_cas>(),
+                                          Nan::Undefined());
     }
 
-    rdr.invokeCallback(errVal, casVal);
+    rdr.invokeCallback(errVal, resVal);
 }
 
 void Connection::lcbStoreRespHandler(lcb_INSTANCE *instance, int cbtype,
@@ -174,7 +198,17 @@ void Connection::lcbStoreRespHandler(lcb_INSTANCE *instance, int cbtype,
         tokenVal = Nan::Null();
     }
 
-    rdr.invokeCallback(errVal, casVal, tokenVal);
+    if (rdr.batch()) {
+        rdr.invokeCallback(errVal, casVal, tokenVal);
+        return;
+    }
+
+    Local<Value> resVal = Nan::Null();
+    if (rc == LCB_SUCCESS) {
+        resVal = KvResult::createMutation(casVal, tokenVal);
+    }
+
+    rdr.invokeCallback(errVal, resVal);
 }
 
 void Connection::lcbCounterRespHandler(lcb_INSTANCE *instance, int cbtype,
@@ -186,18 +220,15 @@ void Connection::lcbCounterRespHandler(lcb_INSTANCE *instance, int cbtype,
     lcb_STATUS rc = rdr.getValue<&lcb_respcounter_status>();
     Local<Value> errVal = rdr.decodeError<lcb_respcounter_error_context>(rc);
 
-    Local<Value> casVal, tokenVal, valueVal;
+    Local<Value> resVal = Nan::Null();
     if (rc == LCB_SUCCESS) {
-        casVal = rdr.decodeCas<&lcb_respcounter_cas>();
-        tokenVal = rdr.decodeMutationToken<&lcb_respcounter_mutation_token>();
-        valueVal = rdr.parseValue<&lcb_respcounter_value>();
-    } else {
-        casVal = Nan::Null();
-        tokenVal = Nan::Null();
-        valueVal = Nan::Null();
+        resVal = KvResult::createCounter(
+            rdr.decodeCas<&lcb_respcounter_cas>(),
+            rdr.decodeMutationToken<&lcb_respcounter_mutation_token>(),
+            rdr.parseValue<&lcb_respcounter_value>());
     }
 
-    rdr.invokeCallback(errVal, casVal, tokenVal, valueVal);
+    rdr.invokeCallback(errVal, resVal);
 }
 
 void Connection::lcbLookupRespHandler(lcb_INSTANCE *instance, int cbtype,
@@ -206,6 +237,11 @@ void Connection::lcbLookupRespHandler(lcb_INSTANCE *instance, int cbtype,
     Nan::HandleScope scope;
     RespReader<lcb_RESPSUBDOC, &lcb_respsubdoc_cookie> rdr(instance, resp);
 
+    if (CasLoop *loop = rdr.casLoop()) {
+        loop->onLookup(instance, resp);
+        return;
+    }
+
     lcb_STATUS rc = rdr.getValue<&lcb_respsubdoc_status>();
     Local<Value> errVal = rdr.decodeError<lcb_respsubdoc_error_context>(rc);
 
@@ -219,24 +255,21 @@ void Connection::lcbLookupRespHandler(lcb_INSTANCE *instance, int cbtype,
 
             lcb_STATUS itemstatus =
                 rdr.getValue<&lcb_respsubdoc_result_status>(i);
-            Nan::Set(resObj, Nan::New("error").ToLocalChecked(),
-                     Error::create(itemstatus));
+            Nan::Set(resObj, key(Key::error), Error::create(itemstatus));
 
             if (itemstatus == LCB_SUCCESS) {
-                Nan::Set(resObj, Nan::New("value").ToLocalChecked(),
-                         rdr.parseValue<&lcb_respsubdoc_result_value>(i));
+                Nan::Set(resObj, key(Key::value),
+                         rdr.parseJsonValue<&lcb_respsubdoc_result_value>(i));
             } else {
-                Nan::Set(resObj, Nan::New("value").ToLocalChecked(),
-                         Nan::Null());
+                Nan::Set(resObj, key(Key::value), Nan::Null());
             }
 
             Nan::Set(resArr, i, resObj);
         }
 
         Local<Object> resObj = Nan::New<Object>();
-        Nan::Set(resObj, Nan::New("cas").ToLocalChecked(),
-                 rdr.decodeCas<&lcb_respsubdoc_cas>());
-        Nan::Set(resObj, Nan::New("content").ToLocalChecked(), resArr);
+        Nan::Set(resObj, key(Key::cas), rdr.decodeCas<&lcb_respsubdoc_cas>());
+        Nan::Set(resObj, key(Key::content), resArr);
         resVal = resObj;
     } else {
         resVal = Nan::Null();
@@ -251,6 +284,11 @@ void Connection::lcbMutateRespHandler(lcb_INSTANCE *instance, int cbtype,
     Nan::HandleScope scope;
     RespReader<lcb_RESPSUBDOC, &lcb_respsubdoc_cookie> rdr(instance, resp);
 
+    if (CasLoop *loop = rdr.casLoop()) {
+        loop->onMutate(instance, resp);
+        return;
+    }
+
     lcb_STATUS rc = rdr.getValue<&lcb_respsubdoc_status>();
     Local<Value> errVal = rdr.decodeError<lcb_respsubdoc_error_context>(rc);
 
@@ -262,8 +300,7 @@ void Connection::lcbMutateRespHandler(lcb_INSTANCE *instance, int cbtype,
 
             // Include the specific index that failed.
             Local<Object> errObj = errVal.As<Object>();
-            Nan::Set(errObj, Nan::New("index").ToLocalChecked(),
-                     Nan::New(static_cast<int>(i)));
+            Nan::Set(errObj, key(Key::index), Nan::New(static_cast<int>(i)));
         }
     }
 
@@ -271,27 +308,31 @@ void Connection::lcbMutateRespHandler(lcb_INSTANCE *instance, int cbtype,
     if (rc == LCB_SUCCESS) {
         size_t numResults = rdr.getValue<&lcb_respsubdoc_result_size>();
 
+        // Only the specs which return a value get an entry, the rest are
+        // left as null.
         Local<Array> resArr = Nan::New<Array>(numResults);
         for (size_t i = 0; i < numResults; ++i) {
-            Local<Object> resObj = Nan::New<Object>();
-
+            const char *value = NULL;
+            size_t nvalue = 0;
             lcb_STATUS itemstatus =
                 rdr.getValue<&lcb_respsubdoc_result_status>(i);
-            if (itemstatus == LCB_SUCCESS) {
-                Nan::Set(resObj, Nan::New("value").ToLocalChecked(),
-                         rdr.parseValue<&lcb_respsubdoc_result_value>(i));
-            } else {
-                Nan::Set(resObj, Nan::New("value").ToLocalChecked(),
-                         Nan::Null());
+            if (itemstatus != LCB_SUCCESS ||
+                lcb_respsubdoc_result_value(resp, i, &value, &nvalue) !=
+                    LCB_SUCCESS ||
+                nvalue == 0) {
+                Nan::Set(resArr, i, Nan::Null());
+                continue;
             }
 
+            Local<Object> resObj = Nan::New<Object>();
+            Nan::Set(resObj, key(Key::value),
+                     rdr.parseJsonValue<&lcb_respsubdoc_result_value>(i));
             Nan::Set(resArr, i, resObj);
         }
 
         Local<Object> resObj = Nan::New<Object>();
-        Nan::Set(resObj, Nan::New("cas").ToLocalChecked(),
-                 rdr.decodeCas<&lcb_respsubdoc_cas>());
-        Nan::Set(resObj, Nan::New("content").ToLocalChecked(), resArr);
+        Nan::Set(resObj, key(Key::cas), rdr.decodeCas<&lcb_respsubdoc_cas>());
+        Nan::Set(resObj, key(Key::content), resArr);
         resVal = resObj;
     } else {
         resVal = Nan::Null();
@@ -335,12 +376,29 @@ void Connection::lcbQueryDataHandler(lcb_INSTANCE *instance, int cbtype,
     lcb_STATUS rc = rdr.getValue<&lcb_respquery_status>();
     Local<Value> errVal = rdr.decodeError<lcb_respquery_error_context>(rc);
 
-    Local<Value> dataRes = rdr.parseValue<&lcb_respquery_row>();
-
     uint32_t rflags = 0;
     if (!rdr.getValue<&lcb_respquery_is_final>()) {
         rflags |= LCBX_RESP_F_NONFINAL;
     }
+
+    if (RowBatcher *batcher = rdr.rowBatcher()) {
+        if (rflags & LCBX_RESP_F_NONFINAL) {
+            lcb_QUERY_HANDLE *handle = nullptr;
+            lcb_respquery_handle(resp, &handle);
+            batcher->setHandle<lcb_QUERY_HANDLE, &lcb_query_pause,
+                               &lcb_query_resume>(instance, handle);
+
+            const char *row = nullptr;
+            size_t nrow = 0;
+            lcb_respquery_row(resp, &row, &nrow);
+            batcher->addRow(row, nrow);
+            return;
+        }
+
+        batcher->finish();
+    }
+
+    Local<Value> dataRes = rdr.parseValue<&lcb_respquery_row>();
     Local<Value> flagsVal = Nan::New<Number>(rflags);
 
     if (rflags & LCBX_RESP_F_NONFINAL) {
@@ -360,12 +418,29 @@ void Connection::lcbAnalyticsDataHandler(lcb_INSTANCE *instance, int cbtype,
     lcb_STATUS rc = rdr.getValue<&lcb_respanalytics_status>();
     Local<Value> errVal = rdr.decodeError<lcb_respanalytics_error_context>(rc);
 
-    Local<Value> dataRes = rdr.parseValue<&lcb_respanalytics_row>();
-
     uint32_t rflags = 0;
     if (!rdr.getValue<&lcb_respanalytics_is_final>()) {
         rflags |= LCBX_RESP_F_NONFINAL;
     }
+
+    if (RowBatcher *batcher = rdr.rowBatcher()) {
+        if (rflags & LCBX_RESP_F_NONFINAL) {
+            lcb_ANALYTICS_HANDLE *handle = nullptr;
+            lcb_respanalytics_handle(resp, &handle);
+            batcher->setHandle<lcb_ANALYTICS_HANDLE, &lcb_analytics_pause,
+                               &lcb_analytics_resume>(instance, handle);
+
+            const char *row = nullptr;
+            size_t nrow = 0;
+            lcb_respanalytics_row(resp, &row, &nrow);
+            batcher->addRow(row, nrow);
+            return;
+        }
+
+        batcher->finish();
+    }
+
+    Local<Value> dataRes = rdr.parseValue<&lcb_respanalytics_row>();
     Local<Value> flagsVal = Nan::New<Number>(rflags);
 
     if (rflags & LCBX_RESP_F_NONFINAL) {
@@ -384,12 +459,29 @@ void Connection::lcbSearchDataHandler(lcb_INSTANCE *instance, int cbtype,
     lcb_STATUS rc = rdr.getValue<&lcb_respsearch_status>();
     Local<Value> errVal = rdr.decodeError<lcb_respsearch_error_context>(rc);
 
-    Local<Value> dataRes = rdr.parseValue<&lcb_respsearch_row>();
-
     uint32_t rflags = 0;
     if (!rdr.getValue<&lcb_respsearch_is_final>()) {
         rflags |= LCBX_RESP_F_NONFINAL;
     }
+
+    if (RowBatcher *batcher = rdr.rowBatcher()) {
+        if (rflags & LCBX_RESP_F_NONFINAL) {
+            lcb_SEARCH_HANDLE *handle = nullptr;
+            lcb_respsearch_handle(resp, &handle);
+            batcher->setHandle<lcb_SEARCH_HANDLE, &lcb_search_pause,
+                               &lcb_search_resume>(instance, handle);
+
+            const char *row = nullptr;
+            size_t nrow = 0;
+            lcb_respsearch_row(resp, &row, &nrow);
+            batcher->addRow(row, nrow);
+            return;
+        }
+
+        batcher->finish();
+    }
+
+    Local<Value> dataRes = rdr.parseValue<&lcb_respsearch_row>();
     Local<Value> flagsVal = Nan::New<Number>(rflags);
 
     if (rflags & LCBX_RESP_F_NONFINAL) {
@@ -1,14 +1,67 @@
 #include "connection.h"
+#include "casloop.h"
 #include "error.h"
+#include "hedgedread.h"
 #include "opbuilder.h"
+#include <memory>
 
 namespace couchnode
 {
 
+// A get which also reads from a replica if the active node is slow to
+// respond, see HedgedRead.  Locking and touching are not supported, as a
+// replica can do neither.
+static void hedgedGet(Connection *me,
+                      const Nan::FunctionCallbackInfo<Value> &info)
+{
+    std::unique_ptr<HedgedRead> read(new HedgedRead(me));
+
+    if (ValueParser::asUint(info[4]) > 0 ||
+        ValueParser::asUint(info[5]) > 0) {
+        return Nan::ThrowError(
+            Error::create("cannot hedge a get which locks or touches"));
+    }
+    if (!read->parseParentSpan(info[6])) {
+        return Nan::ThrowError(Error::create("bad parent span passed"));
+    }
+    if (!read->parseCollection(info[0], info[1])) {
+        return Nan::ThrowError(Error::create("bad scope/collection passed"));
+    }
+    if (!read->parseKey(info[2])) {
+        return Nan::ThrowError(Error::create("bad key passed"));
+    }
+    if (!read->parseTranscoder(info[3])) {
+        return Nan::ThrowError(Error::create("bad transcoder passed"));
+    }
+    if (!read->parseTimeout(info[7])) {
+        return Nan::ThrowError(Error::create("bad timeout passed"));
+    }
+    if (!read->parseDelay(info[8], info[9])) {
+        return Nan::ThrowError(Error::create("bad hedge passed"));
+    }
+    if (!read->parseCallback(info[10])) {
+        return Nan::ThrowError(Error::create("bad callback passed"));
+    }
+
+    lcb_STATUS err = read->start();
+    if (err) {
+        return Nan::ThrowError(Error::create(err));
+    }
+
+    // The read now belongs to libcouchbase, until both reads complete.
+    read.release();
+    return info.GetReturnValue().Set(true);
+}
+
 NAN_METHOD(Connection::fnGet)
 {
     Connection *me = ObjectWrap::Unwrap<Connection>(info.This());
     Nan::HandleScope scope;
+
+    if (!info[8]->IsUndefined() || !info[9]->IsUndefined()) {
+        return hedgedGet(me, info);
+    }
+
     OpBuilder<lcb_CMDGET> enc(me);
 
     if (!enc.parseParentSpan(info[6])) {
@@ -16,7 +69,9 @@ NAN_METHOD(Connection::fnGet)
     }
     enc.beginTrace(LCBTRACE_SERVICE_KV, "get");
 
-    if (!enc.parseOption<&lcb_cmdget_collection>(info[0], info[1])) {
+    if (!enc.parseCollection<&lcb_cmdget_collection,
+                             &lcb_cmdget_collection_id>(
+            me->lcbHandle(), info[0], info[1])) {
         return Nan::ThrowError(Error::create("bad scope/collection passed"));
     }
     if (!enc.parseOption<&lcb_cmdget_key>(info[2])) {
@@ -36,7 +91,7 @@ NAN_METHOD(Connection::fnGet)
     if (!enc.parseOption<&lcb_cmdget_timeout>(info[7])) {
         return Nan::ThrowError(Error::create("bad timeout passed"));
     }
-    if (!enc.parseCallback(info[8])) {
+    if (!enc.parseCallback(info[10])) {
         return Nan::ThrowError(Error::create("bad callback passed"));
     }
 
@@ -59,7 +114,9 @@ NAN_METHOD(Connection::fnExists)
     }
     enc.beginTrace(LCBTRACE_SERVICE_KV, "exists");
 
-    if (!enc.parseOption<&lcb_cmdexists_collection>(info[0], info[1])) {
+    if (!enc.parseCollection<&lcb_cmdexists_collection,
+                             &lcb_cmdexists_collection_id>(
+            me->lcbHandle(), info[0], info[1])) {
         return Nan::ThrowError(Error::create("bad scope/collection passed"));
     }
     if (!enc.parseOption<&lcb_cmdexists_key>(info[2])) {
@@ -95,7 +152,9 @@ NAN_METHOD(Connection::fnGetReplica)
     }
     enc.beginTrace(LCBTRACE_SERVICE_KV, "getReplica");
 
-    if (!enc.parseOption<&lcb_cmdgetreplica_collection>(info[0], info[1])) {
+    if (!enc.parseCollection<&lcb_cmdgetreplica_collection,
+                             &lcb_cmdgetreplica_collection_id>(
+            me->lcbHandle(), info[0], info[1])) {
         return Nan::ThrowError(Error::create("bad scope/collection passed"));
     }
     if (!enc.parseOption<&lcb_cmdgetreplica_key>(info[2])) {
@@ -154,7 +213,9 @@ NAN_METHOD(Connection::fnStore)
     }
     enc.beginTrace(LCBTRACE_SERVICE_KV, opName);
 
-    if (!enc.parseOption<&lcb_cmdstore_collection>(info[0], info[1])) {
+    if (!enc.parseCollection<&lcb_cmdstore_collection,
+                             &lcb_cmdstore_collection_id>(
+            me->lcbHandle(), info[0], info[1])) {
         return Nan::ThrowError(Error::create("bad scope/collection passed"));
     }
     if (!enc.parseOption<&lcb_cmdstore_key>(info[2])) {
@@ -233,6 +294,163 @@ NAN_METHOD(Connection::fnStore)
     return info.GetReturnValue().Set(true);
 }
 
+NAN_METHOD(Connection::fnGetMulti)
+{
+    Connection *me = ObjectWrap::Unwrap<Connection>(info.This());
+    Nan::HandleScope scope;
+    BatchOpBuilder<lcb_CMDGET> enc(me);
+
+    if (!enc.parseParentSpan(info[6])) {
+        return Nan::ThrowError(Error::create("bad parent span passed"));
+    }
+    if (!info[2]->IsArray()) {
+        return Nan::ThrowError(Error::create("bad keys passed"));
+    }
+    if (!enc.parseTranscoder(info[3])) {
+        return Nan::ThrowError(Error::create("bad transcoder passed"));
+    }
+    if (!enc.parseCallback(info[8])) {
+        return Nan::ThrowError(Error::create("bad callback passed"));
+    }
+
+    Local<Array> keys = info[2].As<Array>();
+    for (uint32_t i = 0; i < keys->Length(); ++i) {
+        CmdBuilder<lcb_CMDGET> &cmd = enc.addCmd();
+
+        if (!cmd.parseCollection<&lcb_cmdget_collection,
+                                 &lcb_cmdget_collection_id>(
+                me->lcbHandle(), info[0], info[1])) {
+            return Nan::ThrowError(
+                Error::create("bad scope/collection passed"));
+        }
+        if (!cmd.parseOption<&lcb_cmdget_key>(
+                Nan::Get(keys, i).ToLocalChecked())) {
+            return Nan::ThrowError(Error::create("bad key passed"));
+        }
+        if (!cmd.parseOption<&lcb_cmdget_expiry>(info[4])) {
+            return Nan::ThrowError(Error::create("bad expiry passed"));
+        }
+        if (ValueParser::asUint(info[5]) > 0) {
+            if (!cmd.parseOption<&lcb_cmdget_locktime>(info[5])) {
+                return Nan::ThrowError(Error::create("bad locked passed"));
+            }
+        }
+        if (!cmd.parseOption<&lcb_cmdget_timeout>(info[7])) {
+            return Nan::ThrowError(Error::create("bad timeout passed"));
+        }
+    }
+
+    // Results are delivered as (err, errs[], cas[], values[])
+    enc.execute<&lcb_get>(LCBTRACE_SERVICE_KV, "get", 3);
+
+    return info.GetReturnValue().Set(true);
+}
+
+NAN_METHOD(Connection::fnStoreMulti)
+{
+    Connection *me = ObjectWrap::Unwrap<Connection>(info.This());
+    Nan::HandleScope scope;
+
+    const char *opName = "store";
+    lcb_STORE_OPERATION opType =
+        static_cast<lcb_STORE_OPERATION>(ValueParser::asUint(info[11]));
+    switch (opType) {
+    case LCB_STORE_UPSERT:
+        opName = "upsert";
+        break;
+    case LCB_STORE_INSERT:
+        opName = "insert";
+        break;
+    case LCB_STORE_REPLACE:
+        opName = "replace";
+        break;
+    default:
+        // APPEND/PREPEND are not supported in batches
+        return Nan::ThrowError(Error::create("bad op type passed"));
+    }
+
+    BatchOpBuilder<lcb_CMDSTORE> enc(me);
+
+    if (!enc.parseParentSpan(info[9])) {
+        return Nan::ThrowError(Error::create("bad parent span passed"));
+    }
+    if (!info[2]->IsArray() || !info[4]->IsArray()) {
+        return Nan::ThrowError(Error::create("bad keys/values passed"));
+    }
+    Local<Array> keys = info[2].As<Array>();
+    Local<Array> values = info[4].As<Array>();
+    if (keys->Length() != values->Length()) {
+        return Nan::ThrowError(Error::create("bad keys/values passed"));
+    }
+    if (!enc.parseTranscoder(info[3])) {
+        return Nan::ThrowError(Error::create("bad transcoder passed"));
+    }
+    if (!enc.parseCallback(info[12])) {
+        return Nan::ThrowError(Error::create("bad callback passed"));
+    }
+
+    lcb_DURABILITY_LEVEL durabilityLevel =
+        static_cast<lcb_DURABILITY_LEVEL>(ValueParser::asUint(info[6]));
+    int persistTo = ValueParser::asInt(info[7]);
+    int replicateTo = ValueParser::asInt(info[8]);
+
+    for (uint32_t i = 0; i < keys->Length(); ++i) {
+        CmdBuilder<lcb_CMDSTORE> &cmd = enc.addCmd(opType);
+
+        if (!cmd.parseCollection<&lcb_cmdstore_collection,
+                                 &lcb_cmdstore_collection_id>(
+                me->lcbHandle(), info[0], info[1])) {
+            return Nan::ThrowError(
+                Error::create("bad scope/collection passed"));
+        }
+        if (!cmd.parseOption<&lcb_cmdstore_key>(
+                Nan::Get(keys, i).ToLocalChecked())) {
+            return Nan::ThrowError(Error::create("bad key passed"));
+        }
+
+        Local<Value> errVal;
+        bool parseRes;
+        {
+            Nan::TryCatch tryCatch;
+            parseRes =
+                enc.parseDocValue<&lcb_cmdstore_value, &lcb_cmdstore_flags>(
+                    cmd, Nan::Get(values, i).ToLocalChecked());
+            if (tryCatch.HasCaught()) {
+                errVal = tryCatch.Exception();
+            }
+        }
+        if (!parseRes) {
+            if (!errVal.IsEmpty()) {
+                return Nan::ThrowError(errVal);
+            }
+
+            return Nan::ThrowError(Error::create("bad value passed"));
+        }
+
+        if (ValueParser::asInt64(info[5]) < 0) {
+            lcb_cmdstore_preserve_expiry(cmd.cmd(), 1);
+        } else {
+            if (!cmd.parseOption<&lcb_cmdstore_expiry>(info[5])) {
+                return Nan::ThrowError(Error::create("bad expiry passed"));
+            }
+        }
+        if (durabilityLevel != LCB_DURABILITYLEVEL_NONE) {
+            lcb_cmdstore_durability(cmd.cmd(), durabilityLevel);
+        } else if (persistTo > 0 || replicateTo > 0) {
+            lcb_cmdstore_durability_observe(cmd.cmd(), persistTo,
+                                            replicateTo);
+        }
+        if (!cmd.parseOption<&lcb_cmdstore_timeout>(info[10])) {
+            return Nan::ThrowError(Error::create("bad timeout passed"));
+        }
+    }
+
+    // Results are delivered as (err, errs[], cas[], tokens[])
+    enc.execute<&lcb_store>(LCBTRACE_SERVICE_KV, opName, 3);
+
+    return info.GetReturnValue().Set(true);
+}
+
 NAN_METHOD(Connection::fnRemove)
 {
     Connection *me = ObjectWrap::Unwrap<Connection>(info.This());
@@ -244,7 +462,9 @@ NAN_METHOD(Connection::fnRemove)
     }
     enc.beginTrace(LCBTRACE_SERVICE_KV, "remove");
 
-    if (!enc.parseOption<&lcb_cmdremove_collection>(info[0], info[1])) {
+    if (!enc.parseCollection<&lcb_cmdremove_collection,
+                             &lcb_cmdremove_collection_id>(
+            me->lcbHandle(), info[0], info[1])) {
         return Nan::ThrowError(Error::create("bad scope/collection passed"));
     }
     if (!enc.parseOption<&lcb_cmdremove_key>(info[2])) {
@@ -290,7 +510,9 @@ NAN_METHOD(Connection::fnTouch)
     }
     enc.beginTrace(LCBTRACE_SERVICE_KV, "touch");
 
-    if (!enc.parseOption<&lcb_cmdtouch_collection>(info[0], info[1])) {
+    if (!enc.parseCollection<&lcb_cmdtouch_collection,
+                             &lcb_cmdtouch_collection_id>(
+            me->lcbHandle(), info[0], info[1])) {
         return Nan::ThrowError(Error::create("bad scope/collection passed"));
     }
     if (!enc.parseOption<&lcb_cmdtouch_key>(info[2])) {
@@ -336,7 +558,9 @@ NAN_METHOD(Connection::fnUnlock)
     }
     enc.beginTrace(LCBTRACE_SERVICE_KV, "unlock");
 
-    if (!enc.parseOption<&lcb_cmdunlock_collection>(info[0], info[1])) {
+    if (!enc.parseCollection<&lcb_cmdunlock_collection,
+                             &lcb_cmdunlock_collection_id>(
+            me->lcbHandle(), info[0], info[1])) {
         return Nan::ThrowError(Error::create("bad scope/collection passed"));
     }
     if (!enc.parseOption<&lcb_cmdunlock_key>(info[2])) {
@@ -371,7 +595,9 @@ NAN_METHOD(Connection::fnCounter)
     }
     enc.beginTrace(LCBTRACE_SERVICE_KV, "counter");
 
-    if (!enc.parseOption<&lcb_cmdcounter_collection>(info[0], info[1])) {
+    if (!enc.parseCollection<&lcb_cmdcounter_collection,
+                             &lcb_cmdcounter_collection_id>(
+            me->lcbHandle(), info[0], info[1])) {
         return Nan::ThrowError(Error::create("bad scope/collection passed"));
     }
     if (!enc.parseOption<&lcb_cmdcounter_key>(info[2])) {
@@ -423,7 +649,9 @@ NAN_METHOD(Connection::fnLookupIn)
     }
     enc.beginTrace(LCBTRACE_SERVICE_KV, "lookupIn");
 
-    if (!enc.parseOption<&lcb_cmdsubdoc_collection>(info[0], info[1])) {
+    if (!enc.parseCollection<&lcb_cmdsubdoc_collection,
+                             &lcb_cmdsubdoc_collection_id>(
+            me->lcbHandle(), info[0], info[1])) {
         return Nan::ThrowError(Error::create("bad scope/collection passed"));
     }
     if (!enc.parseOption<&lcb_cmdsubdoc_key>(info[2])) {
@@ -489,7 +717,9 @@ NAN_METHOD(Connection::fnMutateIn)
     }
     enc.beginTrace(LCBTRACE_SERVICE_KV, "mutateIn");
 
-    if (!enc.parseOption<&lcb_cmdsubdoc_collection>(info[0], info[1])) {
+    if (!enc.parseCollection<&lcb_cmdsubdoc_collection,
+                             &lcb_cmdsubdoc_collection_id>(
+            me->lcbHandle(), info[0], info[1])) {
         return Nan::ThrowError(Error::create("bad scope/collection passed"));
     }
     if (!enc.parseOption<&lcb_cmdsubdoc_key>(info[2])) {
@@ -595,6 +825,72 @@ NAN_METHOD(Connection::fnMutateIn)
     return info.GetReturnValue().Set(true);
 }
 
+NAN_METHOD(Connection::fnQueuePop)
+{
+    Connection *me = ObjectWrap::Unwrap<Connection>(info.This());
+    Nan::HandleScope scope;
+    std::unique_ptr<CasLoop> loop(new CasLoop(me, CasLoop::QueuePop));
+
+    if (!loop->parseParentSpan(info[3])) {
+        return Nan::ThrowError(Error::create("bad parent span passed"));
+    }
+    if (!loop->parseCollection(info[0], info[1])) {
+        return Nan::ThrowError(Error::create("bad scope/collection passed"));
+    }
+    if (!loop->parseKey(info[2])) {
+        return Nan::ThrowError(Error::create("bad key passed"));
+    }
+    if (!loop->parseTimeout(info[4])) {
+        return Nan::ThrowError(Error::create("bad timeout passed"));
+    }
+    if (!loop->parseCallback(info[5])) {
+        return Nan::ThrowError(Error::create("bad callback passed"));
+    }
+
+    lcb_STATUS err = loop->start();
+    if (err) {
+        return Nan::ThrowError(Error::create(err));
+    }
+
+    // The loop now belongs to libcouchbase, until its callback is invoked.
+    loop.release();
+    return info.GetReturnValue().Set(true);
+}
+
+NAN_METHOD(Connection::fnSetRemove)
+{
+    Connection *me = ObjectWrap::Unwrap<Connection>(info.This());
+    Nan::HandleScope scope;
+    std::unique_ptr<CasLoop> loop(new CasLoop(me, CasLoop::SetRemove));
+
+    if (!loop->parseParentSpan(info[4])) {
+        return Nan::ThrowError(Error::create("bad parent span passed"));
+    }
+    if (!loop->parseCollection(info[0], info[1])) {
+        return Nan::ThrowError(Error::create("bad scope/collection passed"));
+    }
+    if (!loop->parseKey(info[2])) {
+        return Nan::ThrowError(Error::create("bad key passed"));
+    }
+    if (!loop->parseItem(info[3])) {
+        return Nan::ThrowError(Error::create("bad item passed"));
+    }
+    if (!loop->parseTimeout(info[5])) {
+        return Nan::ThrowError(Error::create("bad timeout passed"));
+    }
+    if (!loop->parseCallback(info[6])) {
+        return Nan::ThrowError(Error::create("bad callback passed"));
+    }
+
+    lcb_STATUS err = loop->start();
+    if (err) {
+        return Nan::ThrowError(Error::create(err));
+    }
+
+    loop.release();
+    return info.GetReturnValue().Set(true);
+}
+
 NAN_METHOD(Connection::fnViewQuery)
 {
     Connection *me = ObjectWrap::Unwrap<Connection>(info.This());
@@ -642,7 +938,7 @@ NAN_METHOD(Connection::fnQuery)
     Nan::HandleScope scope;
     OpBuilder<lcb_CMDQUERY> enc(me);
 
-    if (!enc.parseParentSpan(info[2])) {
+    if (!enc.parseParentSpan(info[3])) {
         return Nan::ThrowError(Error::create("bad parent span passed"));
     }
     enc.beginTrace(LCBTRACE_SERVICE_QUERY, "query");
@@ -652,16 +948,35 @@ NAN_METHOD(Connection::fnQuery)
     if (!enc.parseOption<&lcb_cmdquery_payload>(info[0])) {
         return Nan::ThrowError(Error::create("bad query passed"));
     }
-    uint32_t flags = ValueParser::asUint(info[1]);
+    // The parameters are already encoded, and are added to the request
+    // without being parsed again.
+    if (!info[1]->IsUndefined()) {
+        if (!info[1]->IsArray()) {
+            return Nan::ThrowError(Error::create("bad query params passed"));
+        }
+        Local<Array> params = info[1].As<Array>();
+        for (uint32_t i = 0; i + 1 < params->Length(); i += 2) {
+            if (!enc.parseOption<&lcb_cmdquery_option_raw>(
+                    Nan::Get(params, i).ToLocalChecked(),
+                    Nan::Get(params, i + 1).ToLocalChecked())) {
+                return Nan::ThrowError(
+                    Error::create("bad query params passed"));
+            }
+        }
+    }
+    uint32_t flags = ValueParser::asUint(info[2]);
     if (flags & LCBX_QUERYFLAG_PREPCACHE) {
         lcb_cmdquery_adhoc(enc.cmd(), 0);
     } else {
         lcb_cmdquery_adhoc(enc.cmd(), 1);
     }
-    if (!enc.parseOption<&lcb_cmdquery_timeout>(info[3])) {
+    if (!enc.parseOption<&lcb_cmdquery_timeout>(info[4])) {
         return Nan::ThrowError(Error::create("bad timeout passed"));
     }
-    if (!enc.parseCallback(info[4])) {
+    if (!enc.parseRowBatchSize(info[5])) {
+        return Nan::ThrowError(Error::create("bad row batch size passed"));
+    }
+    if (!enc.parseCallback(info[6])) {
         return Nan::ThrowError(Error::create("bad callback passed"));
     }
 
@@ -670,7 +985,10 @@ NAN_METHOD(Connection::fnQuery)
         return Nan::ThrowError(Error::create(err));
     }
 
-    return info.GetReturnValue().Set(true);
+    if (info[5]->IsUndefined()) {
+        return info.GetReturnValue().Set(true);
+    }
+    return info.GetReturnValue().Set(enc.rowStream());
 }
 
 NAN_METHOD(Connection::fnAnalyticsQuery)
@@ -698,7 +1016,10 @@ NAN_METHOD(Connection::fnAnalyticsQuery)
     if (!enc.parseOption<&lcb_cmdanalytics_timeout>(info[3])) {
         return Nan::ThrowError(Error::create("bad timeout passed"));
     }
-    if (!enc.parseCallback(info[4])) {
+    if (!enc.parseRowBatchSize(info[4])) {
+        return Nan::ThrowError(Error::create("bad row batch size passed"));
+    }
+    if (!enc.parseCallback(info[5])) {
         return Nan::ThrowError(Error::create("bad callback passed"));
     }
 
@@ -707,7 +1028,10 @@ NAN_METHOD(Connection::fnAnalyticsQuery)
         return Nan::ThrowError(Error::create(err));
     }
 
-    return info.GetReturnValue().Set(true);
+    if (info[4]->IsUndefined()) {
+        return info.GetReturnValue().Set(true);
+    }
+    return info.GetReturnValue().Set(enc.rowStream());
 }
 
 NAN_METHOD(Connection::fnSearchQuery)
@@ -730,7 +1054,10 @@ NAN_METHOD(Connection::fnSearchQuery)
     if (!enc.parseOption<&lcb_cmdsearch_timeout>(info[3])) {
         return Nan::ThrowError(Error::create("bad timeout passed"));
     }
-    if (!enc.parseCallback(info[4])) {
+    if (!enc.parseRowBatchSize(info[4])) {
+        return Nan::ThrowError(Error::create("bad row batch size passed"));
+    }
+    if (!enc.parseCallback(info[5])) {
         return Nan::ThrowError(Error::create("bad callback passed"));
     }
 
@@ -739,7 +1066,10 @@ NAN_METHOD(Connection::fnSearchQuery)
         return Nan::ThrowError(Error::create(err));
     }
 
-    return info.GetReturnValue().Set(true);
+    if (info[4]->IsUndefined()) {
+        return info.GetReturnValue().Set(true);
+    }
+    return info.GetReturnValue().Set(enc.rowStream());
 }
 
 NAN_METHOD(Connection::fnHttpRequest)
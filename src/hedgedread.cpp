@@ -0,0 +1,368 @@
+#include "hedgedread.h"
+
+#include "collectionref.h"
+#include "error.h"
+#include "kvresult.h"
+#include "respreader.h"
+
+namespace couchnode
+{
+
+typedef RespReader<lcb_RESPGET, &lcb_respget_cookie> GetRespReader;
+typedef RespReader<lcb_RESPGETREPLICA, &lcb_respgetreplica_cookie>
+    GetReplicaRespReader;
+
+HedgedRead::HedgedRead(Connection *impl)
+    : Nan::AsyncResource("couchbase::hedgedread")
+    , _impl(impl)
+    , _parentSpan(nullptr)
+    , _hasDeadline(false)
+    , _deadlineMs(0)
+    , _hedged(false)
+    , _delayMs(0)
+    , _timer(nullptr)
+    , _activePending(false)
+    , _replicaPending(false)
+    , _done(false)
+{
+    _implRef.Reset(_impl->persistent());
+    _active._hedgedRead = this;
+    _replica._hedgedRead = this;
+}
+
+HedgedRead::~HedgedRead()
+{
+    _callback.Reset();
+    _implRef.Reset();
+    _transcoder.Reset();
+    _activeErr.Reset();
+
+    if (_parentSpan) {
+        delete _parentSpan;
+        _parentSpan = nullptr;
+    }
+
+    if (_timer) {
+        uv_timer_stop(_timer);
+        uv_close(reinterpret_cast<uv_handle_t *>(_timer),
+                 [](uv_handle_t *handle) {
+                     delete reinterpret_cast<uv_timer_t *>(handle);
+                 });
+        _timer = nullptr;
+    }
+}
+
+bool HedgedRead::parseCollection(Local<Value> scope, Local<Value> collection)
+{
+    CollectionRef *ref = CollectionRef::unwrap(scope);
+    if (ref) {
+        _scope = ref->scopeName();
+        _collection = ref->collectionName();
+        return true;
+    }
+
+    ValueParser parser(_impl->scratch());
+    const char *bytes;
+    size_t nbytes;
+    if (!parser.parseString(&bytes, &nbytes, scope)) {
+        return false;
+    }
+    _scope.assign(bytes ? bytes : "", nbytes);
+    if (!parser.parseString(&bytes, &nbytes, collection)) {
+        return false;
+    }
+    _collection.assign(bytes ? bytes : "", nbytes);
+    return true;
+}
+
+bool HedgedRead::parseKey(Local<Value> key)
+{
+    ValueParser parser(_impl->scratch());
+    const char *bytes;
+    size_t nbytes;
+    if (!parser.parseString(&bytes, &nbytes, key) || nbytes == 0) {
+        return false;
+    }
+    _key.assign(bytes, nbytes);
+    return true;
+}
+
+bool HedgedRead::parseTranscoder(Local<Value> transcoder)
+{
+    Nan::MaybeLocal<Object> transcoderObjM = Nan::To<Object>(transcoder);
+    if (transcoderObjM.IsEmpty()) {
+        return false;
+    }
+
+    _transcoder.Reset(transcoderObjM.ToLocalChecked());
+    return true;
+}
+
+bool HedgedRead::parseTimeout(Local<Value> timeout)
+{
+    if (timeout.IsEmpty() || timeout->IsUndefined()) {
+        return true;
+    }
+
+    uint32_t timeoutUs;
+    if (!ValueParser::parseUint(&timeoutUs, timeout)) {
+        return false;
+    }
+
+    // Applies to the read as a whole, the replica gets what remains of it.
+    _hasDeadline = true;
+    _deadlineMs =
+        uv_now(Nan::GetCurrentEventLoop()) + (timeoutUs + 999) / 1000;
+    return true;
+}
+
+bool HedgedRead::parseParentSpan(Local<Value> parentSpan)
+{
+    if (!parentSpan.IsEmpty() && parentSpan->IsObject()) {
+        _parentSpan = new WrappedRequestSpan(_impl, parentSpan.As<Object>());
+    }
+
+    TraceSpan parent;
+    if (_parentSpan && *_parentSpan) {
+        parent = TraceSpan::wrap(_parentSpan->span());
+    }
+
+    _traceSpan =
+        TraceSpan::beginOpTrace(_impl, LCBTRACE_SERVICE_KV, "get", parent);
+    return true;
+}
+
+bool HedgedRead::parseCallback(Local<Value> callback)
+{
+    Nan::MaybeLocal<Function> callbackFnM = Nan::To<Function>(callback);
+    if (callbackFnM.IsEmpty()) {
+        return false;
+    }
+
+    _callback.Reset(callbackFnM.ToLocalChecked());
+    return true;
+}
+
+bool HedgedRead::parseDelay(Local<Value> percentile, Local<Value> fallbackDelay)
+{
+    uint64_t delayUs = 0;
+
+    if (!percentile->IsUndefined()) {
+        Nan::Maybe<double> percentileM = Nan::To<double>(percentile);
+        if (percentileM.IsNothing() || !(percentileM.FromJust() >= 0.0) ||
+            percentileM.FromJust() > 100.0) {
+            return false;
+        }
+        delayUs = _impl->hedgeDelay(percentileM.FromJust());
+        _hedged = delayUs > 0;
+    }
+
+    if (!_hedged && !fallbackDelay->IsUndefined()) {
+        uint32_t fallbackUs;
+        if (!ValueParser::parseUint(&fallbackUs, fallbackDelay)) {
+            return false;
+        }
+        delayUs = fallbackUs;
+        _hedged = true;
+    }
+
+    _delayMs = (delayUs + 999) / 1000;
+    return true;
+}
+
+lcb_STATUS HedgedRead::start()
+{
+    lcb_INSTANCE *instance = _impl->lcbHandle();
+    if (!instance) {
+        return LCB_ERR_REQUEST_CANCELED;
+    }
+
+    lcb_CMDGET *cmd;
+    lcb_cmdget_create(&cmd);
+    lcb_cmdget_collection(cmd, _scope.data(), _scope.size(),
+                          _collection.data(), _collection.size());
+    lcb_cmdget_key(cmd, _key.data(), _key.size());
+
+    lcb_STATUS err = LCB_SUCCESS;
+    if (_hasDeadline) {
+        uint64_t now = uv_now(Nan::GetCurrentEventLoop());
+        if (now >= _deadlineMs) {
+            err = LCB_ERR_TIMEOUT;
+        } else {
+            lcb_cmdget_timeout(
+                cmd, static_cast<uint32_t>((_deadlineMs - now) * 1000));
+        }
+    }
+    if (err == LCB_SUCCESS && _traceSpan) {
+        err = lcbx_cmd_parent_span(cmd, _traceSpan.span());
+    }
+    if (err == LCB_SUCCESS) {
+        err = lcb_get(instance, &_active, cmd);
+    }
+    lcb_cmdget_destroy(cmd);
+    if (err != LCB_SUCCESS) {
+        return err;
+    }
+    _activePending = true;
+
+    if (_hedged) {
+        _timer = new uv_timer_t();
+        uv_timer_init(Nan::GetCurrentEventLoop(), _timer);
+        _timer->data = this;
+        uv_timer_start(_timer, &onTimer, _delayMs, 0);
+    }
+    return LCB_SUCCESS;
+}
+
+lcb_STATUS HedgedRead::scheduleReplica()
+{
+    // The connection may have been shut down while waiting.
+    lcb_INSTANCE *instance = _impl->lcbHandle();
+    if (!instance) {
+        return LCB_ERR_REQUEST_CANCELED;
+    }
+
+    lcb_CMDGETREPLICA *cmd;
+    lcb_cmdgetreplica_create(&cmd, LCB_REPLICA_MODE_ANY);
+    lcb_cmdgetreplica_collection(cmd, _scope.data(), _scope.size(),
+                                 _collection.data(), _collection.size());
+    lcb_cmdgetreplica_key(cmd, _key.data(), _key.size());
+
+    lcb_STATUS err = LCB_SUCCESS;
+    if (_hasDeadline) {
+        uint64_t now = uv_now(Nan::GetCurrentEventLoop());
+        if (now >= _deadlineMs) {
+            err = LCB_ERR_TIMEOUT;
+        } else {
+            lcb_cmdgetreplica_timeout(
+                cmd, static_cast<uint32_t>((_deadlineMs - now) * 1000));
+        }
+    }
+    if (err == LCB_SUCCESS && _traceSpan) {
+        err = lcbx_cmd_parent_span(cmd, _traceSpan.span());
+    }
+    if (err == LCB_SUCCESS) {
+        err = lcb_getreplica(instance, &_replica, cmd);
+    }
+    lcb_cmdgetreplica_destroy(cmd);
+    if (err == LCB_SUCCESS) {
+        _replicaPending = true;
+    }
+    return err;
+}
+
+void HedgedRead::onTimer(uv_timer_t *timer)
+{
+    HedgedRead *me = reinterpret_cast<HedgedRead *>(timer->data);
+    if (me->_done) {
+        return;
+    }
+
+    // Without a replica to read from (or the time to do so), the active
+    // get is all there is, so a failure here is not reported.
+    me->scheduleReplica();
+}
+
+void HedgedRead::onActive(lcb_INSTANCE *instance, const lcb_RESPGET *resp)
+{
+    _activePending = false;
+    if (_done) {
+        release();
+        return;
+    }
+
+    GetRespReader rdr(instance, resp);
+
+    lcb_STATUS rc = rdr.getValue<&lcb_respget_status>();
+    Local<Value> errVal = rdr.decodeError<lcb_respget_error_context>(rc);
+
+    if (rc != LCB_SUCCESS) {
+        // A missing document is authoritative, a replica could only return
+        // a copy which has since been removed.
+        if (rc != LCB_ERR_DOCUMENT_NOT_FOUND && _replicaPending) {
+            _activeErr.Reset(errVal);
+            return;
+        }
+
+        finish(errVal, Nan::Null());
+        return;
+    }
+
+    Local<Value> casVal = rdr.decodeCas<&lcb_respget_cas>();
+    Local<Value> valueVal;
+    {
+        Nan::TryCatch tryCatch;
+        valueVal = rdr.parseDocValue<&lcb_respget_value, &lcb_respget_flags,
+                                     &lcb_respget_backbuf>();
+        if (tryCatch.HasCaught()) {
+            errVal = tryCatch.Exception();
+        }
+    }
+
+    finish(errVal, KvResult::createGet(casVal, valueVal));
+}
+
+void HedgedRead::onReplica(lcb_INSTANCE *instance,
+                           const lcb_RESPGETREPLICA *resp)
+{
+    GetReplicaRespReader rdr(instance, resp);
+    if (!rdr.getValue<&lcb_respgetreplica_is_final>()) {
+        return;
+    }
+
+    _replicaPending = false;
+    if (_done) {
+        release();
+        return;
+    }
+
+    lcb_STATUS rc = rdr.getValue<&lcb_respgetreplica_status>();
+    if (rc != LCB_SUCCESS) {
+        // The active node decides, unless it has already failed.
+        if (!_activePending) {
+            finish(Nan::New(_activeErr), Nan::Null());
+        }
+        return;
+    }
+
+    Local<Value> errVal = Nan::Null();
+    Local<Value> casVal = rdr.decodeCas<&lcb_respgetreplica_cas>();
+    Local<Value> valueVal;
+    {
+        Nan::TryCatch tryCatch;
+        valueVal = rdr.parseDocValue<&lcb_respgetreplica_value,
+                                     &lcb_respgetreplica_flags,
+                                     &lcb_respgetreplica_backbuf>();
+        if (tryCatch.HasCaught()) {
+            errVal = tryCatch.Exception();
+        }
+    }
+
+    finish(errVal, KvResult::createGet(casVal, valueVal));
+}
+
+void HedgedRead::finish(Local<Value> errVal, Local<Value> resVal)
+{
+    _done = true;
+    if (_timer) {
+        uv_timer_stop(_timer);
+    }
+
+    Local<Value> args[] = {errVal, resVal};
+    _callback.Call(2, args, this);
+
+    release();
+}
+
+void HedgedRead::release()
+{
+    // The read which lost still holds a cookie, which libcouchbase will
+    // hand back once it completes.  Both reads are children of the span, so
+    // it must also outlive them.
+    if (!_activePending && !_replicaPending) {
+        _traceSpan.end();
+        delete this;
+    }
+}
+
+} // namespace couchnode
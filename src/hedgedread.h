@@ -0,0 +1,93 @@
+#pragma once
+#ifndef HEDGEDREAD_H
+#define HEDGEDREAD_H
+
+#include "opbuilder.h"
+#include <libcouchbase/couchbase.h>
+#include <nan.h>
+#include <node.h>
+#include <string>
+#include <uv.h>
+
+namespace couchnode
+{
+
+using namespace v8;
+
+// Races a get against the replicas of the document.  The get is sent to the
+// active node, and if it has not responded once the hedge delay has passed,
+// the document is also read from any replica.  Whichever read succeeds first
+// is reported to the callback as (err, result), the same as a get, and the
+// response of the other is dropped when it arrives.  A failure of the active
+// node, other than the document not existing, waits for the replica read in
+// case it can still answer.
+class HedgedRead : public Nan::AsyncResource
+{
+public:
+    HedgedRead(Connection *impl);
+    ~HedgedRead();
+
+    bool parseCollection(Local<Value> scope, Local<Value> collection);
+    bool parseKey(Local<Value> key);
+    bool parseTranscoder(Local<Value> transcoder);
+    bool parseTimeout(Local<Value> timeout);
+    bool parseParentSpan(Local<Value> parentSpan);
+    bool parseCallback(Local<Value> callback);
+
+    // The delay is the given percentile of recent get latencies, or the
+    // fallback (in microseconds) if there are none.  Without either, the
+    // read is not hedged at all.
+    bool parseDelay(Local<Value> percentile, Local<Value> fallbackDelay);
+
+    // Schedules the active get.  The read deletes itself once both reads
+    // have completed, but if this fails it is left to the caller.
+    lcb_STATUS start();
+
+    void onActive(lcb_INSTANCE *instance, const lcb_RESPGET *resp);
+    void onReplica(lcb_INSTANCE *instance, const lcb_RESPGETREPLICA *resp);
+
+    TraceSpan startDecodeTrace()
+    {
+        return TraceSpan::beginDecodeTrace(_impl, _traceSpan);
+    }
+
+    Local<Object> transcoder() const
+    {
+        return Nan::New(_transcoder);
+    }
+
+private:
+    lcb_STATUS scheduleReplica();
+    void finish(Local<Value> errVal, Local<Value> resVal);
+    void release();
+
+    static void onTimer(uv_timer_t *timer);
+
+    Connection *_impl;
+    Nan::Callback _callback;
+    Nan::Persistent<Object> _implRef;
+    Nan::Persistent<Object> _transcoder;
+    Nan::Persistent<Value> _activeErr;
+    WrappedRequestSpan *_parentSpan;
+    TraceSpan _traceSpan;
+
+    std::string _scope;
+    std::string _collection;
+    std::string _key;
+    bool _hasDeadline;
+    uint64_t _deadlineMs;
+    bool _hedged;
+    uint64_t _delayMs;
+
+    // The cookies handed to libcouchbase for each of the two reads.
+    OpCookieBase _active;
+    OpCookieBase _replica;
+    uv_timer_t *_timer;
+    bool _activePending;
+    bool _replicaPending;
+    bool _done;
+};
+
+} // namespace couchnode
+
+#endif // HEDGEDREAD_H
@@ -0,0 +1,82 @@
+#include "kvresult.h"
+
+#include <string>
+
+namespace couchnode
+{
+
+Local<Function> KvResult::define(Local<Object> target, const char *name,
+                                 std::initializer_list<Key> fields)
+{
+    Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>();
+    tpl->SetClassName(
+        Nan::New<String>(std::string("Cb") + name).ToLocalChecked());
+
+    Local<ObjectTemplate> instTpl = tpl->InstanceTemplate();
+    for (Key field : fields) {
+        Nan::SetTemplate(instTpl, key(field), Nan::Undefined());
+    }
+
+    Local<Function> fn = Nan::GetFunction(tpl).ToLocalChecked();
+    Nan::Set(target, Nan::New(name).ToLocalChecked(), fn);
+    return fn;
+}
+
+NAN_MODULE_INIT(KvResult::Init)
+{
+    AddonData *data = AddonData::current();
+
+    data->getResultConstructor.Reset(
+        define(target, "GetResult",
+               {Key::content, Key::cas, Key::expiryTime}));
+    data->existsResultConstructor.Reset(
+        define(target, "ExistsResult", {Key::exists, Key::cas}));
+    data->mutationResultConstructor.Reset(
+        define(target, "MutationResult", {Key::cas, Key::token}));
+    data->counterResultConstructor.Reset(define(
+        target, "CounterResult", {Key::value, Key::cas, Key::token}));
+}
+
+static inline Local<Object> newResult(const Nan::Persistent<Function> &ctor)
+{
+    return Nan::NewInstance(Nan::New<Function>(ctor)).ToLocalChecked();
+}
+
+Local<Value> KvResult::createGet(Local<Value> cas, Local<Value> content)
+{
+    Local<Object> res = newResult(AddonData::current()->getResultConstructor);
+    Nan::Set(res, key(Key::content), content);
+    Nan::Set(res, key(Key::cas), cas);
+    return res;
+}
+
+Local<Value> KvResult::createExists(Local<Value> cas, Local<Value> exists)
+{
+    Local<Object> res =
+        newResult(AddonData::current()->existsResultConstructor);
+    Nan::Set(res, key(Key::exists), exists);
+    Nan::Set(res, key(Key::cas), cas);
+    return res;
+}
+
+Local<Value> KvResult::createMutation(Local<Value> cas, Local<Value> token)
+{
+    Local<Object> res =
+        newResult(AddonData::current()->mutationResultConstructor);
+    Nan::Set(res, key(Key::cas), cas);
+    Nan::Set(res, key(Key::token), token);
+    return res;
+}
+
+Local<Value> KvResult::createCounter(Local<Value> cas, Local<Value> token,
+                                     Local<Value> value)
+{
+    Local<Object> res =
+        newResult(AddonData::current()->counterResultConstructor);
+    Nan::Set(res, key(Key::value), value);
+    Nan::Set(res, key(Key::cas), cas);
+    Nan::Set(res, key(Key::token), token);
+    return res;
+}
+
+} // namespace couchnode
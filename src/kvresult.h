@@ -0,0 +1,38 @@
+#pragma once
+#ifndef KVRESULT_H
+#define KVRESULT_H
+
+#include "addondata.h"
+#include <nan.h>
+#include <initializer_list>
+#include <node.h>
+
+namespace couchnode
+{
+
+using namespace v8;
+
+// Builds the results of the simple key-value operations.  Every field is
+// declared on the instance template up front, so all results of a kind share
+// one hidden class from the start rather than transitioning through a new
+// one for every property, as object literals built in JS do.  The SDK points
+// the prototypes of these at its own GetResult, ExistsResult, etc.
+class KvResult
+{
+public:
+    static NAN_MODULE_INIT(Init);
+
+    static Local<Value> createGet(Local<Value> cas, Local<Value> content);
+    static Local<Value> createExists(Local<Value> cas, Local<Value> exists);
+    static Local<Value> createMutation(Local<Value> cas, Local<Value> token);
+    static Local<Value> createCounter(Local<Value> cas, Local<Value> token,
+                                      Local<Value> value);
+
+private:
+    static Local<Function> define(Local<Object> target, const char *name,
+                                  std::initializer_list<Key> fields);
+};
+
+} // namespace couchnode
+
+#endif // KVRESULT_H
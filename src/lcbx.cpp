@@ -249,3 +249,10 @@ lcb_STATUS lcbx_cmd_parent_span(lcb_CMDDIAG *cmd, lcbtrace_SPAN *span)
 {
     return LCB_ERR_UNSUPPORTED_OPERATION;
 }
+
+lcb_STATUS lcbx_cmd_value_nocopy(lcb_CMDSTORE *cmd, const char *value,
+                                 size_t nvalue, void (*release)(void *),
+                                 void *cookie)
+{
+    return lcb_cmdstore_value_nocopy(cmd, value, nvalue, release, cookie);
+}
@@ -104,4 +104,16 @@ lcb_STATUS lcbx_cmd_parent_span(lcb_CMDHTTP *cmd, lcbtrace_SPAN *span);
 lcb_STATUS lcbx_cmd_parent_span(lcb_CMDPING *cmd, lcbtrace_SPAN *span);
 lcb_STATUS lcbx_cmd_parent_span(lcb_CMDDIAG *cmd, lcbtrace_SPAN *span);
 
+// Only stores can reference a value buffer in place, everything else reports
+// LCB_ERR_UNSUPPORTED_OPERATION without taking ownership of the buffer.
+template <typename CmdType>
+lcb_STATUS lcbx_cmd_value_nocopy(CmdType *cmd, const char *value, size_t nvalue,
+                                 void (*release)(void *), void *cookie)
+{
+    return LCB_ERR_UNSUPPORTED_OPERATION;
+}
+lcb_STATUS lcbx_cmd_value_nocopy(lcb_CMDSTORE *cmd, const char *value,
+                                 size_t nvalue, void (*release)(void *),
+                                 void *cookie);
+
 #endif // LCBX_H
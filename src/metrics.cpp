@@ -1,4 +1,5 @@
 #include "metrics.h"
+#include "error.h"
 
 namespace couchnode
 {
@@ -167,4 +168,119 @@ void ValueRecorder::recordValue(uint64_t value) const
     Nan::Call(recordValueImpl, impl, 1, argv);
 }
 
+NAN_MODULE_INIT(AggregatingMeter::Init)
+{
+    Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(fnNew);
+    tpl->SetClassName(Nan::New<String>("CbAggregatingMeter").ToLocalChecked());
+    tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+    Nan::SetPrototypeMethod(tpl, "snapshot", fnSnapshot);
+    Nan::SetPrototypeMethod(tpl, "drain", fnDrain);
+
+    templ().Reset(tpl);
+
+    Nan::Set(target, Nan::New("AggregatingMeter").ToLocalChecked(),
+             Nan::GetFunction(tpl).ToLocalChecked());
+}
+
+AggregatingMeter *AggregatingMeter::unwrap(Local<Value> val)
+{
+    if (!val->IsObject() || !Nan::New(templ())->HasInstance(val)) {
+        return nullptr;
+    }
+    return ObjectWrap::Unwrap<AggregatingMeter>(val.As<Object>());
+}
+
+AggregatingMeter::AggregatingMeter(lcbmetrics_METER *lcbMeter)
+    : _lcbMeter(lcbMeter)
+{
+}
+
+AggregatingMeter::~AggregatingMeter()
+{
+    lcbmetrics_meter_destroy(_lcbMeter);
+    _lcbMeter = nullptr;
+}
+
+const lcbmetrics_METER *AggregatingMeter::lcbProcs() const
+{
+    return _lcbMeter;
+}
+
+NAN_METHOD(AggregatingMeter::fnNew)
+{
+    Nan::HandleScope scope;
+
+    lcbmetrics_METER *lcbMeter = nullptr;
+    lcb_STATUS err = lcbmetrics_meter_create_aggregating(&lcbMeter);
+    if (err != LCB_SUCCESS) {
+        return Nan::ThrowError(Error::create(err));
+    }
+
+    AggregatingMeter *obj = new AggregatingMeter(lcbMeter);
+    obj->Wrap(info.This());
+
+    info.GetReturnValue().Set(info.This());
+}
+
+static void lcbMeterSummaryHandler(const lcbmetrics_SUMMARY *summary,
+                                   void *cookie)
+{
+    Local<Object> res = *reinterpret_cast<Local<Object> *>(cookie);
+
+    Local<String> svcKey = Nan::New(summary->service).ToLocalChecked();
+    Local<Value> svcVal = Nan::Get(res, svcKey).ToLocalChecked();
+    if (!svcVal->IsObject()) {
+        svcVal = Nan::New<Object>();
+        Nan::Set(res, svcKey, svcVal);
+    }
+
+    Local<Object> percentiles = Nan::New<Object>();
+    Nan::Set(percentiles, Nan::New("50.0").ToLocalChecked(),
+             Nan::New<Number>(static_cast<double>(summary->p50)));
+    Nan::Set(percentiles, Nan::New("90.0").ToLocalChecked(),
+             Nan::New<Number>(static_cast<double>(summary->p90)));
+    Nan::Set(percentiles, Nan::New("99.0").ToLocalChecked(),
+             Nan::New<Number>(static_cast<double>(summary->p99)));
+    Nan::Set(percentiles, Nan::New("99.9").ToLocalChecked(),
+             Nan::New<Number>(static_cast<double>(summary->p999)));
+    Nan::Set(percentiles, Nan::New("100.0").ToLocalChecked(),
+             Nan::New<Number>(static_cast<double>(summary->p100)));
+
+    Local<Object> opVal = Nan::New<Object>();
+    Nan::Set(opVal, Nan::New("totalCount").ToLocalChecked(),
+             Nan::New<Number>(static_cast<double>(summary->total_count)));
+    Nan::Set(opVal, Nan::New("percentiles").ToLocalChecked(), percentiles);
+
+    Nan::Set(svcVal.As<Object>(), Nan::New(summary->operation).ToLocalChecked(),
+             opVal);
+}
+
+Local<Object> AggregatingMeter::summarize(bool reset)
+{
+    Nan::EscapableHandleScope scope;
+
+    Local<Object> res = Nan::New<Object>();
+    lcbmetrics_meter_summarize(_lcbMeter, reset ? 1 : 0,
+                               &lcbMeterSummaryHandler, &res);
+
+    return scope.Escape(res);
+}
+
+NAN_METHOD(AggregatingMeter::fnSnapshot)
+{
+    AggregatingMeter *me = ObjectWrap::Unwrap<AggregatingMeter>(info.This());
+    Nan::HandleScope scope;
+
+    info.GetReturnValue().Set(me->summarize(false));
+}
+
+NAN_METHOD(AggregatingMeter::fnDrain)
+{
+    AggregatingMeter *me = ObjectWrap::Unwrap<AggregatingMeter>(info.This());
+    Nan::HandleScope scope;
+
+    info.GetReturnValue().Set(me->summarize(true));
+}
+
 } // namespace couchnode
@@ -2,6 +2,7 @@
 #ifndef METRICS_H
 #define METRICS_H
 
+#include "addondata.h"
 #include <libcouchbase/couchbase.h>
 #include <nan.h>
 #include <node.h>
@@ -47,6 +48,38 @@ protected:
     Nan::Persistent<Function> _recordValueImpl;
 };
 
+// A meter which aggregates operation latencies natively (see
+// lcbmetrics_meter_create_aggregating), exposed to JS so the aggregated values
+// can be read without a call into JS per recorded value.  A single instance
+// may be shared by any number of connections, each of which keeps a reference
+// to it for as long as its lcb instance exists.
+class AggregatingMeter : public Nan::ObjectWrap
+{
+public:
+    static NAN_MODULE_INIT(Init);
+
+    static inline Nan::Persistent<FunctionTemplate> &templ()
+    {
+        return AddonData::current()->aggregatingMeterTempl;
+    }
+
+    static AggregatingMeter *unwrap(Local<Value> val);
+
+    const lcbmetrics_METER *lcbProcs() const;
+
+private:
+    AggregatingMeter(lcbmetrics_METER *lcbMeter);
+    ~AggregatingMeter();
+
+    static NAN_METHOD(fnNew);
+    static NAN_METHOD(fnSnapshot);
+    static NAN_METHOD(fnDrain);
+
+    Local<Object> summarize(bool reset);
+
+    lcbmetrics_METER *_lcbMeter;
+};
+
 } // namespace couchnode
 
 #endif // METRICS_H
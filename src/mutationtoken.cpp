@@ -71,6 +71,44 @@ v8::Local<v8::Value> MutationToken::create(lcb_MUTATION_TOKEN token,
     return ret;
 }
 
+Local<Value> MutationTokenSlab::create(lcb_MUTATION_TOKEN token,
+                                       const char *bucketName)
+{
+#ifdef COUCHNODE_HAS_BIGINT
+    if (!lcb_mutation_token_is_valid(&token) || !bucketName) {
+        return Nan::Undefined();
+    }
+
+    if (_slab.IsEmpty() || _used == TokensPerSlab ||
+        _bucketName != bucketName) {
+        size_t nbytes = TokensPerSlab * TokenFields * sizeof(uint64_t);
+        char *data = static_cast<char *>(malloc(nbytes));
+        Local<Object> buf = Nan::NewBuffer(data, nbytes).ToLocalChecked();
+        Local<ArrayBuffer> slab = buf.As<Uint8Array>()->Buffer();
+        Nan::Set(slab, Nan::New<String>("bucketName").ToLocalChecked(),
+                 Nan::New<String>(bucketName).ToLocalChecked());
+
+        _slab.Reset(slab);
+        _data = reinterpret_cast<uint64_t *>(data);
+        _used = 0;
+        _bucketName = bucketName;
+    }
+
+    uint64_t *fields = _data + _used * TokenFields;
+    fields[0] = token.vbid_;
+    fields[1] = token.uuid_;
+    fields[2] = token.seqno_;
+
+    Local<ArrayBuffer> slab = Nan::New(_slab).As<ArrayBuffer>();
+    Local<Value> ret = BigUint64Array::New(
+        slab, _used * TokenFields * sizeof(uint64_t), TokenFields);
+    _used++;
+    return ret;
+#else
+    return MutationToken::create(token, bucketName);
+#endif
+}
+
 bool _StrToToken(Local<Value> obj, lcb_MUTATION_TOKEN *token, char *bucketName)
 {
     if (sscanf(*Nan::Utf8String(
@@ -2,9 +2,12 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include "addondata.h"
+#include "cas.h"
 #include <libcouchbase/couchbase.h>
 #include <nan.h>
 #include <node.h>
+#include <string>
 
 namespace couchnode
 {
@@ -24,8 +27,7 @@ public:
 
     static inline Nan::Persistent<Function> &constructor()
     {
-        static Nan::Persistent<Function> class_constructor;
-        return class_constructor;
+        return AddonData::current()->mutationTokenConstructor;
     }
 
 private:
@@ -33,6 +35,32 @@ private:
     static NAN_METHOD(fnInspect);
 };
 
+// Packs the mutation tokens of a connection into shared slabs.  Each token
+// is a BigUint64Array of [vbid, vbuuid, seqno] over the slab's ArrayBuffer,
+// which carries the bucket name, so a token costs one heap object rather
+// than a CbMutationToken and the Buffer holding its data.  A token keeps its
+// whole slab alive, so the slabs are kept small.
+class MutationTokenSlab
+{
+public:
+    enum { TokensPerSlab = 256, TokenFields = 3 };
+
+    v8::Local<v8::Value> create(lcb_MUTATION_TOKEN token,
+                                const char *bucketName);
+
+    void reset()
+    {
+        _slab.Reset();
+        _data = nullptr;
+    }
+
+private:
+    Nan::Persistent<Object> _slab;
+    uint64_t *_data{nullptr};
+    size_t _used{0};
+    std::string _bucketName;
+};
+
 } // namespace couchnode
 
 #endif // TOKEN_H
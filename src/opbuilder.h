@@ -2,28 +2,75 @@
 #ifndef OPBUILDER_H
 #define OPBUILDER_H
 
+#include "collectionref.h"
 #include "connection.h"
+#include "error.h"
 #include "lcbx.h"
+#include "rowbatcher.h"
 #include "tracespan.h"
 #include "tracing.h"
+#include "transcoder.h"
 #include "valueparser.h"
 #include <libcouchbase/couchbase.h>
+#include <memory>
+#include <vector>
 
 namespace couchnode
 {
 
 using namespace v8;
 
-class OpCookie : public Nan::AsyncResource
+class BatchCookie;
+class CasLoop;
+class HedgedRead;
+
+// Common base of every cookie handed to libcouchbase for an operation.  The
+// cookie either belongs to a single operation (an OpCookie), is one entry
+// of a BatchCookie, in which case _batch refers to the owning batch, is
+// the current step of a CasLoop, in which case _casLoop refers to it, or is
+// one of the two reads of a HedgedRead, in which case _hedgedRead does.
+class OpCookieBase
+{
+public:
+    OpCookieBase()
+        : _batch(nullptr)
+        , _batchIndex(0)
+        , _casLoop(nullptr)
+        , _hedgedRead(nullptr)
+    {
+    }
+
+    OpCookieBase(TraceSpan span)
+        : _batch(nullptr)
+        , _batchIndex(0)
+        , _casLoop(nullptr)
+        , _hedgedRead(nullptr)
+        , _traceSpan(span)
+    {
+    }
+
+    void endTrace()
+    {
+        _traceSpan.end();
+    }
+
+    BatchCookie *_batch;
+    uint32_t _batchIndex;
+    CasLoop *_casLoop;
+    HedgedRead *_hedgedRead;
+    TraceSpan _traceSpan;
+};
+
+class OpCookie : public OpCookieBase, public Nan::AsyncResource
 {
 public:
     OpCookie(Connection *impl, const Nan::Callback &callback,
              const Nan::Persistent<Object> &transcoder, TraceSpan span,
              WrappedRequestSpan *parentSpan)
-        : Nan::AsyncResource("couchbase::op")
+        : OpCookieBase(span)
+        , Nan::AsyncResource("couchbase::op")
         , _impl(impl)
         , _parentSpan(parentSpan)
-        , _traceSpan(span)
     {
         _implRef.Reset(_impl->persistent());
         _callback.Reset(callback.GetFunction());
@@ -45,14 +92,16 @@ public:
         }
     }
 
-    TraceSpan startDecodeTrace()
+    // Cookies live in their connection's cookie pool, and must be released
+    // through here rather than deleted.
+    static void destroy(OpCookie *cookie)
     {
-        return TraceSpan::beginDecodeTrace(_impl, _traceSpan);
+        cookie->_impl->cookiePool().destroy(cookie);
     }
 
-    void endTrace()
+    TraceSpan startDecodeTrace()
     {
-        _traceSpan.end();
+        return TraceSpan::beginDecodeTrace(_impl, _traceSpan);
     }
 
     Nan::AsyncResource *asyncContext()
@@ -70,7 +119,128 @@ public:
     Nan::Persistent<Object> _transcoder;
     Nan::Persistent<Object> _implRef;
     WrappedRequestSpan *_parentSpan;
-    TraceSpan _traceSpan;
+    std::unique_ptr<RowBatcher> _rowBatcher;
+};
+
+// A BatchCookie represents a group of operations which were scheduled
+// together and share a single callback and async context.  Each operation
+// is handed its own entry as its libcouchbase cookie, and the results of
+// each entry are stored into one array per callback argument.  Once every
+// entry has completed, the callback is invoked a single time with
+// (null, column0, column1, ...).
+class BatchCookie : public Nan::AsyncResource
+{
+public:
+    BatchCookie(Connection *impl, const Nan::Callback &callback,
+                const Nan::Persistent<Object> &transcoder,
+                WrappedRequestSpan *parentSpan, uint32_t numEntries,
+                uint32_t numColumns)
+        : Nan::AsyncResource("couchbase::batchop")
+        , _impl(impl)
+        , _parentSpan(parentSpan)
+        , _entries(numEntries)
+        , _numColumns(numColumns)
+        , _remaining(numEntries + 1)
+    {
+        _implRef.Reset(_impl->persistent());
+        _callback.Reset(callback.GetFunction());
+        _transcoder.Reset(transcoder);
+
+        Local<Array> columns = Nan::New<Array>(numColumns);
+        for (uint32_t i = 0; i < numColumns; ++i) {
+            Nan::Set(columns, i, Nan::New<Array>(numEntries));
+        }
+        _columns.Reset(columns);
+
+        for (uint32_t i = 0; i < numEntries; ++i) {
+            _entries[i]._batch = this;
+            _entries[i]._batchIndex = i;
+        }
+    }
+
+    ~BatchCookie()
+    {
+        _implRef.Reset();
+        _callback.Reset();
+        _transcoder.Reset();
+        _columns.Reset();
+
+        if (_parentSpan) {
+            delete _parentSpan;
+            _parentSpan = nullptr;
+        }
+    }
+
+    OpCookieBase *entry(uint32_t index)
+    {
+        return &_entries[index];
+    }
+
+    uint32_t size() const
+    {
+        return static_cast<uint32_t>(_entries.size());
+    }
+
+    TraceSpan startDecodeTrace(OpCookieBase *entry)
+    {
+        return TraceSpan::beginDecodeTrace(_impl, entry->_traceSpan);
+    }
+
+    Nan::AsyncResource *asyncContext()
+    {
+        return static_cast<Nan::AsyncResource *>(this);
+    }
+
+    // Stores the results of one entry, any columns which are not provided
+    // are set to null.  Note that this may destroy the batch.
+    void completeEntry(OpCookieBase *entry, int argc, Local<Value> argv[])
+    {
+        entry->endTrace();
+
+        Local<Array> columns = Nan::New(_columns);
+        for (uint32_t i = 0; i < _numColumns; ++i) {
+            Local<Object> column =
+                Nan::Get(columns, i).ToLocalChecked().As<Object>();
+            if (static_cast<int>(i) < argc) {
+                Nan::Set(column, entry->_batchIndex, argv[i]);
+            } else {
+                Nan::Set(column, entry->_batchIndex, Nan::Null());
+            }
+        }
+
+        release();
+    }
+
+    // The batch holds one additional reference while it is being scheduled
+    // so that entries which fail synchronously cannot complete it early.
+    void release()
+    {
+        if (--_remaining > 0) {
+            return;
+        }
+
+        Local<Array> columns = Nan::New(_columns);
+        std::vector<Local<Value>> argsArr;
+        argsArr.push_back(Nan::Null());
+        for (uint32_t i = 0; i < _numColumns; ++i) {
+            argsArr.push_back(Nan::Get(columns, i).ToLocalChecked());
+        }
+
+        _callback.Call(static_cast<int>(argsArr.size()), argsArr.data(),
+                       asyncContext());
+
+        delete this;
+    }
+
+    Connection *_impl;
+    Nan::Callback _callback;
+    Nan::Persistent<Object> _transcoder;
+    Nan::Persistent<Object> _implRef;
+    Nan::Persistent<Array> _columns;
+    WrappedRequestSpan *_parentSpan;
+    std::vector<OpCookieBase> _entries;
+    uint32_t _numColumns;
+    uint32_t _remaining;
 };
 
 template <typename CmdType>
@@ -201,6 +371,33 @@ public:
         return SetFn(_cmd, bytesa, nbytesa, bytesb, nbytesb) == LCB_SUCCESS;
     }
 
+    // Collections are passed either as a CollectionRef, which already knows
+    // the names and usually the collection ID, or as scope/collection names.
+    template <lcb_STATUS (*SetFn)(CmdType *, const char *, size_t, const char *,
+                                  size_t),
+              lcb_STATUS (*SetIdFn)(CmdType *, uint32_t)>
+    bool parseCollection(lcb_INSTANCE *instance, Local<Value> scope,
+                         Local<Value> collection)
+    {
+        CollectionRef *ref = CollectionRef::unwrap(scope);
+        if (!ref) {
+            return parseOption<SetFn>(scope, collection);
+        }
+
+        const std::string &scopeName = ref->scopeName();
+        const std::string &collectionName = ref->collectionName();
+        if (SetFn(_cmd, scopeName.data(), scopeName.size(),
+                  collectionName.data(), collectionName.size()) != LCB_SUCCESS) {
+            return false;
+        }
+
+        uint32_t cid;
+        if (ref->collectionId(instance, &cid)) {
+            return SetIdFn(_cmd, cid) == LCB_SUCCESS;
+        }
+        return true;
+    }
+
     template <lcb_STATUS (*SetFn)(lcb_SUBDOCSPECS *, size_t, uint32_t,
                                   const char *, size_t)>
     bool parseOption(size_t index, Local<Value> flags, Local<Value> value)
@@ -271,12 +468,118 @@ public:
                      parsedValue) == LCB_SUCCESS;
     }
 
+    // Encodes a document value using the passed transcoder and applies the
+    // resulting bytes and flags to the command.
+    template <lcb_STATUS (*BytesFn)(CmdType *, const char *, size_t),
+              lcb_STATUS (*FlagsFn)(CmdType *, uint32_t)>
+    bool encodeDocValue(Local<Object> transcoderObj, Local<Value> value)
+    {
+        Nan::MaybeLocal<Value> encodeFnValM =
+            Nan::Get(transcoderObj, key(Key::encode));
+        if (encodeFnValM.IsEmpty()) {
+            return false;
+        }
+
+        Nan::MaybeLocal<Function> encodeFnM =
+            Nan::To<Function>(encodeFnValM.ToLocalChecked());
+        if (encodeFnM.IsEmpty()) {
+            return false;
+        }
+
+        Local<Function> encodeFn = encodeFnM.ToLocalChecked();
+
+        if (DefaultTranscoder::isEncodeFn(encodeFn) &&
+            DefaultTranscoder::canEncode(value)) {
+            return _encodeDefaultDocValue<BytesFn, FlagsFn>(value);
+        }
+
+        Local<Value> argsArr[] = {value};
+        Nan::MaybeLocal<Value> resValM =
+            Nan::CallAsFunction(encodeFn, transcoderObj, 1, argsArr);
+        if (resValM.IsEmpty()) {
+            return false;
+        }
+
+        Nan::MaybeLocal<Object> resArrM =
+            Nan::To<Object>(resValM.ToLocalChecked());
+        if (resArrM.IsEmpty()) {
+            return false;
+        }
+
+        Local<Object> resArr = resArrM.ToLocalChecked();
+
+        Nan::MaybeLocal<Value> valueValM = Nan::Get(resArr, 0);
+        if (valueValM.IsEmpty()) {
+            return false;
+        }
+        Local<Value> valueVal = valueValM.ToLocalChecked();
+
+        Nan::MaybeLocal<Value> flagsValM = Nan::Get(resArr, 1);
+        if (flagsValM.IsEmpty()) {
+            return false;
+        }
+        Local<Value> flagsVal = flagsValM.ToLocalChecked();
+
+        if (!_parseDocBytes<BytesFn>(valueVal)) {
+            return false;
+        }
+        if (!parseOption<FlagsFn>(flagsVal)) {
+            return false;
+        }
+        return true;
+    }
+
     CmdType *cmd()
     {
         return _cmd;
     }
 
 protected:
+    template <lcb_STATUS (*BytesFn)(CmdType *, const char *, size_t),
+              lcb_STATUS (*FlagsFn)(CmdType *, uint32_t)>
+    bool _encodeDefaultDocValue(Local<Value> value)
+    {
+        const char *bytes;
+        size_t nbytes;
+        uint32_t flags;
+        if (!DefaultTranscoder::encode(_valueParser, value, &bytes, &nbytes,
+                                       &flags)) {
+            return false;
+        }
+
+        if (node::Buffer::HasInstance(value)) {
+            if (!_parseDocBytes<BytesFn>(value)) {
+                return false;
+            }
+        } else if (bytes != nullptr && nbytes != 0) {
+            // Don't call the LCB function if the value is blank.
+            if (BytesFn(_cmd, bytes, nbytes) != LCB_SUCCESS) {
+                return false;
+            }
+        }
+        return FlagsFn(_cmd, flags) == LCB_SUCCESS;
+    }
+
+    // Large Buffers are handed to libcouchbase in place where the command
+    // supports it, anything else is copied as usual.
+    template <lcb_STATUS (*BytesFn)(CmdType *, const char *, size_t)>
+    bool _parseDocBytes(Local<Value> value)
+    {
+        if (node::Buffer::HasInstance(value) &&
+            node::Buffer::Length(value) >= PinnedBuffer::MIN_SIZE) {
+            PinnedBuffer *pin = new PinnedBuffer(value.As<Object>());
+            lcb_STATUS err =
+                lcbx_cmd_value_nocopy(_cmd, pin->data(), pin->length(),
+                                      &PinnedBuffer::release, pin);
+            if (err != LCB_ERR_UNSUPPORTED_OPERATION) {
+                return err == LCB_SUCCESS;
+            }
+            delete pin;
+        }
+
+        return parseOption<BytesFn>(value);
+    }
+
     template <typename T, lcb_STATUS (*SetFn)(CmdType *, T)>
     bool _parseIntOption(Local<Value> value)
     {
@@ -309,19 +612,17 @@ protected:
     ValueParser &_valueParser;
 };
 
-template <typename CmdType>
-class OpBuilder : public CmdBuilder<CmdType>
+class OpBuilderBase
 {
 public:
-    template <typename... Ts>
-    OpBuilder(Connection *impl, Ts... args)
-        : CmdBuilder<CmdType>(_valueParser, args...)
-        , _impl(impl)
+    OpBuilderBase(Connection *impl)
+        : _impl(impl)
+        , _valueParser(impl->scratch())
         , _parentSpan(nullptr)
     {
     }
 
-    ~OpBuilder()
+    ~OpBuilderBase()
     {
         _callback.Reset();
         _transcoder.Reset();
@@ -379,62 +680,54 @@ public:
         return true;
     }
 
-    template <lcb_STATUS (*BytesFn)(CmdType *, const char *, size_t),
-              lcb_STATUS (*FlagsFn)(CmdType *, uint32_t)>
-    bool parseDocValue(Local<Value> value)
+    void beginTrace(lcbtrace_SERVICE service, const char *opName)
     {
-        ScopedTraceSpan encSpan = this->startEncodeTrace();
-
-        Local<Object> transcoderObj = Nan::New(this->_transcoder);
-
-        Nan::MaybeLocal<Value> encodeFnValM =
-            Nan::Get(transcoderObj, Nan::New("encode").ToLocalChecked());
-        if (encodeFnValM.IsEmpty()) {
-            return false;
-        }
+        _traceSpan = beginChildTrace(service, opName);
+    }
 
-        Nan::MaybeLocal<Function> encodeFnM =
-            Nan::To<Function>(encodeFnValM.ToLocalChecked());
-        if (encodeFnM.IsEmpty()) {
-            return false;
+    TraceSpan beginChildTrace(lcbtrace_SERVICE service, const char *opName)
+    {
+        TraceSpan parentSpan;
+        if (_parentSpan && *_parentSpan) {
+            parentSpan = TraceSpan::wrap(_parentSpan->span());
         }
 
-        Local<Function> encodeFn = encodeFnM.ToLocalChecked();
-
-        Local<Value> argsArr[] = {value};
-        Nan::MaybeLocal<Value> resValM =
-            Nan::CallAsFunction(encodeFn, transcoderObj, 1, argsArr);
-        if (resValM.IsEmpty()) {
-            return false;
-        }
+        return TraceSpan::beginOpTrace(_impl, service, opName, parentSpan);
+    }
 
-        Nan::MaybeLocal<Object> resArrM =
-            Nan::To<Object>(resValM.ToLocalChecked());
-        if (resArrM.IsEmpty()) {
-            return false;
-        }
+    ValueParser &valueParser()
+    {
+        return _valueParser;
+    }
 
-        Local<Object> resArr = resArrM.ToLocalChecked();
+protected:
+    Connection *_impl;
+    ValueParser _valueParser;
+    Nan::Callback _callback;
+    Nan::Persistent<Object> _transcoder;
+    WrappedRequestSpan *_parentSpan;
+    TraceSpan _traceSpan;
+};
 
-        Nan::MaybeLocal<Value> valueValM = Nan::Get(resArr, 0);
-        if (valueValM.IsEmpty()) {
-            return false;
-        }
-        Local<Value> valueVal = valueValM.ToLocalChecked();
+template <typename CmdType>
+class OpBuilder : public OpBuilderBase, public CmdBuilder<CmdType>
+{
+public:
+    template <typename... Ts>
+    OpBuilder(Connection *impl, Ts... args)
+        : OpBuilderBase(impl)
+        , CmdBuilder<CmdType>(_valueParser, args...)
+    {
+    }
 
-        Nan::MaybeLocal<Value> flagsValM = Nan::Get(resArr, 1);
-        if (flagsValM.IsEmpty()) {
-            return false;
-        }
-        Local<Value> flagsVal = flagsValM.ToLocalChecked();
+    template <lcb_STATUS (*BytesFn)(CmdType *, const char *, size_t),
+              lcb_STATUS (*FlagsFn)(CmdType *, uint32_t)>
+    bool parseDocValue(Local<Value> value)
+    {
+        ScopedTraceSpan encSpan = this->startEncodeTrace();
 
-        if (!this->template parseOption<BytesFn>(valueVal)) {
-            return false;
-        }
-        if (!this->template parseOption<FlagsFn>(flagsVal)) {
-            return false;
-        }
-        return true;
+        return this->template encodeDocValue<BytesFn, FlagsFn>(
+            Nan::New(this->_transcoder), value);
     }
 
     template <typename SubCmdType, typename... Ts>
@@ -443,21 +736,20 @@ public:
         return CmdBuilder<SubCmdType>(this->_valueParser, args...);
     }
 
-    void beginTrace(lcbtrace_SERVICE service, const char *opName)
+    // Streaming requests only: deliver rows in parsed batches of up to this
+    // many rows, see RowBatcher.
+    bool parseRowBatchSize(Local<Value> value)
     {
-        TraceSpan parentSpan;
-        if (_parentSpan && *_parentSpan) {
-            parentSpan = TraceSpan::wrap(_parentSpan->span());
-        }
-
-        TraceSpan span =
-            TraceSpan::beginOpTrace(_impl, service, opName, parentSpan);
-        _traceSpan = span;
+        return ValueParser::parseUint(&_rowBatchSize, value);
     }
 
-    ValueParser &valueParser()
+    // The JS handle of the row stream created by execute(), if any.
+    Local<Value> rowStream() const
     {
-        return _valueParser;
+        if (_rowStream.IsEmpty()) {
+            return Nan::Undefined();
+        }
+        return _rowStream;
     }
 
     template <lcb_STATUS (*ExecFn)(lcb_INSTANCE *, void *, const CmdType *)>
@@ -471,31 +763,107 @@ public:
             }
         }
 
-        OpCookie *cookie =
-            new OpCookie(this->_impl, this->_callback, this->_transcoder,
-                         this->_traceSpan, this->_parentSpan);
+        OpCookie *cookie = this->_impl->cookiePool().create(
+            this->_impl, this->_callback, this->_transcoder, this->_traceSpan,
+            this->_parentSpan);
 
         // ownership of the parent span wrapper transfers to the opcookie
         _parentSpan = nullptr;
 
-        lcb_STATUS err = ExecFn(this->_impl->lcbHandle(), cookie, this->cmd());
+        if (_rowBatchSize > 0) {
+            cookie->_rowBatcher.reset(new RowBatcher(cookie, _rowBatchSize));
+            _rowStream = cookie->_rowBatcher->streamHandle();
+        }
+
+        // Response handlers expect an OpCookieBase, which is not necessarily
+        // at the same address as the OpCookie itself.
+        lcb_STATUS err =
+            ExecFn(this->_impl->lcbHandle(),
+                   static_cast<OpCookieBase *>(cookie), this->cmd());
         if (err != LCB_SUCCESS) {
             // If the result was unsuccessful, we need to destroy the cookie
             // since we won't see it in any callbacks.
-            delete cookie;
+            OpCookie::destroy(cookie);
         }
 
         return err;
     }
 
+private:
+    uint32_t _rowBatchSize{0};
+    Local<Value> _rowStream;
+};
+
+// Builds a batch of commands of the same type which are scheduled together
+// within a single libcouchbase scheduling context, and whose results are
+// delivered through a single BatchCookie.  All of the commands are parsed
+// before any are scheduled so that argument errors can be thrown without
+// leaving part of the batch in flight.
+template <typename CmdType>
+class BatchOpBuilder : public OpBuilderBase
+{
+public:
+    BatchOpBuilder(Connection *impl)
+        : OpBuilderBase(impl)
+    {
+    }
+
+    template <typename... Ts>
+    CmdBuilder<CmdType> &addCmd(Ts... args)
+    {
+        _cmds.emplace_back(new CmdBuilder<CmdType>(_valueParser, args...));
+        return *_cmds.back();
+    }
+
+    template <lcb_STATUS (*BytesFn)(CmdType *, const char *, size_t),
+              lcb_STATUS (*FlagsFn)(CmdType *, uint32_t)>
+    bool parseDocValue(CmdBuilder<CmdType> &cmd, Local<Value> value)
+    {
+        return cmd.template encodeDocValue<BytesFn, FlagsFn>(
+            Nan::New(_transcoder), value);
+    }
+
+    // Commands which libcouchbase refuses to schedule are completed
+    // immediately with the error, without affecting the rest of the batch.
+    template <lcb_STATUS (*ExecFn)(lcb_INSTANCE *, void *, const CmdType *)>
+    void execute(lcbtrace_SERVICE service, const char *opName,
+                 uint32_t numColumns)
+    {
+        lcb_INSTANCE *instance = _impl->lcbHandle();
+
+        BatchCookie *batch =
+            new BatchCookie(_impl, _callback, _transcoder, _parentSpan,
+                            static_cast<uint32_t>(_cmds.size()), numColumns);
+
+        lcb_sched_enter(instance);
+        for (uint32_t i = 0; i < batch->size(); ++i) {
+            OpCookieBase *entry = batch->entry(i);
+            CmdType *cmd = _cmds[i]->cmd();
+
+            entry->_traceSpan = beginChildTrace(service, opName);
+
+            lcb_STATUS err = LCB_SUCCESS;
+            if (entry->_traceSpan) {
+                err = lcbx_cmd_parent_span(cmd, entry->_traceSpan.span());
+            }
+            if (err == LCB_SUCCESS) {
+                err = ExecFn(instance, entry, cmd);
+            }
+            if (err != LCB_SUCCESS) {
+                Local<Value> errVal = Error::create(err);
+                batch->completeEntry(entry, 1, &errVal);
+            }
+        }
+        lcb_sched_leave(instance);
+
+        // ownership of the parent span wrapper transfers to the batch
+        _parentSpan = nullptr;
+
+        batch->release();
+    }
+
 protected:
-    Connection *_impl;
-    ValueParser _valueParser;
-    std::vector<Nan::Utf8String *> _strings;
-    Nan::Callback _callback;
-    Nan::Persistent<Object> _transcoder;
-    WrappedRequestSpan *_parentSpan;
-    TraceSpan _traceSpan;
+    std::vector<std::unique_ptr<CmdBuilder<CmdType>>> _cmds;
 };
 
 } // namespace couchnode
@@ -0,0 +1,161 @@
+#pragma once
+#ifndef POOL_H
+#define POOL_H
+
+#include <memory>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace couchnode
+{
+
+/**
+ * Recycles the storage of objects of a single type rather than returning it
+ * to the heap, so that objects created once per operation (such as cookies)
+ * do not cost an allocation each.  Up to MaxFree blocks are kept for reuse.
+ *
+ * T may be incomplete wherever the pool is only declared or destroyed.
+ */
+template <typename T, size_t MaxFree = 1024>
+class ObjectPool
+{
+public:
+    ObjectPool()
+        : _numAllocs(0)
+    {
+    }
+
+    ~ObjectPool()
+    {
+        for (void *block : _free) {
+            ::operator delete(block);
+        }
+    }
+
+    template <typename... Ts>
+    T *create(Ts &&... args)
+    {
+        void *block;
+        if (!_free.empty()) {
+            block = _free.back();
+            _free.pop_back();
+        } else {
+            block = ::operator new(sizeof(T));
+            _numAllocs++;
+        }
+        return new (block) T(std::forward<Ts>(args)...);
+    }
+
+    void destroy(T *obj)
+    {
+        obj->~T();
+        if (_free.size() < MaxFree) {
+            _free.push_back(obj);
+        } else {
+            ::operator delete(obj);
+        }
+    }
+
+    // The number of blocks which had to be allocated from the heap.
+    uint64_t numAllocs() const
+    {
+        return _numAllocs;
+    }
+
+private:
+    std::vector<void *> _free;
+    uint64_t _numAllocs;
+};
+
+/**
+ * Scratch memory for the strings parsed out of the arguments of an operation,
+ * which are only needed until the operation has been scheduled.  Memory is
+ * handed out of chunks which are kept for reuse, and released in LIFO order
+ * by rewinding to a previously taken mark.  Nested users (for instance an
+ * operation started from within a transcoder) each rewind only their own
+ * allocations.
+ */
+class ScratchArena
+{
+public:
+    // Strings larger than a chunk are allocated (and freed) individually.
+    static const size_t CHUNK_SIZE = 16 * 1024;
+
+    struct Mark {
+        size_t chunk;
+        size_t offset;
+        size_t numLarge;
+    };
+
+    ScratchArena()
+        : _chunk(0)
+        , _offset(0)
+        , _numAllocs(0)
+    {
+    }
+
+    Mark mark() const
+    {
+        return Mark{_chunk, _offset, _large.size()};
+    }
+
+    void rewind(const Mark &mark)
+    {
+        _chunk = mark.chunk;
+        _offset = mark.offset;
+        _large.resize(mark.numLarge);
+    }
+
+    char *allocate(size_t size)
+    {
+        if (size > CHUNK_SIZE) {
+            _large.emplace_back(new char[size]);
+            _numAllocs++;
+            return _large.back().get();
+        }
+
+        if (_chunk < _chunks.size() && _offset + size > CHUNK_SIZE) {
+            _chunk++;
+            _offset = 0;
+        }
+        if (_chunk == _chunks.size()) {
+            _chunks.emplace_back(new char[CHUNK_SIZE]);
+            _numAllocs++;
+        }
+
+        char *ptr = _chunks[_chunk].get() + _offset;
+        _offset += size;
+        return ptr;
+    }
+
+    // Returns the unused tail of the most recent allocation to the arena.
+    void shrink(char *ptr, size_t size, size_t newSize)
+    {
+        if (size > CHUNK_SIZE || _chunk >= _chunks.size()) {
+            return;
+        }
+        if (ptr + size == _chunks[_chunk].get() + _offset) {
+            _offset -= size - newSize;
+        }
+    }
+
+    // The number of chunks and large strings allocated from the heap.
+    uint64_t numAllocs() const
+    {
+        return _numAllocs;
+    }
+
+private:
+    std::vector<std::unique_ptr<char[]>> _chunks;
+    std::vector<std::unique_ptr<char[]>> _large;
+    size_t _chunk;
+    size_t _offset;
+    uint64_t _numAllocs;
+};
+
+} // namespace couchnode
+
+#endif // POOL_H
@@ -3,6 +3,7 @@
 #define RESPREADER_H
 
 #include "connection.h"
+#include "hedgedread.h"
 #include "opbuilder.h"
 
 namespace couchnode
@@ -96,10 +97,12 @@ public:
         : _instance(instance)
         , _resp(resp)
     {
-        lcb_STATUS rc = CookieFn(_resp, reinterpret_cast<void **>(&_cookie));
+        void *cookie = nullptr;
+        lcb_STATUS rc = CookieFn(_resp, &cookie);
         if (rc != LCB_SUCCESS) {
-            _cookie = nullptr;
+            cookie = nullptr;
         }
+        _cookie = static_cast<OpCookieBase *>(cookie);
     }
 
     Connection *connection() const
@@ -107,9 +110,31 @@ public:
         return Connection::fromInstance(_instance);
     }
 
+    // Returns the cookie of an individually executed operation, or nullptr
+    // if this response belongs to an entry of a batch, a step of a loop or
+    // one of the reads of a hedged read.
     OpCookie *cookie() const
     {
-        return _cookie;
+        if (!_cookie || _cookie->_batch || _cookie->_casLoop ||
+            _cookie->_hedgedRead) {
+            return nullptr;
+        }
+        return static_cast<OpCookie *>(_cookie);
+    }
+
+    BatchCookie *batch() const
+    {
+        return _cookie ? _cookie->_batch : nullptr;
+    }
+
+    CasLoop *casLoop() const
+    {
+        return _cookie ? _cookie->_casLoop : nullptr;
+    }
+
+    HedgedRead *hedgedRead() const
+    {
+        return _cookie ? _cookie->_hedgedRead : nullptr;
     }
 
     template <lcb_STATUS (*GetFn)(const RespType *)>
@@ -187,25 +212,24 @@ public:
         Local<Object> errValObj = errVal.As<Object>();
 
         CtxReader<RespType, lcb_KEY_VALUE_ERROR_CONTEXT, CtxFn> ctxRdr(_resp);
-        Nan::Set(errValObj, Nan::New<String>("ctxtype").ToLocalChecked(),
-                 Nan::New<String>("kv").ToLocalChecked());
-        Nan::Set(errValObj, Nan::New<String>("status_code").ToLocalChecked(),
+        Nan::Set(errValObj, key(Key::ctxtype), key(Key::kv));
+        Nan::Set(errValObj, key(Key::status_code),
                  ctxRdr.template parseValue<&lcb_errctx_kv_status_code>());
-        Nan::Set(errValObj, Nan::New<String>("opaque").ToLocalChecked(),
+        Nan::Set(errValObj, key(Key::opaque),
                  ctxRdr.template parseValue<&lcb_errctx_kv_opaque>());
-        Nan::Set(errValObj, Nan::New<String>("cas").ToLocalChecked(),
+        Nan::Set(errValObj, key(Key::cas),
                  ctxRdr.template decodeCas<&lcb_errctx_kv_cas>());
-        Nan::Set(errValObj, Nan::New<String>("key").ToLocalChecked(),
+        Nan::Set(errValObj, key(Key::key),
                  ctxRdr.template parseValue<&lcb_errctx_kv_key>());
-        Nan::Set(errValObj, Nan::New<String>("bucket").ToLocalChecked(),
+        Nan::Set(errValObj, key(Key::bucket),
                  ctxRdr.template parseValue<&lcb_errctx_kv_bucket>());
-        Nan::Set(errValObj, Nan::New<String>("collection").ToLocalChecked(),
+        Nan::Set(errValObj, key(Key::collection),
                  ctxRdr.template parseValue<&lcb_errctx_kv_collection>());
-        Nan::Set(errValObj, Nan::New<String>("scope").ToLocalChecked(),
+        Nan::Set(errValObj, key(Key::scope),
                  ctxRdr.template parseValue<&lcb_errctx_kv_scope>());
-        Nan::Set(errValObj, Nan::New<String>("context").ToLocalChecked(),
+        Nan::Set(errValObj, key(Key::context),
                  ctxRdr.template parseValue<&lcb_errctx_kv_context>());
-        Nan::Set(errValObj, Nan::New<String>("ref").ToLocalChecked(),
+        Nan::Set(errValObj, key(Key::ref),
                  ctxRdr.template parseValue<&lcb_errctx_kv_ref>());
 
         return errVal;
@@ -223,26 +247,25 @@ public:
         Local<Object> errValObj = errVal.As<Object>();
 
         CtxReader<RespType, lcb_VIEW_ERROR_CONTEXT, CtxFn> ctxRdr(_resp);
-        Nan::Set(errValObj, Nan::New<String>("ctxtype").ToLocalChecked(),
-                 Nan::New<String>("views").ToLocalChecked());
+        Nan::Set(errValObj, key(Key::ctxtype), key(Key::views));
         Nan::Set(
-            errValObj, Nan::New<String>("first_error_code").ToLocalChecked(),
+            errValObj, key(Key::first_error_code),
             ctxRdr.template parseValue<&lcb_errctx_view_first_error_code>());
         Nan::Set(
-            errValObj, Nan::New<String>("first_error_message").ToLocalChecked(),
+            errValObj, key(Key::first_error_message),
             ctxRdr.template parseValue<&lcb_errctx_view_first_error_message>());
         Nan::Set(
-            errValObj, Nan::New<String>("design_document").ToLocalChecked(),
+            errValObj, key(Key::design_document),
             ctxRdr.template parseValue<&lcb_errctx_view_design_document>());
-        Nan::Set(errValObj, Nan::New<String>("view").ToLocalChecked(),
+        Nan::Set(errValObj, key(Key::view),
                  ctxRdr.template parseValue<&lcb_errctx_view_view>());
-        Nan::Set(errValObj, Nan::New<String>("parameters").ToLocalChecked(),
+        Nan::Set(errValObj, key(Key::parameters),
                  ctxRdr.template parseValue<&lcb_errctx_view_query_params>());
         Nan::Set(
-            errValObj, Nan::New<String>("http_response_code").ToLocalChecked(),
+            errValObj, key(Key::http_response_code),
             ctxRdr.template parseValue<&lcb_errctx_view_http_response_code>());
         Nan::Set(
-            errValObj, Nan::New<String>("http_response_body").ToLocalChecked(),
+            errValObj, key(Key::http_response_body),
             ctxRdr.template parseValue<&lcb_errctx_view_http_response_body>());
 
         return errVal;
@@ -260,27 +283,26 @@ public:
         Local<Object> errValObj = errVal.As<Object>();
 
         CtxReader<RespType, lcb_QUERY_ERROR_CONTEXT, CtxFn> ctxRdr(_resp);
-        Nan::Set(errValObj, Nan::New<String>("ctxtype").ToLocalChecked(),
-                 Nan::New<String>("query").ToLocalChecked());
+        Nan::Set(errValObj, key(Key::ctxtype), key(Key::query));
         Nan::Set(
-            errValObj, Nan::New<String>("first_error_code").ToLocalChecked(),
+            errValObj, key(Key::first_error_code),
             ctxRdr.template parseValue<&lcb_errctx_query_first_error_code>());
         Nan::Set(
-            errValObj, Nan::New<String>("first_error_message").ToLocalChecked(),
+            errValObj, key(Key::first_error_message),
             ctxRdr
                 .template parseValue<&lcb_errctx_query_first_error_message>());
-        Nan::Set(errValObj, Nan::New<String>("statement").ToLocalChecked(),
+        Nan::Set(errValObj, key(Key::statement),
                  ctxRdr.template parseValue<&lcb_errctx_query_statement>());
         Nan::Set(
-            errValObj, Nan::New<String>("client_context_id").ToLocalChecked(),
+            errValObj, key(Key::client_context_id),
             ctxRdr.template parseValue<&lcb_errctx_query_client_context_id>());
-        Nan::Set(errValObj, Nan::New<String>("parameters").ToLocalChecked(),
+        Nan::Set(errValObj, key(Key::parameters),
                  ctxRdr.template parseValue<&lcb_errctx_query_query_params>());
         Nan::Set(
-            errValObj, Nan::New<String>("http_response_code").ToLocalChecked(),
+            errValObj, key(Key::http_response_code),
             ctxRdr.template parseValue<&lcb_errctx_query_http_response_code>());
         Nan::Set(
-            errValObj, Nan::New<String>("http_response_body").ToLocalChecked(),
+            errValObj, key(Key::http_response_body),
             ctxRdr.template parseValue<&lcb_errctx_query_http_response_body>());
 
         return errVal;
@@ -298,23 +320,22 @@ public:
         Local<Object> errValObj = errVal.As<Object>();
 
         CtxReader<RespType, lcb_SEARCH_ERROR_CONTEXT, CtxFn> ctxRdr(_resp);
-        Nan::Set(errValObj, Nan::New<String>("ctxtype").ToLocalChecked(),
-                 Nan::New<String>("search").ToLocalChecked());
+        Nan::Set(errValObj, key(Key::ctxtype), key(Key::search));
         Nan::Set(
-            errValObj, Nan::New<String>("error_message").ToLocalChecked(),
+            errValObj, key(Key::error_message),
             ctxRdr.template parseValue<&lcb_errctx_search_error_message>());
-        Nan::Set(errValObj, Nan::New<String>("index_name").ToLocalChecked(),
+        Nan::Set(errValObj, key(Key::index_name),
                  ctxRdr.template parseValue<&lcb_errctx_search_index_name>());
-        Nan::Set(errValObj, Nan::New<String>("query").ToLocalChecked(),
+        Nan::Set(errValObj, key(Key::query),
                  ctxRdr.template parseValue<&lcb_errctx_search_query>());
-        Nan::Set(errValObj, Nan::New<String>("parameters").ToLocalChecked(),
+        Nan::Set(errValObj, key(Key::parameters),
                  ctxRdr.template parseValue<&lcb_errctx_search_params>());
         Nan::Set(
-            errValObj, Nan::New<String>("http_response_code").ToLocalChecked(),
+            errValObj, key(Key::http_response_code),
             ctxRdr
                 .template parseValue<&lcb_errctx_search_http_response_code>());
         Nan::Set(
-            errValObj, Nan::New<String>("http_response_body").ToLocalChecked(),
+            errValObj, key(Key::http_response_body),
             ctxRdr
                 .template parseValue<&lcb_errctx_search_http_response_body>());
 
@@ -333,28 +354,27 @@ public:
         Local<Object> errValObj = errVal.As<Object>();
 
         CtxReader<RespType, lcb_ANALYTICS_ERROR_CONTEXT, CtxFn> ctxRdr(_resp);
-        Nan::Set(errValObj, Nan::New<String>("ctxtype").ToLocalChecked(),
-                 Nan::New<String>("analytics").ToLocalChecked());
+        Nan::Set(errValObj, key(Key::ctxtype), key(Key::analytics));
         Nan::Set(
-            errValObj, Nan::New<String>("first_error_code").ToLocalChecked(),
+            errValObj, key(Key::first_error_code),
             ctxRdr
                 .template parseValue<&lcb_errctx_analytics_first_error_code>());
         Nan::Set(errValObj,
-                 Nan::New<String>("first_error_message").ToLocalChecked(),
+                 key(Key::first_error_message),
                  ctxRdr.template parseValue<
                      &lcb_errctx_analytics_first_error_message>());
-        Nan::Set(errValObj, Nan::New<String>("statement").ToLocalChecked(),
+        Nan::Set(errValObj, key(Key::statement),
                  ctxRdr.template parseValue<&lcb_errctx_analytics_statement>());
         Nan::Set(errValObj,
-                 Nan::New<String>("client_context_id").ToLocalChecked(),
+                 key(Key::client_context_id),
                  ctxRdr.template parseValue<
                      &lcb_errctx_analytics_client_context_id>());
         Nan::Set(errValObj,
-                 Nan::New<String>("http_response_code").ToLocalChecked(),
+                 key(Key::http_response_code),
                  ctxRdr.template parseValue<
                      &lcb_errctx_analytics_http_response_code>());
         Nan::Set(errValObj,
-                 Nan::New<String>("http_response_body").ToLocalChecked(),
+                 key(Key::http_response_body),
                  ctxRdr.template parseValue<
                      &lcb_errctx_analytics_http_response_body>());
 
@@ -371,6 +391,9 @@ public:
             return Nan::Null();
         }
 
+        if (connection()->compactResults()) {
+            return Cas::createBigInt(value);
+        }
         return Cas::create(value);
     }
 
@@ -384,6 +407,10 @@ public:
             return Nan::Null();
         }
 
+        if (connection()->compactResults()) {
+            return connection()->tokenSlab().create(
+                value, connection()->bucketName());
+        }
         return MutationToken::create(value, connection()->bucketName());
     }
 
@@ -412,16 +439,54 @@ public:
         return Nan::CopyBuffer(value, nvalue).ToLocalChecked();
     }
 
+    // Sub-document values are always JSON, so they are parsed here rather
+    // than being copied into a Buffer for JS to parse.  Empty values are
+    // returned as null.
+    template <lcb_STATUS (*ValFn)(const RespType *, size_t, const char **,
+                                  size_t *)>
+    Local<Value> parseJsonValue(size_t index) const
+    {
+        const char *value = NULL;
+        size_t nvalue = 0;
+        if (ValFn(_resp, index, &value, &nvalue) != LCB_SUCCESS ||
+            nvalue == 0) {
+            return Nan::Null();
+        }
+
+        Nan::TryCatch tryCatch;
+        Local<String> valueStr =
+            Nan::New<String>(value, static_cast<int>(nvalue)).ToLocalChecked();
+        Nan::MaybeLocal<Value> parsedM =
+            JSON::Parse(Nan::GetCurrentContext(), valueStr);
+        if (parsedM.IsEmpty()) {
+            // Leave anything we could not parse for JS to deal with.
+            return valueStr;
+        }
+        return parsedM.ToLocalChecked();
+    }
+
+    template <lcb_STATUS (*BackbufFn)(const RespType *, lcb_BACKBUF *)>
+    lcb_BACKBUF parseBackbuf() const
+    {
+        lcb_BACKBUF backbuf = nullptr;
+        if (BackbufFn == nullptr || BackbufFn(_resp, &backbuf) != LCB_SUCCESS) {
+            return nullptr;
+        }
+        return backbuf;
+    }
+
     template <lcb_STATUS (*BytesFn)(const RespType *, const char **, size_t *),
-              lcb_STATUS (*FlagsFn)(const RespType *, uint32_t *)>
+              lcb_STATUS (*FlagsFn)(const RespType *, uint32_t *),
+              lcb_STATUS (*BackbufFn)(const RespType *, lcb_BACKBUF *) =
+                  nullptr>
     Local<Value> parseDocValue() const
     {
-        ScopedTraceSpan decodeTrace = this->_cookie->startDecodeTrace();
+        ScopedTraceSpan decodeTrace = startDecodeTrace();
 
-        Local<Object> transcoderObj = Nan::New(this->_cookie->_transcoder);
+        Local<Object> transcoderObj = transcoder();
 
         Nan::MaybeLocal<Value> decodeFnValM =
-            Nan::Get(transcoderObj, Nan::New("decode").ToLocalChecked());
+            Nan::Get(transcoderObj, key(Key::decode));
         if (decodeFnValM.IsEmpty()) {
             return Nan::Undefined();
         }
@@ -434,7 +499,29 @@ public:
 
         Local<Function> decodeFn = decodeFnM.ToLocalChecked();
 
-        Local<Value> valueVal = parseValue<BytesFn>();
+        if (DefaultTranscoder::isDecodeFn(decodeFn)) {
+            const char *bytes = NULL;
+            size_t nbytes = 0;
+            uint32_t flags = 0;
+            if (BytesFn(_resp, &bytes, &nbytes) != LCB_SUCCESS ||
+                FlagsFn(_resp, &flags) != LCB_SUCCESS) {
+                return Nan::Undefined();
+            }
+
+            return DefaultTranscoder::decode(bytes, nbytes, flags,
+                                             parseBackbuf<BackbufFn>());
+        }
+
+        Local<Value> valueVal;
+        lcb_BACKBUF backbuf = parseBackbuf<BackbufFn>();
+        const char *bytes = NULL;
+        size_t nbytes = 0;
+        if (backbuf && BytesFn(_resp, &bytes, &nbytes) == LCB_SUCCESS &&
+            nbytes >= BackedBuffer::MIN_SIZE) {
+            valueVal = BackedBuffer::create(bytes, nbytes, backbuf);
+        } else {
+            valueVal = parseValue<BytesFn>();
+        }
         Local<Value> flagsVal = parseValue<FlagsFn>();
 
         Local<Value> argsArr[] = {valueVal, flagsVal};
@@ -447,10 +534,45 @@ public:
         return resValM.ToLocalChecked();
     }
 
+    RowBatcher *rowBatcher() const
+    {
+        OpCookie *lclCookie = cookie();
+        if (!lclCookie) {
+            return nullptr;
+        }
+        return lclCookie->_rowBatcher.get();
+    }
+
+    TraceSpan startDecodeTrace() const
+    {
+        if (BatchCookie *lclBatch = batch()) {
+            return lclBatch->startDecodeTrace(_cookie);
+        }
+        if (HedgedRead *lclHedge = hedgedRead()) {
+            return lclHedge->startDecodeTrace();
+        }
+        return cookie()->startDecodeTrace();
+    }
+
+    Local<Object> transcoder() const
+    {
+        if (BatchCookie *lclBatch = batch()) {
+            return Nan::New(lclBatch->_transcoder);
+        }
+        if (HedgedRead *lclHedge = hedgedRead()) {
+            return lclHedge->transcoder();
+        }
+        return Nan::New(cookie()->_transcoder);
+    }
+
     template <typename... Ts>
     void invokeNonFinalCallback(Ts... args) const
     {
+        // Batched operations only ever report their final result.
         OpCookie *lclCookie = cookie();
+        if (!lclCookie) {
+            return;
+        }
 
         Local<Value> argsArr[] = {args...};
         lclCookie->invokeCallback(sizeof...(args), argsArr);
@@ -459,20 +581,26 @@ public:
     template <typename... Ts>
     void invokeCallback(Ts... args) const
     {
+        Local<Value> argsArr[] = {args...};
+
+        if (BatchCookie *lclBatch = batch()) {
+            lclBatch->completeEntry(_cookie, sizeof...(args), argsArr);
+            return;
+        }
+
         OpCookie *lclCookie = cookie();
 
         lclCookie->endTrace();
 
-        Local<Value> argsArr[] = {args...};
         lclCookie->invokeCallback(sizeof...(args), argsArr);
 
-        delete lclCookie;
+        OpCookie::destroy(lclCookie);
     }
 
 private:
     lcb_INSTANCE *_instance;
     const RespType *_resp;
-    OpCookie *_cookie;
+    OpCookieBase *_cookie;
 };
 
 } // namespace couchnode
@@ -0,0 +1,198 @@
+#include "rowbatcher.h"
+#include "lcbx.h"
+#include "opbuilder.h"
+
+namespace couchnode
+{
+
+NAN_MODULE_INIT(RowBatcher::Init)
+{
+    Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>();
+    tpl->SetClassName(Nan::New<String>("CbRowStream").ToLocalChecked());
+    tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+    Nan::SetPrototypeMethod(tpl, "pause", fnPause);
+    Nan::SetPrototypeMethod(tpl, "resume", fnResume);
+
+    constructor().Reset(Nan::GetFunction(tpl).ToLocalChecked());
+}
+
+RowBatcher::RowBatcher(OpCookie *cookie, uint32_t batchSize)
+    : _cookie(cookie)
+    , _batchSize(batchSize)
+    , _numRows(0)
+    , _paused(false)
+    , _instance(nullptr)
+    , _handle(nullptr)
+    , _pauseFn(nullptr)
+    , _resumeFn(nullptr)
+{
+    _check = new uv_check_t();
+    uv_check_init(Nan::GetCurrentEventLoop(), _check);
+    uv_unref(reinterpret_cast<uv_handle_t *>(_check));
+    _check->data = this;
+}
+
+RowBatcher::~RowBatcher()
+{
+    Nan::HandleScope scope;
+
+    uv_check_stop(_check);
+    _check->data = nullptr;
+    uv_close(reinterpret_cast<uv_handle_t *>(_check), onCheckClosed);
+    _check = nullptr;
+
+    if (!_streamObj.IsEmpty()) {
+        Nan::SetInternalFieldPointer(Nan::New(_streamObj), 0, nullptr);
+    }
+    _streamObj.Reset();
+    _rows.Reset();
+}
+
+void RowBatcher::addRow(const char *row, size_t nrow)
+{
+    Nan::HandleScope scope;
+
+    Local<Value> rowVal;
+    {
+        Nan::TryCatch tryCatch;
+        Local<String> rowStr =
+            Nan::New<String>(row, static_cast<int>(nrow)).ToLocalChecked();
+        Nan::MaybeLocal<Value> parsedM =
+            JSON::Parse(Nan::GetCurrentContext(), rowStr);
+        if (!parsedM.IsEmpty()) {
+            rowVal = parsedM.ToLocalChecked();
+        } else {
+            // Leave anything we could not parse for JS to deal with.
+            rowVal = rowStr;
+        }
+    }
+
+    if (_rows.IsEmpty()) {
+        _rows.Reset(Nan::New<Array>());
+    }
+    Nan::Set(Nan::New(_rows), _numRows++, rowVal);
+
+    if (_numRows >= _batchSize && !_paused) {
+        flush();
+    } else {
+        scheduleFlush();
+    }
+}
+
+void RowBatcher::finish()
+{
+    uv_check_stop(_check);
+
+    // The lcb handle does not outlive the final response.
+    _handle = nullptr;
+    _paused = false;
+
+    flush();
+}
+
+void RowBatcher::pause()
+{
+    if (_paused) {
+        return;
+    }
+
+    _paused = true;
+    if (_handle) {
+        _pauseFn(_instance, _handle);
+    }
+}
+
+void RowBatcher::resume()
+{
+    if (!_paused) {
+        return;
+    }
+
+    _paused = false;
+    if (_handle) {
+        _resumeFn(_instance, _handle);
+    }
+
+    // Rows which arrived while paused are delivered from the loop rather
+    // than from within the resume() call itself.
+    if (_numRows > 0) {
+        scheduleFlush();
+    }
+}
+
+Local<Object> RowBatcher::streamHandle()
+{
+    Nan::EscapableHandleScope scope;
+
+    if (_streamObj.IsEmpty()) {
+        Local<Object> obj =
+            Nan::NewInstance(Nan::New<Function>(constructor()))
+                .ToLocalChecked();
+        Nan::SetInternalFieldPointer(obj, 0, this);
+        _streamObj.Reset(obj);
+    }
+
+    return scope.Escape(Nan::New(_streamObj));
+}
+
+void RowBatcher::flush()
+{
+    if (_numRows == 0) {
+        return;
+    }
+
+    Nan::HandleScope scope;
+
+    Local<Array> rows = Nan::New(_rows);
+    _rows.Reset();
+    _numRows = 0;
+
+    Local<Value> argv[] = {Nan::Null(), Nan::New<Number>(LCBX_RESP_F_NONFINAL),
+                           rows};
+    Local<Value> res = _cookie->invokeCallback(3, argv);
+    if (res->IsFalse()) {
+        pause();
+    }
+}
+
+void RowBatcher::scheduleFlush()
+{
+    uv_check_start(_check, onCheck);
+}
+
+void RowBatcher::onCheck(uv_check_t *check)
+{
+    uv_check_stop(check);
+
+    RowBatcher *me = static_cast<RowBatcher *>(check->data);
+    if (!me || me->_paused) {
+        return;
+    }
+    me->flush();
+}
+
+void RowBatcher::onCheckClosed(uv_handle_t *handle)
+{
+    delete reinterpret_cast<uv_check_t *>(handle);
+}
+
+NAN_METHOD(RowBatcher::fnPause)
+{
+    RowBatcher *me = static_cast<RowBatcher *>(
+        Nan::GetInternalFieldPointer(info.This(), 0));
+    if (me) {
+        me->pause();
+    }
+}
+
+NAN_METHOD(RowBatcher::fnResume)
+{
+    RowBatcher *me = static_cast<RowBatcher *>(
+        Nan::GetInternalFieldPointer(info.This(), 0));
+    if (me) {
+        me->resume();
+    }
+}
+
+} // namespace couchnode
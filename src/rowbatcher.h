@@ -0,0 +1,103 @@
+#pragma once
+#ifndef ROWBATCHER_H
+#define ROWBATCHER_H
+
+#include "addondata.h"
+#include <libcouchbase/couchbase.h>
+#include <nan.h>
+#include <node.h>
+#include <uv.h>
+
+namespace couchnode
+{
+
+using namespace v8;
+
+class OpCookie;
+
+// Collects the rows of a streaming query (N1QL, analytics or search) and
+// hands them to JS as arrays of already parsed rows, instead of calling into
+// JS once per raw row.  A batch is delivered once it reaches the configured
+// size, or at the end of the event loop iteration which read it so that rows
+// are not held back waiting for more data.  If the JS callback returns false
+// for a batch, reading from the socket is paused until the stream handle
+// which was returned to JS is resumed.
+class RowBatcher
+{
+public:
+    static NAN_MODULE_INIT(Init);
+
+    RowBatcher(OpCookie *cookie, uint32_t batchSize);
+    ~RowBatcher();
+
+    template <typename HandleType,
+              lcb_STATUS (*PauseFn)(lcb_INSTANCE *, HandleType *),
+              lcb_STATUS (*ResumeFn)(lcb_INSTANCE *, HandleType *)>
+    void setHandle(lcb_INSTANCE *instance, HandleType *handle)
+    {
+        if (_handle || !handle) {
+            return;
+        }
+
+        _instance = instance;
+        _handle = handle;
+        _pauseFn = &callHandleFn<HandleType, PauseFn>;
+        _resumeFn = &callHandleFn<HandleType, ResumeFn>;
+        if (_paused) {
+            _pauseFn(_instance, _handle);
+        }
+    }
+
+    void addRow(const char *row, size_t nrow);
+
+    // Delivers whatever rows are left, paused or not.  Called before the
+    // final callback of the request, after which the lcb handle is gone.
+    void finish();
+
+    void pause();
+    void resume();
+
+    Local<Object> streamHandle();
+
+    static inline Nan::Persistent<Function> &constructor()
+    {
+        return AddonData::current()->rowBatcherConstructor;
+    }
+
+private:
+    typedef lcb_STATUS (*HandleFn)(lcb_INSTANCE *, void *);
+
+    template <typename HandleType,
+              lcb_STATUS (*Fn)(lcb_INSTANCE *, HandleType *)>
+    static lcb_STATUS callHandleFn(lcb_INSTANCE *instance, void *handle)
+    {
+        return Fn(instance, static_cast<HandleType *>(handle));
+    }
+
+    void flush();
+    void scheduleFlush();
+
+    static void onCheck(uv_check_t *check);
+    static void onCheckClosed(uv_handle_t *handle);
+
+    static NAN_METHOD(fnPause);
+    static NAN_METHOD(fnResume);
+
+    OpCookie *_cookie;
+    uint32_t _batchSize;
+    uint32_t _numRows;
+    bool _paused;
+    Nan::Persistent<Array> _rows;
+    Nan::Persistent<Object> _streamObj;
+
+    lcb_INSTANCE *_instance;
+    void *_handle;
+    HandleFn _pauseFn;
+    HandleFn _resumeFn;
+
+    uv_check_t *_check;
+};
+
+} // namespace couchnode
+
+#endif // ROWBATCHER_H
@@ -0,0 +1,136 @@
+#include "transcoder.h"
+
+namespace couchnode
+{
+
+// These must be kept in sync with lib/transcoders.ts
+static const uint32_t NF_JSON = 0x00;
+static const uint32_t NF_RAW = 0x02;
+static const uint32_t NF_UTF8 = 0x04;
+static const uint32_t NF_MASK = 0xff;
+static const uint32_t NF_UNKNOWN = 0x100;
+
+static const uint32_t CF_NONE = 0x00 << 24;
+static const uint32_t CF_PRIVATE = 0x01 << 24;
+static const uint32_t CF_JSON = 0x02 << 24;
+static const uint32_t CF_RAW = 0x03 << 24;
+static const uint32_t CF_UTF8 = 0x04 << 24;
+static const uint32_t CF_MASK = 0xffu << 24;
+
+NAN_MODULE_INIT(DefaultTranscoder::Init)
+{
+    Nan::SetMethod(target, "registerDefaultTranscoder", fnRegister);
+}
+
+NAN_METHOD(DefaultTranscoder::fnRegister)
+{
+    Nan::HandleScope scope;
+
+    if (info.Length() != 2 || !info[0]->IsFunction() ||
+        !info[1]->IsFunction()) {
+        return Nan::ThrowError("expected encode and decode functions");
+    }
+
+    encodeFn().Reset(info[0].As<Function>());
+    decodeFn().Reset(info[1].As<Function>());
+
+    info.GetReturnValue().Set(true);
+}
+
+bool DefaultTranscoder::isEncodeFn(Local<Value> fn)
+{
+    if (encodeFn().IsEmpty()) {
+        return false;
+    }
+    return fn->StrictEquals(Nan::New(encodeFn()));
+}
+
+bool DefaultTranscoder::isDecodeFn(Local<Value> fn)
+{
+    if (decodeFn().IsEmpty()) {
+        return false;
+    }
+    return fn->StrictEquals(Nan::New(decodeFn()));
+}
+
+bool DefaultTranscoder::canEncode(Local<Value> value)
+{
+    // JSON.stringify returns undefined for these, which the JS transcoder
+    // then fails to convert into a Buffer.  Leave the error reporting for
+    // those cases to the JS implementation.
+    return !value->IsUndefined() && !value->IsFunction() &&
+           !value->IsSymbol();
+}
+
+bool DefaultTranscoder::encode(ValueParser &valueParser, Local<Value> value,
+                               const char **bytes, size_t *nbytes,
+                               uint32_t *flags)
+{
+    if (node::Buffer::HasInstance(value)) {
+        *flags = CF_RAW | NF_RAW;
+        return valueParser.parseString(bytes, nbytes, value);
+    }
+
+    if (value->IsString()) {
+        *flags = CF_UTF8 | NF_UTF8;
+        return valueParser.parseString(bytes, nbytes, value);
+    }
+
+    Nan::MaybeLocal<String> jsonStrM =
+        JSON::Stringify(Nan::GetCurrentContext(), value);
+    if (jsonStrM.IsEmpty()) {
+        return false;
+    }
+
+    *flags = CF_JSON | NF_JSON;
+    return valueParser.parseString(bytes, nbytes, jsonStrM.ToLocalChecked());
+}
+
+Local<Value> DefaultTranscoder::decode(const char *bytes, size_t nbytes,
+                                       uint32_t flags, lcb_BACKBUF backbuf)
+{
+    if (!bytes) {
+        bytes = "";
+    }
+
+    uint32_t format = flags & NF_MASK;
+    uint32_t cfformat = flags & CF_MASK;
+
+    if (cfformat != CF_NONE) {
+        if (cfformat == CF_JSON) {
+            format = NF_JSON;
+        } else if (cfformat == CF_RAW) {
+            format = NF_RAW;
+        } else if (cfformat == CF_UTF8) {
+            format = NF_UTF8;
+        } else if (cfformat != CF_PRIVATE) {
+            // Unknown CF Format!  The following will force
+            //   fallback to reporting RAW data.
+            format = NF_UNKNOWN;
+        }
+    }
+
+    if (format == NF_UTF8) {
+        return Nan::New<String>(bytes, nbytes).ToLocalChecked();
+    } else if (format == NF_JSON) {
+        Nan::TryCatch tryCatch;
+        Local<String> jsonStr =
+            Nan::New<String>(bytes, nbytes).ToLocalChecked();
+        Nan::MaybeLocal<Value> parsedM =
+            JSON::Parse(Nan::GetCurrentContext(), jsonStr);
+        if (!parsedM.IsEmpty()) {
+            return parsedM.ToLocalChecked();
+        }
+
+        // If we encounter a parse error, assume that we need
+        // to return bytes instead of an object.
+    }
+
+    // Default to returning a Buffer if all else fails.
+    if (backbuf && nbytes >= BackedBuffer::MIN_SIZE) {
+        return BackedBuffer::create(bytes, nbytes, backbuf);
+    }
+    return Nan::CopyBuffer(bytes, nbytes).ToLocalChecked();
+}
+
+} // namespace couchnode
@@ -0,0 +1,56 @@
+#pragma once
+#ifndef TRANSCODER_H
+#define TRANSCODER_H
+
+#include "addondata.h"
+#include "valueparser.h"
+#include <libcouchbase/couchbase.h>
+#include <nan.h>
+#include <node.h>
+
+namespace couchnode
+{
+
+using namespace v8;
+
+// Native implementation of the common-flags DefaultTranscoder from
+// lib/transcoders.ts.  The JS library registers the encode/decode functions
+// of the stock transcoder, and any transcoder whose encode/decode are those
+// exact functions is then handled here without calling back into JS.
+class DefaultTranscoder
+{
+public:
+    static NAN_MODULE_INIT(Init);
+
+    static bool isEncodeFn(Local<Value> fn);
+    static bool isDecodeFn(Local<Value> fn);
+
+    // Returns false if the value is not one that we can encode natively
+    // with the same semantics as the JS implementation.
+    static bool canEncode(Local<Value> value);
+
+    static bool encode(ValueParser &valueParser, Local<Value> value,
+                       const char **bytes, size_t *nbytes, uint32_t *flags);
+
+    // Raw values are returned as a Buffer referencing `backbuf` rather than a
+    // copy when one is given and the value is large enough.
+    static Local<Value> decode(const char *bytes, size_t nbytes,
+                               uint32_t flags, lcb_BACKBUF backbuf = nullptr);
+
+    static inline Nan::Persistent<Function> &encodeFn()
+    {
+        return AddonData::current()->defaultEncodeFn;
+    }
+
+    static inline Nan::Persistent<Function> &decodeFn()
+    {
+        return AddonData::current()->defaultDecodeFn;
+    }
+
+private:
+    static NAN_METHOD(fnRegister);
+};
+
+} // namespace couchnode
+
+#endif // TRANSCODER_H
@@ -3,7 +3,9 @@
 #define VALUEPARSER_H
 
 #include "cas.h"
+#include "pool.h"
 #include <libcouchbase/couchbase.h>
+#include <libcouchbase/pktfwd.h>
 #include <stdint.h>
 #include <vector>
 
@@ -12,18 +14,92 @@ namespace couchnode
 
 using namespace v8;
 
+/**
+ * Keeps a Buffer alive while libcouchbase sends its contents without copying
+ * them.  Ownership passes to the library, which calls release() once the
+ * request no longer references the data.
+ */
+class PinnedBuffer
+{
+public:
+    // Below this size copying is cheaper than pinning, and small Buffers are
+    // likely to be slices of node's shared allocation pool.
+    static const size_t MIN_SIZE = 16 * 1024;
+
+    explicit PinnedBuffer(Local<Object> buffer)
+        : _buffer(buffer)
+        , _data(node::Buffer::Data(buffer))
+        , _length(node::Buffer::Length(buffer))
+    {
+    }
+
+    ~PinnedBuffer()
+    {
+        _buffer.Reset();
+    }
+
+    const char *data() const
+    {
+        return _data;
+    }
+
+    size_t length() const
+    {
+        return _length;
+    }
+
+    static void release(void *cookie)
+    {
+        delete reinterpret_cast<PinnedBuffer *>(cookie);
+    }
+
+private:
+    Nan::Persistent<Object> _buffer;
+    const char *_data;
+    size_t _length;
+};
+
+/**
+ * The reverse of PinnedBuffer: exposes a value which lives in one of
+ * libcouchbase's network buffers to JS without copying it.  The network
+ * buffer stays referenced until the Buffer is garbage collected.
+ */
+class BackedBuffer
+{
+public:
+    // Referencing a network buffer keeps the whole segment alive, so only do
+    // it when the value makes up most of it.
+    static const size_t MIN_SIZE = 16 * 1024;
+
+    static Local<Object> create(const char *data, size_t length,
+                                lcb_BACKBUF backbuf)
+    {
+        lcb_backbuf_ref(backbuf);
+        return Nan::NewBuffer(const_cast<char *>(data), length,
+                              &BackedBuffer::release, backbuf)
+            .ToLocalChecked();
+    }
+
+private:
+    static void release(char *data, void *hint)
+    {
+        lcb_backbuf_unref(reinterpret_cast<lcb_BACKBUF>(hint));
+    }
+};
+
 class ValueParser
 {
 public:
-    ValueParser()
+    // Parsed strings live in the arena until the parser is destroyed.
+    explicit ValueParser(ScratchArena &arena)
+        : _arena(arena)
+        , _mark(arena.mark())
     {
     }
 
     ~ValueParser()
     {
-        for (size_t i = 0; i < _strings.size(); ++i) {
-            delete _strings[i];
-        }
+        _arena.rewind(_mark);
     }
 
     template <typename T, typename V>
@@ -48,27 +124,38 @@ public:
             return true;
         }
 
-        Nan::Utf8String *utfStr = new Nan::Utf8String(str);
+        Nan::MaybeLocal<String> strM = Nan::To<String>(str);
+        if (strM.IsEmpty()) {
+            return false;
+        }
+        Local<String> strVal = strM.ToLocalChecked();
 
-        if (utfStr->length() == 0) {
+        if (strVal->Length() == 0) {
             // If the length of the string is Zero, we can return a NULL val
-            // along with an nval of 0 and avoid holding onto the string ref.
-
-            delete utfStr;
-
+            // along with an nval of 0 and avoid using any scratch space.
             *val = NULL;
-            *nval = 0;
+            if (nval) {
+                *nval = 0;
+            }
 
             return true;
         }
 
-        _strings.push_back(utfStr);
+        // Each UTF-16 code unit encodes to at most 3 bytes of UTF-8, the
+        // unused remainder is handed back to the arena once written.
+        size_t capacity = static_cast<size_t>(strVal->Length()) * 3;
+        char *bytes = _arena.allocate(capacity);
+        ssize_t nbytes = Nan::DecodeWrite(bytes, capacity, strVal, Nan::UTF8);
+        if (nbytes < 0) {
+            return false;
+        }
+        _arena.shrink(bytes, capacity, static_cast<size_t>(nbytes));
 
         if (val) {
-            *val = **utfStr;
+            *val = bytes;
         }
         if (nval) {
-            *nval = utfStr->length();
+            *nval = static_cast<size_t>(nbytes);
         }
 
         return true;
@@ -142,7 +229,8 @@ public:
     }
 
 private:
-    std::vector<Nan::Utf8String *> _strings;
+    ScratchArena &_arena;
+    ScratchArena::Mark _mark;
 };
 
 } // namespace couchnode
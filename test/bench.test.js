@@ -0,0 +1,58 @@
+'use strict'
+
+const assert = require('chai').assert
+
+const H = require('./harness')
+
+// Runs `numOps` operations produced by `opFn`, keeping up to `concurrency`
+// of them in flight at a time.
+async function runOps(numOps, concurrency, opFn) {
+  let nextOp = 0
+  const worker = async () => {
+    while (nextOp < numOps) {
+      await opFn(nextOp++)
+    }
+  }
+  const workers = []
+  for (let i = 0; i < concurrency; ++i) {
+    workers.push(worker())
+  }
+  await Promise.all(workers)
+}
+
+describe('#benchmarks', function () {
+  describe('#op allocations', function () {
+    const NUM_OPS = 100000
+    let testKey
+
+    before(async function () {
+      testKey = H.genTestKey()
+      await H.co.insert(testKey, { foo: 'bar' })
+    })
+
+    after(async function () {
+      await H.co.remove(testKey)
+    })
+
+    it('should recycle per-op allocations (slow)', async function () {
+      const conn = H.co.conn
+
+      // Warm the pools up first, the first operations have to fill them.
+      await runOps(1000, 1000, () => H.co.get(testKey))
+      const warm = conn.poolStats()
+
+      await runOps(NUM_OPS, 1000, () => H.co.get(testKey))
+      const after = conn.poolStats()
+
+      const allocsPerOp =
+        (after.cookieAllocs -
+          warm.cookieAllocs +
+          after.scratchAllocs -
+          warm.scratchAllocs) /
+        NUM_OPS
+
+      // Without pooling every get allocates its cookie and key separately.
+      assert.isBelow(allocsPerOp, 0.01)
+    }).timeout(120000)
+  })
+})
@@ -77,6 +77,110 @@ describe('#Cluster', function () {
     cluster.close()
   })
 
+  it('should aggregate operation metrics natively', async function () {
+    const meter = new H.lib.AggregatingMeter()
+    var cluster = await H.lib.Cluster.connect(H.connStr, {
+      ...H.connOpts,
+      meter: meter,
+    })
+    var bucket = cluster.bucket(H.bucketName)
+    var coll = bucket.defaultCollection()
+
+    const testKey = H.genTestKey()
+    await coll.insert(testKey, 'bar')
+    await coll.get(testKey)
+    await coll.get(testKey)
+
+    const snapshot = meter.snapshot()
+    assert.strictEqual(snapshot.kv.get.totalCount, 2)
+    assert.ok(snapshot.kv.get.percentiles['99.0'] > 0)
+
+    assert.strictEqual(meter.drain().kv.get.totalCount, 2)
+    assert.strictEqual(meter.snapshot().kv.get.totalCount, 0)
+
+    await coll.remove(testKey)
+    cluster.close()
+  })
+
+  it('should work from worker threads sharing a config cache', async function () {
+    let Worker
+    try {
+      Worker = require('worker_threads').Worker
+    } catch (e) {
+      this.skip()
+    }
+
+    const testKey = H.genTestKey()
+    const workerData = {
+      libPath: require.resolve('../lib/couchbase'),
+      connStr: H.connStr,
+      connOpts: H.connOpts,
+      bucketName: H.bucketName,
+      testKey: testKey,
+    }
+
+    // Each worker loads its own copy of the binding, on its own event loop.
+    const runWorker = (idx) =>
+      new Promise((resolve, reject) => {
+        const worker = new Worker(
+          `
+          const { workerData, parentPort } = require('worker_threads')
+          const couchbase = require(workerData.libPath)
+          ;(async () => {
+            const cluster = await couchbase.connect(workerData.connStr, {
+              ...workerData.connOpts,
+              sharedConfigCache: 'worker-test',
+            })
+            const coll = cluster.bucket(workerData.bucketName).defaultCollection()
+            await coll.upsert(workerData.testKey + '_' + workerData.idx, 'bar')
+            const res = await coll.get(workerData.testKey + '_' + workerData.idx)
+            await cluster.close()
+            parentPort.postMessage(res.value)
+          })().catch((e) => {
+            setImmediate(() => {
+              throw e
+            })
+          })
+          `,
+          { eval: true, workerData: { ...workerData, idx: idx } }
+        )
+        worker.on('message', resolve)
+        worker.on('error', reject)
+      })
+
+    const results = await Promise.all([0, 1, 2, 3].map(runWorker))
+    assert.deepStrictEqual(results, ['bar', 'bar', 'bar', 'bar'])
+  }).timeout(30000)
+
+  it('should let a worker exit with a connection still open', async function () {
+    let Worker
+    try {
+      Worker = require('worker_threads').Worker
+    } catch (e) {
+      this.skip()
+    }
+
+    // Nothing is connected, the connection only has to be torn down cleanly
+    // along with the worker, without ever being garbage collected.
+    const worker = new Worker(
+      `
+      const { workerData, parentPort } = require('worker_threads')
+      const { Connection } = require(workerData.libPath)
+      global.conn = new Connection({ connStr: 'couchbase://localhost/default' })
+      parentPort.postMessage('created')
+      `,
+      {
+        eval: true,
+        workerData: { libPath: require.resolve('../lib/connection') },
+      }
+    )
+    await new Promise((resolve, reject) => {
+      worker.on('message', resolve)
+      worker.on('error', reject)
+    })
+    await worker.terminate()
+  }).timeout(10000)
+
   it('lcbVersion property should work', function () {
     assert(typeof H.lib.lcbVersion === 'string')
   })
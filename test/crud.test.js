@@ -2,6 +2,7 @@
 
 const assert = require('chai').assert
 const H = require('./harness')
+const binding = require('../lib/binding').default
 
 const errorTranscoder = {
   encode: () => {
@@ -45,6 +46,7 @@ function genericTests(collFn) {
       it('should perform basic upserts', async function () {
         var res = await collFn().upsert(testKeyA, testObjVal)
         assert.isObject(res)
+        assert.instanceOf(res, H.lib.MutationResult)
         assert.isNotEmpty(res.cas)
       })
 
@@ -90,8 +92,10 @@ function genericTests(collFn) {
       it('should perform basic gets', async function () {
         var res = await collFn().get(testKeyA)
         assert.isObject(res)
+        assert.instanceOf(res, H.lib.GetResult)
         assert.isNotEmpty(res.cas)
         assert.deepStrictEqual(res.value, testObjVal)
+        assert.isUndefined(res.expiryTime)
 
         // BUG JSCBC-784: Check to make sure that the value property
         // returns the same as the content property.
@@ -203,6 +207,7 @@ function genericTests(collFn) {
         var res = await collFn().exists(testKeyA)
 
         assert.isObject(res)
+        assert.instanceOf(res, H.lib.ExistsResult)
         assert.isNotEmpty(res.cas)
         assert.deepStrictEqual(res.exists, true)
       })
@@ -245,6 +250,62 @@ function genericTests(collFn) {
         // returns the same as the content property.
         assert.strictEqual(res.value, res.content)
       })
+
+      it('should perform hedged gets', async function () {
+        // Without a delay, the replica read is sent straight away.
+        var res = await collFn().get(testKeyA, { hedgeDelay: 0 })
+        assert.instanceOf(res, H.lib.GetResult)
+        assert.isNotEmpty(res.cas)
+        assert.deepStrictEqual(res.content, testObjVal)
+
+        res = await collFn().get(testKeyA, {
+          hedgePercentile: 99,
+          hedgeDelay: 10,
+        })
+        assert.deepStrictEqual(res.content, testObjVal)
+      })
+
+      it('should return the replica while the active get stalls', async function () {
+        if (!H.usingMock) {
+          this.skip()
+        }
+
+        var keyInfo = await H.mockCommand('KEYINFO', { Key: testKeyA })
+        var masterIdx = keyInfo.findIndex(
+          (node) => node && node.Conf.Type === 'master'
+        )
+
+        // Temporary failures are retried, which keeps the active get
+        // pending until the replica read has won.
+        await H.mockCommand('OPFAIL', {
+          code: 0x86,
+          count: -1,
+          servers: [masterIdx],
+        })
+        try {
+          var res = await collFn().get(testKeyA, {
+            hedgeDelay: 10,
+            timeout: 1000,
+          })
+          assert.instanceOf(res, H.lib.GetResult)
+          assert.deepStrictEqual(res.content, testObjVal)
+        } finally {
+          await H.mockCommand('OPFAIL', {
+            code: 0,
+            count: -1,
+            servers: [masterIdx],
+          })
+        }
+
+        // The active get completes after the result was returned.
+        await H.sleep(1200)
+      }).timeout(5000)
+
+      it('should not hedge gets of missing documents', async function () {
+        await H.throwsHelper(async () => {
+          await collFn().get('invalid-key', { hedgeDelay: 0 })
+        }, H.lib.DocumentNotFoundError)
+      })
     })
 
     describe('#replace', function () {
@@ -410,6 +471,7 @@ function genericTests(collFn) {
       it('should increment successfully', async function () {
         var res = await collFn().binary().increment(testKeyBin, 3)
         assert.isObject(res)
+        assert.instanceOf(res, H.lib.CounterResult)
         assert.isNotEmpty(res.cas)
         assert.deepStrictEqual(res.value, 17)
 
@@ -555,6 +617,23 @@ function genericTests(collFn) {
       assert.strictEqual(res.results, res.content)
     })
 
+    it('should decode lookupIn values of any type', async function () {
+      var res = await collFn().lookupIn(testKeySd, [
+        H.lib.LookupInSpec.get('arr'),
+        H.lib.LookupInSpec.get(''),
+        H.lib.LookupInSpec.get('missing'),
+      ])
+      assert.deepStrictEqual(res.content[0].value, [1, 2, 3])
+      assert.deepStrictEqual(res.content[1].value, {
+        foo: 14,
+        bar: 2,
+        baz: 'hello',
+        arr: [1, 2, 3],
+      })
+      assert.instanceOf(res.content[2].error, H.lib.PathNotFoundError)
+      assert.isNull(res.content[2].value)
+    })
+
     it('should doc-not-found for missing lookupIn', async function () {
       await H.throwsHelper(async () => {
         await collFn().lookupIn('some-document-which-does-not-exist', [
@@ -599,6 +678,139 @@ function genericTests(collFn) {
       }, H.lib.CasMismatchError)
     })
   })
+
+  describe('#transcoding', function () {
+    let testKeyTc
+
+    before(function () {
+      testKeyTc = H.genTestKey()
+    })
+
+    it('should round-trip strings', async function () {
+      await collFn().upsert(testKeyTc, 'hello world')
+      const res = await collFn().get(testKeyTc)
+      assert.strictEqual(res.value, 'hello world')
+    })
+
+    it('should round-trip buffers', async function () {
+      const buf = Buffer.from([0, 1, 2, 255])
+      await collFn().upsert(testKeyTc, buf)
+      const res = await collFn().get(testKeyTc)
+      assert.isTrue(Buffer.isBuffer(res.value))
+      assert.isTrue(buf.equals(res.value))
+    })
+
+    it('should round-trip large buffers', async function () {
+      const buf = Buffer.alloc(256 * 1024)
+      for (let i = 0; i < buf.length; ++i) {
+        buf[i] = i % 251
+      }
+      await collFn().upsert(testKeyTc, buf)
+      const res = await collFn().get(testKeyTc)
+      assert.isTrue(Buffer.isBuffer(res.value))
+      assert.isTrue(buf.equals(res.value))
+    })
+
+    it('should round-trip json values', async function () {
+      await collFn().upsert(testKeyTc, [1, 'two', { three: 3 }, null])
+      let res = await collFn().get(testKeyTc)
+      assert.deepStrictEqual(res.value, [1, 'two', { three: 3 }, null])
+
+      await collFn().upsert(testKeyTc, 14)
+      res = await collFn().get(testKeyTc)
+      assert.strictEqual(res.value, 14)
+    })
+
+    it('should respect overridden default transcoder methods', async function () {
+      class CustomTranscoder extends H.lib.DefaultTranscoder {
+        decode(bytes, flags) {
+          return { wrapped: super.decode(bytes, flags) }
+        }
+      }
+
+      await collFn().upsert(testKeyTc, 'hello')
+      const res = await collFn().get(testKeyTc, {
+        transcoder: new CustomTranscoder(),
+      })
+      assert.deepStrictEqual(res.value, { wrapped: 'hello' })
+    })
+  })
+
+  describe('#batched', function () {
+    let testKeys
+
+    before(function () {
+      testKeys = [H.genTestKey(), H.genTestKey(), H.genTestKey()]
+    })
+
+    function batchOp(fnName, ...args) {
+      const coll = collFn()
+      return new Promise((resolve, reject) => {
+        coll.conn[fnName](
+          ...coll._lcbScopeColl,
+          ...args,
+          (err, errs, cas, values) => {
+            if (err) {
+              return reject(err)
+            }
+            resolve({ errs, cas, values })
+          }
+        )
+      })
+    }
+
+    it('should store multiple documents in one call', async function () {
+      const res = await batchOp(
+        'storeMulti',
+        testKeys,
+        collFn().transcoder,
+        testKeys.map((key, idx) => ({ key: key, idx: idx })),
+        undefined,
+        undefined,
+        undefined,
+        undefined,
+        undefined,
+        undefined,
+        binding.LCB_STORE_UPSERT
+      )
+      assert.deepStrictEqual(res.errs, [null, null, null])
+      assert.lengthOf(res.cas, 3)
+      res.cas.forEach((cas) => assert.isOk(cas))
+    })
+
+    it('should get multiple documents in one call', async function () {
+      const missingKey = H.genTestKey()
+      const res = await batchOp(
+        'getMulti',
+        [...testKeys, missingKey],
+        collFn().transcoder,
+        undefined,
+        undefined,
+        undefined,
+        undefined
+      )
+      assert.lengthOf(res.errs, 4)
+      for (let i = 0; i < testKeys.length; ++i) {
+        assert.isNull(res.errs[i])
+        assert.deepStrictEqual(res.values[i], { key: testKeys[i], idx: i })
+      }
+      assert.instanceOf(res.errs[3], H.lib.DocumentNotFoundError)
+      assert.isNull(res.values[3])
+    })
+
+    it('should complete an empty batch', async function () {
+      const res = await batchOp(
+        'getMulti',
+        [],
+        collFn().transcoder,
+        undefined,
+        undefined,
+        undefined,
+        undefined
+      )
+      assert.deepStrictEqual(res.errs, [])
+    })
+  })
 }
 
 describe('#crud', function () {
@@ -615,3 +827,50 @@ describe('#collections-crud', function () {
   /* eslint-disable-next-line mocha/no-setup-in-describe */
   genericTests(() => H.co)
 })
+
+describe('#compact-results', function () {
+  let cluster
+  let coll
+  let testKey
+
+  before(async function () {
+    testKey = H.genTestKey()
+    cluster = await H.newCluster({ compactResults: true })
+    coll = cluster.bucket(H.bucketName).defaultCollection()
+  })
+
+  after(async function () {
+    await coll.remove(testKey)
+    await cluster.close()
+  })
+
+  it('should return BigInt cas and packed tokens', async function () {
+    const res = await coll.upsert(testKey, { foo: 'bar' })
+    assert.strictEqual(typeof res.cas, 'bigint')
+    assert.notStrictEqual(res.cas, BigInt(0))
+
+    if (res.token) {
+      assert.isTrue(ArrayBuffer.isView(res.token))
+      const state = new H.lib.MutationState(res.token)
+      const data = state.toJSON()[H.bucketName]
+      assert.isObject(data)
+      assert.deepStrictEqual(Object.values(data), [
+        [Number(res.token[2]), res.token[1].toString()],
+      ])
+    }
+
+    const gres = await coll.get(testKey)
+    assert.strictEqual(gres.cas, res.cas)
+  })
+
+  it('should accept BigInt and string cas', async function () {
+    const gres = await coll.get(testKey)
+    const rres = await coll.replace(testKey, { foo: 'baz' }, { cas: gres.cas })
+
+    await H.throwsHelper(async () => {
+      await coll.replace(testKey, { foo: 'bla' }, { cas: gres.cas })
+    }, H.lib.CasMismatchError)
+
+    await coll.replace(testKey, { foo: 'bla' }, { cas: rres.cas.toString() })
+  })
+})
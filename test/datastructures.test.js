@@ -250,6 +250,23 @@ function genericTests(collFn) {
       assert.deepEqual(res3, 'test3')
     })
 
+    it('should pop concurrently without losing items', async function () {
+      var items = []
+      for (var i = 0; i < 10; ++i) {
+        items.push('item' + i)
+        await queueObj.push('item' + i)
+      }
+
+      var pops = []
+      for (var j = 0; j < items.length; ++j) {
+        pops.push(queueObj.pop())
+      }
+      var popped = await Promise.all(pops)
+
+      assert.sameMembers(popped, items)
+      assert.equal(await queueObj.size(), 0)
+    })
+
     it('should error poping with no items', async function () {
       await H.throwsHelper(async () => {
         await queueObj.pop()
@@ -318,6 +335,16 @@ function genericTests(collFn) {
       await setObj.remove('test2')
     })
 
+    it('should remove items concurrently', async function () {
+      await setObj.add('test3')
+      await setObj.add('test4')
+
+      await Promise.all([setObj.remove('test3'), setObj.remove('test4')])
+
+      var values = await setObj.values()
+      assert.sameMembers(values, ['test1'])
+    })
+
     it('should error removing an invalid item', async function () {
       await H.throwsHelper(async () => {
         await setObj.remove('invalid-item')
@@ -38,6 +38,11 @@ describe('#diagnostics', function () {
       assert.equal(res.version, 1)
       assert.isString(res.sdk)
       assert.isArray(res.services)
+      assert.isObject(res.queryCache)
+      assert.isNumber(res.queryCache.hits)
+      assert.isNumber(res.queryCache.misses)
+      assert.isNumber(res.queryCache.evictions)
+      assert.isAtLeast(res.queryCache.capacity, 1)
     })
 
     it('should ping a cluster successfully', async function () {
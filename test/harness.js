@@ -213,6 +213,14 @@ class Harness {
     })
   }
 
+  get usingMock() {
+    return this._usingMock
+  }
+
+  async mockCommand(cmd, payload) {
+    return this._sendMockCmd(this._mockInst, cmd, payload)
+  }
+
   async prepare() {
     if (this._usingMock) {
       var mockInst = await this._createMock()
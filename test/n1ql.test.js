@@ -1,6 +1,7 @@
 'use strict'
 
 const assert = require('chai').assert
+const binding = require('../lib/binding').default
 const testdata = require('./testdata')
 
 const H = require('./harness')
@@ -120,6 +121,77 @@ describe('#query', function () {
     }
   }).timeout(10000)
 
+  it('should stream test data through a readable', async function () {
+    const qs = `SELECT * FROM ${H.b.name} WHERE testUid='${testUid}'`
+    const stream = H.c.query(qs).stream({ highWaterMark: 1 })
+
+    const res = await new Promise((resolve, reject) => {
+      const rowsOut = []
+      let metaOut = null
+      stream.on('meta', (meta) => {
+        metaOut = meta
+      })
+      stream.on('error', reject)
+      stream.on('end', () => resolve({ rows: rowsOut, meta: metaOut }))
+
+      // Read slowly, so that the stream has to hold the server back.
+      const readNext = () => {
+        const row = stream.read()
+        if (row !== null) {
+          rowsOut.push(row)
+          setImmediate(readNext)
+        } else {
+          stream.once('readable', readNext)
+        }
+      }
+      readNext()
+    })
+
+    assert.lengthOf(res.rows, testdata.docCount())
+    assert.isObject(res.meta)
+  }).timeout(10000)
+
+  it('should deliver rows to the binding in batches', async function () {
+    const conn = H.c._getClusterConn()
+    const qs = `SELECT * FROM ${H.b.name} WHERE testUid='${testUid}'`
+    const queryData = JSON.stringify({ statement: qs })
+
+    const res = await new Promise((resolve, reject) => {
+      const batches = []
+      const stream = conn.query(
+        queryData,
+        undefined,
+        0,
+        undefined,
+        undefined,
+        2,
+        (err, flags, data) => {
+          if (flags & binding.LCBX_RESP_F_NONFINAL) {
+            batches.push(data)
+            return
+          }
+          if (err) {
+            return reject(err)
+          }
+          resolve({ stream, batches, meta: JSON.parse(data) })
+        }
+      )
+    })
+
+    assert.isFunction(res.stream.pause)
+    assert.isFunction(res.stream.resume)
+    let numRows = 0
+    res.batches.forEach((batch) => {
+      assert.isArray(batch)
+      assert.isAtLeast(batch.length, 1)
+      assert.isAtMost(batch.length, 2)
+      batch.forEach((row) => assert.isObject(row))
+      numRows += batch.length
+    })
+    assert.equal(numRows, testdata.docCount())
+    assert.isObject(res.meta)
+  })
+
   it('should see test data correctly at scope level', async function () {
     H.skipIfMissingFeature(this, H.Features.Collections)
 
@@ -177,6 +249,8 @@ describe('#query', function () {
         res = await H.c.query(qs, {
           parameters: {
             tuid: testUid,
+            // Values JSON cannot represent are dropped
+            unused: () => {},
           },
         })
       } catch (e) {} // eslint-disable-line no-empty